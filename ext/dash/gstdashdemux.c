@@ -36,6 +36,18 @@
  * |[
  * gst-launch-1.0 playbin uri="http://www-itec.uni-klu.ac.at/ftp/datasets/mmsys12/RedBullPlayStreets/redbull_4s/RedBullPlayStreets_4s_isoffmain_DIS_23009_1_v_2_1c2_2011_08_30.mpd"
  * ]|
+ *
+ * ## Live latency
+ *
+ * For live streams with a target latency, an element message named
+ * `dash-live-latency` is posted after each fragment of the first stream. It
+ * contains the current distance to the live edge in the `latency` field,
+ * the latency playback started at in the `target-latency` field and, in the
+ * `playback-rate` field, the rate the application should play at to get
+ * back to the target latency. The target comes from the MPD
+ * ServiceDescription Latency element when present, otherwise from the
+ * suggested or default presentation delay, and the rate stays within the
+ * bounds of the ServiceDescription PlaybackRate element.
  */
 
 /* Implementation notes:
@@ -272,6 +284,24 @@
  *   Advance to keyframe/fragment for that target_time
  *   Adaptivedemux downloads that keyframe/fragment
  *
+ *
+ * Low latency live streams:
+ *
+ * Low latency DASH streams signal with availabilityTimeOffset that their
+ * segments can be requested before they are complete. The server then
+ * delivers them with chunked transfer encoding as the encoder produces
+ * their CMAF chunks (moof + mdat pairs). The fragment waiting time and the
+ * live seek range take that offset into account. Since ISOBMFF data after
+ * the first mdat is pushed as soon as it is received, each chunk reaches
+ * downstream as soon as it is downloaded.
+ *
+ * Playback starts at the target latency of the ServiceDescription element,
+ * and the latency is then measured after each fragment as the difference
+ * between the live edge and the downstream position. As the playback rate
+ * is under the control of the application, the rate needed to come back to
+ * the target is computed here (with the same sigmoid as the reference
+ * dash.js player) but only posted in an element message.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -282,6 +312,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <math.h>
 #include <gio/gio.h>
 #include <gst/base/gsttypefindhelper.h>
 #include <gst/tag/tag.h>
@@ -340,6 +371,11 @@ enum
 #define DEFAULT_MAX_VIDEO_FRAMERATE_D     1
 #define DEFAULT_PRESENTATION_DELAY     "10s"    /* 10s */
 
+/* Live latency control */
+#define LIVE_LATENCY_MESSAGE_NAME "dash-live-latency"
+#define DEFAULT_LIVE_MIN_RATE            0.96
+#define DEFAULT_LIVE_MAX_RATE            1.04
+
 /* Clock drift compensation for live streams */
 #define SLOW_CLOCK_UPDATE_INTERVAL  (1000000 * 30 * 60) /* 30 minutes */
 #define FAST_CLOCK_UPDATE_INTERVAL  (1000000 * 30)      /* 30 seconds */
@@ -390,6 +426,8 @@ static gboolean
 gst_dash_demux_stream_advance_subfragment (GstAdaptiveDemuxStream * stream);
 static gboolean gst_dash_demux_stream_select_bitrate (GstAdaptiveDemuxStream *
     stream, guint64 bitrate);
+static gboolean gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream *
+    stream, GArray * bitrates, guint * current);
 static gint64 gst_dash_demux_get_manifest_update_interval (GstAdaptiveDemux *
     demux);
 static GstFlowReturn gst_dash_demux_update_manifest_data (GstAdaptiveDemux *
@@ -473,12 +511,14 @@ gst_dash_demux_get_live_seek_range (GstAdaptiveDemux * demux, gint64 * start,
   GDateTime *now;
   GDateTime *mstart;
   GTimeSpan stream_now;
-  GstClockTime seg_duration;
+  GstClockTime seg_duration, availability_offset;
 
   if (self->client->mpd_root_node->availabilityStartTime == NULL)
     return FALSE;
 
   seg_duration = gst_mpd_client_get_maximum_segment_duration (self->client);
+  availability_offset =
+      gst_mpd_client_get_availability_time_offset (self->client);
   now = gst_dash_demux_get_server_now_utc (self);
   mstart =
       gst_date_time_to_g_date_time (self->client->mpd_root_node->
@@ -509,9 +549,10 @@ gst_dash_demux_get_live_seek_range (GstAdaptiveDemux * demux, gint64 * start,
      * the MPD start time of the Media Segment, and
      * the MPD duration of the Media Segment.
      Therefore we need to subtract the media segment duration from the stop
-     time.
+     time. Low latency streams make their segments available earlier by
+     their availabilityTimeOffset.
    */
-  *stop -= seg_duration;
+  *stop -= seg_duration - MIN (seg_duration, availability_offset);
   return TRUE;
 }
 
@@ -637,6 +678,8 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
   gstadaptivedemux_class->stream_seek = gst_dash_demux_stream_seek;
   gstadaptivedemux_class->stream_select_bitrate =
       gst_dash_demux_stream_select_bitrate;
+  gstadaptivedemux_class->stream_get_bitrates =
+      gst_dash_demux_stream_get_bitrates;
   gstadaptivedemux_class->stream_update_fragment_info =
       gst_dash_demux_stream_update_fragment_info;
   gstadaptivedemux_class->stream_free = gst_dash_demux_stream_free;
@@ -667,6 +710,10 @@ gst_dash_demux_init (GstDashDemux * demux)
   demux->max_video_framerate_d = DEFAULT_MAX_VIDEO_FRAMERATE_D;
   demux->default_presentation_delay = g_strdup (DEFAULT_PRESENTATION_DELAY);
 
+  demux->live_target_latency = GST_CLOCK_TIME_NONE;
+  demux->live_min_rate = DEFAULT_LIVE_MIN_RATE;
+  demux->live_max_rate = DEFAULT_LIVE_MAX_RATE;
+
   g_mutex_init (&demux->client_lock);
 
   gst_adaptive_demux_set_stream_struct_size (GST_ADAPTIVE_DEMUX_CAST (demux),
@@ -941,7 +988,9 @@ gst_dash_demux_setup_streams (GstAdaptiveDemux * demux)
    * non-live */
   period_idx = 0;
   if (gst_mpd_client_is_live (dashdemux->client)) {
+    const GstMPDServiceDescriptionNode *service;
     GDateTime *g_now;
+    gint64 delay = 0;
     if (dashdemux->client->mpd_root_node->availabilityStartTime == NULL) {
       ret = FALSE;
       GST_ERROR_OBJECT (demux, "MPD does not have availabilityStartTime");
@@ -961,20 +1010,40 @@ gst_dash_demux_setup_streams (GstAdaptiveDemux * demux)
     /* get period index for period encompassing the current time */
     g_now = gst_dash_demux_get_server_now_utc (dashdemux);
     now = gst_date_time_new_from_g_date_time (g_now);
-    if (dashdemux->client->mpd_root_node->suggestedPresentationDelay != -1) {
-      GstDateTime *target = gst_mpd_client_add_time_difference (now,
-          dashdemux->client->mpd_root_node->suggestedPresentationDelay * -1000);
-      gst_date_time_unref (now);
-      now = target;
+    /* The latency target of the service description is meant for the
+     * player, so it takes precedence over the suggested presentation delay */
+    service = gst_mpd_client_get_service_description (dashdemux->client);
+    if (service && service->latency_target) {
+      delay = service->latency_target;
+    } else if (dashdemux->client->mpd_root_node->suggestedPresentationDelay !=
+        -1) {
+      delay = dashdemux->client->mpd_root_node->suggestedPresentationDelay;
     } else if (dashdemux->default_presentation_delay) {
-      gint64 dfp =
+      delay =
           gst_mpd_client_parse_default_presentation_delay (dashdemux->client,
           dashdemux->default_presentation_delay);
+    }
+    if (delay > 0) {
       GstDateTime *target = gst_mpd_client_add_time_difference (now,
-          dfp * -1000);
+          delay * -1000);
       gst_date_time_unref (now);
       now = target;
     }
+
+    /* without a target there is no latency to catch up with */
+    dashdemux->live_target_latency =
+        delay > 0 ? delay * GST_MSECOND : GST_CLOCK_TIME_NONE;
+    dashdemux->live_min_rate = DEFAULT_LIVE_MIN_RATE;
+    dashdemux->live_max_rate = DEFAULT_LIVE_MAX_RATE;
+    if (service && service->playback_rate_min > 0
+        && service->playback_rate_min <= 1.0)
+      dashdemux->live_min_rate = service->playback_rate_min;
+    if (service && service->playback_rate_max >= 1.0)
+      dashdemux->live_max_rate = service->playback_rate_max;
+    GST_DEBUG_OBJECT (demux, "Live target latency %" GST_TIME_FORMAT
+        ", playback rate between %lf and %lf",
+        GST_TIME_ARGS (dashdemux->live_target_latency),
+        dashdemux->live_min_rate, dashdemux->live_max_rate);
     period_idx =
         gst_mpd_client_get_period_index_at_time (dashdemux->client, now);
     if (period_idx == G_MAXUINT) {
@@ -1125,6 +1194,10 @@ gst_dash_demux_reset (GstAdaptiveDemux * ademux)
 
   demux->trickmode_no_audio = FALSE;
   demux->allow_trickmode_key_units = TRUE;
+
+  demux->live_target_latency = GST_CLOCK_TIME_NONE;
+  demux->live_min_rate = DEFAULT_LIVE_MIN_RATE;
+  demux->live_max_rate = DEFAULT_LIVE_MAX_RATE;
 }
 
 static GstCaps *
@@ -1971,6 +2044,53 @@ out:
   return ret;
 }
 
+static void
+gst_dash_demux_post_live_latency (GstDashDemux * dashdemux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemux *demux = GST_ADAPTIVE_DEMUX_CAST (dashdemux);
+  GDateTime *now, *mstart;
+  GstClockTime stream_now, latency;
+  gdouble rate;
+  gint64 pos;
+
+  if (!gst_mpd_client_is_live (dashdemux->client)
+      || demux->segment.rate != 1.0
+      || dashdemux->client->mpd_root_node->availabilityStartTime == NULL
+      || !GST_CLOCK_TIME_IS_VALID (dashdemux->live_target_latency))
+    return;
+
+  if (!gst_pad_peer_query_position (stream->pad, GST_FORMAT_TIME, &pos)
+      || pos < 0)
+    return;
+
+  now = gst_dash_demux_get_server_now_utc (dashdemux);
+  mstart =
+      gst_date_time_to_g_date_time (dashdemux->client->mpd_root_node->
+      availabilityStartTime);
+  stream_now = MAX (g_date_time_difference (now, mstart), 0) * GST_USECOND;
+  g_date_time_unref (now);
+  g_date_time_unref (mstart);
+
+  /* The downstream position is a stream time, which for live streams starts
+   * at the availability start time like the live seek range */
+  latency = stream_now > pos ? stream_now - pos : 0;
+  rate = gst_mpd_helper_get_catch_up_rate (GST_CLOCK_DIFF
+      (dashdemux->live_target_latency, latency), dashdemux->live_min_rate,
+      dashdemux->live_max_rate);
+
+  GST_LOG_OBJECT (dashdemux, "Live latency %" GST_TIME_FORMAT ", target %"
+      GST_TIME_FORMAT ", suggested rate %lf", GST_TIME_ARGS (latency),
+      GST_TIME_ARGS (dashdemux->live_target_latency), rate);
+
+  gst_element_post_message (GST_ELEMENT_CAST (dashdemux),
+      gst_message_new_element (GST_OBJECT_CAST (dashdemux),
+          gst_structure_new (LIVE_LATENCY_MESSAGE_NAME,
+              "latency", G_TYPE_UINT64, latency,
+              "target-latency", G_TYPE_UINT64, dashdemux->live_target_latency,
+              "playback-rate", G_TYPE_DOUBLE, rate, NULL)));
+}
+
 static GstFlowReturn
 gst_dash_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream)
 {
@@ -1982,6 +2102,9 @@ gst_dash_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream)
 
   GST_DEBUG_OBJECT (stream->pad, "Advance fragment");
 
+  if (stream->demux->streams && stream == stream->demux->streams->data)
+    gst_dash_demux_post_live_latency (dashdemux, stream);
+
   /* Update download statistics */
   if (dashstream->moof_sync_samples &&
       GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (dashdemux) &&
@@ -2161,6 +2284,105 @@ gst_dash_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream)
   return ret;
 }
 
+static gint
+gst_dash_demux_compare_representations (gconstpointer a, gconstpointer b)
+{
+  const GstMPDRepresentationNode *rep_a =
+      *(const GstMPDRepresentationNode **) a;
+  const GstMPDRepresentationNode *rep_b =
+      *(const GstMPDRepresentationNode **) b;
+
+  return rep_a->bandwidth < rep_b->bandwidth ? -1 :
+      (rep_a->bandwidth > rep_b->bandwidth ? 1 : 0);
+}
+
+/* Lists the representations gst_dash_demux_stream_select_bitrate() can pick,
+ * that is the ones it selects when given their own bandwidth under the
+ * max-bitrate and max-video-* constraints */
+static gboolean
+gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream * stream,
+    GArray * bitrates, guint * current)
+{
+  GstDashDemux *demux = GST_DASH_DEMUX_CAST (stream->demux);
+  GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
+  GstActiveStream *active_stream = dashstream->active_stream;
+  GstMPDRepresentationNode *cur_rep;
+  GPtrArray *reps;
+  GList *rep_list, *list;
+  gboolean found = FALSE;
+  guint i;
+
+  if (active_stream == NULL || active_stream->cur_adapt_set == NULL
+      || active_stream->cur_representation == NULL)
+    return FALSE;
+
+  /* select_bitrate doesn't switch in key-frame trick mode */
+  if (GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (stream->demux))
+    return FALSE;
+
+  rep_list = active_stream->cur_adapt_set->Representations;
+  cur_rep = active_stream->cur_representation;
+  reps = g_ptr_array_new ();
+
+  for (list = rep_list; list; list = g_list_next (list)) {
+    GstMPDRepresentationNode *rep = list->data;
+
+    if (rep == NULL)
+      continue;
+
+    if (active_stream->mimeType == GST_STREAM_VIDEO && demux->max_bitrate &&
+        rep->bandwidth > demux->max_bitrate)
+      continue;
+
+    /* filtered out by the video constraints, or shadowed by another
+     * representation of the same bandwidth */
+    if (gst_mpd_client_get_rep_idx_with_max_bandwidth (rep_list,
+            rep->bandwidth, demux->max_video_width, demux->max_video_height,
+            demux->max_video_framerate_n, demux->max_video_framerate_d) !=
+        g_list_position (rep_list, list))
+      continue;
+
+    g_ptr_array_add (reps, rep);
+  }
+
+  /* select_bitrate falls back to the lowest representation */
+  if (reps->len == 0) {
+    gint idx = gst_mpd_client_get_rep_idx_with_min_bandwidth (rep_list);
+
+    if (idx >= 0)
+      g_ptr_array_add (reps, g_list_nth_data (rep_list, idx));
+  }
+
+  if (reps->len == 0) {
+    g_ptr_array_free (reps, TRUE);
+    return FALSE;
+  }
+
+  /* representations are in manifest order */
+  g_ptr_array_sort (reps, gst_dash_demux_compare_representations);
+
+  *current = 0;
+  for (i = 0; i < reps->len; i++) {
+    GstMPDRepresentationNode *rep = g_ptr_array_index (reps, i);
+    guint64 bandwidth = rep->bandwidth;
+
+    g_array_append_val (bitrates, bandwidth);
+
+    /* the current representation may not be allowed anymore, report the
+     * highest one below it then */
+    if (rep == cur_rep) {
+      *current = i;
+      found = TRUE;
+    } else if (!found && rep->bandwidth <= cur_rep->bandwidth) {
+      *current = i;
+    }
+  }
+
+  g_ptr_array_free (reps, TRUE);
+
+  return TRUE;
+}
+
 static gboolean
 gst_dash_demux_stream_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate)
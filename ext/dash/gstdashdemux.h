@@ -146,6 +146,11 @@ struct _GstDashDemux
 
   gboolean trickmode_no_audio;
   gboolean allow_trickmode_key_units;
+
+  /* Live latency the playback started at and should be kept at, with the
+   * playback rate bounds used to catch up */
+  GstClockTime live_target_latency;
+  gdouble live_min_rate, live_max_rate;
 };
 
 struct _GstDashDemuxClass
@@ -828,12 +828,21 @@ gst_mpd_client_stream_update_presentation_time_offset (GstMPDClient * client,
     stream->presentationTimeOffset =
         gst_util_uint64_scale (segbase->presentationTimeOffset, GST_SECOND,
         segbase->timescale);
+    /* availabilityTimeOffset="INF" parses as infinity */
+    if (segbase->availabilityTimeOffset >= G_MAXUINT64 / GST_SECOND)
+      stream->availabilityTimeOffset = GST_CLOCK_TIME_NONE;
+    else
+      stream->availabilityTimeOffset =
+          segbase->availabilityTimeOffset * GST_SECOND;
   } else {
     stream->presentationTimeOffset = 0;
+    stream->availabilityTimeOffset = 0;
   }
 
-  GST_LOG ("Setting stream's presentation time offset to %" GST_TIME_FORMAT,
-      GST_TIME_ARGS (stream->presentationTimeOffset));
+  GST_LOG ("Setting stream's presentation time offset to %" GST_TIME_FORMAT
+      ", availability time offset to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (stream->presentationTimeOffset),
+      GST_TIME_ARGS (stream->availabilityTimeOffset));
 }
 
 gboolean
@@ -1975,6 +1984,42 @@ gst_mpd_client_get_utc_timing_sources (GstMPDClient * client,
   return NULL;
 }
 
+/* Returns the first ServiceDescription element of the MPD, or NULL */
+const GstMPDServiceDescriptionNode *
+gst_mpd_client_get_service_description (GstMPDClient * client)
+{
+  g_return_val_if_fail (client != NULL, NULL);
+  g_return_val_if_fail (client->mpd_root_node != NULL, NULL);
+
+  if (client->mpd_root_node->ServiceDescriptions == NULL)
+    return NULL;
+
+  return client->mpd_root_node->ServiceDescriptions->data;
+}
+
+/* Returns the smallest availability time offset of the active streams,
+ * that is how much earlier than their end the segments of all streams can
+ * be requested, GST_CLOCK_TIME_NONE if they are always available */
+GstClockTime
+gst_mpd_client_get_availability_time_offset (GstMPDClient * client)
+{
+  GstClockTime offset = GST_CLOCK_TIME_NONE;
+  GList *list;
+
+  g_return_val_if_fail (client != NULL, 0);
+
+  if (client->active_streams == NULL)
+    return 0;
+
+  for (list = client->active_streams; list; list = g_list_next (list)) {
+    GstActiveStream *stream = list->data;
+
+    offset = MIN (offset, stream->availabilityTimeOffset);
+  }
+
+  return offset;
+}
+
 
 gboolean
 gst_mpd_client_get_next_fragment (GstMPDClient * client,
@@ -2948,6 +2993,11 @@ gst_mpd_client_get_next_segment_availability_start_time (GstMPDClient * client,
     segmentEndTime = period_start + (1 + seg_idx) * seg_duration;
   }
 
+  /* Low latency streams announce segments before they are complete, they
+   * can be requested that much earlier and are then delivered as they are
+   * produced */
+  segmentEndTime -= MIN (segmentEndTime, stream->availabilityTimeOffset);
+
   availability_start_time = gst_mpd_client_get_availability_start_time (client);
   if (availability_start_time == NULL) {
     GST_WARNING_OBJECT (client, "Failed to get availability_start_time");
@@ -85,6 +85,8 @@ gboolean gst_mpd_client_stream_seek (GstMPDClient * client, GstActiveStream * st
 gboolean gst_mpd_client_seek_to_time (GstMPDClient * client, GDateTime * time);
 GstClockTime gst_mpd_client_get_stream_presentation_offset (GstMPDClient *client, guint stream_idx);
 gchar** gst_mpd_client_get_utc_timing_sources (GstMPDClient *client, guint methods, GstMPDUTCTimingType *selected_method);
+const GstMPDServiceDescriptionNode *gst_mpd_client_get_service_description (GstMPDClient *client);
+GstClockTime gst_mpd_client_get_availability_time_offset (GstMPDClient *client);
 GstClockTime gst_mpd_client_get_period_start_time (GstMPDClient *client);
 
 /* Period selection */
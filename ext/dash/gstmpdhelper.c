@@ -22,6 +22,10 @@
 #include "gstmpdhelper.h"
 #include "gstmpdbaseurlnode.h"
 
+#include <math.h>
+
+#define LIVE_LATENCY_TOLERANCE (50 * GST_MSECOND)
+
 gboolean
 gst_mpd_helper_get_mpd_type (xmlNode * a_node,
     const gchar * property_name, GstMPDFileType * property_value)
@@ -183,6 +187,25 @@ gst_mpd_helper_combine_urls (GstUri * base, GList * list, gchar ** query,
   return ret;
 }
 
+/* Playback rate bringing the live latency back to the target latency,
+ * @deviation being the latency minus the target. Same curve as the default
+ * catch-up mode of dash.js: a sigmoid going from @min_rate to @max_rate */
+gdouble
+gst_mpd_helper_get_catch_up_rate (GstClockTimeDiff deviation,
+    gdouble min_rate, gdouble max_rate)
+{
+  gdouble d, max_change, rate;
+
+  if (ABS (deviation) <= LIVE_LATENCY_TOLERANCE)
+    return 1.0;
+
+  d = (gdouble) deviation / GST_SECOND;
+  max_change = d > 0 ? max_rate - 1.0 : 1.0 - min_rate;
+  rate = 1.0 - max_change + 2 * max_change / (1.0 + exp (-5.0 * d));
+
+  return CLAMP (rate, min_rate, max_rate);
+}
+
 /* comparison functions */
 int
 gst_mpd_helper_strncmp_ext (const char *s1, const char *s2)
@@ -65,6 +65,7 @@ const gchar * gst_mpd_helper_get_video_codec_from_mime (GstCaps * caps);
 const gchar * gst_mpd_helper_get_audio_codec_from_mime (GstCaps * caps);
 GstUri *gst_mpd_helper_combine_urls (GstUri * base, GList * list, gchar ** query, guint idx);
 int gst_mpd_helper_strncmp_ext (const char *s1, const char *s2);
+gdouble gst_mpd_helper_get_catch_up_rate (GstClockTimeDiff deviation, gdouble min_rate, gdouble max_rate);
 
 G_END_DECLS
 #endif /* __GST_MPDHELPER_H__ */
@@ -78,6 +78,8 @@ static gboolean gst_mpdparser_parse_root_node (GstMPDRootNode ** pointer,
     xmlNode * a_node);
 static void gst_mpdparser_parse_utctiming_node (GList ** list,
     xmlNode * a_node);
+static void gst_mpdparser_parse_service_description_node (GList ** list,
+    xmlNode * a_node);
 
 /*
   Duration Data Type
@@ -254,6 +256,7 @@ gst_mpdparser_parse_seg_base_type_ext (GstMPDSegmentBaseNode ** pointer,
   guint intval;
   guint64 int64val;
   gboolean boolval;
+  gdouble doubleval;
   GstXMLRange *rangeval;
 
   gst_mpd_segment_base_node_free (*pointer);
@@ -262,6 +265,7 @@ gst_mpdparser_parse_seg_base_type_ext (GstMPDSegmentBaseNode ** pointer,
   /* Initialize values that have defaults */
   seg_base_type->indexRangeExact = FALSE;
   seg_base_type->timescale = 1;
+  seg_base_type->availabilityTimeComplete = TRUE;
 
   /* Inherit attribute values from parent */
   if (parent) {
@@ -269,6 +273,9 @@ gst_mpdparser_parse_seg_base_type_ext (GstMPDSegmentBaseNode ** pointer,
     seg_base_type->presentationTimeOffset = parent->presentationTimeOffset;
     seg_base_type->indexRange = gst_xml_helper_clone_range (parent->indexRange);
     seg_base_type->indexRangeExact = parent->indexRangeExact;
+    seg_base_type->availabilityTimeOffset = parent->availabilityTimeOffset;
+    seg_base_type->availabilityTimeComplete =
+        parent->availabilityTimeComplete;
     seg_base_type->Initialization =
         gst_mpd_url_type_node_clone (parent->Initialization);
     seg_base_type->RepresentationIndex =
@@ -296,6 +303,17 @@ gst_mpdparser_parse_seg_base_type_ext (GstMPDSegmentBaseNode ** pointer,
           FALSE, &boolval)) {
     seg_base_type->indexRangeExact = boolval;
   }
+  if (gst_xml_helper_get_prop_double (a_node, "availabilityTimeOffset",
+          &doubleval)) {
+    if (doubleval >= 0)
+      seg_base_type->availabilityTimeOffset = doubleval;
+    else
+      GST_WARNING ("ignoring negative availabilityTimeOffset %lf", doubleval);
+  }
+  if (gst_xml_helper_get_prop_boolean (a_node, "availabilityTimeComplete",
+          TRUE, &boolval)) {
+    seg_base_type->availabilityTimeComplete = boolval;
+  }
 
   /* explore children nodes */
   for (cur_node = a_node->children; cur_node; cur_node = cur_node->next) {
@@ -1031,6 +1049,43 @@ gst_mpdparser_parse_utctiming_node (GList ** list, xmlNode * a_node)
   }
 }
 
+/* The ServiceDescription element is defined in ISO/IEC 23009-1 Annex K,
+ * only its Latency and PlaybackRate children are used */
+static void
+gst_mpdparser_parse_service_description_node (GList ** list, xmlNode * a_node)
+{
+  GstMPDServiceDescriptionNode *new_description;
+  xmlNode *cur_node;
+
+  new_description = gst_mpd_service_description_node_new ();
+  *list = g_list_append (*list, new_description);
+
+  GST_LOG ("attributes of ServiceDescription node:");
+  gst_xml_helper_get_prop_unsigned_integer (a_node, "id", 0,
+      &new_description->id);
+
+  for (cur_node = a_node->children; cur_node; cur_node = cur_node->next) {
+    if (cur_node->type != XML_ELEMENT_NODE)
+      continue;
+
+    if (xmlStrcmp (cur_node->name, (xmlChar *) "Latency") == 0) {
+      GST_LOG ("attributes of Latency node:");
+      gst_xml_helper_get_prop_unsigned_integer (cur_node, "target", 0,
+          &new_description->latency_target);
+      gst_xml_helper_get_prop_unsigned_integer (cur_node, "min", 0,
+          &new_description->latency_min);
+      gst_xml_helper_get_prop_unsigned_integer (cur_node, "max", 0,
+          &new_description->latency_max);
+    } else if (xmlStrcmp (cur_node->name, (xmlChar *) "PlaybackRate") == 0) {
+      GST_LOG ("attributes of PlaybackRate node:");
+      gst_xml_helper_get_prop_double (cur_node, "min",
+          &new_description->playback_rate_min);
+      gst_xml_helper_get_prop_double (cur_node, "max",
+          &new_description->playback_rate_max);
+    }
+  }
+}
+
 static gboolean
 gst_mpdparser_parse_root_node (GstMPDRootNode ** pointer, xmlNode * a_node)
 {
@@ -1093,6 +1148,10 @@ gst_mpdparser_parse_root_node (GstMPDRootNode ** pointer, xmlNode * a_node)
       } else if (xmlStrcmp (cur_node->name, (xmlChar *) "UTCTiming") == 0) {
         gst_mpdparser_parse_utctiming_node (&new_mpd_root->UTCTimings,
             cur_node);
+      } else if (xmlStrcmp (cur_node->name,
+              (xmlChar *) "ServiceDescription") == 0) {
+        gst_mpdparser_parse_service_description_node
+            (&new_mpd_root->ServiceDescriptions, cur_node);
       }
     }
   }
@@ -35,6 +35,7 @@
 #include "gstmpdrootnode.h"
 #include "gstmpdbaseurlnode.h"
 #include "gstmpdutctimingnode.h"
+#include "gstmpdservicedescriptionnode.h"
 #include "gstmpdmetricsnode.h"
 #include "gstmpdmetricsrangenode.h"
 #include "gstmpdsnode.h"
@@ -143,6 +144,7 @@ struct _GstActiveStream
   guint segment_repeat_index;                 /* index of the repeat count of a segment */
   GPtrArray *segments;                        /* array of GstMediaSegment */
   GstClockTime presentationTimeOffset;        /* presentation time offset of the current segment */
+  GstClockTime availabilityTimeOffset;        /* how much earlier than their end segments can be requested, GST_CLOCK_TIME_NONE if always available */
 };
 
 /* MPD file parsing */
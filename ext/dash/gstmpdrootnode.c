@@ -189,6 +189,8 @@ gst_mpd_root_node_finalize (GObject * object)
   g_list_free_full (self->Metrics, (GDestroyNotify) gst_mpd_metrics_node_free);
   g_list_free_full (self->UTCTimings,
       (GDestroyNotify) gst_mpd_utctiming_node_free);
+  g_list_free_full (self->ServiceDescriptions,
+      (GDestroyNotify) gst_mpd_service_description_node_free);
 
 
   G_OBJECT_CLASS (gst_mpd_root_node_parent_class)->finalize (object);
@@ -258,6 +260,8 @@ gst_mpd_root_get_xml_node (GstMPDNode * node)
   g_list_foreach (self->Periods, gst_mpd_node_get_list_item, root_xml_node);
   g_list_foreach (self->Metrics, gst_mpd_node_get_list_item, root_xml_node);
   g_list_foreach (self->UTCTimings, gst_mpd_node_get_list_item, root_xml_node);
+  g_list_foreach (self->ServiceDescriptions, gst_mpd_node_get_list_item,
+      root_xml_node);
 
   return root_xml_node;
 }
@@ -389,6 +393,8 @@ gst_mpd_root_node_init (GstMPDRootNode * self)
   self->Metrics = NULL;
   /* list of GstUTCTimingNode nodes */
   self->UTCTimings = NULL;
+  /* list of GstMPDServiceDescriptionNode nodes */
+  self->ServiceDescriptions = NULL;
 }
 
 GstMPDRootNode *
@@ -37,6 +37,8 @@ struct _GstMPDSegmentBaseNode
   guint64 presentationTimeOffset;
   GstXMLRange *indexRange;
   gboolean indexRangeExact;
+  gdouble availabilityTimeOffset;     /* [s], INFINITY if always available */
+  gboolean availabilityTimeComplete;
   /* Initialization node */
   GstMPDURLTypeNode *Initialization;
   /* RepresentationIndex node */
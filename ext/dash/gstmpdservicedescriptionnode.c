@@ -0,0 +1,97 @@
+/* GStreamer
+ *
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+#include "gstmpdservicedescriptionnode.h"
+#include "gstmpdparser.h"
+
+G_DEFINE_TYPE (GstMPDServiceDescriptionNode, gst_mpd_service_description_node,
+    GST_TYPE_MPD_NODE);
+
+/* Base class */
+
+static xmlNodePtr
+gst_mpd_service_description_get_xml_node (GstMPDNode * node)
+{
+  xmlNodePtr service_description_xml_node = NULL;
+  xmlNodePtr child;
+  GstMPDServiceDescriptionNode *self = GST_MPD_SERVICE_DESCRIPTION_NODE (node);
+
+  service_description_xml_node =
+      xmlNewNode (NULL, (xmlChar *) "ServiceDescription");
+
+  gst_xml_helper_set_prop_uint (service_description_xml_node, "id", self->id);
+
+  if (self->latency_target || self->latency_min || self->latency_max) {
+    child = xmlNewNode (NULL, (xmlChar *) "Latency");
+    if (self->latency_target)
+      gst_xml_helper_set_prop_uint (child, "target", self->latency_target);
+    if (self->latency_min)
+      gst_xml_helper_set_prop_uint (child, "min", self->latency_min);
+    if (self->latency_max)
+      gst_xml_helper_set_prop_uint (child, "max", self->latency_max);
+    xmlAddChild (service_description_xml_node, child);
+  }
+
+  if (self->playback_rate_min > 0 || self->playback_rate_max > 0) {
+    child = xmlNewNode (NULL, (xmlChar *) "PlaybackRate");
+    if (self->playback_rate_min > 0)
+      gst_xml_helper_set_prop_double (child, "min", self->playback_rate_min);
+    if (self->playback_rate_max > 0)
+      gst_xml_helper_set_prop_double (child, "max", self->playback_rate_max);
+    xmlAddChild (service_description_xml_node, child);
+  }
+
+  return service_description_xml_node;
+}
+
+static void
+gst_mpd_service_description_node_class_init (GstMPDServiceDescriptionNodeClass
+    * klass)
+{
+  GstMPDNodeClass *m_klass;
+
+  m_klass = GST_MPD_NODE_CLASS (klass);
+
+  m_klass->get_xml_node = gst_mpd_service_description_get_xml_node;
+}
+
+static void
+gst_mpd_service_description_node_init (GstMPDServiceDescriptionNode * self)
+{
+  self->id = 0;
+  self->latency_target = 0;
+  self->latency_min = 0;
+  self->latency_max = 0;
+  self->playback_rate_min = 0;
+  self->playback_rate_max = 0;
+}
+
+GstMPDServiceDescriptionNode *
+gst_mpd_service_description_node_new (void)
+{
+  return g_object_new (GST_TYPE_MPD_SERVICE_DESCRIPTION_NODE, NULL);
+}
+
+void
+gst_mpd_service_description_node_free (GstMPDServiceDescriptionNode * self)
+{
+  if (self)
+    gst_object_unref (self);
+}
@@ -73,6 +73,12 @@ static gboolean gst_hls_demux_update_playlist (GstHLSDemux * demux,
     gboolean update, GError ** err);
 static gchar *gst_hls_src_buf_to_utf8_playlist (GstBuffer * buf);
 
+static gboolean gst_hls_demux_update_m3u8 (GstHLSDemux * demux,
+    GstM3U8 * m3u8, GstFragment * download, const gchar * name,
+    gboolean with_directives, GError ** err);
+static gboolean gst_hls_demux_update_renditions (GstHLSDemux * demux,
+    GError ** err);
+
 /* FIXME: the return value is never used? */
 static gboolean gst_hls_demux_change_playlist (GstHLSDemux * demux,
     guint max_bitrate, gboolean * changed);
@@ -90,6 +96,11 @@ static gint64 gst_hls_demux_get_manifest_update_interval (GstAdaptiveDemux *
 static gboolean gst_hls_demux_process_manifest (GstAdaptiveDemux * demux,
     GstBuffer * buf);
 static GstFlowReturn gst_hls_demux_update_manifest (GstAdaptiveDemux * demux);
+static gchar *gst_hls_demux_get_blocking_manifest_update_uri (GstAdaptiveDemux *
+    demux);
+static GstFlowReturn
+gst_hls_demux_update_manifest_from_download (GstAdaptiveDemux * demux,
+    GstFragment * download);
 static gboolean gst_hls_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek);
 static GstFlowReturn gst_hls_demux_stream_seek (GstAdaptiveDemuxStream *
     stream, gboolean forward, GstSeekFlags flags, GstClockTime ts,
@@ -108,8 +119,12 @@ static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
+static gboolean gst_hls_demux_peek_fragment_info (GstAdaptiveDemuxStream *
+    stream, guint index, GstAdaptiveDemuxStreamFragment * fragment);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
+static gboolean gst_hls_demux_get_bitrates (GstAdaptiveDemuxStream * stream,
+    GArray * bitrates, guint * current);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
 static gboolean gst_hls_demux_get_live_seek_range (GstAdaptiveDemux * demux,
     gint64 * start, gint64 * stop);
@@ -167,6 +182,10 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
       gst_hls_demux_get_manifest_update_interval;
   adaptivedemux_class->process_manifest = gst_hls_demux_process_manifest;
   adaptivedemux_class->update_manifest = gst_hls_demux_update_manifest;
+  adaptivedemux_class->get_blocking_manifest_update_uri =
+      gst_hls_demux_get_blocking_manifest_update_uri;
+  adaptivedemux_class->update_manifest_from_download =
+      gst_hls_demux_update_manifest_from_download;
   adaptivedemux_class->reset = gst_hls_demux_reset;
   adaptivedemux_class->seek = gst_hls_demux_seek;
   adaptivedemux_class->stream_seek = gst_hls_demux_stream_seek;
@@ -175,7 +194,10 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment_info =
+      gst_hls_demux_peek_fragment_info;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
+  adaptivedemux_class->stream_get_bitrates = gst_hls_demux_get_bitrates;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
   adaptivedemux_class->start_fragment = gst_hls_demux_start_fragment;
@@ -402,15 +424,15 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
     GstSeekFlags flags, GstClockTime ts, GstClockTime * final_ts)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
-  GList *walk;
+  GstM3U8 *playlist = hls_stream->playlist;
   GstClockTime current_pos;
   gint64 current_sequence;
   gboolean snap_after, snap_nearest;
   GstM3U8MediaFile *file = NULL;
+  guint index;
 
   current_sequence = 0;
-  current_pos = gst_m3u8_is_live (hls_stream->playlist) ?
-      hls_stream->playlist->first_file_start : 0;
+  current_pos = gst_m3u8_is_live (playlist) ? playlist->first_file_start : 0;
 
   /* Snap to segment boundary. Improves seek performance on slow machines. */
   snap_nearest =
@@ -419,40 +441,40 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
 
   GST_M3U8_CLIENT_LOCK (hlsdemux->client);
   /* FIXME: Here we need proper discont handling */
-  for (walk = hls_stream->playlist->files; walk; walk = walk->next) {
-    file = walk->data;
+  index = gst_m3u8_find_fragment_index (playlist, ts);
+  if (index < playlist->files->len) {
+    file = g_ptr_array_index (playlist->files, index);
 
-    current_sequence = file->sequence;
     if ((forward && snap_after) || snap_nearest) {
-      if (current_pos >= ts)
-        break;
-      if (snap_nearest && ts - current_pos < file->duration / 2)
-        break;
+      /* snap to the start of the next fragment, unless the nearest one is
+       * the start of the fragment containing ts */
+      if (ts > file->start && (!snap_nearest
+              || ts - file->start >= file->duration / 2))
+        index++;
     } else if (!forward && snap_after) {
-      /* check if the next fragment is our target, in this case we want to
-       * start from the previous fragment */
-      GstClockTime next_pos = current_pos + file->duration;
-
-      if (next_pos <= ts && ts < next_pos + file->duration) {
-        break;
-      }
-    } else if (current_pos <= ts && ts < current_pos + file->duration) {
-      break;
+      /* the fragment before the target one ends at the target's start */
+      if (index > 0)
+        index--;
     }
-    current_pos += file->duration;
   }
 
-  if (walk == NULL) {
+  if (index < playlist->files->len) {
+    file = g_ptr_array_index (playlist->files, index);
+    current_sequence = file->sequence;
+    current_pos = file->start;
+  } else if (playlist->files->len > 0) {
     GST_DEBUG_OBJECT (stream->pad, "seeking further than track duration");
-    current_sequence++;
+    file = g_ptr_array_index (playlist->files, playlist->files->len - 1);
+    current_sequence = file->sequence + 1;
+    current_pos = file->start + file->duration;
   }
 
   GST_DEBUG_OBJECT (stream->pad, "seeking to sequence %u",
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
-  hls_stream->playlist->sequence = current_sequence;
-  hls_stream->playlist->current_file = walk;
-  hls_stream->playlist->sequence_position = current_pos;
+  playlist->sequence = current_sequence;
+  playlist->part_index = -1;
+  playlist->sequence_position = current_pos;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
 
   /* Play from the end of the current selected segment */
@@ -480,6 +502,56 @@ gst_hls_demux_update_manifest (GstAdaptiveDemux * demux)
   return GST_FLOW_OK;
 }
 
+static gchar *
+gst_hls_demux_get_blocking_manifest_update_uri (GstAdaptiveDemux * demux)
+{
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
+  GstM3U8 *m3u8;
+  gchar *uri;
+
+  if (hlsdemux->current_variant == NULL)
+    return NULL;
+
+  m3u8 = hlsdemux->current_variant->m3u8;
+  uri = gst_m3u8_get_blocking_reload_uri (m3u8);
+  if (uri == NULL)
+    return NULL;
+
+  /* the variant can change while waiting for the answer */
+  if (hlsdemux->reload_m3u8)
+    gst_m3u8_unref (hlsdemux->reload_m3u8);
+  hlsdemux->reload_m3u8 = gst_m3u8_ref (m3u8);
+
+  return uri;
+}
+
+static GstFlowReturn
+gst_hls_demux_update_manifest_from_download (GstAdaptiveDemux * demux,
+    GstFragment * download)
+{
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
+  GstHLSVariantStream *variant = hlsdemux->current_variant;
+  GstM3U8 *m3u8 = hlsdemux->reload_m3u8;
+  gboolean ret;
+
+  hlsdemux->reload_m3u8 = NULL;
+  if (m3u8 == NULL || variant == NULL)
+    return GST_FLOW_ERROR;
+
+  if (variant->m3u8 != m3u8) {
+    GST_DEBUG_OBJECT (demux, "Dropping reload of the previous variant");
+    gst_m3u8_unref (m3u8);
+    return GST_FLOW_OK;
+  }
+  gst_m3u8_unref (m3u8);
+
+  ret = gst_hls_demux_update_m3u8 (hlsdemux, variant->m3u8, download,
+      variant->name, TRUE, NULL)
+      && gst_hls_demux_update_renditions (hlsdemux, NULL);
+
+  return ret ? GST_FLOW_OK : GST_FLOW_ERROR;
+}
+
 static void
 create_stream_for_playlist (GstAdaptiveDemux * demux, GstM3U8 * playlist,
     gboolean is_primary_playlist, gboolean selected)
@@ -573,10 +645,13 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
     variant->m3u8->sequence_position =
         hlsdemux->current_variant->m3u8->sequence_position;
     variant->m3u8->sequence = hlsdemux->current_variant->m3u8->sequence;
+    /* low-latency variants are expected to have aligned parts */
+    variant->m3u8->part_index = hlsdemux->current_variant->m3u8->part_index;
 
     GST_DEBUG_OBJECT (hlsdemux,
         "Switching Variant. Copying over sequence %" G_GINT64_FORMAT
-        " and sequence_pos %" GST_TIME_FORMAT, variant->m3u8->sequence,
+        ", part %d and sequence_pos %" GST_TIME_FORMAT,
+        variant->m3u8->sequence, variant->m3u8->part_index,
         GST_TIME_ARGS (variant->m3u8->sequence_position));
 
     for (i = 0; i < GST_HLS_N_MEDIA_TYPES; ++i) {
@@ -589,6 +664,7 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
 
         if (new_media) {
           new_media->playlist->sequence = old_media->playlist->sequence;
+          new_media->playlist->part_index = old_media->playlist->part_index;
           new_media->playlist->sequence_position =
               old_media->playlist->sequence_position;
         }
@@ -1147,6 +1223,32 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_hls_demux_peek_fragment_info (GstAdaptiveDemuxStream * stream,
+    guint index, GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (GST_HLS_DEMUX_STREAM_CAST (stream));
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0, index);
+  if (file == NULL)
+    return FALSE;
+
+  fragment->uri = g_strdup (file->uri);
+  fragment->range_start = file->offset;
+  if (file->size != -1)
+    fragment->range_end = file->offset + file->size - 1;
+  else
+    fragment->range_end = -1;
+  fragment->duration = file->duration;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1176,6 +1278,38 @@ gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
   return changed;
 }
 
+static gboolean
+gst_hls_demux_get_bitrates (GstAdaptiveDemuxStream * stream,
+    GArray * bitrates, guint * current)
+{
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (stream->demux);
+  GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GList *l;
+
+  /* like in select_bitrate, only the primary stream switches variants */
+  if (hlsdemux->master == NULL || hlsdemux->master->is_simple
+      || hlsdemux->current_variant == NULL
+      || hls_stream->is_primary_playlist == FALSE)
+    return FALSE;
+
+  /* variant lists are sorted low to high */
+  if (hlsdemux->current_variant->iframe)
+    l = hlsdemux->master->iframe_variants;
+  else
+    l = hlsdemux->master->variants;
+
+  for (; l != NULL; l = l->next) {
+    GstHLSVariantStream *variant = l->data;
+    guint64 bandwidth = variant->bandwidth;
+
+    if (variant == hlsdemux->current_variant)
+      *current = bitrates->len;
+    g_array_append_val (bitrates, bandwidth);
+  }
+
+  return TRUE;
+}
+
 static void
 gst_hls_demux_reset (GstAdaptiveDemux * ademux)
 {
@@ -1192,6 +1326,10 @@ gst_hls_demux_reset (GstAdaptiveDemux * ademux)
     gst_hls_variant_stream_unref (demux->current_variant);
     demux->current_variant = NULL;
   }
+  if (demux->reload_m3u8 != NULL) {
+    gst_m3u8_unref (demux->reload_m3u8);
+    demux->reload_m3u8 = NULL;
+  }
   demux->srcpad_counter = 0;
 
   gst_hls_demux_clear_all_pending_data (demux);
@@ -1287,6 +1425,7 @@ gst_hls_demux_update_variant_playlist (GstHLSDemux * hlsdemux, gchar * data,
       /* FIXME: Deal with losing position due to missing an update */
       variant->m3u8->sequence_position = old->m3u8->sequence_position;
       variant->m3u8->sequence = old->m3u8->sequence;
+      variant->m3u8->part_index = old->m3u8->part_index;
     }
   }
 
@@ -1330,39 +1469,26 @@ out:
   return ret;
 }
 
+/* Updates @m3u8 with the media playlist in @download. The URI of playlists
+ * requested with delivery directives is only changed by redirections. */
 static gboolean
-gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
-    GstHLSMedia * media, GError ** err)
+gst_hls_demux_update_m3u8 (GstHLSDemux * demux, GstM3U8 * m3u8,
+    GstFragment * download, const gchar * name, gboolean with_directives,
+    GError ** err)
 {
-  GstAdaptiveDemux *adaptive_demux = GST_ADAPTIVE_DEMUX (demux);
-  GstFragment *download;
   GstBuffer *buf;
   gchar *playlist;
-  const gchar *main_uri;
-  GstM3U8 *m3u8;
-  gchar *uri = media->uri;
-
-  main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
-  download =
-      gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
-      TRUE, TRUE, TRUE, err);
-
-  if (download == NULL)
-    return FALSE;
-
-  m3u8 = media->playlist;
 
   /* Set the base URI of the playlist to the redirect target if any */
   if (download->redirect_permanent && download->redirect_uri) {
-    gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL, media->name);
-  } else {
-    gst_m3u8_set_uri (m3u8, download->uri, download->redirect_uri, media->name);
+    gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL, name);
+  } else if (!with_directives || download->redirect_uri) {
+    gst_m3u8_set_uri (m3u8, download->uri, download->redirect_uri, name);
   }
 
   buf = gst_fragment_get_buffer (download);
   playlist = gst_hls_src_buf_to_utf8_playlist (buf);
   gst_buffer_unref (buf);
-  g_object_unref (download);
 
   if (playlist == NULL) {
     GST_WARNING_OBJECT (demux, "Couldn't validate playlist encoding");
@@ -1381,6 +1507,70 @@ gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
   return TRUE;
 }
 
+static gboolean
+gst_hls_demux_update_rendition_manifest (GstHLSDemux * demux,
+    GstHLSMedia * media, GError ** err)
+{
+  GstAdaptiveDemux *adaptive_demux = GST_ADAPTIVE_DEMUX (demux);
+  GstFragment *download;
+  const gchar *main_uri;
+  gchar *uri;
+  gboolean ret;
+
+  /* Low-latency variant playlists report how far the renditions got, which
+   * lets the server answer with a playlist that is just as recent */
+  uri = gst_m3u8_get_rendition_report_uri (demux->current_variant->m3u8,
+      media->uri);
+
+  main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
+  download =
+      gst_uri_downloader_fetch_uri (adaptive_demux->downloader,
+      uri ? uri : media->uri, main_uri, TRUE, TRUE, TRUE, err);
+
+  if (download == NULL) {
+    g_free (uri);
+    return FALSE;
+  }
+
+  ret = gst_hls_demux_update_m3u8 (demux, media->playlist, download,
+      media->name, uri != NULL, err);
+  g_object_unref (download);
+  g_free (uri);
+
+  return ret;
+}
+
+static gboolean
+gst_hls_demux_update_renditions (GstHLSDemux * demux, GError ** err)
+{
+  gint i;
+
+  for (i = 0; i < GST_HLS_N_MEDIA_TYPES; ++i) {
+    GList *mlist = demux->current_variant->media[i];
+
+    while (mlist != NULL) {
+      GstHLSMedia *media = mlist->data;
+
+      if (media->uri == NULL) {
+        /* No uri means this is a placeholder for a stream
+         * contained in another mux */
+        mlist = mlist->next;
+        continue;
+      }
+      GST_LOG_OBJECT (demux,
+          "Updating playlist for media of type %d - %s, uri: %s", i,
+          media->name, media->uri);
+
+      if (!gst_hls_demux_update_rendition_manifest (demux, media, err))
+        return FALSE;
+
+      mlist = mlist->next;
+    }
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
     GError ** err)
@@ -1393,7 +1583,6 @@ gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
   const gchar *main_uri;
   GstM3U8 *m3u8;
   gchar *uri;
-  gint i;
 
 retry:
   uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
@@ -1461,67 +1650,27 @@ retry:
 
   m3u8 = demux->current_variant->m3u8;
 
-  /* Set the base URI of the playlist to the redirect target if any */
-  if (download->redirect_permanent && download->redirect_uri) {
-    gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL,
-        demux->current_variant->name);
-  } else {
-    gst_m3u8_set_uri (m3u8, download->uri, download->redirect_uri,
-        demux->current_variant->name);
-  }
-
-  buf = gst_fragment_get_buffer (download);
-  playlist = gst_hls_src_buf_to_utf8_playlist (buf);
-  gst_buffer_unref (buf);
-  g_object_unref (download);
-
-  if (playlist == NULL) {
-    GST_WARNING_OBJECT (demux, "Couldn't validate playlist encoding");
-    g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_WRONG_TYPE,
-        "Couldn't validate playlist encoding");
+  if (!gst_hls_demux_update_m3u8 (demux, m3u8, download,
+          demux->current_variant->name, FALSE, err)) {
+    g_object_unref (download);
     return FALSE;
   }
+  g_object_unref (download);
 
-  if (!gst_m3u8_update (m3u8, playlist)) {
-    GST_WARNING_OBJECT (demux, "Couldn't update playlist");
-    g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
-        "Couldn't update playlist");
+  if (!gst_hls_demux_update_renditions (demux, err))
     return FALSE;
-  }
-
-  for (i = 0; i < GST_HLS_N_MEDIA_TYPES; ++i) {
-    GList *mlist = demux->current_variant->media[i];
-
-    while (mlist != NULL) {
-      GstHLSMedia *media = mlist->data;
-
-      if (media->uri == NULL) {
-        /* No uri means this is a placeholder for a stream
-         * contained in another mux */
-        mlist = mlist->next;
-        continue;
-      }
-      GST_LOG_OBJECT (demux,
-          "Updating playlist for media of type %d - %s, uri: %s", i,
-          media->name, media->uri);
-
-      if (!gst_hls_demux_update_rendition_manifest (demux, media, err))
-        return FALSE;
-
-      mlist = mlist->next;
-    }
-  }
 
   /* If it's a live source, do not let the sequence number go beyond
-   * three fragments before the end of the list */
-  if (update == FALSE && gst_m3u8_is_live (m3u8)) {
+   * three fragments before the end of the list. Low-latency playlists
+   * start closer to the end, at a part. */
+  if (update == FALSE && gst_m3u8_is_live (m3u8) && m3u8->part_index < 0) {
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
-    last_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence;
+    last_sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            m3u8->files->len - 1))->sequence;
     first_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_first (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, 0))->sequence;
 
     GST_DEBUG_OBJECT (demux,
         "sequence:%" G_GINT64_FORMAT " , first_sequence:%" G_GINT64_FORMAT
@@ -1537,9 +1686,8 @@ retry:
     }
     GST_M3U8_CLIENT_UNLOCK (demux->client);
   } else if (!gst_m3u8_is_live (m3u8)) {
-    GstClockTime current_pos, target_pos;
-    guint sequence = 0;
-    GList *walk;
+    GstClockTime current_pos = 0, target_pos;
+    guint sequence = 0, index;
 
     /* Sequence numbers are not guaranteed to be the same in different
      * playlists, so get the correct fragment here based on the current
@@ -1562,20 +1710,19 @@ retry:
     GST_LOG_OBJECT (demux, "Looking for sequence position %"
         GST_TIME_FORMAT " in updated playlist", GST_TIME_ARGS (target_pos));
 
-    current_pos = 0;
-    for (walk = m3u8->files; walk; walk = walk->next) {
-      GstM3U8MediaFile *file = walk->data;
+    index = gst_m3u8_find_fragment_index (m3u8, target_pos);
+    if (index < m3u8->files->len) {
+      GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, index);
 
       sequence = file->sequence;
-      if (current_pos <= target_pos
-          && target_pos < current_pos + file->duration) {
-        break;
-      }
-      current_pos += file->duration;
+      current_pos = file->start;
+    } else if (m3u8->files->len > 0) {
+      /* End of playlist */
+      GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, index - 1);
+
+      sequence = file->sequence + 1;
+      current_pos = file->start + file->duration;
     }
-    /* End of playlist */
-    if (!walk)
-      sequence++;
     m3u8->sequence = sequence;
     m3u8->sequence_position = current_pos;
     GST_M3U8_CLIENT_UNLOCK (demux->client);
@@ -1878,16 +2025,15 @@ static gint64
 gst_hls_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
 {
   GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
-  GstClockTime target_duration;
+  GstClockTime interval;
 
   if (hlsdemux->current_variant) {
-    target_duration =
-        gst_m3u8_get_target_duration (hlsdemux->current_variant->m3u8);
+    interval = gst_m3u8_get_update_interval (hlsdemux->current_variant->m3u8);
   } else {
-    target_duration = 5 * GST_SECOND;
+    interval = 5 * GST_SECOND;
   }
 
-  return gst_util_uint64_scale (target_duration, G_USEC_PER_SEC, GST_SECOND);
+  return gst_util_uint64_scale (interval, G_USEC_PER_SEC, GST_SECOND);
 }
 
 static gboolean
@@ -147,6 +147,9 @@ struct _GstHLSDemux
   GstHLSMasterPlaylist *master;
 
   GstHLSVariantStream  *current_variant;
+
+  /* Playlist a blocking reload is pending for */
+  GstM3U8              *reload_m3u8;
 };
 
 struct _GstHLSDemuxClass
@@ -35,6 +35,9 @@ static GstM3U8MediaFile *gst_m3u8_media_file_new (gchar * uri,
     gchar * title, GstClockTime duration, guint sequence);
 static void gst_m3u8_init_file_unref (GstM3U8InitFile * self);
 static gchar *uri_join (const gchar * uri, const gchar * path);
+static gboolean uri_join_matches (const gchar * uri1, const gchar * uri2,
+    const gchar * joined);
+static void gst_m3u8_clear_partial_info (GstM3U8 * self);
 
 GstM3U8 *
 gst_m3u8_new (void)
@@ -43,12 +46,15 @@ gst_m3u8_new (void)
 
   m3u8 = g_new0 (GstM3U8, 1);
 
-  m3u8->current_file = NULL;
+  m3u8->files = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_m3u8_media_file_unref);
   m3u8->current_file_duration = GST_CLOCK_TIME_NONE;
   m3u8->sequence = -1;
   m3u8->sequence_position = 0;
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
+  m3u8->part_index = -1;
+  m3u8->part_hold_back = GST_CLOCK_TIME_NONE;
 
   g_mutex_init (&m3u8->lock);
   m3u8->ref_count = 1;
@@ -105,8 +111,8 @@ gst_m3u8_unref (GstM3U8 * self)
     g_free (self->base_uri);
     g_free (self->name);
 
-    g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (self->files);
+    g_ptr_array_unref (self->files);
+    gst_m3u8_clear_partial_info (self);
 
     g_free (self->last_data);
     g_mutex_clear (&self->lock);
@@ -147,6 +153,8 @@ gst_m3u8_media_file_unref (GstM3U8MediaFile * self)
   if (g_atomic_int_dec_and_test (&self->ref_count)) {
     if (self->init_file)
       gst_m3u8_init_file_unref (self->init_file);
+    if (self->partial_segments)
+      g_ptr_array_unref (self->partial_segments);
     g_free (self->title);
     g_free (self->uri);
     g_free (self->key);
@@ -186,6 +194,66 @@ gst_m3u8_init_file_unref (GstM3U8InitFile * self)
   }
 }
 
+static void
+gst_m3u8_rendition_report_free (GstM3U8RenditionReport * report)
+{
+  g_free (report->uri);
+  g_free (report);
+}
+
+/* call with M3U8_LOCK held */
+static void
+gst_m3u8_clear_partial_info (GstM3U8 * self)
+{
+  if (self->partial_file) {
+    gst_m3u8_media_file_unref (self->partial_file);
+    self->partial_file = NULL;
+  }
+  if (self->preload_hint) {
+    gst_m3u8_media_file_unref (self->preload_hint);
+    self->preload_hint = NULL;
+  }
+  g_list_free_full (self->rendition_reports,
+      (GDestroyNotify) gst_m3u8_rendition_report_free);
+  self->rendition_reports = NULL;
+}
+
+/* Sets the encryption, initialization and byte range properties of a part
+ * or preload hint */
+static void
+gst_m3u8_part_init (GstM3U8MediaFile * part, const gchar * key,
+    const guint8 * iv, GstM3U8InitFile * init_file, gint64 offset,
+    gint64 size)
+{
+  part->key = g_strdup (key);
+  if (part->key) {
+    if (iv) {
+      memcpy (part->iv, iv, sizeof (part->iv));
+    } else {
+      guint8 *seq_iv = part->iv + 12;
+      GST_WRITE_UINT32_BE (seq_iv, part->sequence);
+    }
+  }
+  if (init_file)
+    part->init_file = gst_m3u8_init_file_ref (init_file);
+  part->offset = offset;
+  part->size = size;
+}
+
+/* The parts of a segment share its sequence number */
+static void
+gst_m3u8_media_file_set_sequence (GstM3U8MediaFile * file, gint64 sequence)
+{
+  guint i;
+
+  file->sequence = sequence;
+  if (file->partial_segments) {
+    for (i = 0; i < file->partial_segments->len; i++)
+      GST_M3U8_MEDIA_FILE (g_ptr_array_index (file->partial_segments,
+              i))->sequence = sequence;
+  }
+}
+
 static gboolean
 int_from_string (gchar * ptr, gchar ** endptr, gint * val)
 {
@@ -342,68 +410,103 @@ gst_hls_variant_stream_compare_by_bitrate (gconstpointer a, gconstpointer b)
   return vs_a->bandwidth - vs_b->bandwidth;
 }
 
+/* Returns the index of the file with @sequence in @files, which are sorted
+ * by increasing sequence without gaps, or -1 if there is no such file */
+static gint
+m3u8_files_find_sequence (GPtrArray * files, gint64 sequence)
+{
+  GstM3U8MediaFile *file;
+  gint64 index;
+
+  if (files->len == 0)
+    return -1;
+
+  file = g_ptr_array_index (files, 0);
+  index = sequence - file->sequence;
+  if (index < 0 || index >= files->len)
+    return -1;
+
+  file = g_ptr_array_index (files, index);
+  if (file->sequence != sequence)
+    return -1;
+
+  return index;
+}
+
+static gboolean
+gst_m3u8_init_file_equal (GstM3U8InitFile * a, GstM3U8InitFile * b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return a->offset == b->offset && a->size == b->size
+      && g_str_equal (a->uri, b->uri);
+}
+
+/* Returns whether @file has the properties of the playlist entry with the
+ * relative or absolute @uri, without resolving it */
+static gboolean
+gst_m3u8_media_file_matches (GstM3U8MediaFile * file, const gchar * base_uri,
+    const gchar * uri, const gchar * title, GstClockTime duration,
+    gboolean discont, const gchar * key, const guint8 * iv,
+    GstM3U8InitFile * init_file, gint64 offset, gint64 size)
+{
+  if (file->partial_segments != NULL || file->duration != duration
+      || file->discont != discont || file->offset != offset
+      || file->size != size || g_strcmp0 (file->title, title) != 0
+      || g_strcmp0 (file->key, key) != 0
+      || memcmp (file->iv, iv, sizeof (file->iv)) != 0
+      || !gst_m3u8_init_file_equal (file->init_file, init_file))
+    return FALSE;
+
+  return uri_join_matches (base_uri, uri, file->uri);
+}
+
 /* If we have MEDIA-SEQUENCE, ensure that it's consistent. If it is not,
  * the client SHOULD halt playback (6.3.4), which is what we do then. */
 static gboolean
-check_media_seqnums (GstM3U8 * self, GList * previous_files)
+check_media_seqnums (GstM3U8 * self, GPtrArray * previous_files)
 {
-  GList *l, *m;
-  GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  GstM3U8MediaFile *f1, *f2;
+  gint64 sequence, first, last;
 
-  g_return_val_if_fail (previous_files, FALSE);
+  g_return_val_if_fail (previous_files->len > 0, FALSE);
 
-  if (!self->files) {
+  if (self->files->len == 0) {
     /* Empty playlists are trivially consistent */
     return TRUE;
   }
 
-  /* Find first case of higher/equal sequence number in new playlist.
-   * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
+  f1 = g_ptr_array_index (self->files, self->files->len - 1);
+  f2 = g_ptr_array_index (previous_files, previous_files->len - 1);
+  last = MIN (f1->sequence, f2->sequence);
 
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (f1->sequence >= f2->sequence) {
-        match = TRUE;
-        break;
-      }
-    }
-    if (match)
-      break;
-  }
-
-  /* We must have seen at least one entry on each list */
-  g_assert (f1 != NULL);
-  g_assert (f2 != NULL);
-
-  if (!l) {
-    /* No match, no sequence in the new playlist was higher than
-     * any in the old. This is bad! */
+  f2 = g_ptr_array_index (previous_files, 0);
+  if (f1->sequence < f2->sequence) {
+    /* No sequence in the new playlist is higher than any in the old. This is
+     * bad! */
     GST_ERROR ("Media sequence doesn't continue: last new %" G_GINT64_FORMAT
-        " < last old %" G_GINT64_FORMAT, f1->sequence, f2->sequence);
+        " < first old %" G_GINT64_FORMAT, f1->sequence, f2->sequence);
     return FALSE;
   }
 
-  for (; l && m; l = l->next, m = m->next) {
-    f1 = l->data;
-    f2 = m->data;
+  f1 = g_ptr_array_index (self->files, 0);
+  first = MAX (f1->sequence, f2->sequence);
+
+  /* Both playlists are sorted without gaps, so entries with the same
+   * sequence are found by index. Reused entries are the same by
+   * construction */
+  for (sequence = first; sequence <= last; sequence++) {
+    f1 = g_ptr_array_index (self->files,
+        m3u8_files_find_sequence (self->files, sequence));
+    f2 = g_ptr_array_index (previous_files,
+        m3u8_files_find_sequence (previous_files, sequence));
 
-    if (f1->sequence == f2->sequence && !g_str_equal (f1->uri, f2->uri)) {
+    if (f1 != f2 && !g_str_equal (f1->uri, f2->uri)) {
       /* Same sequence, different URI. This is bad! */
       GST_ERROR ("Media URIs inconsistent (sequence %" G_GINT64_FORMAT
           "): had '%s', got '%s'", f1->sequence, f2->uri, f1->uri);
       return FALSE;
-    } else if (f1->sequence < f2->sequence) {
-      /* Not same sequence but by construction sequence must be higher in the
-       * new one. All good in that case, if it isn't then this means that
-       * sequence numbers are decreasing or files were inserted */
-      GST_ERROR ("Media sequences inconsistent: %" G_GINT64_FORMAT " < %"
-          G_GINT64_FORMAT ": URIs new '%s' old '%s'", f1->sequence,
-          f2->sequence, f1->uri, f2->uri);
-      return FALSE;
     }
   }
 
@@ -416,42 +519,43 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
  * playlist in relation to the old. That is, same URIs get the same number
  * and later URIs get higher numbers */
 static void
-generate_media_seqnums (GstM3U8 * self, GList * previous_files)
+generate_media_seqnums (GstM3U8 * self, GPtrArray * previous_files)
 {
-  GList *l, *m;
-  GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  GHashTable *previous_uris;
+  GstM3U8MediaFile *f1, *f2;
   gint64 mediasequence;
+  guint i, j;
 
-  g_return_if_fail (previous_files);
+  g_return_if_fail (previous_files->len > 0);
+
+  previous_uris = g_hash_table_new (g_str_hash, g_str_equal);
+  for (j = 0; j < previous_files->len; j++) {
+    f2 = g_ptr_array_index (previous_files, j);
+    if (!g_hash_table_contains (previous_uris, f2->uri))
+      g_hash_table_insert (previous_uris, f2->uri, f2);
+  }
 
   /* Find first case of same URI in new playlist.
    * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (g_str_equal (f1->uri, f2->uri)) {
-        match = TRUE;
-        break;
-      }
-    }
-
-    if (match)
+  f2 = NULL;
+  for (i = 0; i < self->files->len; i++) {
+    f1 = g_ptr_array_index (self->files, i);
+    f2 = g_hash_table_lookup (previous_uris, f1->uri);
+    if (f2)
       break;
   }
+  g_hash_table_unref (previous_uris);
 
-  if (l) {
+  if (f2) {
     /* Match, check that all following ones are matching too and continue
      * sequence numbers from there on */
 
     mediasequence = f2->sequence;
+    j = m3u8_files_find_sequence (previous_files, f2->sequence);
 
-    for (; l && m; l = l->next, m = m->next) {
-      f1 = l->data;
-      f2 = m->data;
+    for (; i < self->files->len && j < previous_files->len; i++, j++) {
+      f1 = g_ptr_array_index (self->files, i);
+      f2 = g_ptr_array_index (previous_files, j);
 
       f1->sequence = mediasequence;
       mediasequence++;
@@ -462,20 +566,73 @@ generate_media_seqnums (GstM3U8 * self, GList * previous_files)
       }
     }
   } else {
-    /* No match, this means f2 is the last item in the previous playlist
-     * and we have to start our new playlist at that sequence */
+    /* No match, this means we have to start our new playlist after the
+     * last item in the previous playlist */
+    f2 = g_ptr_array_index (previous_files, previous_files->len - 1);
     mediasequence = f2->sequence + 1;
-    l = self->files;
+    i = 0;
   }
 
-  for (; l; l = l->next) {
-    f1 = l->data;
+  for (; i < self->files->len; i++) {
+    f1 = g_ptr_array_index (self->files, i);
 
     f1->sequence = mediasequence;
     mediasequence++;
   }
 }
 
+/* call with M3U8_LOCK held. Starts playback of a live low-latency playlist
+ * PART-HOLD-BACK from its end, at a part starting with an independent frame.
+ * Returns FALSE if the playlist doesn't have enough parts for that */
+static gboolean
+m3u8_start_live_part (GstM3U8 * self)
+{
+  GstM3U8MediaFile *segment;
+  GstClockTime hold_back, position, distance = 0;
+  guint n = self->files->len;   /* segments before the current one */
+
+  if (self->partial_targetduration == 0 || n == 0)
+    return FALSE;
+
+  hold_back = self->part_hold_back;
+  if (!GST_CLOCK_TIME_IS_VALID (hold_back))
+    hold_back = GST_M3U8_LIVE_MIN_PART_DISTANCE * self->partial_targetduration;
+
+  /* walk the parts backwards from the end of the playlist */
+  position = self->last_file_end;
+  if (self->partial_file) {
+    segment = self->partial_file;
+    position += segment->duration;
+  } else {
+    segment = g_ptr_array_index (self->files, --n);
+  }
+
+  while (segment->partial_segments) {
+    GPtrArray *parts = segment->partial_segments;
+    gint i;
+
+    for (i = parts->len - 1; i >= 0; i--) {
+      GstM3U8MediaFile *part = g_ptr_array_index (parts, i);
+
+      position = position > part->duration ? position - part->duration : 0;
+      distance += part->duration;
+
+      if (distance >= hold_back && (part->independent || i == 0)) {
+        self->sequence = segment->sequence;
+        self->part_index = i;
+        self->sequence_position = position;
+        return TRUE;
+      }
+    }
+
+    if (n == 0)
+      break;
+    segment = g_ptr_array_index (self->files, --n);
+  }
+
+  return FALSE;
+}
+
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
@@ -484,16 +641,17 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 {
   gint val;
   GstClockTime duration;
-  gchar *title, *end;
+  gchar *title, *end, *text;
   gboolean discontinuity = FALSE;
   gchar *current_key = NULL;
   gboolean have_iv = FALSE;
   guint8 iv[16] = { 0, };
   gint64 size = -1, offset = -1;
   gint64 mediasequence;
-  GList *previous_files = NULL;
+  GPtrArray *previous_files;
   gboolean have_mediasequence = FALSE;
   GstM3U8InitFile *last_init_file = NULL;
+  GPtrArray *parts = NULL;
 
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
@@ -503,6 +661,12 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   /* check if the data changed since last update */
   if (self->last_data && g_str_equal (self->last_data, data)) {
     GST_DEBUG ("Playlist is the same as previous one");
+    if (self->blocking_reload) {
+      /* don't keep on reloading it without any delay */
+      GST_WARNING ("Server didn't block the playlist reload, disabling them");
+      self->can_block_reload = FALSE;
+      self->blocking_reload = FALSE;
+    }
     g_free (data);
     GST_M3U8_UNLOCK (self);
     return TRUE;
@@ -525,16 +689,26 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   g_free (self->last_data);
   self->last_data = data;
+  self->blocking_reload = FALSE;
+
+  /* parsing modifies the text, keep the original one to detect unchanged
+   * playlists on the next update */
+  data = text = g_strdup (data);
 
-  self->current_file = NULL;
   previous_files = self->files;
-  self->files = NULL;
+  self->files = g_ptr_array_new_full (previous_files->len,
+      (GDestroyNotify) gst_m3u8_media_file_unref);
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
 
   /* By default, allow caching */
   self->allowcache = TRUE;
 
+  gst_m3u8_clear_partial_info (self);
+  self->partial_targetduration = 0;
+  self->can_block_reload = FALSE;
+  self->part_hold_back = GST_CLOCK_TIME_NONE;
+
   duration = 0;
   title = NULL;
   data += 7;
@@ -550,57 +724,71 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       *r = '\0';
 
     if (data[0] != '#' && data[0] != '\0') {
+      GstM3U8MediaFile *file, *prev;
+      guint8 file_iv[16] = { 0, };
+      gint index;
+
       if (duration <= 0) {
         GST_LOG ("%s: got line without EXTINF, dropping", data);
         goto next_line;
       }
 
-      data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
-      if (data != NULL) {
-        GstM3U8MediaFile *file;
-        file = gst_m3u8_media_file_new (data, title, duration, mediasequence++);
+      if (size != -1 && offset == -1) {
+        prev = self->files->len > 0 ?
+            g_ptr_array_index (self->files, self->files->len - 1) : NULL;
+        offset = prev ? prev->offset + prev->size : 0;
+      } else if (size == -1) {
+        offset = 0;
+      }
 
-        /* set encryption params */
-        file->key = current_key ? g_strdup (current_key) : NULL;
-        if (file->key) {
-          if (have_iv) {
-            memcpy (file->iv, iv, sizeof (iv));
-          } else {
-            guint8 *iv = file->iv + 12;
-            GST_WRITE_UINT32_BE (iv, file->sequence);
-          }
+      /* set encryption params */
+      if (current_key) {
+        if (have_iv) {
+          memcpy (file_iv, iv, sizeof (iv));
+        } else {
+          GST_WRITE_UINT32_BE (file_iv + 12, mediasequence);
         }
+      }
 
-        if (size != -1) {
-          file->size = size;
-          if (offset != -1) {
-            file->offset = offset;
-          } else {
-            GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
+      /* Entries that were already in the previous playlist are reused
+       * instead of being created again */
+      prev = NULL;
+      if (have_mediasequence && parts == NULL) {
+        index = m3u8_files_find_sequence (previous_files, mediasequence);
+        if (index >= 0)
+          prev = g_ptr_array_index (previous_files, index);
+      }
 
-            if (!prev) {
-              offset = 0;
-            } else {
-              offset = prev->offset + prev->size;
-            }
-            file->offset = offset;
-          }
-        } else {
-          file->size = -1;
-          file->offset = 0;
-        }
+      if (prev && gst_m3u8_media_file_matches (prev,
+              self->base_uri ? self->base_uri : self->uri, data, title,
+              duration, discontinuity, current_key, file_iv, last_init_file,
+              offset, size)) {
+        file = gst_m3u8_media_file_ref (prev);
+        g_free (title);
+        mediasequence++;
+      } else {
+        data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
+        if (data == NULL)
+          goto next_line;
 
+        file = gst_m3u8_media_file_new (data, title, duration, mediasequence++);
+        file->key = g_strdup (current_key);
+        memcpy (file->iv, file_iv, sizeof (file_iv));
+        file->offset = offset;
+        file->size = size;
         file->discont = discontinuity;
         if (last_init_file)
           file->init_file = gst_m3u8_init_file_ref (last_init_file);
-
-        duration = 0;
-        title = NULL;
-        discontinuity = FALSE;
-        size = offset = -1;
-        self->files = g_list_prepend (self->files, file);
+        file->partial_segments = parts;
+        parts = NULL;
       }
 
+      duration = 0;
+      title = NULL;
+      discontinuity = FALSE;
+      size = offset = -1;
+      g_ptr_array_add (self->files, file);
+
     } else if (g_str_has_prefix (data, "#EXTINF:")) {
       gdouble fval;
       if (!double_from_string (data + 8, &data, &fval)) {
@@ -751,6 +939,156 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
           last_init_file = init_file;
         }
+      } else if (g_str_has_prefix (data_ext_x, "PART-INF:")) {
+        gchar *v, *a;
+        gdouble fval;
+
+        data = data + 16;
+
+        while (data != NULL && parse_attributes (&data, &a, &v)) {
+          if (strcmp (a, "PART-TARGET") == 0
+              && double_from_string (v, NULL, &fval))
+            self->partial_targetduration = fval * (gdouble) GST_SECOND;
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART:")) {
+        gchar *v, *a, *part_uri = NULL;
+        gdouble part_duration = -1;
+        gboolean independent = FALSE;
+        gint64 part_size = -1, part_offset = -1;
+        GstM3U8MediaFile *part;
+
+        data = data + 12;
+
+        while (data != NULL && parse_attributes (&data, &a, &v)) {
+          if (strcmp (a, "URI") == 0) {
+            g_free (part_uri);
+            part_uri =
+                uri_join (self->base_uri ? self->base_uri : self->uri, v);
+          } else if (strcmp (a, "DURATION") == 0) {
+            if (!double_from_string (v, NULL, &part_duration))
+              part_duration = -1;
+          } else if (strcmp (a, "INDEPENDENT") == 0) {
+            independent = g_ascii_strcasecmp (v, "YES") == 0;
+          } else if (strcmp (a, "BYTERANGE") == 0) {
+            if (!int64_from_string (v, &v, &part_size)
+                || (*v == '@' && !int64_from_string (v + 1, &v,
+                        &part_offset)))
+              part_size = part_offset = -1;
+          }
+        }
+
+        if (part_uri == NULL || part_duration < 0) {
+          GST_WARNING ("Ignoring invalid EXT-X-PART");
+          g_free (part_uri);
+          goto next_line;
+        }
+
+        if (part_size != -1 && part_offset == -1) {
+          /* continues the previous part of the same resource */
+          GstM3U8MediaFile *prev =
+              parts ? g_ptr_array_index (parts, parts->len - 1) : NULL;
+
+          if (prev && g_str_equal (prev->uri, part_uri))
+            part_offset = prev->offset + prev->size;
+          else
+            part_offset = 0;
+        } else if (part_size == -1) {
+          part_offset = 0;
+        }
+
+        part = gst_m3u8_media_file_new (part_uri, NULL,
+            part_duration * (gdouble) GST_SECOND, mediasequence);
+        gst_m3u8_part_init (part, current_key, have_iv ? iv : NULL,
+            last_init_file, part_offset, part_size);
+        part->independent = independent;
+        /* the discontinuity is at the start of the segment */
+        part->discont = discontinuity && parts == NULL;
+
+        if (parts == NULL)
+          parts = g_ptr_array_new_with_free_func ((GDestroyNotify)
+              gst_m3u8_media_file_unref);
+        g_ptr_array_add (parts, part);
+      } else if (g_str_has_prefix (data_ext_x, "PRELOAD-HINT:")) {
+        gchar *v, *a, *hint_uri = NULL;
+        gboolean is_part = FALSE, have_start = FALSE;
+        gint64 hint_offset = 0, hint_size = -1;
+
+        data = data + 20;
+
+        while (data != NULL && parse_attributes (&data, &a, &v)) {
+          if (strcmp (a, "TYPE") == 0) {
+            is_part = strcmp (v, "PART") == 0;
+          } else if (strcmp (a, "URI") == 0) {
+            g_free (hint_uri);
+            hint_uri =
+                uri_join (self->base_uri ? self->base_uri : self->uri, v);
+          } else if (strcmp (a, "BYTERANGE-START") == 0) {
+            have_start = int64_from_string (v, NULL, &hint_offset);
+          } else if (strcmp (a, "BYTERANGE-LENGTH") == 0) {
+            if (!int64_from_string (v, NULL, &hint_size))
+              hint_size = -1;
+          }
+        }
+
+        /* Without a length, a byte range hint spans the rest of the
+         * resource, which can hold more than the hinted part */
+        if (!is_part || hint_uri == NULL || (have_start && hint_size == -1)) {
+          GST_LOG ("Ignoring preload hint");
+          g_free (hint_uri);
+          goto next_line;
+        }
+
+        if (self->preload_hint)
+          gst_m3u8_media_file_unref (self->preload_hint);
+        self->preload_hint = gst_m3u8_media_file_new (hint_uri, NULL,
+            self->partial_targetduration, mediasequence);
+        gst_m3u8_part_init (self->preload_hint, current_key,
+            have_iv ? iv : NULL, last_init_file, hint_offset, hint_size);
+        self->preload_hint_part = parts ? parts->len : 0;
+      } else if (g_str_has_prefix (data_ext_x, "SERVER-CONTROL:")) {
+        gchar *v, *a;
+        gdouble fval;
+
+        data = data + 22;
+
+        while (data != NULL && parse_attributes (&data, &a, &v)) {
+          if (strcmp (a, "CAN-BLOCK-RELOAD") == 0) {
+            self->can_block_reload = g_ascii_strcasecmp (v, "YES") == 0;
+          } else if (strcmp (a, "PART-HOLD-BACK") == 0) {
+            if (double_from_string (v, NULL, &fval))
+              self->part_hold_back = fval * (gdouble) GST_SECOND;
+          }
+        }
+      } else if (g_str_has_prefix (data_ext_x, "RENDITION-REPORT:")) {
+        gchar *v, *a;
+        GstM3U8RenditionReport *report;
+
+        data = data + 24;
+
+        report = g_new0 (GstM3U8RenditionReport, 1);
+        report->last_msn = -1;
+        report->last_part = -1;
+        while (data != NULL && parse_attributes (&data, &a, &v)) {
+          if (strcmp (a, "URI") == 0) {
+            g_free (report->uri);
+            report->uri =
+                uri_join (self->base_uri ? self->base_uri : self->uri, v);
+          } else if (strcmp (a, "LAST-MSN") == 0) {
+            if (!int64_from_string (v, NULL, &report->last_msn))
+              report->last_msn = -1;
+          } else if (strcmp (a, "LAST-PART") == 0) {
+            if (!int_from_string (v, NULL, &report->last_part))
+              report->last_part = -1;
+          }
+        }
+
+        if (report->uri == NULL || report->last_msn < 0) {
+          GST_WARNING ("Ignoring invalid EXT-X-RENDITION-REPORT");
+          gst_m3u8_rendition_report_free (report);
+          goto next_line;
+        }
+        self->rendition_reports =
+            g_list_prepend (self->rendition_reports, report);
       } else {
         GST_LOG ("Ignored line: %s", data);
       }
@@ -766,13 +1104,27 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   g_free (current_key);
   current_key = NULL;
+  g_free (text);
 
-  self->files = g_list_reverse (self->files);
+  if (parts) {
+    /* parts of the segment that is still being produced */
+    GstClockTime partial_duration = 0;
+    guint i;
+
+    for (i = 0; i < parts->len; i++)
+      partial_duration +=
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (parts, i))->duration;
+
+    self->partial_file = gst_m3u8_media_file_new (NULL, NULL,
+        partial_duration, mediasequence);
+    self->partial_file->partial_segments = parts;
+    parts = NULL;
+  }
 
   if (last_init_file)
     gst_m3u8_init_file_unref (last_init_file);
 
-  if (previous_files) {
+  if (previous_files->len > 0) {
     gboolean consistent = TRUE;
 
     if (have_mediasequence) {
@@ -781,18 +1133,16 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       generate_media_seqnums (self, previous_files);
     }
 
-    g_list_foreach (previous_files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (previous_files);
-    previous_files = NULL;
-
     /* error was reported above already */
     if (!consistent) {
+      g_ptr_array_unref (previous_files);
       GST_M3U8_UNLOCK (self);
       return FALSE;
     }
   }
+  g_ptr_array_unref (previous_files);
 
-  if (self->files == NULL) {
+  if (self->files->len == 0) {
     GST_ERROR ("Invalid media playlist, it does not contain any media files");
     GST_M3U8_UNLOCK (self);
     return FALSE;
@@ -800,14 +1150,14 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   /* calculate the start and end times of this media playlist. */
   {
-    GList *walk;
     GstM3U8MediaFile *file;
-    GstClockTime duration = 0;
+    GstClockTime duration = 0, position;
+    guint i;
 
     mediasequence = -1;
 
-    for (walk = self->files; walk; walk = walk->next) {
-      file = walk->data;
+    for (i = 0; i < self->files->len; i++) {
+      file = g_ptr_array_index (self->files, i);
 
       if (mediasequence == -1) {
         mediasequence = file->sequence;
@@ -818,6 +1168,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       } else {
         mediasequence = file->sequence;
       }
+      gst_m3u8_media_file_set_sequence (file, file->sequence);
 
       duration += file->duration;
       if (file->sequence > self->highest_sequence_number) {
@@ -835,6 +1186,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         self->highest_sequence_number = file->sequence;
       }
     }
+    if (self->partial_file)
+      gst_m3u8_media_file_set_sequence (self->partial_file, mediasequence + 1);
+    if (self->preload_hint)
+      self->preload_hint->sequence = mediasequence + 1;
     if (GST_M3U8_IS_LIVE (self)) {
       self->first_file_start = self->last_file_end - duration;
       GST_DEBUG ("Live playlist range %" GST_TIME_FORMAT " -> %"
@@ -842,79 +1197,159 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
           GST_TIME_ARGS (self->last_file_end));
     }
     self->duration = duration;
+
+    /* for lookups by position */
+    position = GST_M3U8_IS_LIVE (self) ? self->first_file_start : 0;
+    for (i = 0; i < self->files->len; i++) {
+      file = g_ptr_array_index (self->files, i);
+      file->start = position;
+      position += file->duration;
+    }
   }
 
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
-    GList *file;
-
-    if (GST_M3U8_IS_LIVE (self)) {
-      gint i;
-      GstClockTime sequence_pos = 0;
-
-      file = g_list_last (self->files);
+  if (self->sequence == -1 && GST_M3U8_IS_LIVE (self)
+      && m3u8_start_live_part (self)) {
+    GST_DEBUG ("first sequence: %u, part %d", (guint) self->sequence,
+        self->part_index);
+  } else if (self->sequence == -1) {
+    GstM3U8MediaFile *file;
+    guint i = 0;
 
-      if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
-        sequence_pos =
-            self->last_file_end - GST_M3U8_MEDIA_FILE (file->data)->duration;
-      }
+    /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
+     * the end of the playlist. See section 6.3.3 of HLS draft */
+    if (GST_M3U8_IS_LIVE (self)
+        && self->files->len > GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE)
+      i = self->files->len - 1 - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
 
-      /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
-       * the end of the playlist. See section 6.3.3 of HLS draft */
-      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file->prev &&
-          GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos;
-          ++i) {
-        file = file->prev;
-        sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
-      }
-      self->sequence_position = sequence_pos;
-    } else {
-      file = g_list_first (self->files);
-      self->sequence_position = 0;
-    }
-    self->current_file = file;
-    self->sequence = GST_M3U8_MEDIA_FILE (file->data)->sequence;
+    file = g_ptr_array_index (self->files, i);
+    self->sequence_position = file->start;
+    self->sequence = file->sequence;
     GST_DEBUG ("first sequence: %u", (guint) self->sequence);
   }
 
   GST_LOG ("processed media playlist %s, %u fragments", self->name,
-      g_list_length (self->files));
+      self->files->len);
 
   GST_M3U8_UNLOCK (self);
 
   return TRUE;
 }
 
-/* call with M3U8_LOCK held */
-static GList *
+/* call with M3U8_LOCK held. Returns the index of the fragment to play for
+ * the current sequence, or -1 if there is none */
+static gint
 m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   GstM3U8MediaFile *file;
-  GList *l = m3u8->files;
+  gint64 index;
+
+  if (m3u8->files->len == 0)
+    return -1;
+
+  file = g_ptr_array_index (m3u8->files, 0);
+  index = m3u8->sequence - file->sequence;
 
   if (forward) {
-    while (l) {
-      file = l->data;
+    if (index < 0)
+      index = 0;
+    else if (index >= m3u8->files->len)
+      index = -1;
+  } else if (index >= m3u8->files->len) {
+    index = m3u8->files->len - 1;
+  } else if (index < 0) {
+    index = -1;
+  }
 
-      if (file->sequence >= m3u8->sequence)
-        break;
+  return index;
+}
 
-      l = l->next;
-    }
-  } else {
-    l = g_list_last (l);
+/* call with M3U8_LOCK held. Returns the segment with @sequence, including
+ * the one low-latency playlists only list the first parts of */
+static GstM3U8MediaFile *
+m3u8_find_segment (GstM3U8 * m3u8, gint64 sequence)
+{
+  gint index;
 
-    while (l) {
-      file = l->data;
+  if (m3u8->partial_file && m3u8->partial_file->sequence == sequence)
+    return m3u8->partial_file;
 
-      if (file->sequence <= m3u8->sequence)
-        break;
+  index = m3u8_files_find_sequence (m3u8->files, sequence);
+  if (index < 0)
+    return NULL;
 
-      l = l->prev;
-    }
+  return g_ptr_array_index (m3u8->files, index);
+}
+
+/* call with M3U8_LOCK held. Moves the part position @sequence / @part_index
+ * to the next part, skipping to the next segment at the end of a complete
+ * one. Segments listed without parts count as a single part. */
+static void
+m3u8_next_part (GstM3U8 * m3u8, gint64 * sequence, gint * part_index)
+{
+  GstM3U8MediaFile *segment;
+
+  (*part_index)++;
+
+  while ((segment = m3u8_find_segment (m3u8, *sequence)) != NULL
+      && segment != m3u8->partial_file) {
+    gint n_parts =
+        segment->partial_segments ? segment->partial_segments->len : 1;
+
+    if (*part_index < n_parts)
+      break;
+
+    (*sequence)++;
+    *part_index = 0;
   }
+}
+
+/* call with M3U8_LOCK held. Returns the media file to download for the part
+ * position @sequence / @part_index: a part, a segment listed without parts,
+ * or the preload hint of a part that isn't listed yet. */
+static GstM3U8MediaFile *
+m3u8_get_part (GstM3U8 * m3u8, gint64 sequence, gint part_index)
+{
+  GstM3U8MediaFile *segment = m3u8_find_segment (m3u8, sequence);
+
+  if (segment && segment->partial_segments
+      && (guint) part_index < segment->partial_segments->len)
+    return g_ptr_array_index (segment->partial_segments, part_index);
+
+  if (segment && segment != m3u8->partial_file
+      && segment->partial_segments == NULL && part_index == 0)
+    return segment;
 
-  return l;
+  if (m3u8->preload_hint && m3u8->preload_hint->sequence == sequence
+      && m3u8->preload_hint_part == part_index)
+    return m3u8->preload_hint;
+
+  return NULL;
+}
+
+/* call with M3U8_LOCK held. Servers remove the parts of a segment some time
+ * after it is complete. Playback can't continue in the middle of such a
+ * segment, so move on to the start of the next one */
+static void
+m3u8_skip_removed_parts (GstM3U8 * m3u8)
+{
+  GstM3U8MediaFile *segment;
+
+  if (m3u8->part_index <= 0)
+    return;
+
+  segment = m3u8_find_segment (m3u8, m3u8->sequence);
+  if (segment == NULL || segment == m3u8->partial_file
+      || m3u8_get_part (m3u8, m3u8->sequence, m3u8->part_index) != NULL)
+    return;
+
+  GST_DEBUG ("Parts of segment %u were removed, skipping to the next one",
+      (guint) m3u8->sequence);
+
+  if (GST_CLOCK_TIME_IS_VALID (segment->start))
+    m3u8->sequence_position = segment->start + segment->duration;
+  m3u8->sequence++;
+  m3u8->part_index = 0;
 }
 
 GstM3U8MediaFile *
@@ -922,6 +1357,7 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
     GstClockTime * sequence_position, gboolean * discont)
 {
   GstM3U8MediaFile *file = NULL;
+  gint index = -1;
 
   g_return_val_if_fail (m3u8 != NULL, NULL);
 
@@ -932,16 +1368,29 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
-  if (m3u8->current_file == NULL)
-    m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
+  m3u8_skip_removed_parts (m3u8);
 
-  if (m3u8->current_file == NULL)
-    goto out;
+  if (m3u8->part_index < 0)
+    index = m3u8_find_next_fragment (m3u8, forward);
 
-  file = gst_m3u8_media_file_ref (m3u8->current_file->data);
+  /* continue with parts after the last complete segment */
+  if (m3u8->part_index < 0 && index < 0 && forward
+      && m3u8_get_part (m3u8, m3u8->sequence, 0) != NULL)
+    m3u8->part_index = 0;
 
-  GST_DEBUG ("Got fragment with sequence %u (current sequence %u)",
-      (guint) file->sequence, (guint) m3u8->sequence);
+  if (m3u8->part_index >= 0) {
+    file = m3u8_get_part (m3u8, m3u8->sequence, m3u8->part_index);
+    if (file == NULL)
+      goto out;
+    file = gst_m3u8_media_file_ref (file);
+  } else if (index >= 0) {
+    file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files, index));
+  } else {
+    goto out;
+  }
+
+  GST_DEBUG ("Got fragment with sequence %u (current sequence %u, part %d)",
+      (guint) file->sequence, (guint) m3u8->sequence, m3u8->part_index);
 
   if (sequence_position)
     *sequence_position = m3u8->sequence_position;
@@ -962,7 +1411,7 @@ gboolean
 gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   gboolean have_next;
-  GList *cur;
+  gint index;
 
   g_return_val_if_fail (m3u8 != NULL, FALSE);
 
@@ -971,26 +1420,80 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   GST_DEBUG ("Checking next fragment %" G_GINT64_FORMAT,
       m3u8->sequence + (forward ? 1 : -1));
 
-  if (m3u8->current_file) {
-    cur = m3u8->current_file;
+  if (m3u8->part_index >= 0 && forward) {
+    gint64 sequence = m3u8->sequence;
+    gint part_index = m3u8->part_index;
+
+    m3u8_next_part (m3u8, &sequence, &part_index);
+    have_next = m3u8_get_part (m3u8, sequence, part_index) != NULL;
   } else {
-    cur = m3u8_find_next_fragment (m3u8, forward);
-  }
+    index = m3u8_find_next_fragment (m3u8, forward);
+
+    if (index < 0) {
+      have_next = FALSE;
+    } else if (!forward) {
+      have_next = index > 0;
+    } else if (index + 1 < m3u8->files->len) {
+      have_next = TRUE;
+    } else {
+      /* the last complete segment can be followed by parts */
+      GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, index);
 
-  have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
+      have_next = m3u8_get_part (m3u8, file->sequence + 1, 0) != NULL;
+    }
+  }
 
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+/* Returns the fragment that comes @index fragments after the current one,
+ * without moving the playlist position */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint index)
+{
+  GstM3U8MediaFile *file = NULL;
+  gint64 cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (m3u8->part_index >= 0 && forward) {
+    gint64 sequence = m3u8->sequence;
+    gint part_index = m3u8->part_index;
+
+    for (; index > 0; index--)
+      m3u8_next_part (m3u8, &sequence, &part_index);
+
+    file = m3u8_get_part (m3u8, sequence, part_index);
+    if (file)
+      gst_m3u8_media_file_ref (file);
+    goto out;
+  }
+
+  cur = m3u8_find_next_fragment (m3u8, forward);
+  if (cur < 0)
+    goto out;
+
+  cur = forward ? cur + index : cur - index;
+  if (cur >= 0 && cur < m3u8->files->len)
+    file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files, cur));
+
+out:
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
-static void
+static gboolean
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
 {
-  gint targetnum = m3u8->sequence;
-  GList *tmp;
-  GstM3U8MediaFile *mf;
+  gint64 targetnum = m3u8->sequence;
+  gint index;
 
   /* figure out the target seqnum */
   if (forward)
@@ -998,24 +1501,23 @@ m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
   else
     targetnum -= 1;
 
-  for (tmp = m3u8->files; tmp; tmp = tmp->next) {
-    mf = (GstM3U8MediaFile *) tmp->data;
-    if (mf->sequence == targetnum)
-      break;
-  }
-  if (tmp == NULL) {
+  index = m3u8_files_find_sequence (m3u8->files, targetnum);
+  if (index < 0) {
     GST_WARNING ("Can't find next fragment");
-    return;
+    return FALSE;
   }
-  m3u8->current_file = tmp;
   m3u8->sequence = targetnum;
-  m3u8->current_file_duration = GST_M3U8_MEDIA_FILE (tmp->data)->duration;
+  m3u8->current_file_duration =
+      GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, index))->duration;
+
+  return TRUE;
 }
 
 void
 gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   GstM3U8MediaFile *file;
+  gint index;
 
   g_return_if_fail (m3u8 != NULL);
 
@@ -1035,59 +1537,61 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     GST_DEBUG ("Sequence position now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (m3u8->sequence_position));
   }
-  if (!m3u8->current_file) {
-    GList *l;
 
-    GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
-    for (l = m3u8->files; l != NULL; l = l->next) {
-      if (GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence) {
-        m3u8->current_file = l;
-        break;
-      }
-    }
-    if (m3u8->current_file == NULL) {
-      GST_DEBUG
-          ("Could not find current fragment, trying next fragment directly");
-      m3u8_alternate_advance (m3u8, forward);
-
-      /* Resync sequence number if the above has failed for live streams */
-      if (m3u8->current_file == NULL && GST_M3U8_IS_LIVE (m3u8)) {
-        /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
-           the end of the playlist. See section 6.3.3 of HLS draft */
-        gint pos =
-            g_list_length (m3u8->files) - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
-        m3u8->current_file = g_list_nth (m3u8->files, pos >= 0 ? pos : 0);
-        m3u8->current_file_duration =
-            GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
-
-        GST_WARNING ("Resyncing live playlist");
-      }
+  if (m3u8->part_index >= 0) {
+    if (!forward) {
+      /* parts are only played forward, continue with whole segments */
+      m3u8->part_index = -1;
+      m3u8->sequence--;
       goto out;
     }
-  }
 
-  file = GST_M3U8_MEDIA_FILE (m3u8->current_file->data);
-  GST_DEBUG ("Advancing from sequence %u", (guint) file->sequence);
-  if (forward) {
-    m3u8->current_file = m3u8->current_file->next;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
-    } else {
-      m3u8->sequence = file->sequence + 1;
+    m3u8_next_part (m3u8, &m3u8->sequence, &m3u8->part_index);
+    GST_DEBUG ("Advanced to sequence %u, part %d", (guint) m3u8->sequence,
+        m3u8->part_index);
+
+    /* Resync if the playlist moved on without us */
+    if (m3u8->files->len > 0 && m3u8->sequence <
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, 0))->sequence) {
+      GST_WARNING ("Resyncing live playlist");
+      if (!m3u8_start_live_part (m3u8))
+        m3u8->part_index = -1;
     }
-  } else {
-    m3u8->current_file = m3u8->current_file->prev;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
-    } else {
-      m3u8->sequence = file->sequence - 1;
+    goto out;
+  }
+
+  GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
+  index = m3u8_files_find_sequence (m3u8->files, m3u8->sequence);
+  if (index < 0) {
+    GST_DEBUG
+        ("Could not find current fragment, trying next fragment directly");
+
+    /* Resync sequence number if the above has failed for live streams */
+    if (!m3u8_alternate_advance (m3u8, forward) && GST_M3U8_IS_LIVE (m3u8)
+        && m3u8->files->len > 0) {
+      /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
+         the end of the playlist. See section 6.3.3 of HLS draft */
+      index = MAX ((gint) m3u8->files->len -
+          GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE, 0);
+      file = g_ptr_array_index (m3u8->files, index);
+      m3u8->sequence = file->sequence;
+      m3u8->current_file_duration = file->duration;
+
+      GST_WARNING ("Resyncing live playlist");
     }
+    goto out;
   }
-  if (m3u8->current_file) {
+
+  file = g_ptr_array_index (m3u8->files, index);
+  GST_DEBUG ("Advancing from sequence %u", (guint) file->sequence);
+  index += forward ? 1 : -1;
+  m3u8->sequence = file->sequence + (forward ? 1 : -1);
+  if (index >= 0 && index < m3u8->files->len) {
     /* Store duration of the fragment we're using to update the position 
      * the next time we advance */
     m3u8->current_file_duration =
-        GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            index))->duration;
   }
 
 out:
@@ -1108,12 +1612,13 @@ gst_m3u8_get_duration (GstM3U8 * m3u8)
   if (!m3u8->endlist)
     goto out;
 
-  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files != NULL) {
-    GList *f;
+  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files->len > 0) {
+    guint i;
 
     m3u8->duration = 0;
-    for (f = m3u8->files; f != NULL; f = f->next)
-      m3u8->duration += GST_M3U8_MEDIA_FILE (f)->duration;
+    for (i = 0; i < m3u8->files->len; i++)
+      m3u8->duration +=
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, i))->duration;
   }
   duration = m3u8->duration;
 
@@ -1220,35 +1725,70 @@ out:
   return ret;
 }
 
+/* Returns whether uri_join (@uri1, @uri2) is @joined, without allocating */
+static gboolean
+uri_join_matches (const gchar * uri1, const gchar * uri2,
+    const gchar * joined)
+{
+  gsize joined_len = strlen (joined), len2 = strlen (uri2), prefix_len;
+  const gchar *tmp;
+
+  /* the joined URI always ends with uri2 */
+  if (len2 > joined_len || strcmp (joined + joined_len - len2, uri2) != 0)
+    return FALSE;
+
+  if (gst_uri_is_valid (uri2))
+    return joined_len == len2;
+
+  prefix_len = joined_len - len2;
+  if (uri2[0] != '/') {
+    /* uri1 up to its last / char, ignoring query params */
+    tmp = strchr (uri1, '?');
+    if (tmp)
+      tmp = g_strrstr_len (uri1, tmp - uri1, "/");
+    else
+      tmp = strrchr (uri1, '/');
+    if (!tmp)
+      return FALSE;
+
+    return prefix_len == tmp - uri1 + 1 && strncmp (joined, uri1,
+        prefix_len) == 0;
+  }
+
+  /* <scheme>://<hostname> of uri1 */
+  tmp = strstr (uri1, "://");
+  if (!tmp || strchr (uri1, ':') != tmp)
+    return FALSE;
+  tmp = strchr (tmp + 3, '/');
+  if (!tmp)
+    tmp = uri1 + strlen (uri1);
+
+  return prefix_len == tmp - uri1 && strncmp (joined, uri1, prefix_len) == 0;
+}
+
 gboolean
 gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 {
   GstClockTime duration = 0;
-  GList *walk;
-  GstM3U8MediaFile *file;
-  guint count;
+  GstM3U8MediaFile *first, *last;
   guint min_distance = 0;
 
   g_return_val_if_fail (m3u8 != NULL, FALSE);
 
   GST_M3U8_LOCK (m3u8);
 
-  if (m3u8->files == NULL)
-    goto out;
-
   if (GST_M3U8_IS_LIVE (m3u8)) {
     /* min_distance is used to make sure the seek range is never closer than
        GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE fragments from the end of a live
        playlist - see 6.3.3. "Playing the Playlist file" of the HLS draft */
     min_distance = GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
   }
-  count = g_list_length (m3u8->files);
+  if (m3u8->files->len <= min_distance)
+    goto out;
 
-  for (walk = m3u8->files; walk && count > min_distance; walk = walk->next) {
-    file = walk->data;
-    --count;
-    duration += file->duration;
-  }
+  first = g_ptr_array_index (m3u8->files, 0);
+  last = g_ptr_array_index (m3u8->files, m3u8->files->len - min_distance - 1);
+  duration = last->start + last->duration - first->start;
 
   if (duration <= 0)
     goto out;
@@ -1262,6 +1802,159 @@ out:
   return (duration > 0);
 }
 
+/* Returns the index in files of the fragment containing @position, which is
+ * in the timeline of sequence_position. Positions before the first fragment
+ * give 0 and positions after the last one the number of fragments. */
+guint
+gst_m3u8_find_fragment_index (GstM3U8 * m3u8, GstClockTime position)
+{
+  GstM3U8MediaFile *file;
+  guint low = 0, high;
+
+  g_return_val_if_fail (m3u8 != NULL, 0);
+
+  GST_M3U8_LOCK (m3u8);
+
+  /* find the first fragment starting after position */
+  high = m3u8->files->len;
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+
+    file = g_ptr_array_index (m3u8->files, mid);
+    if (file->start <= position)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low > 0) {
+    file = g_ptr_array_index (m3u8->files, low - 1);
+    if (low < m3u8->files->len || position < file->start + file->duration)
+      low--;
+  }
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return low;
+}
+
+/* Returns the interval between reloads of a live playlist. New parts of
+ * low-latency playlists show up after about a part target duration */
+GstClockTime
+gst_m3u8_get_update_interval (GstM3U8 * m3u8)
+{
+  GstClockTime interval;
+
+  g_return_val_if_fail (m3u8 != NULL, GST_CLOCK_TIME_NONE);
+
+  GST_M3U8_LOCK (m3u8);
+  if (m3u8->partial_targetduration > 0)
+    interval = m3u8->partial_targetduration;
+  else
+    interval = m3u8->targetduration;
+  GST_M3U8_UNLOCK (m3u8);
+
+  return interval;
+}
+
+/* Replaces the delivery directives of @uri */
+static gchar *
+uri_with_delivery_directives (const gchar * uri, gint64 msn, gint part)
+{
+  const gchar *query = strchr (uri, '?');
+  GString *str;
+  gchar sep = '?';
+
+  str = g_string_new_len (uri, query ? query - uri : strlen (uri));
+  if (query) {
+    gchar **params = g_strsplit (query + 1, "&", -1);
+    guint i;
+
+    for (i = 0; params[i]; i++) {
+      if (params[i][0] == '\0' || g_str_has_prefix (params[i], "_HLS_"))
+        continue;
+      g_string_append_c (str, sep);
+      g_string_append (str, params[i]);
+      sep = '&';
+    }
+    g_strfreev (params);
+  }
+
+  g_string_append_printf (str, "%c_HLS_msn=%" G_GINT64_FORMAT, sep, msn);
+  if (part >= 0)
+    g_string_append_printf (str, "&_HLS_part=%d", part);
+
+  return g_string_free (str, FALSE);
+}
+
+/* Returns the URI of a blocking reload of a live playlist, which the server
+ * answers once the segment or part following the last listed one is
+ * available, or NULL if the server doesn't support them. The next update is
+ * expected to be the answer to that request. */
+gchar *
+gst_m3u8_get_blocking_reload_uri (GstM3U8 * m3u8)
+{
+  GstM3U8MediaFile *last;
+  gchar *uri = NULL;
+  gint part = -1;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (!GST_M3U8_IS_LIVE (m3u8) || !m3u8->can_block_reload
+      || m3u8->files->len == 0 || m3u8->uri == NULL)
+    goto out;
+
+  last = g_ptr_array_index (m3u8->files, m3u8->files->len - 1);
+  if (m3u8->partial_targetduration > 0) {
+    part = 0;
+    if (m3u8->partial_file)
+      part = m3u8->partial_file->partial_segments->len;
+  }
+
+  uri = uri_with_delivery_directives (m3u8->uri, last->sequence + 1, part);
+  m3u8->blocking_reload = TRUE;
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return uri;
+}
+
+/* Returns the URI requesting the playlist at @uri at least as recent as the
+ * last EXT-X-RENDITION-REPORT of @m3u8 for it, which the server answers
+ * right away, or NULL if there is no such report */
+gchar *
+gst_m3u8_get_rendition_report_uri (GstM3U8 * m3u8, const gchar * uri)
+{
+  gchar *report_uri = NULL;
+  GList *l;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (!m3u8->can_block_reload)
+    goto out;
+
+  for (l = m3u8->rendition_reports; l; l = l->next) {
+    GstM3U8RenditionReport *report = l->data;
+
+    if (g_str_equal (report->uri, uri)) {
+      report_uri = uri_with_delivery_directives (uri, report->last_msn,
+          report->last_part);
+      break;
+    }
+  }
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return report_uri;
+}
+
 GstHLSMedia *
 gst_hls_media_ref (GstHLSMedia * media)
 {
@@ -31,6 +31,7 @@ G_BEGIN_DECLS
 typedef struct _GstM3U8 GstM3U8;
 typedef struct _GstM3U8MediaFile GstM3U8MediaFile;
 typedef struct _GstM3U8InitFile GstM3U8InitFile;
+typedef struct _GstM3U8RenditionReport GstM3U8RenditionReport;
 typedef struct _GstHLSMedia GstHLSMedia;
 typedef struct _GstM3U8Client GstM3U8Client;
 typedef struct _GstHLSVariantStream GstHLSVariantStream;
@@ -50,6 +51,11 @@ typedef struct _GstHLSMasterPlaylist GstHLSMasterPlaylist;
    value is three fragments */
 #define GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE 3
 
+/* Low-latency playlists without PART-HOLD-BACK are started this many part
+ * target durations from their end, the minimum allowed by the LL-HLS
+ * specification */
+#define GST_M3U8_LIVE_MIN_PART_DISTANCE 3
+
 struct _GstM3U8
 {
   gchar *uri;                   /* actually downloaded URI */
@@ -64,10 +70,9 @@ struct _GstM3U8
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
-  GList *files;
+  GPtrArray *files;             /* GstM3U8MediaFile by increasing sequence, without gaps */
 
   /* state */
-  GList *current_file;
   GstClockTime current_file_duration; /* Duration of current fragment */
   gint64 sequence;                    /* the next sequence for this client */
   GstClockTime sequence_position;     /* position of this sequence */
@@ -76,9 +81,20 @@ struct _GstM3U8
   GstClockTime last_file_end;         /* timecode of the end of the last fragment in the current media playlist */
   GstClockTime duration;              /* cached total duration */
   gint discont_sequence;              /* currently expected EXT-X-DISCONTINUITY-SEQUENCE */
+  gint part_index;                    /* part of the sequence played next, -1 when playing whole segments */
+
+  /* low-latency info */
+  GstClockTime partial_targetduration; /* last EXT-X-PART-INF PART-TARGET, 0 if no parts */
+  gboolean can_block_reload;          /* EXT-X-SERVER-CONTROL CAN-BLOCK-RELOAD */
+  GstClockTime part_hold_back;        /* EXT-X-SERVER-CONTROL PART-HOLD-BACK */
+  GstM3U8MediaFile *partial_file;     /* parts of the segment following the last complete one */
+  GstM3U8MediaFile *preload_hint;     /* EXT-X-PRELOAD-HINT of the part following the last listed one */
+  gint preload_hint_part;             /* part index of preload_hint in its segment */
+  GList *rendition_reports;           /* list of GstM3U8RenditionReport */
 
   /*< private > */
   gchar *last_data;
+  gboolean blocking_reload;     /* next update answers a blocking reload */
   GMutex lock;
 
   gint ref_count;               /* ATOMIC */
@@ -95,12 +111,15 @@ struct _GstM3U8MediaFile
   GstClockTime duration;
   gchar *uri;
   gint64 sequence;               /* the sequence nb of this file */
+  GstClockTime start;           /* start of this file, like sequence_position */
   gboolean discont;             /* this file marks a discontinuity */
   gchar *key;
   guint8 iv[16];
   gint64 offset, size;
   gint ref_count;               /* ATOMIC */
   GstM3U8InitFile *init_file;   /* Media Initialization (hold ref) */
+  GPtrArray *partial_segments;  /* EXT-X-PART entries of this segment, or NULL */
+  gboolean independent;         /* part starting with an independent frame */
 };
 
 struct _GstM3U8InitFile
@@ -110,6 +129,13 @@ struct _GstM3U8InitFile
   guint ref_count;      /* ATOMIC */
 };
 
+struct _GstM3U8RenditionReport
+{
+  gchar *uri;
+  gint64 last_msn;
+  gint last_part;               /* -1 if not reported */
+};
+
 GstM3U8MediaFile * gst_m3u8_media_file_ref   (GstM3U8MediaFile * mfile);
 
 void               gst_m3u8_media_file_unref (GstM3U8MediaFile * mfile);
@@ -132,6 +158,10 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     index);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
@@ -147,6 +177,16 @@ gboolean           gst_m3u8_get_seek_range       (GstM3U8 * m3u8,
                                                   gint64  * start,
                                                   gint64  * stop);
 
+GstClockTime       gst_m3u8_get_update_interval  (GstM3U8 * m3u8);
+
+guint              gst_m3u8_find_fragment_index  (GstM3U8      * m3u8,
+                                                  GstClockTime   position);
+
+gchar *            gst_m3u8_get_blocking_reload_uri (GstM3U8 * m3u8);
+
+gchar *            gst_m3u8_get_rendition_report_uri (GstM3U8     * m3u8,
+                                                      const gchar * uri);
+
 typedef enum
 {
   GST_HLS_MEDIA_TYPE_INVALID = -1,
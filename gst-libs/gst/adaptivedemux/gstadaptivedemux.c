@@ -131,6 +131,10 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_BITRATE_LIMIT 0.8f
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
+#define DEFAULT_PREFETCH_DEPTH 0
+#define MAX_PREFETCH_DEPTH 32
+#define DEFAULT_ABR_ALGORITHM NULL
+#define PREFETCH_MAX_BYTES 32 * 1024 * 1024     /* Per stream, on top of the queue */
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -157,6 +161,8 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_DEPTH,
+  PROP_ABR_ALGORITHM,
   PROP_LAST
 };
 
@@ -172,6 +178,7 @@ struct _GstAdaptiveDemuxPrivate
 
   GstTask *updates_task;        /* MT safe */
   GRecMutex updates_lock;
+  GstUriDownloader *updates_downloader; /* blocking manifest requests */
   GMutex updates_timed_lock;
   GCond updates_timed_cond;     /* protected by updates_timed_lock */
   gboolean stop_updates_task;   /* protected by updates_timed_lock */
@@ -205,6 +212,52 @@ struct _GstAdaptiveDemuxPrivate
    * without needing to stop tasks when they just want to
    * update the segment boundaries */
   GMutex segment_lock;
+
+  guint prefetch_depth;         /* protected by manifest_lock */
+  gchar *abr_algorithm;         /* protected by manifest_lock */
+};
+
+typedef enum
+{
+  PREFETCH_QUEUED,
+  PREFETCH_DOWNLOADING,
+  PREFETCH_DONE,
+  PREFETCH_FAILED
+} GstAdaptiveDemuxPrefetchState;
+
+typedef struct _GstAdaptiveDemuxPrefetchEntry
+{
+  volatile gint ref_count;
+
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  /* protected by the prefetch lock */
+  GstAdaptiveDemuxPrefetchState state;
+  gboolean cancelled;
+  GstUriDownloader *downloader; /* while downloading */
+
+  /* set once the state is PREFETCH_DONE */
+  GstBuffer *buffer;
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetchEntry;
+
+/* Fragments that come after the current one, downloaded by a pool of
+ * GstUriDownloader while the current fragment is being pushed */
+struct _GstAdaptiveDemuxPrefetch
+{
+  GstAdaptiveDemux *demux;
+
+  GMutex lock;
+  GCond cond;
+  GQueue entries;               /* protected by lock, in fragment order */
+  GQueue downloaders;           /* protected by lock, the idle ones */
+  GThreadPool *pool;
+
+  /* protected by manifest_lock */
+  guint hits;
+  guint misses;
 };
 
 typedef struct _GstAdaptiveDemuxTimer
@@ -265,6 +318,9 @@ static GstFlowReturn gst_adaptive_demux_update_manifest (GstAdaptiveDemux *
     demux);
 static GstFlowReturn
 gst_adaptive_demux_update_manifest_default (GstAdaptiveDemux * demux);
+static GstFlowReturn
+gst_adaptive_demux_update_manifest_blocking (GstAdaptiveDemux * demux,
+    const gchar * uri);
 static gboolean gst_adaptive_demux_has_next_period (GstAdaptiveDemux * demux);
 static void gst_adaptive_demux_advance_period (GstAdaptiveDemux * demux);
 
@@ -304,6 +360,10 @@ static gboolean gst_adaptive_demux_clock_callback (GstClock * clock,
 static gboolean
 gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
     * demux);
+static void gst_adaptive_demux_prefetch_cancel (GstAdaptiveDemuxPrefetch *
+    prefetch);
+static void gst_adaptive_demux_prefetch_free (GstAdaptiveDemuxPrefetch *
+    prefetch);
 
 /* we can't use G_DEFINE_ABSTRACT_TYPE because we need the klass in the _init
  * method to get to the padtemplates */
@@ -361,6 +421,13 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_DEPTH:
+      demux->priv->prefetch_depth = g_value_get_uint (value);
+      break;
+    case PROP_ABR_ALGORITHM:
+      g_free (demux->priv->abr_algorithm);
+      demux->priv->abr_algorithm = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -385,6 +452,12 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_DEPTH:
+      g_value_set_uint (value, demux->priv->prefetch_depth);
+      break;
+    case PROP_ABR_ALGORITHM:
+      g_value_set_string (value, demux->priv->abr_algorithm);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -430,6 +503,39 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-depth:
+   *
+   * Number of fragments after the current one to download concurrently
+   * while the current one is being pushed. The prefetched fragments are
+   * kept in memory until they are needed and dropped on seeks and bitrate
+   * switches. Only used with subclasses that can look ahead in their
+   * fragment list.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_DEPTH,
+      g_param_spec_uint ("prefetch-depth", "Prefetch depth",
+          "Number of upcoming fragments to download in advance (0 = disabled)",
+          0, MAX_PREFETCH_DEPTH, DEFAULT_PREFETCH_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-algorithm:
+   *
+   * Name of the #GstAdaptiveDemuxAbrAlgorithm selecting the bitrate of the
+   * streams, see gst_adaptive_demux_abr_find(). If %NULL or unknown, the
+   * representation with the highest bitrate below the measured download
+   * rate is used. Ignored when #GstAdaptiveDemux:connection-speed is set.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_ALGORITHM,
+      g_param_spec_string ("abr-algorithm", "ABR algorithm",
+          "Name of the algorithm selecting the bitrate (NULL = default, "
+          "\"" GST_ADAPTIVE_DEMUX_ABR_BOLA "\" = buffer based)",
+          DEFAULT_ABR_ALGORITHM, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -456,6 +562,9 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   demux->priv->input_adapter = gst_adapter_new ();
   demux->downloader = gst_uri_downloader_new ();
   gst_uri_downloader_set_parent (demux->downloader, GST_ELEMENT_CAST (demux));
+  demux->priv->updates_downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_parent (demux->priv->updates_downloader,
+      GST_ELEMENT_CAST (demux));
   demux->stream_struct_size = sizeof (GstAdaptiveDemuxStream);
   demux->priv->segment_seqnum = gst_util_seqnum_next ();
   demux->have_group_id = FALSE;
@@ -520,6 +629,8 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_depth = DEFAULT_PREFETCH_DEPTH;
+  demux->priv->abr_algorithm = DEFAULT_ABR_ALGORITHM;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -534,6 +645,8 @@ gst_adaptive_demux_finalize (GObject * object)
 
   g_object_unref (priv->input_adapter);
   g_object_unref (demux->downloader);
+  g_object_unref (priv->updates_downloader);
+  g_free (priv->abr_algorithm);
 
   g_mutex_clear (&priv->updates_timed_lock);
   g_cond_clear (&priv->updates_timed_cond);
@@ -1400,6 +1513,17 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
     stream->download_task = NULL;
   }
 
+  if (stream->prefetch) {
+    gst_adaptive_demux_prefetch_free (stream->prefetch);
+    stream->prefetch = NULL;
+  }
+
+  if (stream->abr) {
+    stream->abr->free (stream->abr_state);
+    stream->abr = NULL;
+    stream->abr_state = NULL;
+  }
+
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
 
   if (stream->pending_segment) {
@@ -2041,6 +2165,7 @@ static void
 gst_adaptive_demux_stop_manifest_update_task (GstAdaptiveDemux * demux)
 {
   gst_uri_downloader_cancel (demux->downloader);
+  gst_uri_downloader_cancel (demux->priv->updates_downloader);
 
   gst_task_stop (demux->priv->updates_task);
 
@@ -2059,6 +2184,7 @@ gst_adaptive_demux_start_manifest_update_task (GstAdaptiveDemux * demux)
 
   if (gst_adaptive_demux_is_live (demux)) {
     gst_uri_downloader_reset (demux->downloader);
+    gst_uri_downloader_reset (demux->priv->updates_downloader);
     g_mutex_lock (&demux->priv->updates_timed_lock);
     demux->priv->stop_updates_task = FALSE;
     g_mutex_unlock (&demux->priv->updates_timed_lock);
@@ -2098,6 +2224,9 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
       gst_task_stop (stream->download_task);
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      /* prefetched fragments are useless after a seek */
+      gst_adaptive_demux_prefetch_cancel (stream->prefetch);
     }
     list_to_process = demux->prepared_streams;
   }
@@ -2274,6 +2403,117 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   return stream->current_download_rate;
 }
 
+/* must be called with manifest_lock taken */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstClockTime downloaded;
+  gint64 pos;
+
+  /* the download position only moves forward in forward playback */
+  if (demux->segment.rate < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  if (!gst_pad_peer_query_position (stream->pad, GST_FORMAT_TIME, &pos)
+      || pos < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  downloaded =
+      gst_segment_to_stream_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
+
+  if (!GST_CLOCK_TIME_IS_VALID (downloaded))
+    return GST_CLOCK_TIME_NONE;
+
+  return downloaded > pos ? downloaded - pos : 0;
+}
+
+/* must be called with manifest_lock taken */
+static gboolean
+gst_adaptive_demux_stream_ensure_abr (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  const GstAdaptiveDemuxAbrAlgorithm *abr = NULL;
+
+  if (demux->priv->abr_algorithm)
+    abr = gst_adaptive_demux_abr_find (demux->priv->abr_algorithm);
+
+  if (abr != stream->abr) {
+    if (stream->abr)
+      stream->abr->free (stream->abr_state);
+    stream->abr_state = NULL;
+
+    stream->abr = abr;
+    if (abr) {
+      GST_INFO_OBJECT (stream->pad, "Using ABR algorithm %s", abr->name);
+      stream->abr_state = abr->create ();
+    } else if (demux->priv->abr_algorithm) {
+      GST_WARNING_OBJECT (demux, "Unknown ABR algorithm %s",
+          demux->priv->abr_algorithm);
+    }
+  }
+
+  return stream->abr != NULL;
+}
+
+/* must be called with manifest_lock taken */
+static guint64
+gst_adaptive_demux_stream_get_target_bitrate (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstClockTime duration)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxAbrFragment fragment;
+  GstAdaptiveDemuxAbrContext context;
+  GArray *bitrates;
+  guint64 bitrate;
+  guint current = 0;
+
+  /* keeps current_download_rate and the moving average up to date */
+  bitrate = gst_adaptive_demux_stream_update_current_bitrate (demux, stream);
+
+  if (demux->connection_speed || klass->stream_get_bitrates == NULL
+      || !gst_adaptive_demux_stream_ensure_abr (demux, stream))
+    return bitrate;
+
+  fragment.size = stream->fragment_bytes_downloaded;
+  fragment.duration = duration;
+  fragment.download_time = stream->last_download_time;
+  fragment.latency = stream->last_latency;
+  stream->abr->fragment_downloaded (stream->abr_state, &fragment);
+
+  /* the algorithms reason in media time, let the subclass handle trick
+   * modes as before */
+  if (ABS (demux->segment.rate) != 1.0)
+    return bitrate;
+
+  bitrates = g_array_new (FALSE, FALSE, sizeof (guint64));
+  if (klass->stream_get_bitrates (stream, bitrates, &current)
+      && bitrates->len > 0) {
+    guint index;
+
+    context.bitrates = (const guint64 *) bitrates->data;
+    context.n_bitrates = bitrates->len;
+    context.current = MIN (current, bitrates->len - 1);
+    context.buffer_level =
+        gst_adaptive_demux_stream_get_buffer_level (demux, stream);
+    context.fragment_duration = duration;
+
+    index = stream->abr->select_representation (stream->abr_state, &context);
+    bitrate = g_array_index (bitrates, guint64, MIN (index,
+            bitrates->len - 1));
+
+    GST_DEBUG_OBJECT (stream->pad, "%s selected bitrate %" G_GUINT64_FORMAT
+        " (buffer level %" GST_TIME_FORMAT ")", stream->abr->name, bitrate,
+        GST_TIME_ARGS (context.buffer_level));
+  }
+  g_array_free (bitrates, TRUE);
+
+  return bitrate;
+}
+
 /* must be called with manifest_lock taken */
 static GstFlowReturn
 gst_adaptive_demux_combine_flows (GstAdaptiveDemux * demux)
@@ -3117,6 +3357,379 @@ uritype (GstAdaptiveDemuxStream * s)
 }
 #endif
 
+static void
+gst_adaptive_demux_prefetch_entry_unref (GstAdaptiveDemuxPrefetchEntry * entry)
+{
+  if (!g_atomic_int_dec_and_test (&entry->ref_count))
+    return;
+
+  g_free (entry->uri);
+  if (entry->buffer)
+    gst_buffer_unref (entry->buffer);
+  g_slice_free (GstAdaptiveDemuxPrefetchEntry, entry);
+}
+
+/* must be called with the prefetch lock taken.
+ * Takes over the reference held by the entries queue */
+static void
+gst_adaptive_demux_prefetch_entry_cancel (GstAdaptiveDemuxPrefetchEntry * entry)
+{
+  entry->cancelled = TRUE;
+  if (entry->downloader)
+    gst_uri_downloader_cancel (entry->downloader);
+  gst_adaptive_demux_prefetch_entry_unref (entry);
+}
+
+/* Runs in the threads of the prefetch pool */
+static void
+gst_adaptive_demux_prefetch_download (GstAdaptiveDemuxPrefetchEntry * entry,
+    GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GstUriDownloader *downloader;
+  GstFragment *download;
+  GstBuffer *buffer = NULL;
+  GError *err = NULL;
+  gint64 range_end;
+
+  g_mutex_lock (&prefetch->lock);
+  if (entry->cancelled) {
+    g_mutex_unlock (&prefetch->lock);
+    gst_adaptive_demux_prefetch_entry_unref (entry);
+    return;
+  }
+
+  downloader = g_queue_pop_head (&prefetch->downloaders);
+  if (downloader == NULL) {
+    downloader = gst_uri_downloader_new ();
+    gst_uri_downloader_set_parent (downloader,
+        GST_ELEMENT_CAST (prefetch->demux));
+  }
+  /* forget about cancellations of its previous download, any later one is
+   * for this entry */
+  gst_uri_downloader_reset (downloader);
+  entry->downloader = downloader;
+  entry->state = PREFETCH_DOWNLOADING;
+  g_mutex_unlock (&prefetch->lock);
+
+  /* HTTP ranges are inclusive, GStreamer segments are exclusive for the
+   * stop position */
+  range_end = entry->range_end;
+  if (range_end != -1)
+    range_end += 1;
+
+  download = gst_uri_downloader_fetch_uri_with_range (downloader, entry->uri,
+      NULL, FALSE, FALSE, TRUE, entry->range_start, range_end, &err);
+  if (download)
+    buffer = gst_fragment_get_buffer (download);
+
+  g_mutex_lock (&prefetch->lock);
+  entry->downloader = NULL;
+  g_queue_push_tail (&prefetch->downloaders, downloader);
+  if (buffer != NULL && !entry->cancelled) {
+    entry->buffer = buffer;
+    entry->download_time =
+        download->download_stop_time - download->download_start_time;
+    entry->state = PREFETCH_DONE;
+    buffer = NULL;
+  } else {
+    GST_DEBUG_OBJECT (prefetch->demux, "Prefetching %s failed: %s",
+        entry->uri, err ? err->message : "cancelled");
+    entry->state = PREFETCH_FAILED;
+  }
+  g_cond_broadcast (&prefetch->cond);
+  g_mutex_unlock (&prefetch->lock);
+
+  if (buffer)
+    gst_buffer_unref (buffer);
+  if (download)
+    g_object_unref (download);
+  g_clear_error (&err);
+  gst_adaptive_demux_prefetch_entry_unref (entry);
+}
+
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_new (GstAdaptiveDemux * demux, guint depth)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = g_slice_new0 (GstAdaptiveDemuxPrefetch);
+
+  prefetch->demux = demux;
+  g_mutex_init (&prefetch->lock);
+  g_cond_init (&prefetch->cond);
+  g_queue_init (&prefetch->entries);
+  g_queue_init (&prefetch->downloaders);
+  prefetch->pool =
+      g_thread_pool_new ((GFunc) gst_adaptive_demux_prefetch_download,
+      prefetch, depth, FALSE, NULL);
+
+  return prefetch;
+}
+
+/* Drops all prefetched fragments and aborts their downloads */
+static void
+gst_adaptive_demux_prefetch_cancel (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GstAdaptiveDemuxPrefetchEntry *entry;
+
+  if (prefetch == NULL)
+    return;
+
+  g_mutex_lock (&prefetch->lock);
+  while ((entry = g_queue_pop_head (&prefetch->entries)))
+    gst_adaptive_demux_prefetch_entry_cancel (entry);
+  g_cond_broadcast (&prefetch->cond);
+  g_mutex_unlock (&prefetch->lock);
+}
+
+static void
+gst_adaptive_demux_prefetch_free (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  gst_adaptive_demux_prefetch_cancel (prefetch);
+
+  /* downloads that did not start yet will see they were cancelled */
+  g_thread_pool_free (prefetch->pool, FALSE, TRUE);
+
+  g_queue_foreach (&prefetch->downloaders, (GFunc) g_object_unref, NULL);
+  g_queue_clear (&prefetch->downloaders);
+  g_mutex_clear (&prefetch->lock);
+  g_cond_clear (&prefetch->cond);
+  g_slice_free (GstAdaptiveDemuxPrefetch, prefetch);
+}
+
+/* must be called with the prefetch lock taken */
+static GstAdaptiveDemuxPrefetchEntry *
+gst_adaptive_demux_prefetch_find (GstAdaptiveDemuxPrefetch * prefetch,
+    const gchar * uri, gint64 range_start, gint64 range_end)
+{
+  GList *iter;
+
+  for (iter = prefetch->entries.head; iter; iter = g_list_next (iter)) {
+    GstAdaptiveDemuxPrefetchEntry *entry = iter->data;
+
+    if (entry->range_start == range_start && entry->range_end == range_end
+        && g_strcmp0 (entry->uri, uri) == 0)
+      return entry;
+  }
+
+  return NULL;
+}
+
+/* must be called with the prefetch lock taken */
+static gsize
+gst_adaptive_demux_prefetch_get_size (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GList *iter;
+  gsize size = 0;
+
+  for (iter = prefetch->entries.head; iter; iter = g_list_next (iter)) {
+    GstAdaptiveDemuxPrefetchEntry *entry = iter->data;
+
+    if (entry->buffer)
+      size += gst_buffer_get_size (entry->buffer);
+  }
+
+  return size;
+}
+
+/* must be called with manifest_lock taken.
+ *
+ * Starts downloading the fragments that follow stream->fragment, up to the
+ * prefetch-depth property */
+static void
+gst_adaptive_demux_stream_prefetch_fragments (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxPrefetch *prefetch;
+  guint depth = demux->priv->prefetch_depth;
+  guint i;
+
+  /* Fragments downloaded in chunks are already pushed as they arrive */
+  if (depth == 0 || klass->stream_peek_fragment_info == NULL
+      || klass->need_another_chunk != NULL)
+    return;
+
+  if (stream->prefetch == NULL)
+    stream->prefetch = gst_adaptive_demux_prefetch_new (demux, depth);
+  prefetch = stream->prefetch;
+  g_thread_pool_set_max_threads (prefetch->pool, depth, NULL);
+
+  for (i = 1; i <= depth; i++) {
+    GstAdaptiveDemuxStreamFragment fragment = { 0, };
+    GstAdaptiveDemuxPrefetchEntry *entry;
+
+    fragment.range_end = -1;
+    if (!klass->stream_peek_fragment_info (stream, i, &fragment)
+        || fragment.uri == NULL) {
+      gst_adaptive_demux_stream_fragment_clear (&fragment);
+      break;
+    }
+
+    g_mutex_lock (&prefetch->lock);
+    entry = gst_adaptive_demux_prefetch_find (prefetch, fragment.uri,
+        fragment.range_start, fragment.range_end);
+    if (entry == NULL) {
+      if (prefetch->entries.length >= depth ||
+          gst_adaptive_demux_prefetch_get_size (prefetch) >=
+          PREFETCH_MAX_BYTES) {
+        g_mutex_unlock (&prefetch->lock);
+        gst_adaptive_demux_stream_fragment_clear (&fragment);
+        break;
+      }
+
+      GST_LOG_OBJECT (stream->pad, "Prefetching %s, range:%" G_GINT64_FORMAT
+          " - %" G_GINT64_FORMAT, fragment.uri, fragment.range_start,
+          fragment.range_end);
+
+      entry = g_slice_new0 (GstAdaptiveDemuxPrefetchEntry);
+      /* one reference for the queue and one for the download */
+      entry->ref_count = 2;
+      entry->uri = fragment.uri;
+      fragment.uri = NULL;
+      entry->range_start = fragment.range_start;
+      entry->range_end = fragment.range_end;
+      entry->state = PREFETCH_QUEUED;
+      g_queue_push_tail (&prefetch->entries, entry);
+      g_thread_pool_push (prefetch->pool, entry, NULL);
+    }
+    g_mutex_unlock (&prefetch->lock);
+
+    gst_adaptive_demux_stream_fragment_clear (&fragment);
+  }
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Returns the prefetched stream->fragment, waiting for its download to
+ * finish if needed, or NULL if it has to be downloaded by the stream */
+static GstAdaptiveDemuxPrefetchEntry *
+gst_adaptive_demux_stream_take_prefetched (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = stream->prefetch;
+  GstAdaptiveDemuxPrefetchEntry *entry, *head;
+  gboolean done;
+
+  if (prefetch == NULL || stream->internal_pad == NULL)
+    return NULL;
+
+  g_mutex_lock (&prefetch->lock);
+  if (g_queue_is_empty (&prefetch->entries)) {
+    g_mutex_unlock (&prefetch->lock);
+    return NULL;
+  }
+
+  entry = gst_adaptive_demux_prefetch_find (prefetch, stream->fragment.uri,
+      stream->fragment.range_start, stream->fragment.range_end);
+  if (entry == NULL) {
+    /* the stream did not continue where we expected */
+    while ((head = g_queue_pop_head (&prefetch->entries)))
+      gst_adaptive_demux_prefetch_entry_cancel (head);
+    g_mutex_unlock (&prefetch->lock);
+    prefetch->misses++;
+    GST_DEBUG_OBJECT (stream->pad, "Fragment %s was not prefetched",
+        stream->fragment.uri);
+    return NULL;
+  }
+
+  /* the fragments before this one were skipped */
+  while ((head = g_queue_peek_head (&prefetch->entries)) != entry)
+    gst_adaptive_demux_prefetch_entry_cancel (g_queue_pop_head
+        (&prefetch->entries));
+
+  g_atomic_int_inc (&entry->ref_count);
+  done = entry->state == PREFETCH_DONE || entry->state == PREFETCH_FAILED;
+  g_mutex_unlock (&prefetch->lock);
+
+  if (!done) {
+    GST_DEBUG_OBJECT (stream->pad, "Waiting for prefetch of %s", entry->uri);
+
+    GST_MANIFEST_UNLOCK (demux);
+    g_mutex_lock (&prefetch->lock);
+    while (!entry->cancelled && (entry->state == PREFETCH_QUEUED
+            || entry->state == PREFETCH_DOWNLOADING))
+      g_cond_wait (&prefetch->cond, &prefetch->lock);
+    g_mutex_unlock (&prefetch->lock);
+    GST_MANIFEST_LOCK (demux);
+  }
+
+  g_mutex_lock (&prefetch->lock);
+  done = !entry->cancelled && entry->state == PREFETCH_DONE;
+  if (!entry->cancelled) {
+    g_queue_remove (&prefetch->entries, entry);
+    gst_adaptive_demux_prefetch_entry_unref (entry);
+  }
+  g_mutex_unlock (&prefetch->lock);
+
+  if (!done) {
+    gst_adaptive_demux_prefetch_entry_unref (entry);
+    prefetch->misses++;
+    return NULL;
+  }
+
+  prefetch->hits++;
+  GST_DEBUG_OBJECT (stream->pad, "Using prefetched %s, %u hits %u misses",
+      entry->uri, prefetch->hits, prefetch->misses);
+
+  return entry;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Pushes a prefetched fragment through the same path as the data downloaded
+ * by the source element. */
+static GstFlowReturn
+gst_adaptive_demux_stream_push_prefetched (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstAdaptiveDemuxPrefetchEntry * entry)
+{
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+  gsize size;
+
+  buffer = entry->buffer;
+  entry->buffer = NULL;
+  size = gst_buffer_get_size (buffer);
+
+  /* what _uri_handler_probe() measures for the source element */
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+  stream->fragment_bytes_downloaded = size;
+  stream->last_latency = GST_CLOCK_TIME_NONE;
+  stream->last_download_time = entry->download_time;
+  stream->last_bitrate = gst_util_uint64_scale (size, 8 * GST_SECOND,
+      MAX (entry->download_time, 1));
+
+  /* _src_chain() would ask the source element for the size */
+  if (stream->fragment.bitrate == 0 && stream->fragment.duration != 0) {
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+  }
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  GST_MANIFEST_UNLOCK (demux);
+  ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    ret = stream->last_ret = GST_FLOW_FLUSHING;
+    g_mutex_unlock (&stream->fragment_download_lock);
+    return ret;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* the whole fragment was pushed, as if the source element went EOS */
+  if (ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+
+  return stream->last_ret;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  *
@@ -3439,9 +4052,24 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
+    GstAdaptiveDemuxPrefetchEntry *prefetched =
+        gst_adaptive_demux_stream_take_prefetched (demux, stream);
+
+    /* Look ahead only now: the current fragment is never queued itself, and
+     * finding the queue filled with the fragments after it would be taken
+     * as a miss, cancelling them */
+    gst_adaptive_demux_stream_prefetch_fragments (demux, stream);
+
+    if (prefetched) {
+      ret = gst_adaptive_demux_stream_push_prefetched (demux, stream,
+          prefetched);
+      gst_adaptive_demux_prefetch_entry_unref (prefetched);
+    } else {
+      ret =
+          gst_adaptive_demux_stream_download_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
+    }
     GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
         stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
   }
@@ -3995,34 +4623,49 @@ gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux)
   /* Updating playlist only needed for live playlists */
   while (gst_adaptive_demux_is_live (demux)) {
     GstFlowReturn ret = GST_FLOW_OK;
+    gchar *blocking_uri = NULL;
 
-    /* Wait here until we should do the next update or we're cancelled */
-    GST_DEBUG_OBJECT (demux, "Wait for next playlist update");
+    /* After failures, fall back to regular updates */
+    if (klass->get_blocking_manifest_update_uri
+        && demux->priv->update_failed_count == 0)
+      blocking_uri = klass->get_blocking_manifest_update_uri (demux);
 
-    GST_MANIFEST_UNLOCK (demux);
+    if (blocking_uri) {
+      ret = gst_adaptive_demux_update_manifest_blocking (demux, blocking_uri);
+      g_free (blocking_uri);
+      if (ret == GST_FLOW_FLUSHING) {
+        GST_MANIFEST_UNLOCK (demux);
+        goto quit;
+      }
+    } else {
+      /* Wait here until we should do the next update or we're cancelled */
+      GST_DEBUG_OBJECT (demux, "Wait for next playlist update");
 
-    g_mutex_lock (&demux->priv->updates_timed_lock);
-    if (demux->priv->stop_updates_task) {
+      GST_MANIFEST_UNLOCK (demux);
+
+      g_mutex_lock (&demux->priv->updates_timed_lock);
+      if (demux->priv->stop_updates_task) {
+        g_mutex_unlock (&demux->priv->updates_timed_lock);
+        goto quit;
+      }
+      gst_adaptive_demux_wait_until (demux->realtime_clock,
+          &demux->priv->updates_timed_cond,
+          &demux->priv->updates_timed_lock, next_update);
       g_mutex_unlock (&demux->priv->updates_timed_lock);
-      goto quit;
-    }
-    gst_adaptive_demux_wait_until (demux->realtime_clock,
-        &demux->priv->updates_timed_cond,
-        &demux->priv->updates_timed_lock, next_update);
-    g_mutex_unlock (&demux->priv->updates_timed_lock);
 
-    g_mutex_lock (&demux->priv->updates_timed_lock);
-    if (demux->priv->stop_updates_task) {
+      g_mutex_lock (&demux->priv->updates_timed_lock);
+      if (demux->priv->stop_updates_task) {
+        g_mutex_unlock (&demux->priv->updates_timed_lock);
+        goto quit;
+      }
       g_mutex_unlock (&demux->priv->updates_timed_lock);
-      goto quit;
-    }
-    g_mutex_unlock (&demux->priv->updates_timed_lock);
 
-    GST_MANIFEST_LOCK (demux);
+      GST_MANIFEST_LOCK (demux);
 
-    GST_DEBUG_OBJECT (demux, "Updating playlist");
+      GST_DEBUG_OBJECT (demux, "Updating playlist");
 
-    ret = gst_adaptive_demux_update_manifest (demux);
+      ret = gst_adaptive_demux_update_manifest (demux);
+    }
 
     if (ret == GST_FLOW_EOS) {
     } else if (ret != GST_FLOW_OK) {
@@ -4162,6 +4805,7 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstClockTime duration)
 {
   GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstStructure *stats;
   GstFlowReturn ret;
 
   g_return_val_if_fail (klass->stream_advance_fragment != NULL, GST_FLOW_ERROR);
@@ -4177,17 +4821,22 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
   /* FIXME : All those time statistics are biased, since they are calculated
    * *AFTER* the queue2, which might be blocking. They should ideally be
    * calculated *before* queue2 in the uri_handler_probe */
+  stats = gst_structure_new (GST_ADAPTIVE_DEMUX_STATISTICS_MESSAGE_NAME,
+      "manifest-uri", G_TYPE_STRING,
+      demux->manifest_uri, "uri", G_TYPE_STRING,
+      stream->fragment.uri, "fragment-start-time",
+      GST_TYPE_CLOCK_TIME, stream->download_start_time,
+      "fragment-stop-time", GST_TYPE_CLOCK_TIME,
+      gst_util_get_timestamp (), "fragment-size", G_TYPE_UINT64,
+      stream->download_total_bytes, "fragment-download-time",
+      GST_TYPE_CLOCK_TIME, stream->last_download_time, NULL);
+  if (stream->prefetch) {
+    gst_structure_set (stats, "prefetch-hits", G_TYPE_UINT,
+        stream->prefetch->hits, "prefetch-misses", G_TYPE_UINT,
+        stream->prefetch->misses, NULL);
+  }
   gst_element_post_message (GST_ELEMENT_CAST (demux),
-      gst_message_new_element (GST_OBJECT_CAST (demux),
-          gst_structure_new (GST_ADAPTIVE_DEMUX_STATISTICS_MESSAGE_NAME,
-              "manifest-uri", G_TYPE_STRING,
-              demux->manifest_uri, "uri", G_TYPE_STRING,
-              stream->fragment.uri, "fragment-start-time",
-              GST_TYPE_CLOCK_TIME, stream->download_start_time,
-              "fragment-stop-time", GST_TYPE_CLOCK_TIME,
-              gst_util_get_timestamp (), "fragment-size", G_TYPE_UINT64,
-              stream->download_total_bytes, "fragment-download-time",
-              GST_TYPE_CLOCK_TIME, stream->last_download_time, NULL)));
+      gst_message_new_element (GST_OBJECT_CAST (demux), stats));
 
   /* Don't update to the end of the segment if in reverse playback */
   GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
@@ -4228,8 +4877,10 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
 
   if (ret == GST_FLOW_OK) {
     if (gst_adaptive_demux_stream_select_bitrate (demux, stream,
-            gst_adaptive_demux_stream_update_current_bitrate (demux, stream))) {
+            gst_adaptive_demux_stream_get_target_bitrate (demux, stream,
+                duration))) {
       stream->need_header = TRUE;
+      gst_adaptive_demux_prefetch_cancel (stream->prefetch);
       ret = (GstFlowReturn) GST_ADAPTIVE_DEMUX_FLOW_SWITCH;
     }
 
@@ -4366,6 +5017,39 @@ gst_adaptive_demux_update_manifest_default (GstAdaptiveDemux * demux)
   return ret;
 }
 
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_manifest_updated (GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstClockTime duration;
+
+  /* Send an updated duration message */
+  duration = klass->get_duration (demux);
+  if (duration != GST_CLOCK_TIME_NONE) {
+    GST_DEBUG_OBJECT (demux,
+        "Sending duration message : %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (duration));
+    gst_element_post_message (GST_ELEMENT (demux),
+        gst_message_new_duration_changed (GST_OBJECT (demux)));
+  } else {
+    GST_DEBUG_OBJECT (demux,
+        "Duration unknown, can not send the duration message");
+  }
+
+  /* If a manifest changes it's liveness or periodic updateness, we need
+   * to start/stop the manifest update task appropriately */
+  /* Keep this condition in sync with the one in
+   * gst_adaptive_demux_start_manifest_update_task()
+   */
+  if (gst_adaptive_demux_is_live (demux) &&
+      klass->requires_periodical_playlist_update (demux)) {
+    gst_adaptive_demux_start_manifest_update_task (demux);
+  } else {
+    gst_adaptive_demux_stop_manifest_update_task (demux);
+  }
+}
+
 /* must be called with manifest_lock taken */
 static GstFlowReturn
 gst_adaptive_demux_update_manifest (GstAdaptiveDemux * demux)
@@ -4375,34 +5059,56 @@ gst_adaptive_demux_update_manifest (GstAdaptiveDemux * demux)
 
   ret = klass->update_manifest (demux);
 
-  if (ret == GST_FLOW_OK) {
-    GstClockTime duration;
-    /* Send an updated duration message */
-    duration = klass->get_duration (demux);
-    if (duration != GST_CLOCK_TIME_NONE) {
-      GST_DEBUG_OBJECT (demux,
-          "Sending duration message : %" GST_TIME_FORMAT,
-          GST_TIME_ARGS (duration));
-      gst_element_post_message (GST_ELEMENT (demux),
-          gst_message_new_duration_changed (GST_OBJECT (demux)));
-    } else {
-      GST_DEBUG_OBJECT (demux,
-          "Duration unknown, can not send the duration message");
-    }
+  if (ret == GST_FLOW_OK)
+    gst_adaptive_demux_manifest_updated (demux);
 
-    /* If a manifest changes it's liveness or periodic updateness, we need
-     * to start/stop the manifest update task appropriately */
-    /* Keep this condition in sync with the one in
-     * gst_adaptive_demux_start_manifest_update_task()
-     */
-    if (gst_adaptive_demux_is_live (demux) &&
-        klass->requires_periodical_playlist_update (demux)) {
-      gst_adaptive_demux_start_manifest_update_task (demux);
-    } else {
-      gst_adaptive_demux_stop_manifest_update_task (demux);
-    }
+  return ret;
+}
+
+/* must be called with manifest_lock taken, which is released while
+ * waiting for the answer to the request */
+static GstFlowReturn
+gst_adaptive_demux_update_manifest_blocking (GstAdaptiveDemux * demux,
+    const gchar * uri)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstFragment *download;
+  GstFlowReturn ret;
+  GError *error = NULL;
+  gchar *referer;
+
+  GST_DEBUG_OBJECT (demux, "Blocking manifest request %s", uri);
+
+  referer = g_strdup (demux->manifest_uri);
+  GST_MANIFEST_UNLOCK (demux);
+  download = gst_uri_downloader_fetch_uri (demux->priv->updates_downloader,
+      uri, referer, TRUE, TRUE, TRUE, &error);
+  g_free (referer);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&demux->priv->updates_timed_lock);
+  if (demux->priv->stop_updates_task) {
+    g_mutex_unlock (&demux->priv->updates_timed_lock);
+    if (download)
+      g_object_unref (download);
+    g_clear_error (&error);
+    return GST_FLOW_FLUSHING;
+  }
+  g_mutex_unlock (&demux->priv->updates_timed_lock);
+
+  if (download == NULL) {
+    GST_WARNING_OBJECT (demux, "Blocking manifest request failed: %s",
+        error ? error->message : "unknown error");
+    g_clear_error (&error);
+    return GST_FLOW_ERROR;
   }
 
+  ret = klass->update_manifest_from_download (demux, download);
+  g_object_unref (download);
+
+  if (ret == GST_FLOW_OK)
+    gst_adaptive_demux_manifest_updated (demux);
+
   return ret;
 }
 
@@ -26,6 +26,7 @@
 #include <gst/base/gstadapter.h>
 #include <gst/uridownloader/gsturidownloader.h>
 #include <gst/adaptivedemux/adaptive-demux-prelude.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
 
 G_BEGIN_DECLS
 
@@ -92,6 +93,7 @@ typedef struct _GstAdaptiveDemuxStream GstAdaptiveDemuxStream;
 typedef struct _GstAdaptiveDemux GstAdaptiveDemux;
 typedef struct _GstAdaptiveDemuxClass GstAdaptiveDemuxClass;
 typedef struct _GstAdaptiveDemuxPrivate GstAdaptiveDemuxPrivate;
+typedef struct _GstAdaptiveDemuxPrefetch GstAdaptiveDemuxPrefetch;
 
 struct _GstAdaptiveDemuxStreamFragment
 {
@@ -195,6 +197,13 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* fragments downloaded ahead of time, NULL if prefetching is disabled */
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  /* ABR algorithm replacing the default bitrate selection, if any */
+  const GstAdaptiveDemuxAbrAlgorithm *abr;
+  gpointer abr_state;
 };
 
 /**
@@ -482,6 +491,76 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment_info:
+   * @stream: #GstAdaptiveDemuxStream
+   * @index: number of fragments after the current one
+   * @fragment: #GstAdaptiveDemuxStreamFragment to fill
+   *
+   * Fills the uri and byte range of the fragment that comes @index
+   * fragments after the current one in @fragment, without changing the
+   * position of @stream. Optional, fragments are only prefetched for
+   * subclasses implementing it.
+   *
+   * Returns: %TRUE if there is such a fragment
+   *
+   * Since: 1.18
+   */
+  gboolean (*stream_peek_fragment_info) (GstAdaptiveDemuxStream * stream, guint index, GstAdaptiveDemuxStreamFragment * fragment);
+
+  /**
+   * stream_get_bitrates:
+   * @stream: #GstAdaptiveDemuxStream
+   * @bitrates: #GArray of #guint64 to append the bitrates to
+   * @current: location for the index of the current representation
+   *
+   * Appends the bitrates of the representations @stream can switch between
+   * to @bitrates, in increasing order, and stores the index of the one
+   * currently used in @current. Passing one of them to
+   * #GstAdaptiveDemuxClass.stream_select_bitrate() must select that
+   * representation. Optional, the #GstAdaptiveDemux:abr-algorithm is only
+   * used with subclasses implementing it.
+   *
+   * Returns: %TRUE if @stream can switch representations
+   *
+   * Since: 1.18
+   */
+  gboolean (*stream_get_bitrates) (GstAdaptiveDemuxStream * stream, GArray * bitrates, guint * current);
+
+  /**
+   * get_blocking_manifest_update_uri:
+   * @demux: #GstAdaptiveDemux
+   *
+   * During live streaming, returns the URI of a blocking manifest request,
+   * which the server only answers once the manifest was updated. The
+   * manifest update task then requests it right after the previous update
+   * instead of waiting for the update interval, without holding the
+   * manifest lock, and passes the answer to
+   * #GstAdaptiveDemuxClass.update_manifest_from_download(). Optional.
+   *
+   * Returns: (transfer full) (nullable): the URI, or %NULL to wait for the
+   *          update interval
+   *
+   * Since: 1.18
+   */
+  gchar *       (*get_blocking_manifest_update_uri) (GstAdaptiveDemux * demux);
+
+  /**
+   * update_manifest_from_download:
+   * @demux: #GstAdaptiveDemux
+   * @download: the answer to the blocking manifest request
+   *
+   * Updates the manifest from the answer to the request returned by
+   * #GstAdaptiveDemuxClass.get_blocking_manifest_update_uri(), which must
+   * be implemented along with it.
+   *
+   * Returns: #GST_FLOW_OK is all succeeded, #GST_FLOW_EOS if the stream ended
+   *          or #GST_FLOW_ERROR if an error happened
+   *
+   * Since: 1.18
+   */
+  GstFlowReturn (*update_manifest_from_download) (GstAdaptiveDemux * demux, GstFragment * download);
 };
 
 GST_ADAPTIVE_DEMUX_API
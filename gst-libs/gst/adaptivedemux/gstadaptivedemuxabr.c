@@ -0,0 +1,350 @@
+/* GStreamer
+ *
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstadaptivedemuxabr
+ * @short_description: Adaptive bitrate algorithms for adaptive demuxers
+ *
+ * By default #GstAdaptiveDemux picks the representation with the highest
+ * bitrate below the recently measured download rate. This reacts to every
+ * change of the throughput, which makes it switch back and forth on links
+ * with a fluctuating rate.
+ *
+ * A #GstAdaptiveDemuxAbrAlgorithm replaces that heuristic when its name is
+ * set on the #GstAdaptiveDemux:abr-algorithm property. It is fed the size,
+ * download time and latency of each fragment and selects the representation
+ * of the next one, knowing how much media is buffered downstream.
+ * Applications can provide their own algorithms with
+ * gst_adaptive_demux_abr_register().
+ *
+ * The "bola" algorithm is always available. It follows the BOLA buffer
+ * based controller as used in dash.js: with enough media buffered, the
+ * buffer level decides which representation to use, so short throughput
+ * drops are absorbed by the buffer instead of causing switches. A
+ * throughput rule based on two exponentially weighted moving averages of
+ * the download rate is used while the buffer fills up, and limits how far
+ * above the sustainable bitrate the buffer rule can go.
+ *
+ * Since: 1.18
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "gstadaptivedemuxabr.h"
+
+GST_DEBUG_CATEGORY_STATIC (adaptivedemux_abr_debug);
+#define GST_CAT_DEFAULT adaptivedemux_abr_debug
+
+/* buffer level below which the throughput rule is used */
+#define BOLA_MIN_BUFFER (10 * GST_SECOND)
+/* the buffer target grows with the number of representations */
+#define BOLA_MIN_BUFFER_PER_LEVEL (2 * GST_SECOND)
+#define BOLA_STABLE_BUFFER (12 * GST_SECOND)
+
+/* half lives of the download rate averages, in seconds of download */
+#define BOLA_FAST_HALF_LIFE 2.0
+#define BOLA_SLOW_HALF_LIFE 5.0
+
+/* fraction of the estimated download rate the throughput rule uses */
+#define BOLA_THROUGHPUT_SAFETY 0.9
+
+typedef struct
+{
+  gdouble half_life;
+  gdouble estimate;
+  /* sum of the weights, to correct the bias towards the initial 0 */
+  gdouble total_weight;
+} GstAdaptiveDemuxAbrEwma;
+
+typedef struct
+{
+  GstAdaptiveDemuxAbrEwma fast;
+  GstAdaptiveDemuxAbrEwma slow;
+  gdouble latency;              /* seconds */
+  guint n_samples;
+} GstAdaptiveDemuxBola;
+
+static GMutex abr_lock;
+static GList *abr_algorithms;   /* protected by abr_lock */
+
+static void
+gst_adaptive_demux_abr_ewma_sample (GstAdaptiveDemuxAbrEwma * ewma,
+    gdouble weight, gdouble value)
+{
+  gdouble alpha = pow (0.5, weight / ewma->half_life);
+
+  ewma->estimate = alpha * ewma->estimate + (1.0 - alpha) * value;
+  ewma->total_weight = alpha * ewma->total_weight + (1.0 - alpha);
+}
+
+static gdouble
+gst_adaptive_demux_abr_ewma_get (GstAdaptiveDemuxAbrEwma * ewma)
+{
+  if (ewma->total_weight <= 0.0)
+    return 0.0;
+  return ewma->estimate / ewma->total_weight;
+}
+
+static gpointer
+gst_adaptive_demux_bola_create (void)
+{
+  GstAdaptiveDemuxBola *bola = g_new0 (GstAdaptiveDemuxBola, 1);
+
+  bola->fast.half_life = BOLA_FAST_HALF_LIFE;
+  bola->slow.half_life = BOLA_SLOW_HALF_LIFE;
+
+  return bola;
+}
+
+static void
+gst_adaptive_demux_bola_free (gpointer state)
+{
+  g_free (state);
+}
+
+static void
+gst_adaptive_demux_bola_fragment_downloaded (gpointer state,
+    const GstAdaptiveDemuxAbrFragment * fragment)
+{
+  GstAdaptiveDemuxBola *bola = state;
+  gdouble download_time, latency, rate;
+
+  if (!GST_CLOCK_TIME_IS_VALID (fragment->download_time)
+      || fragment->download_time == 0 || fragment->size == 0)
+    return;
+
+  download_time = (gdouble) fragment->download_time / GST_SECOND;
+  rate = fragment->size * 8 / download_time;
+
+  /* longer downloads are more significant measurements */
+  gst_adaptive_demux_abr_ewma_sample (&bola->fast, download_time, rate);
+  gst_adaptive_demux_abr_ewma_sample (&bola->slow, download_time, rate);
+
+  latency = 0.0;
+  if (GST_CLOCK_TIME_IS_VALID (fragment->latency))
+    latency = (gdouble) fragment->latency / GST_SECOND;
+  if (bola->n_samples == 0)
+    bola->latency = latency;
+  else
+    bola->latency = 0.8 * bola->latency + 0.2 * latency;
+
+  bola->n_samples++;
+}
+
+/* highest representation that can be downloaded faster than it plays,
+ * including the request latency */
+static guint
+gst_adaptive_demux_bola_throughput_index (GstAdaptiveDemuxBola * bola,
+    const GstAdaptiveDemuxAbrContext * context)
+{
+  gdouble available;
+  guint i;
+
+  available = MIN (gst_adaptive_demux_abr_ewma_get (&bola->fast),
+      gst_adaptive_demux_abr_ewma_get (&bola->slow)) * BOLA_THROUGHPUT_SAFETY;
+
+  if (GST_CLOCK_TIME_IS_VALID (context->fragment_duration)
+      && context->fragment_duration > 0) {
+    gdouble duration = (gdouble) context->fragment_duration / GST_SECOND;
+
+    if (duration > bola->latency)
+      available *= (duration - bola->latency) / duration;
+  }
+
+  for (i = context->n_bitrates - 1; i > 0; i--) {
+    if (context->bitrates[i] <= available)
+      break;
+  }
+
+  return i;
+}
+
+/* representation maximizing the BOLA objective for the buffer level */
+static guint
+gst_adaptive_demux_bola_buffer_index (const GstAdaptiveDemuxAbrContext *
+    context)
+{
+  gdouble lowest = MAX (context->bitrates[0], 1);
+  gdouble buffer, buffer_target, min_buffer, gp, vp, best_score = 0.0;
+  guint i, best = 0;
+
+  buffer = (gdouble) context->buffer_level / GST_SECOND;
+  min_buffer = (gdouble) BOLA_MIN_BUFFER / GST_SECOND;
+  buffer_target = (gdouble) MAX (BOLA_STABLE_BUFFER, BOLA_MIN_BUFFER +
+      BOLA_MIN_BUFFER_PER_LEVEL * context->n_bitrates) / GST_SECOND;
+
+  /* the utility of a representation is the log of its bitrate, offset to
+   * be 1 for the lowest one */
+  gp = log (context->bitrates[context->n_bitrates - 1] / lowest) /
+      (buffer_target / min_buffer - 1.0);
+  if (gp <= 0.0)
+    return context->n_bitrates - 1;
+  vp = min_buffer / gp;
+
+  for (i = 0; i < context->n_bitrates; i++) {
+    gdouble bitrate = MAX (context->bitrates[i], 1);
+    gdouble utility = log (bitrate / lowest) + 1.0;
+    gdouble score = (vp * (utility + gp) - buffer) / bitrate;
+
+    if (i == 0 || score >= best_score) {
+      best_score = score;
+      best = i;
+    }
+  }
+
+  return best;
+}
+
+static guint
+gst_adaptive_demux_bola_select_representation (gpointer state,
+    const GstAdaptiveDemuxAbrContext * context)
+{
+  GstAdaptiveDemuxBola *bola = state;
+  guint current, throughput, best;
+
+  current = MIN (context->current, context->n_bitrates - 1);
+  if (context->n_bitrates == 1 || bola->n_samples == 0)
+    return current;
+
+  throughput = gst_adaptive_demux_bola_throughput_index (bola, context);
+
+  /* startup, or the buffer ran low: follow the throughput, but only go up
+   * one representation at a time */
+  if (!GST_CLOCK_TIME_IS_VALID (context->buffer_level)
+      || context->buffer_level < BOLA_MIN_BUFFER) {
+    best = MIN (throughput, current + 1);
+    GST_LOG ("buffer level %" GST_TIME_FORMAT ", throughput rule selects %u",
+        GST_TIME_ARGS (context->buffer_level), best);
+    return best;
+  }
+
+  best = gst_adaptive_demux_bola_buffer_index (context);
+
+  /* don't go up beyond what the throughput sustains (BOLA-O) */
+  if (best > current && best > throughput)
+    best = MAX (throughput, current);
+  /* and only go down when the throughput requires it, the buffer is there to
+   * absorb short drops */
+  if (best < current)
+    best = MAX (best, MIN (current, throughput));
+  if (GST_CLOCK_TIME_IS_VALID (context->fragment_duration)
+      && context->buffer_level < context->fragment_duration)
+    best = MIN (best, throughput);
+
+  GST_LOG ("buffer level %" GST_TIME_FORMAT ", throughput index %u, "
+      "current %u, selected %u", GST_TIME_ARGS (context->buffer_level),
+      throughput, current, best);
+
+  return best;
+}
+
+static const GstAdaptiveDemuxAbrAlgorithm bola_algorithm = {
+  GST_ADAPTIVE_DEMUX_ABR_BOLA,
+  gst_adaptive_demux_bola_create,
+  gst_adaptive_demux_bola_free,
+  gst_adaptive_demux_bola_fragment_downloaded,
+  gst_adaptive_demux_bola_select_representation,
+};
+
+/* must be called with abr_lock taken */
+static void
+gst_adaptive_demux_abr_init (void)
+{
+  static gboolean initialized = FALSE;
+
+  if (initialized)
+    return;
+
+  GST_DEBUG_CATEGORY_INIT (adaptivedemux_abr_debug, "adaptivedemuxabr", 0,
+      "Adaptive demux ABR algorithms");
+
+  abr_algorithms = g_list_append (abr_algorithms, (gpointer) & bola_algorithm);
+  initialized = TRUE;
+}
+
+/**
+ * gst_adaptive_demux_abr_register:
+ * @algorithm: a #GstAdaptiveDemuxAbrAlgorithm
+ *
+ * Makes @algorithm available to gst_adaptive_demux_abr_find() and the
+ * #GstAdaptiveDemux:abr-algorithm property. If an algorithm with the same
+ * name was registered before, @algorithm is used instead from now on.
+ *
+ * @algorithm must stay valid as long as the library is used, usually it is
+ * a static structure.
+ *
+ * Since: 1.18
+ */
+void
+gst_adaptive_demux_abr_register (const GstAdaptiveDemuxAbrAlgorithm *
+    algorithm)
+{
+  g_return_if_fail (algorithm != NULL);
+  g_return_if_fail (algorithm->name != NULL);
+  g_return_if_fail (algorithm->create != NULL);
+  g_return_if_fail (algorithm->free != NULL);
+  g_return_if_fail (algorithm->fragment_downloaded != NULL);
+  g_return_if_fail (algorithm->select_representation != NULL);
+
+  g_mutex_lock (&abr_lock);
+  gst_adaptive_demux_abr_init ();
+  abr_algorithms = g_list_prepend (abr_algorithms, (gpointer) algorithm);
+  g_mutex_unlock (&abr_lock);
+
+  GST_DEBUG ("registered ABR algorithm %s", algorithm->name);
+}
+
+/**
+ * gst_adaptive_demux_abr_find:
+ * @name: name of the algorithm
+ *
+ * Looks up a #GstAdaptiveDemuxAbrAlgorithm registered with
+ * gst_adaptive_demux_abr_register() or shipped with the library.
+ *
+ * Returns: (transfer none) (nullable): the algorithm called @name, or %NULL
+ *
+ * Since: 1.18
+ */
+const GstAdaptiveDemuxAbrAlgorithm *
+gst_adaptive_demux_abr_find (const gchar * name)
+{
+  const GstAdaptiveDemuxAbrAlgorithm *algorithm = NULL;
+  GList *iter;
+
+  g_return_val_if_fail (name != NULL, NULL);
+
+  g_mutex_lock (&abr_lock);
+  gst_adaptive_demux_abr_init ();
+  for (iter = abr_algorithms; iter; iter = g_list_next (iter)) {
+    const GstAdaptiveDemuxAbrAlgorithm *cur = iter->data;
+
+    if (g_strcmp0 (cur->name, name) == 0) {
+      algorithm = cur;
+      break;
+    }
+  }
+  g_mutex_unlock (&abr_lock);
+
+  return algorithm;
+}
@@ -0,0 +1,127 @@
+/* GStreamer
+ *
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_ADAPTIVE_DEMUX_ABR_H_
+#define _GST_ADAPTIVE_DEMUX_ABR_H_
+
+#include <gst/gst.h>
+#include <gst/adaptivedemux/adaptive-demux-prelude.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GST_ADAPTIVE_DEMUX_ABR_BOLA:
+ *
+ * Name of the buffer based algorithm shipped with the library, a BOLA
+ * controller combined with a throughput rule.
+ *
+ * Since: 1.18
+ */
+#define GST_ADAPTIVE_DEMUX_ABR_BOLA "bola"
+
+typedef struct _GstAdaptiveDemuxAbrFragment GstAdaptiveDemuxAbrFragment;
+typedef struct _GstAdaptiveDemuxAbrContext GstAdaptiveDemuxAbrContext;
+typedef struct _GstAdaptiveDemuxAbrAlgorithm GstAdaptiveDemuxAbrAlgorithm;
+
+/**
+ * GstAdaptiveDemuxAbrFragment:
+ * @size: number of bytes downloaded
+ * @duration: media duration of the fragment, or %GST_CLOCK_TIME_NONE
+ * @download_time: time from the request to the last byte
+ * @latency: time from the request to the first byte, or
+ *     %GST_CLOCK_TIME_NONE if unknown
+ *
+ * Measurements of a finished fragment download.
+ *
+ * Since: 1.18
+ */
+struct _GstAdaptiveDemuxAbrFragment
+{
+  guint64 size;
+  GstClockTime duration;
+  GstClockTime download_time;
+  GstClockTime latency;
+};
+
+/**
+ * GstAdaptiveDemuxAbrContext:
+ * @bitrates: (array length=n_bitrates): bitrates of the representations in
+ *     bits per second, in increasing order
+ * @n_bitrates: number of entries in @bitrates, at least 1
+ * @current: index of the representation currently downloaded
+ * @buffer_level: amount of media downloaded but not played yet, or
+ *     %GST_CLOCK_TIME_NONE if unknown
+ * @fragment_duration: expected duration of the next fragment, or
+ *     %GST_CLOCK_TIME_NONE if unknown
+ *
+ * State of the stream a representation is selected for.
+ *
+ * Since: 1.18
+ */
+struct _GstAdaptiveDemuxAbrContext
+{
+  const guint64 *bitrates;
+  guint n_bitrates;
+  guint current;
+  GstClockTime buffer_level;
+  GstClockTime fragment_duration;
+};
+
+/**
+ * GstAdaptiveDemuxAbrAlgorithm:
+ * @name: name used to select the algorithm
+ * @create: creates the per stream state of the algorithm
+ * @free: frees the state returned by @create
+ * @fragment_downloaded: feeds the measurements of a finished fragment
+ * @select_representation: returns the index in @context's bitrates of the
+ *     representation to download next
+ *
+ * Adaptive bitrate algorithm used by #GstAdaptiveDemux streams instead of
+ * the default throughput heuristic. Each stream has its own state, which is
+ * never used from several threads at once.
+ *
+ * Since: 1.18
+ */
+struct _GstAdaptiveDemuxAbrAlgorithm
+{
+  const gchar *name;
+
+  gpointer (*create) (void);
+  void     (*free) (gpointer state);
+
+  void     (*fragment_downloaded) (gpointer state,
+                                   const GstAdaptiveDemuxAbrFragment * fragment);
+  guint    (*select_representation) (gpointer state,
+                                     const GstAdaptiveDemuxAbrContext * context);
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_ADAPTIVE_DEMUX_API
+void gst_adaptive_demux_abr_register (const GstAdaptiveDemuxAbrAlgorithm * algorithm);
+
+GST_ADAPTIVE_DEMUX_API
+const GstAdaptiveDemuxAbrAlgorithm *
+     gst_adaptive_demux_abr_find (const gchar * name);
+
+G_END_DECLS
+
+#endif /* _GST_ADAPTIVE_DEMUX_ABR_H_ */
@@ -0,0 +1,873 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:gstav1parser
+ * @title: GstAV1Parser
+ * @short_description: Convenience library for parsing AV1 video bitstream.
+ *
+ * Identifies the OBUs of an AV1 bitstream, either in the low overhead
+ * format of section 5 of the specification (with obu_size fields, as used
+ * by the "obu-stream" stream format) or in the length delimited format of
+ * Annex B, and parses sequence headers and the leading part of frame
+ * headers.
+ *
+ * OBUs are identified in place, their payload is never copied.
+ *
+ * For more details about the structures, you can refer to the
+ * specification: https://aomediacodec.github.io/av1-spec/
+ *
+ * Since: 1.18
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/base/gstbitreader.h>
+#include "gstav1parser.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_av1_parser_debug);
+#define GST_CAT_DEFAULT gst_av1_parser_debug
+
+static gboolean initialized = FALSE;
+#define INITIALIZE_DEBUG_CATEGORY \
+  if (!initialized) { \
+    GST_DEBUG_CATEGORY_INIT (gst_av1_parser_debug, "codecparsers_av1", 0, \
+        "av1 parser library"); \
+    initialized = TRUE; \
+  }
+
+#define READ_BITS(br, val, nbits) G_STMT_START { \
+  guint32 tmp_; \
+  if (!gst_bit_reader_get_bits_uint32 (br, &tmp_, nbits)) { \
+    GST_WARNING ("failed to read %d bits for %s", nbits, #val); \
+    goto error; \
+  } \
+  val = tmp_; \
+} G_STMT_END
+
+#define READ_BIT(br, val) READ_BITS (br, val, 1)
+
+/* uvlc(), section 4.10.3 */
+static gboolean
+av1_read_uvlc (GstBitReader * br, guint32 * value)
+{
+  guint leading_zeros = 0;
+  guint32 bits;
+  guint8 done = 0;
+
+  while (!done) {
+    if (!gst_bit_reader_get_bits_uint8 (br, &done, 1))
+      return FALSE;
+    if (!done)
+      leading_zeros++;
+  }
+
+  if (leading_zeros >= 32) {
+    *value = G_MAXUINT32;
+    return TRUE;
+  }
+
+  if (!gst_bit_reader_get_bits_uint32 (br, &bits, leading_zeros))
+    return FALSE;
+
+  *value = bits + (1u << leading_zeros) - 1;
+
+  return TRUE;
+}
+
+/**
+ * gst_av1_parse_leb128:
+ * @data: The data to parse
+ * @size: The size of @data
+ * @value: (out): the decoded value
+ * @consumed: (out): the number of bytes the value was coded on
+ *
+ * Reads an unsigned integer coded as leb128(), as used for obu_size and
+ * for the sizes of Annex B.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.18
+ */
+GstAV1ParserResult
+gst_av1_parse_leb128 (const guint8 * data, guint32 size, guint32 * value,
+    guint32 * consumed)
+{
+  guint64 val = 0;
+  guint i;
+
+  g_return_val_if_fail (data != NULL || size == 0, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (value != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (consumed != NULL, GST_AV1_PARSER_ERROR);
+
+  for (i = 0; i < 8; i++) {
+    if (i >= size)
+      return GST_AV1_PARSER_NO_MORE_DATA;
+
+    val |= ((guint64) (data[i] & 0x7f)) << (i * 7);
+
+    if (!(data[i] & 0x80)) {
+      if (val > G_MAXUINT32)
+        return GST_AV1_PARSER_BITSTREAM_ERROR;
+
+      *value = val;
+      *consumed = i + 1;
+      return GST_AV1_PARSER_OK;
+    }
+  }
+
+  return GST_AV1_PARSER_BITSTREAM_ERROR;
+}
+
+/* obu_header(), section 5.3.2, and obu_size if present. The OBU size is
+ * taken from @obu_length if it is not coded in the OBU */
+static GstAV1ParserResult
+gst_av1_parse_obu_header (const guint8 * data, guint32 size,
+    guint32 obu_length, GstAV1OBU * obu)
+{
+  GstAV1OBUHeader *header = &obu->header;
+  GstAV1ParserResult res;
+  guint32 obu_size, leb_size;
+  guint8 byte;
+
+  if (size < 1)
+    return GST_AV1_PARSER_NO_MORE_DATA;
+
+  byte = data[0];
+  if (byte & 0x80) {
+    GST_WARNING ("obu_forbidden_bit is set");
+    return GST_AV1_PARSER_BITSTREAM_ERROR;
+  }
+
+  header->obu_type = (byte >> 3) & 0xf;
+  header->obu_extention_flag = (byte >> 2) & 0x1;
+  header->obu_has_size_field = (byte >> 1) & 0x1;
+  header->obu_temporal_id = 0;
+  header->obu_spatial_id = 0;
+  obu->header_size = 1;
+
+  if (header->obu_extention_flag) {
+    if (size < 2)
+      return GST_AV1_PARSER_NO_MORE_DATA;
+
+    header->obu_temporal_id = (data[1] >> 5) & 0x7;
+    header->obu_spatial_id = (data[1] >> 3) & 0x3;
+    obu->header_size++;
+  }
+
+  if (header->obu_has_size_field) {
+    res = gst_av1_parse_leb128 (data + obu->header_size,
+        size - obu->header_size, &obu_size, &leb_size);
+    if (res != GST_AV1_PARSER_OK)
+      return res;
+
+    obu->header_size += leb_size;
+
+    if (obu_length && obu->header_size + obu_size > obu_length) {
+      GST_WARNING ("obu_size %u doesn't fit obu_length %u", obu_size,
+          obu_length);
+      return GST_AV1_PARSER_BITSTREAM_ERROR;
+    }
+  } else {
+    if (!obu_length) {
+      /* only allowed for the last OBU of a packetized sample */
+      obu_length = size;
+    }
+
+    if (obu_length < obu->header_size) {
+      GST_WARNING ("obu_length %u is smaller than the header", obu_length);
+      return GST_AV1_PARSER_BITSTREAM_ERROR;
+    }
+
+    obu_size = obu_length - obu->header_size;
+  }
+
+  if (size < obu->header_size + obu_size)
+    return GST_AV1_PARSER_NO_MORE_DATA;
+
+  obu->obu_type = header->obu_type;
+  obu->obu_size = obu_size;
+  obu->data = data + obu->header_size;
+
+  return GST_AV1_PARSER_OK;
+}
+
+/**
+ * gst_av1_parser_new:
+ *
+ * Creates a new #GstAV1Parser. It should be freed with
+ * gst_av1_parser_free() after use.
+ *
+ * Returns: a new #GstAV1Parser
+ *
+ * Since: 1.18
+ */
+GstAV1Parser *
+gst_av1_parser_new (void)
+{
+  INITIALIZE_DEBUG_CATEGORY;
+  GST_DEBUG ("Create AV1 Parser");
+
+  return g_slice_new0 (GstAV1Parser);
+}
+
+/**
+ * gst_av1_parser_reset:
+ * @parser: the #GstAV1Parser
+ *
+ * Forgets the sequence header and reference frames, e.g. after a seek.
+ *
+ * Since: 1.18
+ */
+void
+gst_av1_parser_reset (GstAV1Parser * parser)
+{
+  g_return_if_fail (parser != NULL);
+
+  memset (&parser->seq_header, 0, sizeof (parser->seq_header));
+  parser->has_seq_header = FALSE;
+  memset (parser->ref_frame_type, 0, sizeof (parser->ref_frame_type));
+  memset (parser->ref_valid, 0, sizeof (parser->ref_valid));
+}
+
+/**
+ * gst_av1_parser_free:
+ * @parser: the #GstAV1Parser to free
+ *
+ * Frees @parser.
+ *
+ * Since: 1.18
+ */
+void
+gst_av1_parser_free (GstAV1Parser * parser)
+{
+  if (parser)
+    g_slice_free (GstAV1Parser, parser);
+}
+
+/**
+ * gst_av1_parser_identify_one_obu:
+ * @parser: the #GstAV1Parser
+ * @data: The data to parse, starting with an OBU header
+ * @size: The size of @data
+ * @obu: (out): the #GstAV1OBU to fill
+ * @consumed: (out): the size of the whole OBU
+ *
+ * Identifies the OBU at the start of @data, in the low overhead bitstream
+ * format of section 5. An OBU without obu_size field is assumed to span the
+ * rest of @data, which is only valid for the last OBU of a packetized
+ * temporal unit.
+ *
+ * Returns: a #GstAV1ParserResult, %GST_AV1_PARSER_NO_MORE_DATA if @data
+ * doesn't hold the whole OBU.
+ *
+ * Since: 1.18
+ */
+GstAV1ParserResult
+gst_av1_parser_identify_one_obu (GstAV1Parser * parser, const guint8 * data,
+    guint32 size, GstAV1OBU * obu, guint32 * consumed)
+{
+  GstAV1ParserResult res;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (data != NULL || size == 0, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (consumed != NULL, GST_AV1_PARSER_ERROR);
+
+  memset (obu, 0, sizeof (GstAV1OBU));
+
+  res = gst_av1_parse_obu_header (data, size, 0, obu);
+  if (res != GST_AV1_PARSER_OK)
+    return res;
+
+  *consumed = obu->header_size + obu->obu_size;
+
+  GST_LOG ("OBU type %d, size %u", obu->obu_type, *consumed);
+
+  return GST_AV1_PARSER_OK;
+}
+
+/**
+ * gst_av1_parser_identify_one_obu_annexb:
+ * @parser: the #GstAV1Parser
+ * @data: The data to parse, starting with an obu_length
+ * @size: The size of @data
+ * @obu: (out): the #GstAV1OBU to fill
+ * @consumed: (out): the size of the OBU and of its obu_length
+ *
+ * Identifies the OBU at the start of @data, in the length delimited
+ * bitstream format of Annex B. @data must point inside a frame_unit(),
+ * the temporal_unit_size and frame_unit_size can be read with
+ * gst_av1_parse_leb128().
+ *
+ * Returns: a #GstAV1ParserResult, %GST_AV1_PARSER_NO_MORE_DATA if @data
+ * doesn't hold the whole OBU.
+ *
+ * Since: 1.18
+ */
+GstAV1ParserResult
+gst_av1_parser_identify_one_obu_annexb (GstAV1Parser * parser,
+    const guint8 * data, guint32 size, GstAV1OBU * obu, guint32 * consumed)
+{
+  GstAV1ParserResult res;
+  guint32 obu_length, leb_size;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (data != NULL || size == 0, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (consumed != NULL, GST_AV1_PARSER_ERROR);
+
+  memset (obu, 0, sizeof (GstAV1OBU));
+
+  res = gst_av1_parse_leb128 (data, size, &obu_length, &leb_size);
+  if (res != GST_AV1_PARSER_OK)
+    return res;
+
+  if (obu_length == 0) {
+    GST_WARNING ("empty OBU");
+    return GST_AV1_PARSER_BITSTREAM_ERROR;
+  }
+
+  if (size - leb_size < obu_length)
+    return GST_AV1_PARSER_NO_MORE_DATA;
+
+  res = gst_av1_parse_obu_header (data + leb_size, obu_length, obu_length,
+      obu);
+  if (res != GST_AV1_PARSER_OK)
+    return res == GST_AV1_PARSER_NO_MORE_DATA ?
+        GST_AV1_PARSER_BITSTREAM_ERROR : res;
+
+  obu->offset = leb_size;
+  *consumed = leb_size + obu_length;
+
+  GST_LOG ("OBU type %d, size %u", obu->obu_type, *consumed);
+
+  return GST_AV1_PARSER_OK;
+}
+
+/* color_config(), section 5.5.2 */
+static gboolean
+gst_av1_parse_color_config (GstBitReader * br,
+    GstAV1SequenceHeaderOBU * seq_header)
+{
+  GstAV1ColorConfig *cc = &seq_header->color_config;
+
+  READ_BIT (br, cc->high_bitdepth);
+  if (seq_header->seq_profile == GST_AV1_PROFILE_2 && cc->high_bitdepth) {
+    READ_BIT (br, cc->twelve_bit);
+    cc->bit_depth = cc->twelve_bit ? 12 : 10;
+  } else {
+    cc->bit_depth = cc->high_bitdepth ? 10 : 8;
+  }
+
+  if (seq_header->seq_profile == GST_AV1_PROFILE_1)
+    cc->mono_chrome = FALSE;
+  else
+    READ_BIT (br, cc->mono_chrome);
+
+  READ_BIT (br, cc->color_description_present_flag);
+  if (cc->color_description_present_flag) {
+    READ_BITS (br, cc->color_primaries, 8);
+    READ_BITS (br, cc->transfer_characteristics, 8);
+    READ_BITS (br, cc->matrix_coefficients, 8);
+  } else {
+    /* CP_UNSPECIFIED, TC_UNSPECIFIED and MC_UNSPECIFIED */
+    cc->color_primaries = 2;
+    cc->transfer_characteristics = 2;
+    cc->matrix_coefficients = 2;
+  }
+
+  if (cc->mono_chrome) {
+    READ_BIT (br, cc->color_range);
+    cc->subsampling_x = 1;
+    cc->subsampling_y = 1;
+    cc->chroma_sample_position = 0;
+    cc->separate_uv_delta_q = FALSE;
+    return TRUE;
+  }
+
+  /* CP_BT_709, TC_SRGB and MC_IDENTITY */
+  if (cc->color_primaries == 1 && cc->transfer_characteristics == 13 &&
+      cc->matrix_coefficients == 0) {
+    cc->color_range = TRUE;
+    cc->subsampling_x = 0;
+    cc->subsampling_y = 0;
+  } else {
+    READ_BIT (br, cc->color_range);
+
+    if (seq_header->seq_profile == GST_AV1_PROFILE_0) {
+      cc->subsampling_x = 1;
+      cc->subsampling_y = 1;
+    } else if (seq_header->seq_profile == GST_AV1_PROFILE_1) {
+      cc->subsampling_x = 0;
+      cc->subsampling_y = 0;
+    } else if (cc->bit_depth == 12) {
+      READ_BIT (br, cc->subsampling_x);
+      if (cc->subsampling_x)
+        READ_BIT (br, cc->subsampling_y);
+      else
+        cc->subsampling_y = 0;
+    } else {
+      cc->subsampling_x = 1;
+      cc->subsampling_y = 0;
+    }
+
+    if (cc->subsampling_x && cc->subsampling_y)
+      READ_BITS (br, cc->chroma_sample_position, 2);
+  }
+
+  READ_BIT (br, cc->separate_uv_delta_q);
+
+  return TRUE;
+
+error:
+  GST_WARNING ("error parsing \"Color config\"");
+  return FALSE;
+}
+
+/**
+ * gst_av1_parser_parse_sequence_header_obu:
+ * @parser: the #GstAV1Parser
+ * @obu: a #GST_AV1_OBU_SEQUENCE_HEADER #GstAV1OBU
+ * @seq_header: (out): the #GstAV1SequenceHeaderOBU to fill
+ *
+ * Parses the sequence header in @obu, and makes it the active sequence
+ * header of @parser.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.18
+ */
+GstAV1ParserResult
+gst_av1_parser_parse_sequence_header_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1SequenceHeaderOBU * seq_header)
+{
+  GstBitReader bit_reader;
+  GstBitReader *br = &bit_reader;
+  guint i;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu->obu_type == GST_AV1_OBU_SEQUENCE_HEADER,
+      GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (seq_header != NULL, GST_AV1_PARSER_ERROR);
+
+  gst_bit_reader_init (br, obu->data, obu->obu_size);
+  memset (seq_header, 0, sizeof (*seq_header));
+
+  READ_BITS (br, seq_header->seq_profile, 3);
+  if (seq_header->seq_profile > GST_AV1_PROFILE_2) {
+    GST_WARNING ("Unsupported profile %d", seq_header->seq_profile);
+    goto error;
+  }
+
+  READ_BIT (br, seq_header->still_picture);
+  READ_BIT (br, seq_header->reduced_still_picture_header);
+
+  if (seq_header->reduced_still_picture_header) {
+    READ_BITS (br, seq_header->operating_points[0].seq_level_idx, 5);
+  } else {
+    READ_BIT (br, seq_header->timing_info_present_flag);
+    if (seq_header->timing_info_present_flag) {
+      READ_BITS (br, seq_header->num_units_in_display_tick, 32);
+      READ_BITS (br, seq_header->time_scale, 32);
+      READ_BIT (br, seq_header->equal_picture_interval);
+      if (seq_header->equal_picture_interval &&
+          !av1_read_uvlc (br, &seq_header->num_ticks_per_picture_minus_1))
+        goto error;
+
+      READ_BIT (br, seq_header->decoder_model_info_present_flag);
+      if (seq_header->decoder_model_info_present_flag) {
+        READ_BITS (br, seq_header->buffer_delay_length_minus_1, 5);
+        READ_BITS (br, seq_header->num_units_in_decoding_tick, 32);
+        READ_BITS (br, seq_header->buffer_removal_time_length_minus_1, 5);
+        READ_BITS (br, seq_header->frame_presentation_time_length_minus_1, 5);
+      }
+    }
+
+    READ_BIT (br, seq_header->initial_display_delay_present_flag);
+    READ_BITS (br, seq_header->operating_points_cnt_minus_1, 5);
+
+    for (i = 0; i <= seq_header->operating_points_cnt_minus_1; i++) {
+      GstAV1OperatingPoint *op = &seq_header->operating_points[i];
+
+      READ_BITS (br, op->idc, 12);
+      READ_BITS (br, op->seq_level_idx, 5);
+      if (op->seq_level_idx > 7)
+        READ_BIT (br, op->seq_tier);
+
+      if (seq_header->decoder_model_info_present_flag) {
+        READ_BIT (br, op->decoder_model_present_for_this_op);
+        if (op->decoder_model_present_for_this_op) {
+          guint n = seq_header->buffer_delay_length_minus_1 + 1;
+
+          READ_BITS (br, op->decoder_buffer_delay, n);
+          READ_BITS (br, op->encoder_buffer_delay, n);
+          READ_BIT (br, op->low_delay_mode_flag);
+        }
+      }
+
+      if (seq_header->initial_display_delay_present_flag) {
+        READ_BIT (br, op->initial_display_delay_present_for_this_op);
+        if (op->initial_display_delay_present_for_this_op)
+          READ_BITS (br, op->initial_display_delay_minus_1, 4);
+      }
+    }
+  }
+
+  READ_BITS (br, seq_header->frame_width_bits_minus_1, 4);
+  READ_BITS (br, seq_header->frame_height_bits_minus_1, 4);
+  READ_BITS (br, seq_header->max_frame_width_minus_1,
+      seq_header->frame_width_bits_minus_1 + 1);
+  READ_BITS (br, seq_header->max_frame_height_minus_1,
+      seq_header->frame_height_bits_minus_1 + 1);
+
+  if (!seq_header->reduced_still_picture_header)
+    READ_BIT (br, seq_header->frame_id_numbers_present_flag);
+  if (seq_header->frame_id_numbers_present_flag) {
+    READ_BITS (br, seq_header->delta_frame_id_length_minus_2, 4);
+    READ_BITS (br, seq_header->additional_frame_id_length_minus_1, 3);
+  }
+
+  READ_BIT (br, seq_header->use_128x128_superblock);
+  READ_BIT (br, seq_header->enable_filter_intra);
+  READ_BIT (br, seq_header->enable_intra_edge_filter);
+
+  if (seq_header->reduced_still_picture_header) {
+    seq_header->seq_force_screen_content_tools =
+        GST_AV1_SELECT_SCREEN_CONTENT_TOOLS;
+    seq_header->seq_force_integer_mv = GST_AV1_SELECT_INTEGER_MV;
+  } else {
+    gboolean seq_choose;
+
+    READ_BIT (br, seq_header->enable_interintra_compound);
+    READ_BIT (br, seq_header->enable_masked_compound);
+    READ_BIT (br, seq_header->enable_warped_motion);
+    READ_BIT (br, seq_header->enable_dual_filter);
+    READ_BIT (br, seq_header->enable_order_hint);
+    if (seq_header->enable_order_hint) {
+      READ_BIT (br, seq_header->enable_jnt_comp);
+      READ_BIT (br, seq_header->enable_ref_frame_mvs);
+    }
+
+    READ_BIT (br, seq_choose);
+    if (seq_choose)
+      seq_header->seq_force_screen_content_tools =
+          GST_AV1_SELECT_SCREEN_CONTENT_TOOLS;
+    else
+      READ_BIT (br, seq_header->seq_force_screen_content_tools);
+
+    if (seq_header->seq_force_screen_content_tools > 0) {
+      READ_BIT (br, seq_choose);
+      if (seq_choose)
+        seq_header->seq_force_integer_mv = GST_AV1_SELECT_INTEGER_MV;
+      else
+        READ_BIT (br, seq_header->seq_force_integer_mv);
+    } else {
+      seq_header->seq_force_integer_mv = GST_AV1_SELECT_INTEGER_MV;
+    }
+
+    if (seq_header->enable_order_hint) {
+      READ_BITS (br, seq_header->order_hint_bits_minus_1, 3);
+      seq_header->order_hint_bits = seq_header->order_hint_bits_minus_1 + 1;
+    }
+  }
+
+  READ_BIT (br, seq_header->enable_superres);
+  READ_BIT (br, seq_header->enable_cdef);
+  READ_BIT (br, seq_header->enable_restoration);
+
+  if (!gst_av1_parse_color_config (br, seq_header))
+    goto error;
+
+  READ_BIT (br, seq_header->film_grain_params_present);
+
+  parser->seq_header = *seq_header;
+  parser->has_seq_header = TRUE;
+
+  return GST_AV1_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"Sequence header\"");
+  return GST_AV1_PARSER_BITSTREAM_ERROR;
+}
+
+/* temporal_point_info(), section 5.9.31 */
+static gboolean
+gst_av1_skip_temporal_point_info (GstBitReader * br,
+    const GstAV1SequenceHeaderOBU * seq_header)
+{
+  return gst_bit_reader_skip (br,
+      seq_header->frame_presentation_time_length_minus_1 + 1);
+}
+
+/* frame_size(), superres_params() and render_size(), sections 5.9.5 to
+ * 5.9.8 */
+static gboolean
+gst_av1_parse_frame_size (GstBitReader * br,
+    const GstAV1SequenceHeaderOBU * seq_header,
+    GstAV1FrameHeaderOBU * frame_header)
+{
+  gboolean flag;
+
+  if (frame_header->frame_size_override_flag) {
+    READ_BITS (br, frame_header->frame_width,
+        seq_header->frame_width_bits_minus_1 + 1);
+    READ_BITS (br, frame_header->frame_height,
+        seq_header->frame_height_bits_minus_1 + 1);
+    frame_header->frame_width++;
+    frame_header->frame_height++;
+  } else {
+    frame_header->frame_width = seq_header->max_frame_width_minus_1 + 1;
+    frame_header->frame_height = seq_header->max_frame_height_minus_1 + 1;
+  }
+
+  frame_header->upscaled_width = frame_header->frame_width;
+
+  if (seq_header->enable_superres) {
+    READ_BIT (br, flag);
+    if (flag) {
+      guint denom;
+
+      /* SUPERRES_DENOM_MIN is 9 */
+      READ_BITS (br, denom, 3);
+      denom += 9;
+      frame_header->frame_width =
+          (frame_header->upscaled_width * 8 + denom / 2) / denom;
+    }
+  }
+
+  READ_BIT (br, flag);
+  if (flag) {
+    READ_BITS (br, frame_header->render_width, 16);
+    READ_BITS (br, frame_header->render_height, 16);
+    frame_header->render_width++;
+    frame_header->render_height++;
+  } else {
+    frame_header->render_width = frame_header->upscaled_width;
+    frame_header->render_height = frame_header->frame_height;
+  }
+
+  return TRUE;
+
+error:
+  GST_WARNING ("error parsing \"Frame size\"");
+  return FALSE;
+}
+
+/**
+ * gst_av1_parser_parse_frame_header_obu:
+ * @parser: the #GstAV1Parser
+ * @obu: a #GST_AV1_OBU_FRAME_HEADER or #GST_AV1_OBU_FRAME #GstAV1OBU
+ * @frame_header: (out): the #GstAV1FrameHeaderOBU to fill
+ *
+ * Parses the leading part of the frame header in @obu, see
+ * #GstAV1FrameHeaderOBU, and keeps track of the frame types held in the
+ * reference slots it refreshes.
+ *
+ * Returns: a #GstAV1ParserResult
+ *
+ * Since: 1.18
+ */
+GstAV1ParserResult
+gst_av1_parser_parse_frame_header_obu (GstAV1Parser * parser,
+    GstAV1OBU * obu, GstAV1FrameHeaderOBU * frame_header)
+{
+  const GstAV1SequenceHeaderOBU *seq_header = &parser->seq_header;
+  GstBitReader bit_reader;
+  GstBitReader *br = &bit_reader;
+  guint id_len = 0;
+  guint i;
+
+  g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (obu->obu_type == GST_AV1_OBU_FRAME_HEADER ||
+      obu->obu_type == GST_AV1_OBU_FRAME, GST_AV1_PARSER_ERROR);
+  g_return_val_if_fail (frame_header != NULL, GST_AV1_PARSER_ERROR);
+
+  if (!parser->has_seq_header) {
+    GST_WARNING ("no sequence header");
+    return GST_AV1_PARSER_MISSING_OBU_REFERENCE;
+  }
+
+  gst_bit_reader_init (br, obu->data, obu->obu_size);
+  memset (frame_header, 0, sizeof (*frame_header));
+  frame_header->primary_ref_frame = GST_AV1_PRIMARY_REF_NONE;
+
+  if (seq_header->frame_id_numbers_present_flag)
+    id_len = seq_header->additional_frame_id_length_minus_1 +
+        seq_header->delta_frame_id_length_minus_2 + 3;
+
+  if (seq_header->reduced_still_picture_header) {
+    frame_header->frame_type = GST_AV1_KEY_FRAME;
+    frame_header->frame_is_intra = TRUE;
+    frame_header->show_frame = TRUE;
+    frame_header->error_resilient_mode = TRUE;
+  } else {
+    READ_BIT (br, frame_header->show_existing_frame);
+    if (frame_header->show_existing_frame) {
+      READ_BITS (br, frame_header->frame_to_show_map_idx, 3);
+      if (seq_header->decoder_model_info_present_flag &&
+          !seq_header->equal_picture_interval &&
+          !gst_av1_skip_temporal_point_info (br, seq_header))
+        goto error;
+      if (id_len && !gst_bit_reader_skip (br, id_len))
+        goto error;
+
+      if (!parser->ref_valid[frame_header->frame_to_show_map_idx]) {
+        GST_WARNING ("frame_to_show_map_idx %d is not a valid reference",
+            frame_header->frame_to_show_map_idx);
+        return GST_AV1_PARSER_MISSING_OBU_REFERENCE;
+      }
+
+      frame_header->frame_type =
+          parser->ref_frame_type[frame_header->frame_to_show_map_idx];
+      frame_header->show_frame = TRUE;
+
+      /* showing a key frame refreshes all the slots with it */
+      if (frame_header->frame_type == GST_AV1_KEY_FRAME) {
+        frame_header->refresh_frame_flags = 0xff;
+        for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++)
+          parser->ref_frame_type[i] = GST_AV1_KEY_FRAME;
+      }
+
+      return GST_AV1_PARSER_OK;
+    }
+
+    READ_BITS (br, frame_header->frame_type, 2);
+    frame_header->frame_is_intra =
+        frame_header->frame_type == GST_AV1_INTRA_ONLY_FRAME ||
+        frame_header->frame_type == GST_AV1_KEY_FRAME;
+
+    READ_BIT (br, frame_header->show_frame);
+    if (frame_header->show_frame &&
+        seq_header->decoder_model_info_present_flag &&
+        !seq_header->equal_picture_interval &&
+        !gst_av1_skip_temporal_point_info (br, seq_header))
+      goto error;
+
+    if (frame_header->show_frame)
+      frame_header->showable_frame =
+          frame_header->frame_type != GST_AV1_KEY_FRAME;
+    else
+      READ_BIT (br, frame_header->showable_frame);
+
+    if (frame_header->frame_type == GST_AV1_SWITCH_FRAME ||
+        (frame_header->frame_type == GST_AV1_KEY_FRAME &&
+            frame_header->show_frame))
+      frame_header->error_resilient_mode = TRUE;
+    else
+      READ_BIT (br, frame_header->error_resilient_mode);
+  }
+
+  if (frame_header->frame_type == GST_AV1_KEY_FRAME &&
+      frame_header->show_frame) {
+    for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++)
+      parser->ref_valid[i] = FALSE;
+  }
+
+  READ_BIT (br, frame_header->disable_cdf_update);
+
+  if (seq_header->seq_force_screen_content_tools ==
+      GST_AV1_SELECT_SCREEN_CONTENT_TOOLS)
+    READ_BIT (br, frame_header->allow_screen_content_tools);
+  else
+    frame_header->allow_screen_content_tools =
+        seq_header->seq_force_screen_content_tools;
+
+  if (frame_header->allow_screen_content_tools) {
+    if (seq_header->seq_force_integer_mv == GST_AV1_SELECT_INTEGER_MV)
+      READ_BIT (br, frame_header->force_integer_mv);
+    else
+      frame_header->force_integer_mv = seq_header->seq_force_integer_mv;
+  }
+  if (frame_header->frame_is_intra)
+    frame_header->force_integer_mv = TRUE;
+
+  if (id_len)
+    READ_BITS (br, frame_header->current_frame_id, id_len);
+
+  if (frame_header->frame_type == GST_AV1_SWITCH_FRAME)
+    frame_header->frame_size_override_flag = TRUE;
+  else if (!seq_header->reduced_still_picture_header)
+    READ_BIT (br, frame_header->frame_size_override_flag);
+
+  if (seq_header->order_hint_bits)
+    READ_BITS (br, frame_header->order_hint, seq_header->order_hint_bits);
+
+  if (!frame_header->frame_is_intra && !frame_header->error_resilient_mode)
+    READ_BITS (br, frame_header->primary_ref_frame, 3);
+
+  if (seq_header->decoder_model_info_present_flag) {
+    gboolean buffer_removal_time_present_flag;
+
+    READ_BIT (br, buffer_removal_time_present_flag);
+    if (buffer_removal_time_present_flag) {
+      for (i = 0; i <= seq_header->operating_points_cnt_minus_1; i++) {
+        const GstAV1OperatingPoint *op = &seq_header->operating_points[i];
+        gboolean in_temporal_layer, in_spatial_layer;
+
+        if (!op->decoder_model_present_for_this_op)
+          continue;
+
+        in_temporal_layer = (op->idc >> obu->header.obu_temporal_id) & 1;
+        in_spatial_layer = (op->idc >> (obu->header.obu_spatial_id + 8)) & 1;
+        if ((op->idc == 0 || (in_temporal_layer && in_spatial_layer)) &&
+            !gst_bit_reader_skip (br,
+                seq_header->buffer_removal_time_length_minus_1 + 1))
+          goto error;
+      }
+    }
+  }
+
+  if (frame_header->frame_type == GST_AV1_SWITCH_FRAME ||
+      (frame_header->frame_type == GST_AV1_KEY_FRAME &&
+          frame_header->show_frame))
+    frame_header->refresh_frame_flags = 0xff;
+  else
+    READ_BITS (br, frame_header->refresh_frame_flags, 8);
+
+  for (i = 0; i < GST_AV1_NUM_REF_FRAMES; i++) {
+    if (frame_header->refresh_frame_flags & (1 << i)) {
+      parser->ref_frame_type[i] = frame_header->frame_type;
+      parser->ref_valid[i] = TRUE;
+    }
+  }
+
+  if (!frame_header->frame_is_intra)
+    return GST_AV1_PARSER_OK;
+
+  /* ref_order_hint[] */
+  if (frame_header->refresh_frame_flags != 0xff &&
+      frame_header->error_resilient_mode && seq_header->enable_order_hint &&
+      !gst_bit_reader_skip (br,
+          GST_AV1_NUM_REF_FRAMES * seq_header->order_hint_bits))
+    goto error;
+
+  if (!gst_av1_parse_frame_size (br, seq_header, frame_header))
+    goto error;
+
+  return GST_AV1_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"Frame header\"");
+  return GST_AV1_PARSER_BITSTREAM_ERROR;
+}
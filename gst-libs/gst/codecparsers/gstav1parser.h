@@ -0,0 +1,356 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GST_AV1_PARSER_H
+#define GST_AV1_PARSER_H
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The AV1 parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+#include <gst/codecparsers/codecparsers-prelude.h>
+
+G_BEGIN_DECLS
+
+#define GST_AV1_MAX_OPERATING_POINTS  32
+#define GST_AV1_NUM_REF_FRAMES        8
+#define GST_AV1_PRIMARY_REF_NONE      7
+#define GST_AV1_SELECT_SCREEN_CONTENT_TOOLS 2
+#define GST_AV1_SELECT_INTEGER_MV     2
+
+typedef struct _GstAV1Parser               GstAV1Parser;
+typedef struct _GstAV1OBUHeader            GstAV1OBUHeader;
+typedef struct _GstAV1OBU                  GstAV1OBU;
+typedef struct _GstAV1SequenceHeaderOBU    GstAV1SequenceHeaderOBU;
+typedef struct _GstAV1OperatingPoint       GstAV1OperatingPoint;
+typedef struct _GstAV1ColorConfig          GstAV1ColorConfig;
+typedef struct _GstAV1FrameHeaderOBU       GstAV1FrameHeaderOBU;
+
+/**
+ * GstAV1ParserResult:
+ * @GST_AV1_PARSER_OK: The parsing went well
+ * @GST_AV1_PARSER_NO_MORE_DATA: More data is needed to complete the OBU
+ * @GST_AV1_PARSER_BITSTREAM_ERROR: The data to parse is broken
+ * @GST_AV1_PARSER_MISSING_OBU_REFERENCE: A needed preceding OBU, such as
+ *   the sequence header, has not been parsed yet
+ * @GST_AV1_PARSER_ERROR: An error occurred during the parsing
+ *
+ * Result type of any parsing function.
+ *
+ * Since: 1.18
+ */
+typedef enum
+{
+  GST_AV1_PARSER_OK,
+  GST_AV1_PARSER_NO_MORE_DATA,
+  GST_AV1_PARSER_BITSTREAM_ERROR,
+  GST_AV1_PARSER_MISSING_OBU_REFERENCE,
+  GST_AV1_PARSER_ERROR,
+} GstAV1ParserResult;
+
+/**
+ * GstAV1OBUType:
+ *
+ * OBU types, see section 6.2.2 of the AV1 specification.
+ *
+ * Since: 1.18
+ */
+typedef enum
+{
+  GST_AV1_OBU_RESERVED_0 = 0,
+  GST_AV1_OBU_SEQUENCE_HEADER = 1,
+  GST_AV1_OBU_TEMPORAL_DELIMITER = 2,
+  GST_AV1_OBU_FRAME_HEADER = 3,
+  GST_AV1_OBU_TILE_GROUP = 4,
+  GST_AV1_OBU_METADATA = 5,
+  GST_AV1_OBU_FRAME = 6,
+  GST_AV1_OBU_REDUNDANT_FRAME_HEADER = 7,
+  GST_AV1_OBU_TILE_LIST = 8,
+  GST_AV1_OBU_PADDING = 15,
+} GstAV1OBUType;
+
+/**
+ * GstAV1Profile:
+ * @GST_AV1_PROFILE_0: Main profile, 8 and 10-bit 4:2:0 and monochrome
+ * @GST_AV1_PROFILE_1: High profile, adds 4:4:4
+ * @GST_AV1_PROFILE_2: Professional profile, adds 4:2:2 and 12-bit
+ * @GST_AV1_PROFILE_UNDEFINED: Undefined profile
+ *
+ * Since: 1.18
+ */
+typedef enum
+{
+  GST_AV1_PROFILE_0 = 0,
+  GST_AV1_PROFILE_1 = 1,
+  GST_AV1_PROFILE_2 = 2,
+  GST_AV1_PROFILE_UNDEFINED,
+} GstAV1Profile;
+
+/**
+ * GstAV1FrameType:
+ *
+ * Since: 1.18
+ */
+typedef enum
+{
+  GST_AV1_KEY_FRAME = 0,
+  GST_AV1_INTER_FRAME = 1,
+  GST_AV1_INTRA_ONLY_FRAME = 2,
+  GST_AV1_SWITCH_FRAME = 3,
+} GstAV1FrameType;
+
+/**
+ * GstAV1OBUHeader:
+ * @obu_type: the type of the OBU
+ * @obu_extention_flag: whether the temporal and spatial ids are present
+ * @obu_has_size_field: whether obu_size is coded in the OBU
+ * @obu_temporal_id: the temporal layer of the OBU
+ * @obu_spatial_id: the spatial layer of the OBU
+ *
+ * Since: 1.18
+ */
+struct _GstAV1OBUHeader
+{
+  GstAV1OBUType obu_type;
+  gboolean obu_extention_flag;
+  gboolean obu_has_size_field;
+  guint8 obu_temporal_id;
+  guint8 obu_spatial_id;
+};
+
+/**
+ * GstAV1OBU:
+ * @header: the parsed OBU header
+ * @obu_type: the type of the OBU, same as @header.obu_type
+ * @offset: the offset of the OBU header in the data it was identified in,
+ *   non-zero when it is preceded by an Annex B obu_length
+ * @header_size: the size of the OBU header and obu_size field, if any
+ * @obu_size: the size of the payload
+ * @data: the payload, pointing into the parsed data
+ *
+ * A single OBU. The payload is not copied, @data stays valid for as long as
+ * the data the OBU was identified in does.
+ *
+ * Since: 1.18
+ */
+struct _GstAV1OBU
+{
+  GstAV1OBUHeader header;
+  GstAV1OBUType obu_type;
+  guint32 offset;
+  guint32 header_size;
+  guint32 obu_size;
+  const guint8 *data;
+};
+
+/**
+ * GstAV1OperatingPoint:
+ *
+ * The parameters of one operating point of a sequence header.
+ *
+ * Since: 1.18
+ */
+struct _GstAV1OperatingPoint
+{
+  guint16 idc;
+  guint8 seq_level_idx;
+  guint8 seq_tier;
+  gboolean decoder_model_present_for_this_op;
+  guint32 decoder_buffer_delay;
+  guint32 encoder_buffer_delay;
+  gboolean low_delay_mode_flag;
+  gboolean initial_display_delay_present_for_this_op;
+  guint8 initial_display_delay_minus_1;
+};
+
+/**
+ * GstAV1ColorConfig:
+ *
+ * color_config() of a sequence header, with the derived bit depth.
+ *
+ * Since: 1.18
+ */
+struct _GstAV1ColorConfig
+{
+  gboolean high_bitdepth;
+  gboolean twelve_bit;
+  gboolean mono_chrome;
+  gboolean color_description_present_flag;
+  guint8 color_primaries;
+  guint8 transfer_characteristics;
+  guint8 matrix_coefficients;
+  gboolean color_range;
+  guint8 subsampling_x;
+  guint8 subsampling_y;
+  guint8 chroma_sample_position;
+  gboolean separate_uv_delta_q;
+
+  /* calculated values */
+  guint8 bit_depth;
+};
+
+/**
+ * GstAV1SequenceHeaderOBU:
+ *
+ * A sequence header OBU, see section 5.5 of the AV1 specification. Field
+ * names follow the specification.
+ *
+ * Since: 1.18
+ */
+struct _GstAV1SequenceHeaderOBU
+{
+  GstAV1Profile seq_profile;
+  gboolean still_picture;
+  gboolean reduced_still_picture_header;
+
+  gboolean timing_info_present_flag;
+  guint32 num_units_in_display_tick;
+  guint32 time_scale;
+  gboolean equal_picture_interval;
+  guint32 num_ticks_per_picture_minus_1;
+
+  gboolean decoder_model_info_present_flag;
+  guint8 buffer_delay_length_minus_1;
+  guint32 num_units_in_decoding_tick;
+  guint8 buffer_removal_time_length_minus_1;
+  guint8 frame_presentation_time_length_minus_1;
+
+  gboolean initial_display_delay_present_flag;
+  guint8 operating_points_cnt_minus_1;
+  GstAV1OperatingPoint operating_points[GST_AV1_MAX_OPERATING_POINTS];
+
+  guint8 frame_width_bits_minus_1;
+  guint8 frame_height_bits_minus_1;
+  guint16 max_frame_width_minus_1;
+  guint16 max_frame_height_minus_1;
+  gboolean frame_id_numbers_present_flag;
+  guint8 delta_frame_id_length_minus_2;
+  guint8 additional_frame_id_length_minus_1;
+  gboolean use_128x128_superblock;
+  gboolean enable_filter_intra;
+  gboolean enable_intra_edge_filter;
+  gboolean enable_interintra_compound;
+  gboolean enable_masked_compound;
+  gboolean enable_warped_motion;
+  gboolean enable_dual_filter;
+  gboolean enable_order_hint;
+  gboolean enable_jnt_comp;
+  gboolean enable_ref_frame_mvs;
+  guint8 seq_force_screen_content_tools;
+  guint8 seq_force_integer_mv;
+  guint8 order_hint_bits_minus_1;
+  gboolean enable_superres;
+  gboolean enable_cdef;
+  gboolean enable_restoration;
+  GstAV1ColorConfig color_config;
+  gboolean film_grain_params_present;
+
+  /* calculated values */
+  guint8 order_hint_bits;
+};
+
+/**
+ * GstAV1FrameHeaderOBU:
+ *
+ * The leading part of uncompressed_header(), see section 5.9 of the AV1
+ * specification. Parsing stops after the fields needed to tell how a
+ * frame is shown and referenced, and the frame size of intra frames, so
+ * the rest of the header is not available.
+ *
+ * Since: 1.18
+ */
+struct _GstAV1FrameHeaderOBU
+{
+  gboolean show_existing_frame;
+  guint8 frame_to_show_map_idx;
+  GstAV1FrameType frame_type;
+  gboolean show_frame;
+  gboolean showable_frame;
+  gboolean error_resilient_mode;
+  gboolean disable_cdf_update;
+  gboolean allow_screen_content_tools;
+  gboolean force_integer_mv;
+  guint32 current_frame_id;
+  gboolean frame_size_override_flag;
+  guint32 order_hint;
+  guint8 primary_ref_frame;
+  guint8 refresh_frame_flags;
+
+  /* only for key and intra-only frames */
+  guint32 frame_width;
+  guint32 frame_height;
+  guint32 upscaled_width;
+  guint32 render_width;
+  guint32 render_height;
+
+  /* calculated values */
+  gboolean frame_is_intra;
+};
+
+/**
+ * GstAV1Parser:
+ * @seq_header: the last parsed sequence header
+ *
+ * Parser context that needs to be live across OBUs. It keeps the active
+ * sequence header, and the type of the frames held in each reference slot
+ * so that shown existing key frames are identified.
+ *
+ * Since: 1.18
+ */
+struct _GstAV1Parser
+{
+  GstAV1SequenceHeaderOBU seq_header;
+
+  /*< private >*/
+  gboolean has_seq_header;
+  GstAV1FrameType ref_frame_type[GST_AV1_NUM_REF_FRAMES];
+  gboolean ref_valid[GST_AV1_NUM_REF_FRAMES];
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_CODEC_PARSERS_API
+GstAV1Parser *     gst_av1_parser_new (void);
+
+GST_CODEC_PARSERS_API
+void               gst_av1_parser_reset (GstAV1Parser * parser);
+
+GST_CODEC_PARSERS_API
+void               gst_av1_parser_free (GstAV1Parser * parser);
+
+GST_CODEC_PARSERS_API
+GstAV1ParserResult gst_av1_parse_leb128 (const guint8 * data, guint32 size, guint32 * value, guint32 * consumed);
+
+GST_CODEC_PARSERS_API
+GstAV1ParserResult gst_av1_parser_identify_one_obu (GstAV1Parser * parser, const guint8 * data, guint32 size, GstAV1OBU * obu, guint32 * consumed);
+
+GST_CODEC_PARSERS_API
+GstAV1ParserResult gst_av1_parser_identify_one_obu_annexb (GstAV1Parser * parser, const guint8 * data, guint32 size, GstAV1OBU * obu, guint32 * consumed);
+
+GST_CODEC_PARSERS_API
+GstAV1ParserResult gst_av1_parser_parse_sequence_header_obu (GstAV1Parser * parser, GstAV1OBU * obu, GstAV1SequenceHeaderOBU * seq_header);
+
+GST_CODEC_PARSERS_API
+GstAV1ParserResult gst_av1_parser_parse_frame_header_obu (GstAV1Parser * parser, GstAV1OBU * obu, GstAV1FrameHeaderOBU * frame_header);
+
+G_END_DECLS
+
+#endif /* GST_AV1_PARSER_H */
@@ -385,6 +385,64 @@ gst_h264_sps_copy (GstH264SPS * dst_sps, const GstH264SPS * src_sps)
   return TRUE;
 }
 
+/* Private parser state, allocated in place of the public struct. It keeps
+ * the raw bytes of every stored parameter set, so that an identical one
+ * re-sent later (usually with every IDR) is recognised without parsing and
+ * deep copying it again */
+typedef struct
+{
+  GstH264NalParser parser;
+
+  NalFingerprint sps_fp[GST_H264_MAX_SPS_COUNT];
+  NalFingerprint pps_fp[GST_H264_MAX_PPS_COUNT];
+
+  /* sps_generation[id] is bumped whenever sps[id] is replaced, and a PPS is
+   * only reused if the SPS it was parsed against has not changed since */
+  guint sps_generation[GST_H264_MAX_SPS_COUNT];
+  guint pps_sps_generation[GST_H264_MAX_PPS_COUNT];
+
+  /* whether sps[id] was parsed as a subset SPS, with its MVC extension */
+  gboolean sps_subset[GST_H264_MAX_SPS_COUNT];
+} GstH264NalParserImpl;
+
+#define GST_H264_NAL_PARSER_IMPL(p) ((GstH264NalParserImpl *) (p))
+
+static void
+gst_h264_nal_fingerprint_init (NalFingerprint * fp, GstH264NalUnit * nalu)
+{
+  nal_fingerprint_init (fp, nalu->data + nalu->offset, nalu->size);
+}
+
+/* Reads the id of a SPS or PPS, which are near the start of the payload,
+ * without parsing the rest of it */
+static gboolean
+gst_h264_peek_parameter_set_id (GstH264NalUnit * nalu, guint * id)
+{
+  NalReader nr;
+  guint32 val;
+
+  if (nalu->size < nalu->header_bytes)
+    return FALSE;
+
+  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+      nalu->size - nalu->header_bytes);
+
+  /* profile_idc, constraint flags and level_idc */
+  if (nalu->type != GST_H264_NAL_PPS && !nal_reader_skip (&nr, 24))
+    return FALSE;
+
+  if (!nal_reader_get_ue (&nr, &val))
+    return FALSE;
+
+  if (val >= (nalu->type == GST_H264_NAL_PPS ?
+          GST_H264_MAX_PPS_COUNT : GST_H264_MAX_SPS_COUNT))
+    return FALSE;
+
+  *id = val;
+
+  return TRUE;
+}
+
 /****** Parsing functions *****/
 
 static gboolean
@@ -1338,6 +1396,134 @@ error:
   return GST_H264_PARSER_ERROR;
 }
 
+/* Parses @nalu and stores the result in nalparser->sps, unless it is
+ * identical to the SPS already stored with the same id. If @sps is not %NULL,
+ * it is filled with a copy of the stored SPS. @changed tells whether the
+ * stored SPS was replaced */
+static GstH264ParserResult
+gst_h264_parser_store_sps (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264SPS * sps, gboolean subset,
+    gboolean * changed)
+{
+  GstH264NalParserImpl *impl = GST_H264_NAL_PARSER_IMPL (nalparser);
+  GstH264ParserResult res;
+  NalFingerprint fp;
+  GstH264SPS tmp;
+  guint id;
+
+  gst_h264_nal_fingerprint_init (&fp, nalu);
+
+  if (gst_h264_peek_parameter_set_id (nalu, &id) && nalparser->sps[id].valid
+      && impl->sps_subset[id] == subset
+      && nal_fingerprint_equal (&impl->sps_fp[id], &fp)) {
+    GST_LOG ("sequence parameter set with id: %d is unchanged", id);
+
+    *changed = FALSE;
+    nalparser->last_sps = &nalparser->sps[id];
+    if (sps) {
+      memset (sps, 0, sizeof (*sps));
+      if (!gst_h264_sps_copy (sps, &nalparser->sps[id])) {
+        gst_h264_sps_clear (sps);
+        return GST_H264_PARSER_ERROR;
+      }
+    }
+    return GST_H264_PARSER_OK;
+  }
+
+  *changed = TRUE;
+  if (!sps)
+    sps = &tmp;
+
+  if (subset)
+    res = gst_h264_parse_subset_sps (nalu, sps);
+  else
+    res = gst_h264_parse_sps (nalu, sps);
+
+  if (res == GST_H264_PARSER_OK) {
+    id = sps->id;
+
+    GST_DEBUG ("adding sequence parameter set with id: %d to array", id);
+
+    if (!gst_h264_sps_copy (&nalparser->sps[id], sps)) {
+      nal_fingerprint_clear (&impl->sps_fp[id]);
+      gst_h264_sps_clear (sps);
+      return GST_H264_PARSER_ERROR;
+    }
+    nal_fingerprint_store (&impl->sps_fp[id], &fp);
+    impl->sps_generation[id]++;
+    impl->sps_subset[id] = subset;
+    nalparser->last_sps = &nalparser->sps[id];
+
+    if (sps == &tmp)
+      gst_h264_sps_clear (&tmp);
+  }
+
+  return res;
+}
+
+/* Same as gst_h264_parser_store_sps(), a stored PPS is also parsed again if
+ * the SPS it refers to has changed since */
+static GstH264ParserResult
+gst_h264_parser_store_pps (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264PPS * pps, gboolean * changed)
+{
+  GstH264NalParserImpl *impl = GST_H264_NAL_PARSER_IMPL (nalparser);
+  GstH264ParserResult res;
+  GstH264PPS *stored;
+  NalFingerprint fp;
+  GstH264PPS tmp;
+  guint id;
+
+  gst_h264_nal_fingerprint_init (&fp, nalu);
+
+  if (gst_h264_peek_parameter_set_id (nalu, &id)) {
+    stored = &nalparser->pps[id];
+
+    if (stored->valid && stored->sequence && stored->sequence->valid
+        && impl->pps_sps_generation[id] ==
+        impl->sps_generation[stored->sequence->id]
+        && nal_fingerprint_equal (&impl->pps_fp[id], &fp)) {
+      GST_LOG ("picture parameter set with id: %d is unchanged", id);
+
+      *changed = FALSE;
+      nalparser->last_pps = stored;
+      if (pps) {
+        memset (pps, 0, sizeof (*pps));
+        if (!gst_h264_pps_copy (pps, stored))
+          return GST_H264_PARSER_ERROR;
+      }
+      return GST_H264_PARSER_OK;
+    }
+  }
+
+  *changed = TRUE;
+  if (!pps)
+    pps = &tmp;
+
+  res = gst_h264_parse_pps (nalparser, nalu, pps);
+
+  if (res == GST_H264_PARSER_OK) {
+    id = pps->id;
+
+    GST_DEBUG ("adding picture parameter set with id: %d to array", id);
+
+    if (!gst_h264_pps_copy (&nalparser->pps[id], pps)) {
+      nal_fingerprint_clear (&impl->pps_fp[id]);
+      if (pps == &tmp)
+        gst_h264_pps_clear (&tmp);
+      return GST_H264_PARSER_ERROR;
+    }
+    nal_fingerprint_store (&impl->pps_fp[id], &fp);
+    impl->pps_sps_generation[id] = impl->sps_generation[pps->sequence->id];
+    nalparser->last_pps = &nalparser->pps[id];
+
+    if (pps == &tmp)
+      gst_h264_pps_clear (&tmp);
+  }
+
+  return res;
+}
+
 /******** API *************/
 
 /**
@@ -1351,11 +1537,11 @@ error:
 GstH264NalParser *
 gst_h264_nal_parser_new (void)
 {
-  GstH264NalParser *nalparser;
+  GstH264NalParserImpl *impl;
 
-  nalparser = g_slice_new0 (GstH264NalParser);
+  impl = g_slice_new0 (GstH264NalParserImpl);
 
-  return nalparser;
+  return &impl->parser;
 }
 
 /**
@@ -1367,13 +1553,18 @@ gst_h264_nal_parser_new (void)
 void
 gst_h264_nal_parser_free (GstH264NalParser * nalparser)
 {
+  GstH264NalParserImpl *impl = GST_H264_NAL_PARSER_IMPL (nalparser);
   guint i;
 
-  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++)
+  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
     gst_h264_sps_clear (&nalparser->sps[i]);
-  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++)
+    nal_fingerprint_clear (&impl->sps_fp[i]);
+  }
+  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
     gst_h264_pps_clear (&nalparser->pps[i]);
-  g_slice_free (GstH264NalParser, nalparser);
+    nal_fingerprint_clear (&impl->pps_fp[i]);
+  }
+  g_slice_free (GstH264NalParserImpl, impl);
 
   nalparser = NULL;
 }
@@ -1581,15 +1772,14 @@ gst_h264_parser_identify_nalu_avc (GstH264NalParser * nalparser,
 GstH264ParserResult
 gst_h264_parser_parse_nal (GstH264NalParser * nalparser, GstH264NalUnit * nalu)
 {
-  GstH264SPS sps;
-  GstH264PPS pps;
+  gboolean changed;
 
   switch (nalu->type) {
     case GST_H264_NAL_SPS:
-      return gst_h264_parser_parse_sps (nalparser, nalu, &sps);
-      break;
+      return gst_h264_parser_store_sps (nalparser, nalu, NULL, FALSE,
+          &changed);
     case GST_H264_NAL_PPS:
-      return gst_h264_parser_parse_pps (nalparser, nalu, &pps);
+      return gst_h264_parser_store_pps (nalparser, nalu, NULL, &changed);
   }
 
   return GST_H264_PARSER_OK;
@@ -1609,15 +1799,46 @@ GstH264ParserResult
 gst_h264_parser_parse_sps (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
     GstH264SPS * sps)
 {
-  GstH264ParserResult res = gst_h264_parse_sps (nalu, sps);
+  gboolean changed;
 
-  if (res == GST_H264_PARSER_OK) {
-    GST_DEBUG ("adding sequence parameter set with id: %d to array", sps->id);
+  g_return_val_if_fail (sps != NULL, GST_H264_PARSER_ERROR);
+
+  return gst_h264_parser_store_sps (nalparser, nalu, sps, FALSE, &changed);
+}
+
+/**
+ * gst_h264_parser_update_sps:
+ * @nalparser: a #GstH264NalParser
+ * @nalu: The #GST_H264_NAL_SPS or #GST_H264_NAL_SUBSET_SPS #GstH264NalUnit
+ * @sps: (out) (transfer none): the #GstH264SPS stored in @nalparser
+ * @changed: (out) (optional): whether the SPS stored with the same id was
+ *     replaced
+ *
+ * Parses @nalu and stores the resulting SPS in @nalparser, like
+ * gst_h264_parser_parse_sps() and gst_h264_parser_parse_subset_sps(), but
+ * without filling a copy of it. A SPS identical to the one already stored
+ * with the same id is neither parsed nor copied again.
+ *
+ * @sps points to the stored SPS, it must not be modified and stays valid
+ * until another SPS with the same id is parsed.
+ *
+ * Returns: a #GstH264ParserResult
+ *
+ * Since: 1.18
+ */
+GstH264ParserResult
+gst_h264_parser_update_sps (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264SPS ** sps, gboolean * changed)
+{
+  GstH264ParserResult res;
+  gboolean dummy;
+
+  g_return_val_if_fail (sps != NULL, GST_H264_PARSER_ERROR);
+
+  res = gst_h264_parser_store_sps (nalparser, nalu, NULL,
+      nalu->type == GST_H264_NAL_SUBSET_SPS, changed ? changed : &dummy);
+  *sps = res == GST_H264_PARSER_OK ? nalparser->last_sps : NULL;
 
-    if (!gst_h264_sps_copy (&nalparser->sps[sps->id], sps))
-      return GST_H264_PARSER_ERROR;
-    nalparser->last_sps = &nalparser->sps[sps->id];
-  }
   return res;
 }
 
@@ -1925,19 +2146,11 @@ GstH264ParserResult
 gst_h264_parser_parse_subset_sps (GstH264NalParser * nalparser,
     GstH264NalUnit * nalu, GstH264SPS * sps)
 {
-  GstH264ParserResult res;
+  gboolean changed;
 
-  res = gst_h264_parse_subset_sps (nalu, sps);
-  if (res == GST_H264_PARSER_OK) {
-    GST_DEBUG ("adding sequence parameter set with id: %d to array", sps->id);
+  g_return_val_if_fail (sps != NULL, GST_H264_PARSER_ERROR);
 
-    if (!gst_h264_sps_copy (&nalparser->sps[sps->id], sps)) {
-      gst_h264_sps_clear (sps);
-      return GST_H264_PARSER_ERROR;
-    }
-    nalparser->last_sps = &nalparser->sps[sps->id];
-  }
-  return res;
+  return gst_h264_parser_store_sps (nalparser, nalu, sps, TRUE, &changed);
 }
 
 /**
@@ -2141,15 +2354,45 @@ GstH264ParserResult
 gst_h264_parser_parse_pps (GstH264NalParser * nalparser,
     GstH264NalUnit * nalu, GstH264PPS * pps)
 {
-  GstH264ParserResult res = gst_h264_parse_pps (nalparser, nalu, pps);
+  gboolean changed;
 
-  if (res == GST_H264_PARSER_OK) {
-    GST_DEBUG ("adding picture parameter set with id: %d to array", pps->id);
+  g_return_val_if_fail (pps != NULL, GST_H264_PARSER_ERROR);
 
-    if (!gst_h264_pps_copy (&nalparser->pps[pps->id], pps))
-      return GST_H264_PARSER_ERROR;
-    nalparser->last_pps = &nalparser->pps[pps->id];
-  }
+  return gst_h264_parser_store_pps (nalparser, nalu, pps, &changed);
+}
+
+/**
+ * gst_h264_parser_update_pps:
+ * @nalparser: a #GstH264NalParser
+ * @nalu: The #GST_H264_NAL_PPS #GstH264NalUnit
+ * @pps: (out) (transfer none): the #GstH264PPS stored in @nalparser
+ * @changed: (out) (optional): whether the PPS stored with the same id was
+ *     replaced
+ *
+ * Parses @nalu and stores the resulting PPS in @nalparser, like
+ * gst_h264_parser_parse_pps(), but without filling a copy of it. A PPS
+ * identical to the one already stored with the same id is neither parsed nor
+ * copied again, unless the SPS it refers to has changed since.
+ *
+ * @pps points to the stored PPS, it must not be modified and stays valid
+ * until another PPS with the same id is parsed.
+ *
+ * Returns: a #GstH264ParserResult
+ *
+ * Since: 1.18
+ */
+GstH264ParserResult
+gst_h264_parser_update_pps (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264PPS ** pps, gboolean * changed)
+{
+  GstH264ParserResult res;
+  gboolean dummy;
+
+  g_return_val_if_fail (pps != NULL, GST_H264_PARSER_ERROR);
+
+  res = gst_h264_parser_store_pps (nalparser, nalu, NULL,
+      changed ? changed : &dummy);
+  *pps = res == GST_H264_PARSER_OK ? nalparser->last_pps : NULL;
 
   return res;
 }
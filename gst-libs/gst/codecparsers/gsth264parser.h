@@ -1161,6 +1161,16 @@ GST_CODEC_PARSERS_API
 GstH264ParserResult gst_h264_parser_parse_pps         (GstH264NalParser *nalparser,
                                                        GstH264NalUnit *nalu, GstH264PPS *pps);
 
+GST_CODEC_PARSERS_API
+GstH264ParserResult gst_h264_parser_update_sps        (GstH264NalParser *nalparser,
+                                                       GstH264NalUnit *nalu, GstH264SPS **sps,
+                                                       gboolean *changed);
+
+GST_CODEC_PARSERS_API
+GstH264ParserResult gst_h264_parser_update_pps        (GstH264NalParser *nalparser,
+                                                       GstH264NalUnit *nalu, GstH264PPS **pps,
+                                                       gboolean *changed);
+
 GST_CODEC_PARSERS_API
 GstH264ParserResult gst_h264_parser_parse_sei         (GstH264NalParser *nalparser,
                                                        GstH264NalUnit *nalu, GArray ** messages);
@@ -308,6 +308,121 @@ static const struct h265_profile_string h265_profiles[] = {
   {GST_H265_PROFILE_3D_MAIN, "3d-main"},
 };
 
+/* Private parser state, allocated in place of the public struct. It keeps
+ * the raw bytes of every stored parameter set, so that an identical one
+ * re-sent later (usually with every IRAP picture) is recognised without
+ * parsing it again */
+typedef struct
+{
+  GstH265Parser parser;
+
+  NalFingerprint vps_fp[GST_H265_MAX_VPS_COUNT];
+  NalFingerprint sps_fp[GST_H265_MAX_SPS_COUNT];
+  NalFingerprint pps_fp[GST_H265_MAX_PPS_COUNT];
+
+  /* X_generation[id] is bumped whenever X[id] is replaced, and a parameter
+   * set is only reused if the one it was parsed against has not changed
+   * since */
+  guint vps_generation[GST_H265_MAX_VPS_COUNT];
+  guint sps_generation[GST_H265_MAX_SPS_COUNT];
+  guint sps_vps_generation[GST_H265_MAX_SPS_COUNT];
+  guint pps_sps_generation[GST_H265_MAX_PPS_COUNT];
+
+  /* whether sps[id] was parsed with its VUI parameters */
+  gboolean sps_vui[GST_H265_MAX_SPS_COUNT];
+} GstH265ParserImpl;
+
+#define GST_H265_PARSER_IMPL(p) ((GstH265ParserImpl *) (p))
+
+static void
+gst_h265_nal_fingerprint_init (NalFingerprint * fp, GstH265NalUnit * nalu)
+{
+  nal_fingerprint_init (fp, nalu->data + nalu->offset, nalu->size);
+}
+
+/* Reads a parameter set id stored in the first @nbits of the payload, or as
+ * the first ue(v) if @nbits is 0, without parsing the rest of it */
+static gboolean
+gst_h265_peek_parameter_set_id (GstH265NalUnit * nalu, guint nbits,
+    guint max, guint * id)
+{
+  NalReader nr;
+  guint32 val;
+  guint8 bits;
+
+  if (nalu->size < nalu->header_bytes)
+    return FALSE;
+
+  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+      nalu->size - nalu->header_bytes);
+
+  if (nbits) {
+    if (!nal_reader_get_bits_uint8 (&nr, &bits, nbits))
+      return FALSE;
+    val = bits;
+  } else if (!nal_reader_get_ue (&nr, &val)) {
+    return FALSE;
+  }
+
+  if (val >= max)
+    return FALSE;
+
+  *id = val;
+
+  return TRUE;
+}
+
+/* Reads the VPS and SPS ids of a SPS. The SPS id comes after the variable
+ * length profile_tier_level(), which is skipped without being parsed */
+static gboolean
+gst_h265_peek_sps_id (GstH265NalUnit * nalu, guint * vps_id, guint * id)
+{
+  NalReader nr;
+  guint8 vps, max_sub_layers_minus1, present[7];
+  guint32 val;
+  guint i;
+
+  if (nalu->size < nalu->header_bytes)
+    return FALSE;
+
+  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+      nalu->size - nalu->header_bytes);
+
+  if (!nal_reader_get_bits_uint8 (&nr, &vps, 4)
+      || !nal_reader_get_bits_uint8 (&nr, &max_sub_layers_minus1, 3)
+      || max_sub_layers_minus1 > 6 || !nal_reader_skip (&nr, 1))
+    return FALSE;
+
+  /* general profile, tier and level */
+  if (!nal_reader_skip_long (&nr, 96))
+    return FALSE;
+
+  /* sub_layer_profile_present_flag and sub_layer_level_present_flag */
+  for (i = 0; i < max_sub_layers_minus1; i++) {
+    if (!nal_reader_get_bits_uint8 (&nr, &present[i], 2))
+      return FALSE;
+  }
+
+  if (max_sub_layers_minus1 > 0
+      && !nal_reader_skip (&nr, 2 * (8 - max_sub_layers_minus1)))
+    return FALSE;
+
+  for (i = 0; i < max_sub_layers_minus1; i++) {
+    if ((present[i] & 0x2) && !nal_reader_skip_long (&nr, 88))
+      return FALSE;
+    if ((present[i] & 0x1) && !nal_reader_skip (&nr, 8))
+      return FALSE;
+  }
+
+  if (!nal_reader_get_ue (&nr, &val) || val >= GST_H265_MAX_SPS_COUNT)
+    return FALSE;
+
+  *vps_id = vps;
+  *id = val;
+
+  return TRUE;
+}
+
 /****** Parsing functions *****/
 
 static gboolean
@@ -1335,6 +1450,163 @@ error:
   return GST_H265_PARSER_ERROR;
 }
 
+/* Parses @nalu and stores the result in parser->vps, unless it is identical
+ * to the VPS already stored with the same id. If @vps is not %NULL, it is
+ * filled with the stored VPS. @changed tells whether the stored VPS was
+ * replaced */
+static GstH265ParserResult
+gst_h265_parser_store_vps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265VPS * vps, gboolean * changed)
+{
+  GstH265ParserImpl *impl = GST_H265_PARSER_IMPL (parser);
+  GstH265ParserResult res;
+  NalFingerprint fp;
+  GstH265VPS tmp;
+  guint id;
+
+  gst_h265_nal_fingerprint_init (&fp, nalu);
+
+  if (gst_h265_peek_parameter_set_id (nalu, 4, GST_H265_MAX_VPS_COUNT, &id)
+      && parser->vps[id].valid
+      && nal_fingerprint_equal (&impl->vps_fp[id], &fp)) {
+    GST_LOG ("video parameter set with id: %d is unchanged", id);
+
+    *changed = FALSE;
+    parser->last_vps = &parser->vps[id];
+    if (vps)
+      *vps = parser->vps[id];
+    return GST_H265_PARSER_OK;
+  }
+
+  *changed = TRUE;
+  if (!vps)
+    vps = &tmp;
+
+  res = gst_h265_parse_vps (nalu, vps);
+
+  if (res == GST_H265_PARSER_OK) {
+    id = vps->id;
+
+    GST_DEBUG ("adding video parameter set with id: %d to array", id);
+
+    parser->vps[id] = *vps;
+    parser->last_vps = &parser->vps[id];
+    nal_fingerprint_store (&impl->vps_fp[id], &fp);
+    impl->vps_generation[id]++;
+  }
+
+  return res;
+}
+
+/* Same as gst_h265_parser_store_vps(), a stored SPS is also parsed again if
+ * the VPS it refers to has changed since, or if it was parsed without the
+ * VUI parameters that are now requested */
+static GstH265ParserResult
+gst_h265_parser_store_sps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265SPS * sps, gboolean parse_vui_params, gboolean * changed)
+{
+  GstH265ParserImpl *impl = GST_H265_PARSER_IMPL (parser);
+  GstH265ParserResult res;
+  GstH265VPS *vps;
+  NalFingerprint fp;
+  GstH265SPS tmp;
+  guint vps_id, id;
+
+  gst_h265_nal_fingerprint_init (&fp, nalu);
+
+  if (gst_h265_peek_sps_id (nalu, &vps_id, &id)) {
+    vps = gst_h265_parser_get_vps (parser, vps_id);
+
+    if (parser->sps[id].valid && parser->sps[id].vps == vps
+        && (!parse_vui_params || impl->sps_vui[id])
+        && (!vps || impl->sps_vps_generation[id] ==
+            impl->vps_generation[vps_id])
+        && nal_fingerprint_equal (&impl->sps_fp[id], &fp)) {
+      GST_LOG ("sequence parameter set with id: %d is unchanged", id);
+
+      *changed = FALSE;
+      parser->last_sps = &parser->sps[id];
+      if (sps)
+        *sps = parser->sps[id];
+      return GST_H265_PARSER_OK;
+    }
+  }
+
+  *changed = TRUE;
+  if (!sps)
+    sps = &tmp;
+
+  res = gst_h265_parse_sps (parser, nalu, sps, parse_vui_params);
+
+  if (res == GST_H265_PARSER_OK) {
+    id = sps->id;
+
+    GST_DEBUG ("adding sequence parameter set with id: %d to array", id);
+
+    parser->sps[id] = *sps;
+    parser->last_sps = &parser->sps[id];
+    nal_fingerprint_store (&impl->sps_fp[id], &fp);
+    impl->sps_generation[id]++;
+    impl->sps_vps_generation[id] =
+        sps->vps ? impl->vps_generation[sps->vps->id] : 0;
+    impl->sps_vui[id] = parse_vui_params;
+  }
+
+  return res;
+}
+
+/* Same as gst_h265_parser_store_vps(), a stored PPS is also parsed again if
+ * the SPS it refers to has changed since */
+static GstH265ParserResult
+gst_h265_parser_store_pps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265PPS * pps, gboolean * changed)
+{
+  GstH265ParserImpl *impl = GST_H265_PARSER_IMPL (parser);
+  GstH265ParserResult res;
+  GstH265PPS *stored;
+  NalFingerprint fp;
+  GstH265PPS tmp;
+  guint id;
+
+  gst_h265_nal_fingerprint_init (&fp, nalu);
+
+  if (gst_h265_peek_parameter_set_id (nalu, 0, GST_H265_MAX_PPS_COUNT, &id)) {
+    stored = &parser->pps[id];
+
+    if (stored->valid && stored->sps && stored->sps->valid
+        && impl->pps_sps_generation[id] ==
+        impl->sps_generation[stored->sps->id]
+        && nal_fingerprint_equal (&impl->pps_fp[id], &fp)) {
+      GST_LOG ("picture parameter set with id: %d is unchanged", id);
+
+      *changed = FALSE;
+      parser->last_pps = stored;
+      if (pps)
+        *pps = *stored;
+      return GST_H265_PARSER_OK;
+    }
+  }
+
+  *changed = TRUE;
+  if (!pps)
+    pps = &tmp;
+
+  res = gst_h265_parse_pps (parser, nalu, pps);
+
+  if (res == GST_H265_PARSER_OK) {
+    id = pps->id;
+
+    GST_DEBUG ("adding picture parameter set with id: %d to array", id);
+
+    parser->pps[id] = *pps;
+    parser->last_pps = &parser->pps[id];
+    nal_fingerprint_store (&impl->pps_fp[id], &fp);
+    impl->pps_sps_generation[id] = impl->sps_generation[pps->sps->id];
+  }
+
+  return res;
+}
+
 /******** API *************/
 
 /**
@@ -1348,11 +1620,11 @@ error:
 GstH265Parser *
 gst_h265_parser_new (void)
 {
-  GstH265Parser *parser;
+  GstH265ParserImpl *impl;
 
-  parser = g_slice_new0 (GstH265Parser);
+  impl = g_slice_new0 (GstH265ParserImpl);
 
-  return parser;
+  return &impl->parser;
 }
 
 /**
@@ -1364,7 +1636,16 @@ gst_h265_parser_new (void)
 void
 gst_h265_parser_free (GstH265Parser * parser)
 {
-  g_slice_free (GstH265Parser, parser);
+  GstH265ParserImpl *impl = GST_H265_PARSER_IMPL (parser);
+  guint i;
+
+  for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++)
+    nal_fingerprint_clear (&impl->vps_fp[i]);
+  for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++)
+    nal_fingerprint_clear (&impl->sps_fp[i]);
+  for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++)
+    nal_fingerprint_clear (&impl->pps_fp[i]);
+  g_slice_free (GstH265ParserImpl, impl);
   parser = NULL;
 }
 
@@ -1566,19 +1847,15 @@ gst_h265_parser_identify_nalu_hevc (GstH265Parser * parser,
 GstH265ParserResult
 gst_h265_parser_parse_nal (GstH265Parser * parser, GstH265NalUnit * nalu)
 {
-  GstH265VPS vps;
-  GstH265SPS sps;
-  GstH265PPS pps;
+  gboolean changed;
 
   switch (nalu->type) {
     case GST_H265_NAL_VPS:
-      return gst_h265_parser_parse_vps (parser, nalu, &vps);
-      break;
+      return gst_h265_parser_store_vps (parser, nalu, NULL, &changed);
     case GST_H265_NAL_SPS:
-      return gst_h265_parser_parse_sps (parser, nalu, &sps, FALSE);
-      break;
+      return gst_h265_parser_store_sps (parser, nalu, NULL, FALSE, &changed);
     case GST_H265_NAL_PPS:
-      return gst_h265_parser_parse_pps (parser, nalu, &pps);
+      return gst_h265_parser_store_pps (parser, nalu, NULL, &changed);
   }
 
   return GST_H265_PARSER_OK;
@@ -1598,14 +1875,44 @@ GstH265ParserResult
 gst_h265_parser_parse_vps (GstH265Parser * parser, GstH265NalUnit * nalu,
     GstH265VPS * vps)
 {
-  GstH265ParserResult res = gst_h265_parse_vps (nalu, vps);
+  gboolean changed;
 
-  if (res == GST_H265_PARSER_OK) {
-    GST_DEBUG ("adding video parameter set with id: %d to array", vps->id);
+  g_return_val_if_fail (vps != NULL, GST_H265_PARSER_ERROR);
 
-    parser->vps[vps->id] = *vps;
-    parser->last_vps = &parser->vps[vps->id];
-  }
+  return gst_h265_parser_store_vps (parser, nalu, vps, &changed);
+}
+
+/**
+ * gst_h265_parser_update_vps:
+ * @parser: a #GstH265Parser
+ * @nalu: The #GST_H265_NAL_VPS #GstH265NalUnit to parse
+ * @vps: (out) (transfer none): the #GstH265VPS stored in @parser
+ * @changed: (out) (optional): whether the VPS stored with the same id was
+ *     replaced
+ *
+ * Parses @nalu and stores the resulting VPS in @parser, like
+ * gst_h265_parser_parse_vps(), but without filling a copy of it. A VPS
+ * identical to the one already stored with the same id is not parsed again.
+ *
+ * @vps points to the stored VPS, it must not be modified and stays valid
+ * until another VPS with the same id is parsed.
+ *
+ * Returns: a #GstH265ParserResult
+ *
+ * Since: 1.18
+ */
+GstH265ParserResult
+gst_h265_parser_update_vps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265VPS ** vps, gboolean * changed)
+{
+  GstH265ParserResult res;
+  gboolean dummy;
+
+  g_return_val_if_fail (vps != NULL, GST_H265_PARSER_ERROR);
+
+  res = gst_h265_parser_store_vps (parser, nalu, NULL,
+      changed ? changed : &dummy);
+  *vps = res == GST_H265_PARSER_OK ? parser->last_vps : NULL;
 
   return res;
 }
@@ -1767,15 +2074,47 @@ GstH265ParserResult
 gst_h265_parser_parse_sps (GstH265Parser * parser, GstH265NalUnit * nalu,
     GstH265SPS * sps, gboolean parse_vui_params)
 {
-  GstH265ParserResult res =
-      gst_h265_parse_sps (parser, nalu, sps, parse_vui_params);
+  gboolean changed;
 
-  if (res == GST_H265_PARSER_OK) {
-    GST_DEBUG ("adding sequence parameter set with id: %d to array", sps->id);
+  g_return_val_if_fail (sps != NULL, GST_H265_PARSER_ERROR);
 
-    parser->sps[sps->id] = *sps;
-    parser->last_sps = &parser->sps[sps->id];
-  }
+  return gst_h265_parser_store_sps (parser, nalu, sps, parse_vui_params,
+      &changed);
+}
+
+/**
+ * gst_h265_parser_update_sps:
+ * @parser: a #GstH265Parser
+ * @nalu: The #GST_H265_NAL_SPS #GstH265NalUnit to parse
+ * @sps: (out) (transfer none): the #GstH265SPS stored in @parser
+ * @parse_vui_params: Whether to parse the vui_params or not
+ * @changed: (out) (optional): whether the SPS stored with the same id was
+ *     replaced
+ *
+ * Parses @nalu and stores the resulting SPS in @parser, like
+ * gst_h265_parser_parse_sps(), but without filling a copy of it. A SPS
+ * identical to the one already stored with the same id is not parsed again,
+ * unless the VPS it refers to has changed since.
+ *
+ * @sps points to the stored SPS, it must not be modified and stays valid
+ * until another SPS with the same id is parsed.
+ *
+ * Returns: a #GstH265ParserResult
+ *
+ * Since: 1.18
+ */
+GstH265ParserResult
+gst_h265_parser_update_sps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265SPS ** sps, gboolean parse_vui_params, gboolean * changed)
+{
+  GstH265ParserResult res;
+  gboolean dummy;
+
+  g_return_val_if_fail (sps != NULL, GST_H265_PARSER_ERROR);
+
+  res = gst_h265_parser_store_sps (parser, nalu, NULL, parse_vui_params,
+      changed ? changed : &dummy);
+  *sps = res == GST_H265_PARSER_OK ? parser->last_sps : NULL;
 
   return res;
 }
@@ -2218,13 +2557,45 @@ GstH265ParserResult
 gst_h265_parser_parse_pps (GstH265Parser * parser,
     GstH265NalUnit * nalu, GstH265PPS * pps)
 {
-  GstH265ParserResult res = gst_h265_parse_pps (parser, nalu, pps);
-  if (res == GST_H265_PARSER_OK) {
-    GST_DEBUG ("adding picture parameter set with id: %d to array", pps->id);
+  gboolean changed;
 
-    parser->pps[pps->id] = *pps;
-    parser->last_pps = &parser->pps[pps->id];
-  }
+  g_return_val_if_fail (pps != NULL, GST_H265_PARSER_ERROR);
+
+  return gst_h265_parser_store_pps (parser, nalu, pps, &changed);
+}
+
+/**
+ * gst_h265_parser_update_pps:
+ * @parser: a #GstH265Parser
+ * @nalu: The #GST_H265_NAL_PPS #GstH265NalUnit to parse
+ * @pps: (out) (transfer none): the #GstH265PPS stored in @parser
+ * @changed: (out) (optional): whether the PPS stored with the same id was
+ *     replaced
+ *
+ * Parses @nalu and stores the resulting PPS in @parser, like
+ * gst_h265_parser_parse_pps(), but without filling a copy of it. A PPS
+ * identical to the one already stored with the same id is not parsed again,
+ * unless the SPS it refers to has changed since.
+ *
+ * @pps points to the stored PPS, it must not be modified and stays valid
+ * until another PPS with the same id is parsed.
+ *
+ * Returns: a #GstH265ParserResult
+ *
+ * Since: 1.18
+ */
+GstH265ParserResult
+gst_h265_parser_update_pps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265PPS ** pps, gboolean * changed)
+{
+  GstH265ParserResult res;
+  gboolean dummy;
+
+  g_return_val_if_fail (pps != NULL, GST_H265_PARSER_ERROR);
+
+  res = gst_h265_parser_store_pps (parser, nalu, NULL,
+      changed ? changed : &dummy);
+  *pps = res == GST_H265_PARSER_OK ? parser->last_pps : NULL;
 
   return res;
 }
@@ -2534,6 +2905,164 @@ error:
   return GST_H265_PARSER_ERROR;
 }
 
+/* Below that many slice segments per thread, handing them over to another
+ * thread costs more than parsing them */
+#define SLICE_HDRS_PER_THREAD 4
+#define MAX_SLICE_HDR_THREADS 8
+
+typedef struct
+{
+  GstH265Parser *parser;
+  GstH265NalUnit *nalus;
+  GstH265SliceHdr *slices;
+  GstH265ParserResult *results;
+  guint n_nalus;
+
+  /* index of the next slice segment to parse, threads which run out of work
+   * keep taking slice segments from here until there are none left */
+  volatile gint next;
+
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
+} GstH265SliceHdrBatch;
+
+static void
+gst_h265_slice_hdr_batch_run (GstH265SliceHdrBatch * batch)
+{
+  guint i;
+
+  while ((i = g_atomic_int_add (&batch->next, 1)) < batch->n_nalus) {
+    batch->results[i] = gst_h265_parser_parse_slice_hdr (batch->parser,
+        &batch->nalus[i], &batch->slices[i]);
+  }
+}
+
+static void
+gst_h265_slice_hdr_batch_worker (gpointer data, gpointer user_data)
+{
+  GstH265SliceHdrBatch *batch = data;
+
+  gst_h265_slice_hdr_batch_run (batch);
+
+  g_mutex_lock (&batch->lock);
+  if (--batch->n_pending == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->lock);
+}
+
+static GThreadPool *
+gst_h265_slice_hdr_get_thread_pool (void)
+{
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&pool)) {
+    gint n_threads = CLAMP (g_get_num_processors () - 1, 1,
+        MAX_SLICE_HDR_THREADS);
+
+    g_once_init_leave (&pool,
+        g_thread_pool_new (gst_h265_slice_hdr_batch_worker, NULL, n_threads,
+            FALSE, NULL));
+  }
+
+  return pool;
+}
+
+/**
+ * gst_h265_parser_parse_slice_hdrs:
+ * @parser: a #GstH265Parser
+ * @nalus: (array length=n_nalus): the slice segment #GstH265NalUnit of one
+ *   access unit
+ * @n_nalus: the number of entries in @nalus
+ * @slices: (array length=n_nalus) (out caller-allocates): the
+ *   #GstH265SliceHdr to fill, one for each entry of @nalus
+ * @results: (array length=n_nalus) (out caller-allocates) (optional): the
+ *   #GstH265ParserResult of each slice segment header
+ *
+ * Parses the slice segment headers of @nalus and fills @slices as
+ * gst_h265_parser_parse_slice_hdr() would for each of them, with @slices[i]
+ * always corresponding to @nalus[i]. Slice segment headers only depend on the
+ * parameter sets, so when there are enough of them the work is spread over
+ * a pool of threads shared by all parsers.
+ *
+ * The parameter sets stored in @parser are only read, but the caller must
+ * make sure no VPS, SPS or PPS is parsed with @parser until this function
+ * returns. Fields of dependent slice segments inherited from the preceding
+ * independent slice segment are not filled in, as with
+ * gst_h265_parser_parse_slice_hdr().
+ *
+ * Each successfully parsed entry of @slices shall be deallocated with
+ * gst_h265_slice_hdr_free() when it is no longer needed.
+ *
+ * Returns: %GST_H265_PARSER_OK if all slice segment headers were parsed,
+ *   otherwise the result of the first one which couldn't be, in decoding
+ *   order
+ *
+ * Since: 1.18
+ */
+GstH265ParserResult
+gst_h265_parser_parse_slice_hdrs (GstH265Parser * parser,
+    GstH265NalUnit * nalus, guint n_nalus, GstH265SliceHdr * slices,
+    GstH265ParserResult * results)
+{
+  GstH265SliceHdrBatch batch = { 0, };
+  GstH265ParserResult res = GST_H265_PARSER_OK;
+  GThreadPool *pool = NULL;
+  guint n_threads;
+  guint i;
+
+  g_return_val_if_fail (parser != NULL, GST_H265_PARSER_ERROR);
+  g_return_val_if_fail (nalus != NULL || n_nalus == 0, GST_H265_PARSER_ERROR);
+  g_return_val_if_fail (slices != NULL || n_nalus == 0, GST_H265_PARSER_ERROR);
+
+  batch.parser = parser;
+  batch.nalus = nalus;
+  batch.slices = slices;
+  batch.results = results ? results : g_new (GstH265ParserResult, n_nalus);
+  batch.n_nalus = n_nalus;
+
+  n_threads = n_nalus / SLICE_HDRS_PER_THREAD;
+  if (n_threads > 1) {
+    pool = gst_h265_slice_hdr_get_thread_pool ();
+    n_threads = MIN (n_threads,
+        (guint) g_thread_pool_get_max_threads (pool) + 1);
+  }
+
+  if (n_threads > 1) {
+    g_mutex_init (&batch.lock);
+    g_cond_init (&batch.cond);
+    batch.n_pending = n_threads - 1;
+
+    for (i = 0; i < n_threads - 1; i++)
+      g_thread_pool_push (pool, &batch, NULL);
+
+    /* the calling thread takes its share too */
+    gst_h265_slice_hdr_batch_run (&batch);
+
+    g_mutex_lock (&batch.lock);
+    while (batch.n_pending)
+      g_cond_wait (&batch.cond, &batch.lock);
+    g_mutex_unlock (&batch.lock);
+
+    g_mutex_clear (&batch.lock);
+    g_cond_clear (&batch.cond);
+  } else {
+    gst_h265_slice_hdr_batch_run (&batch);
+  }
+
+  for (i = 0; i < n_nalus; i++) {
+    if (batch.results[i] != GST_H265_PARSER_OK) {
+      res = batch.results[i];
+      break;
+    }
+  }
+
+  if (!results)
+    g_free (batch.results);
+
+  return res;
+}
+
 static GstH265ParserResult
 gst_h265_parser_parse_sei_message (GstH265Parser * parser,
     guint8 nal_type, NalReader * nr, GstH265SEIMessage * sei)
@@ -1406,6 +1406,12 @@ struct _GstH265SEIMessage
  * GstH265Parser:
  *
  * H265 NAL Parser (opaque structure).
+ *
+ * The parameter sets stored in the parser are only modified when parsing a
+ * VPS, SPS or PPS, parsing slice segment headers only reads them. Slice
+ * segment headers can therefore be parsed from several threads at once, as
+ * gst_h265_parser_parse_slice_hdrs() does, as long as no parameter set is
+ * parsed meanwhile.
  */
 struct _GstH265Parser
 {
@@ -1452,6 +1458,13 @@ GstH265ParserResult gst_h265_parser_parse_slice_hdr (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
                                                      GstH265SliceHdr * slice);
 
+GST_CODEC_PARSERS_API
+GstH265ParserResult gst_h265_parser_parse_slice_hdrs (GstH265Parser       * parser,
+                                                      GstH265NalUnit      * nalus,
+                                                      guint                 n_nalus,
+                                                      GstH265SliceHdr     * slices,
+                                                      GstH265ParserResult * results);
+
 GST_CODEC_PARSERS_API
 GstH265ParserResult gst_h265_parser_parse_vps       (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
@@ -1468,6 +1481,25 @@ GstH265ParserResult gst_h265_parser_parse_pps       (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
                                                      GstH265PPS      * pps);
 
+GST_CODEC_PARSERS_API
+GstH265ParserResult gst_h265_parser_update_vps      (GstH265Parser   * parser,
+                                                     GstH265NalUnit  * nalu,
+                                                     GstH265VPS     ** vps,
+                                                     gboolean        * changed);
+
+GST_CODEC_PARSERS_API
+GstH265ParserResult gst_h265_parser_update_sps      (GstH265Parser   * parser,
+                                                     GstH265NalUnit  * nalu,
+                                                     GstH265SPS     ** sps,
+                                                     gboolean          parse_vui_params,
+                                                     gboolean        * changed);
+
+GST_CODEC_PARSERS_API
+GstH265ParserResult gst_h265_parser_update_pps      (GstH265Parser   * parser,
+                                                     GstH265NalUnit  * nalu,
+                                                     GstH265PPS     ** pps,
+                                                     gboolean        * changed);
+
 GST_CODEC_PARSERS_API
 GstH265ParserResult gst_h265_parser_parse_sei       (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
@@ -222,9 +222,6 @@ static const GstJpegHuffmanTableEntry default_chrominance_ac_table[] = {
 };
 /* *INDENT-ON* */
 
-static gint gst_jpeg_scan_for_marker_code (const guint8 * data, gsize size,
-    guint offset);
-
 static inline gboolean
 jpeg_parse_to_next_marker (GstByteReader * br, GstJpegMarker * marker)
 {
@@ -241,7 +238,8 @@ jpeg_parse_to_next_marker (GstByteReader * br, GstJpegMarker * marker)
   return TRUE;
 }
 
-/* gst_jpeg_scan_for_marker_code:
+/**
+ * gst_jpeg_scan_for_marker_code:
  * @data: The data to parse
  * @size: The size of @data
  * @offset: The offset from which to start parsing
@@ -250,26 +248,97 @@ jpeg_parse_to_next_marker (GstByteReader * br, GstJpegMarker * marker)
  * code. If found, the function returns an offset to the marker code,
  * including the 0xff prefix code but excluding any extra fill bytes.
  *
+ * Stuffed 0xff bytes of entropy-coded data are skipped, so this can be
+ * used to find the end of an entropy-coded segment.
+ *
  * Returns: offset to the marker code if found, or -1 if not found.
+ *
+ * Since: 1.18
  */
-static gint
+gint
 gst_jpeg_scan_for_marker_code (const guint8 * data, gsize size, guint offset)
 {
-  guint i;
-
-  i = offset + 1;
-  while (i < size) {
-    const guint8 v = data[i];
-    if (v < 0xc0)
-      i += 2;
-    else if (v < 0xff && data[i - 1] == 0xff)
-      return i - 1;
-    else
-      i++;
+  const guint8 *p, *end;
+
+  g_return_val_if_fail (data != NULL || size == 0, -1);
+
+  if (size < 2 || offset >= size - 1)
+    return -1;
+
+  /* 0xff bytes are rare in entropy-coded data, so let the C library's
+   * vectorised memchr() skip over everything else */
+  p = data + offset;
+  end = data + size - 1;
+  while (p < end) {
+    p = memchr (p, 0xff, end - p);
+    if (!p)
+      return -1;
+    if (p[1] >= 0xc0 && p[1] < 0xff)
+      return p - data;
+    p++;
   }
   return -1;
 }
 
+/**
+ * gst_jpeg_scan_restart_intervals:
+ * @data: The data to parse
+ * @size: The size of @data
+ * @offset: The offset of the entropy-coded data, right after the scan
+ *   header
+ * @intervals: (element-type guint): a #GArray to append the offsets to
+ * @end_offset: (out) (optional): the offset of the marker code ending the
+ *   entropy-coded data
+ *
+ * Splits the entropy-coded data of a scan into its restart intervals, as
+ * delimited by the RSTn markers. The offset of the entropy-coded data of
+ * each interval is appended to @intervals, starting with @offset, so that
+ * the intervals can be decoded independently.
+ *
+ * Returns: TRUE if the marker ending the entropy-coded data was found.
+ *   Otherwise more data is needed, and @intervals only holds the intervals
+ *   found so far.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_jpeg_scan_restart_intervals (const guint8 * data, gsize size,
+    guint offset, GArray * intervals, guint * end_offset)
+{
+  guint start = offset;
+  guint n_markers = 0;
+  gint ofs;
+
+  g_return_val_if_fail (data != NULL, FALSE);
+  g_return_val_if_fail (intervals != NULL, FALSE);
+  g_return_val_if_fail (g_array_get_element_size (intervals) ==
+      sizeof (guint), FALSE);
+
+  g_array_append_val (intervals, start);
+
+  while ((ofs = gst_jpeg_scan_for_marker_code (data, size, start)) >= 0) {
+    GstJpegMarker marker = data[ofs + 1];
+
+    if (marker < GST_JPEG_MARKER_RST_MIN || marker > GST_JPEG_MARKER_RST_MAX) {
+      if (end_offset)
+        *end_offset = ofs;
+      return TRUE;
+    }
+
+    /* RSTn markers count modulo 8 */
+    if (marker != GST_JPEG_MARKER_RST_MIN + (n_markers % 8)) {
+      GST_WARNING ("unexpected RST%d marker after %u intervals",
+          marker - GST_JPEG_MARKER_RST_MIN, n_markers + 1);
+    }
+    n_markers++;
+
+    start = ofs + 2;
+    g_array_append_val (intervals, start);
+  }
+
+  return FALSE;
+}
+
 /**
  * gst_jpeg_segment_parse_frame_header:
  * @segment: the JPEG segment
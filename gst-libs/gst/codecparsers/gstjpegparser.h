@@ -381,6 +381,18 @@ gboolean  gst_jpeg_parse (GstJpegSegment * seg,
                           gsize            size,
                           guint            offset);
 
+GST_CODEC_PARSERS_API
+gint      gst_jpeg_scan_for_marker_code (const guint8 * data,
+                                         gsize          size,
+                                         guint          offset);
+
+GST_CODEC_PARSERS_API
+gboolean  gst_jpeg_scan_restart_intervals (const guint8 * data,
+                                           gsize          size,
+                                           guint          offset,
+                                           GArray       * intervals,
+                                           guint        * end_offset);
+
 GST_CODEC_PARSERS_API
 gboolean  gst_jpeg_segment_parse_frame_header  (const GstJpegSegment  * segment,
                                                 GstJpegFrameHdr       * frame_hdr);
@@ -193,7 +193,7 @@ static inline gint
 scan_for_start_codes (const GstByteReader * reader, guint offset, guint size)
 {
   const guint8 *data;
-  guint i = 0;
+  gint i;
 
   g_assert ((guint64) offset + size <= reader->size - reader->byte);
 
@@ -203,19 +203,8 @@ scan_for_start_codes (const GstByteReader * reader, guint offset, guint size)
 
   data = reader->data + reader->byte + offset;
 
-  while (i <= (size - 4)) {
-    if (data[i + 2] > 1) {
-      i += 3;
-    } else if (data[i + 1]) {
-      i += 2;
-    } else if (data[i] || data[i + 2] != 1) {
-      i++;
-    } else {
-      break;
-    }
-  }
-
-  if (i <= (size - 4))
+  i = scan_for_start_code (data, size);
+  if (i >= 0)
     return offset + i;
 
   /* nothing found */
@@ -814,3 +814,127 @@ gst_vp9_parser_parse_frame_header (GstVp9Parser * parser,
 error:
   return GST_VP9_PARSER_ERROR;
 }
+
+/**
+ * gst_vp9_parser_parse_superframe_info:
+ * @parser: The #GstVp9Parser
+ * @superframe_info: The #GstVp9SuperframeInfo to fill
+ * @data: The data to parse
+ * @size: The size of the @data to parse
+ *
+ * Parses the superframe index that may trail @data, and fills in
+ * @superframe_info with the size of every frame it contains. If @data is a
+ * single frame, @superframe_info describes a superframe made of one frame
+ * of @size bytes.
+ *
+ * Returns: a #GstVp9ParserResult
+ *
+ * Since: 1.18
+ */
+GstVp9ParserResult
+gst_vp9_parser_parse_superframe_info (GstVp9Parser * parser,
+    GstVp9SuperframeInfo * superframe_info, const guint8 * data, gsize size)
+{
+  const guint8 *index;
+  guint8 marker;
+  guint32 frames_in_superframe, bytes_per_framesize, index_size;
+  gsize total_size = 0;
+  guint i, j;
+
+  g_return_val_if_fail (parser != NULL, GST_VP9_PARSER_ERROR);
+  g_return_val_if_fail (superframe_info != NULL, GST_VP9_PARSER_ERROR);
+  g_return_val_if_fail (data != NULL, GST_VP9_PARSER_ERROR);
+
+  memset (superframe_info, 0, sizeof (GstVp9SuperframeInfo));
+
+  if (size == 0)
+    return GST_VP9_PARSER_BROKEN_DATA;
+
+  superframe_info->frames_in_superframe = 1;
+  superframe_info->frame_sizes[0] = size;
+
+  /* superframe_index() ends with a marker byte 0b110xxxxx */
+  marker = data[size - 1];
+  if ((marker & 0xe0) != 0xc0)
+    return GST_VP9_PARSER_OK;
+
+  frames_in_superframe = (marker & 0x7) + 1;
+  bytes_per_framesize = ((marker >> 3) & 0x3) + 1;
+  index_size = 2 + bytes_per_framesize * frames_in_superframe;
+
+  /* the index is also prefixed with the marker byte, otherwise the last byte
+   * of a regular frame just happens to look like a marker */
+  if (size <= index_size || data[size - index_size] != marker)
+    return GST_VP9_PARSER_OK;
+
+  GST_DEBUG ("Got VP9 superframe with %u frames, size %" G_GSIZE_FORMAT,
+      frames_in_superframe, size);
+
+  index = &data[size - index_size + 1];
+  for (i = 0; i < frames_in_superframe; i++) {
+    guint32 frame_size = 0;
+
+    for (j = 0; j < bytes_per_framesize; j++)
+      frame_size |= (*index++) << (j * 8);
+
+    if (frame_size == 0) {
+      GST_ERROR ("Invalid frame size 0 in superframe index");
+      return GST_VP9_PARSER_BROKEN_DATA;
+    }
+
+    superframe_info->frame_sizes[i] = frame_size;
+    total_size += frame_size;
+  }
+
+  if (total_size > size - index_size) {
+    GST_ERROR ("Superframe index describes %" G_GSIZE_FORMAT " bytes of "
+        "frames but only %" G_GSIZE_FORMAT " are available", total_size,
+        size - index_size);
+    return GST_VP9_PARSER_BROKEN_DATA;
+  }
+
+  superframe_info->bytes_per_framesize = bytes_per_framesize;
+  superframe_info->frames_in_superframe = frames_in_superframe;
+  superframe_info->superframe_index_size = index_size;
+
+  return GST_VP9_PARSER_OK;
+}
+
+/**
+ * gst_vp9_superframe_info_get_frame:
+ * @superframe_info: The #GstVp9SuperframeInfo of @buffer
+ * @buffer: The #GstBuffer holding the superframe
+ * @index: The index of the frame to get, in decoding order
+ *
+ * Creates a sub-buffer of @buffer holding frame @index of the superframe.
+ * The returned buffer references the memory of @buffer instead of copying
+ * it, and carries over its flags, timestamps and metadata.
+ *
+ * Returns: (transfer full) (nullable): a new #GstBuffer, or %NULL if
+ * @index is not a frame of @superframe_info.
+ *
+ * Since: 1.18
+ */
+GstBuffer *
+gst_vp9_superframe_info_get_frame (const GstVp9SuperframeInfo *
+    superframe_info, GstBuffer * buffer, guint index)
+{
+  gsize offset = 0;
+  guint i;
+
+  g_return_val_if_fail (superframe_info != NULL, NULL);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+
+  if (index >= superframe_info->frames_in_superframe)
+    return NULL;
+
+  for (i = 0; i < index; i++)
+    offset += superframe_info->frame_sizes[i];
+
+  if (offset + superframe_info->frame_sizes[index] >
+      gst_buffer_get_size (buffer))
+    return NULL;
+
+  return gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL, offset,
+      superframe_info->frame_sizes[index]);
+}
@@ -61,6 +61,8 @@ G_BEGIN_DECLS
 
 #define GST_VP9_PREDICTION_PROBS   3
 
+#define GST_VP9_MAX_FRAMES_IN_SUPERFRAME 8
+
 typedef struct _GstVp9Parser               GstVp9Parser;
 typedef struct _GstVp9FrameHdr             GstVp9FrameHdr;
 typedef struct _GstVp9LoopFilter           GstVp9LoopFilter;
@@ -68,6 +70,7 @@ typedef struct _GstVp9QuantIndices         GstVp9QuantIndices;
 typedef struct _GstVp9Segmentation         GstVp9Segmentation;
 typedef struct _GstVp9SegmentationInfo     GstVp9SegmentationInfo;
 typedef struct _GstVp9SegmentationInfoData GstVp9SegmentationInfoData;
+typedef struct _GstVp9SuperframeInfo       GstVp9SuperframeInfo;
 
 /**
  * GstVp9ParseResult:
@@ -451,6 +454,27 @@ struct _GstVp9Segmentation
   guint8 reference_skip;
 };
 
+/**
+ * GstVp9SuperframeInfo:
+ * @bytes_per_framesize: the number of bytes used to code each frame size
+ * @frames_in_superframe: the number of frames in the superframe, 1 if the
+ *   data is a single frame
+ * @frame_sizes: the size in bytes of each frame, in decoding order
+ * @superframe_index_size: the size of the superframe index trailing the
+ *   frames, 0 if the data is a single frame
+ *
+ * Layout of a VP9 superframe, see Annex B of the VP9 specification.
+ *
+ * Since: 1.18
+ */
+struct _GstVp9SuperframeInfo
+{
+  guint32 bytes_per_framesize;
+  guint32 frames_in_superframe;
+  guint32 frame_sizes[GST_VP9_MAX_FRAMES_IN_SUPERFRAME];
+  guint32 superframe_index_size;
+};
+
 /**
  * GstVp9Parser:
  * @priv: GstVp9ParserPrivate struct to keep track of state variables
@@ -489,6 +513,12 @@ GstVp9Parser *     gst_vp9_parser_new (void);
 GST_CODEC_PARSERS_API
 GstVp9ParserResult gst_vp9_parser_parse_frame_header (GstVp9Parser* parser, GstVp9FrameHdr * frame_hdr, const guint8 * data, gsize size);
 
+GST_CODEC_PARSERS_API
+GstVp9ParserResult gst_vp9_parser_parse_superframe_info (GstVp9Parser * parser, GstVp9SuperframeInfo * superframe_info, const guint8 * data, gsize size);
+
+GST_CODEC_PARSERS_API
+GstBuffer *        gst_vp9_superframe_info_get_frame (const GstVp9SuperframeInfo * superframe_info, GstBuffer * buffer, guint index);
+
 GST_CODEC_PARSERS_API
 void               gst_vp9_parser_free (GstVp9Parser * parser);
 
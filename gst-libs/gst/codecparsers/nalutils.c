@@ -36,6 +36,7 @@
 #endif
 
 #include "nalutils.h"
+#include "parserutils.h"
 
 /* Compute Ceil(Log2(v)) */
 /* Derived from branchless code for integer log2(v) from:
@@ -63,6 +64,97 @@ ceil_log2 (guint32 v)
 
 /****** Nal parser ******/
 
+/* Number of bytes looked at for emulation prevention bytes at once. Slice
+ * headers are parsed from NAL units of any size, so never scan too far
+ * ahead of what is actually going to be read */
+#define NAL_READER_EPB_SCAN_SIZE 64
+
+/* Bits the cache is refilled up to. Keeping one bit free means all the
+ * shifts below stay well defined */
+#define NAL_READER_CACHE_BITS 63
+
+#if defined(__GNUC__)
+#define nal_reader_clz64(x) __builtin_clzll (x)
+#else
+static inline guint
+nal_reader_clz64 (guint64 x)
+{
+  guint n = 0;
+
+  while (!(x & G_GUINT64_CONSTANT (0x8000000000000000))) {
+    x <<= 1;
+    n++;
+  }
+
+  return n;
+}
+#endif
+
+static inline gboolean
+nal_reader_is_epb (const guint8 * data, guint pos)
+{
+  return pos >= 2 && data[pos] == 0x03 && data[pos - 1] == 0x00 &&
+      data[pos - 2] == 0x00;
+}
+
+/* Returns the position of the first emulation_prevention_three_byte at or
+ * after @from, or the end of the scanned window if there is none */
+static guint
+nal_reader_find_epb (const guint8 * data, guint size, guint from)
+{
+  const guint8 *p;
+  guint end, i;
+
+  if (size - from > NAL_READER_EPB_SCAN_SIZE)
+    end = from + NAL_READER_EPB_SCAN_SIZE;
+  else
+    end = size;
+
+  i = MAX (from, 2);
+  while (i < end) {
+    p = memchr (data + i, 0x03, end - i);
+    if (p == NULL)
+      break;
+
+    i = p - data;
+    if (data[i - 1] == 0x00 && data[i - 2] == 0x00)
+      return i;
+    i++;
+  }
+
+  return end;
+}
+
+/* Loads as many whole bytes into the cache as fit and are known not to be
+ * emulation prevention bytes */
+static inline void
+nal_reader_fill (NalReader * nr)
+{
+  guint n;
+
+  if (nr->byte >= nr->next_epb)
+    nr->next_epb = nal_reader_find_epb (nr->data, nr->size, nr->byte);
+
+  n = MIN ((NAL_READER_CACHE_BITS - nr->bits_in_cache) / 8,
+      nr->next_epb - nr->byte);
+  if (n == 0)
+    return;
+
+  if (G_LIKELY (nr->size - nr->byte >= 8)) {
+    guint64 word = GST_READ_UINT64_BE (nr->data + nr->byte);
+
+    nr->cache = (nr->cache << (n * 8)) | (word >> (64 - n * 8));
+  } else {
+    guint i;
+
+    for (i = 0; i < n; i++)
+      nr->cache = (nr->cache << 8) | nr->data[nr->byte + i];
+  }
+
+  nr->byte += n;
+  nr->bits_in_cache += n * 8;
+}
+
 void
 nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 {
@@ -72,38 +164,45 @@ nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 
   nr->byte = 0;
   nr->bits_in_cache = 0;
-  /* fill with something other than 0 to detect emulation prevention bytes */
-  nr->first_byte = 0xff;
-  nr->epb_cache = 0xff;
-  nr->cache = 0xff;
+  nr->next_epb = 0;
+  nr->cache = 0;
 }
 
+/* Makes sure at least @nbits (at most 32) are in the cache. The cache is
+ * refilled a word at a time up to the next emulation prevention byte, which
+ * are only skipped when the bits following them are actually needed so that
+ * the position and the number of emulation prevention bytes stay exact */
 gboolean
 nal_reader_read (NalReader * nr, guint nbits)
 {
+  if (G_LIKELY (nr->bits_in_cache >= nbits))
+    return TRUE;
+
   if (G_UNLIKELY (nr->byte * 8 + (nbits - nr->bits_in_cache) > nr->size * 8)) {
     GST_DEBUG ("Can not read %u bits, bits in cache %u, Byte * 8 %u, size in "
         "bits %u", nbits, nr->bits_in_cache, nr->byte * 8, nr->size * 8);
     return FALSE;
   }
 
+  nal_reader_fill (nr);
+
   while (nr->bits_in_cache < nbits) {
     guint8 byte;
 
-  next_byte:
     if (G_UNLIKELY (nr->byte >= nr->size))
       return FALSE;
 
-    byte = nr->data[nr->byte++];
-    nr->epb_cache = (nr->epb_cache << 8) | byte;
+    byte = nr->data[nr->byte];
 
     /* check if the byte is a emulation_prevention_three_byte */
-    if ((nr->epb_cache & 0xffffff) == 0x3) {
+    if (nal_reader_is_epb (nr->data, nr->byte)) {
       nr->n_epb++;
-      goto next_byte;
+      nr->byte++;
+      continue;
     }
-    nr->cache = (nr->cache << 8) | nr->first_byte;
-    nr->first_byte = byte;
+
+    nr->cache = (nr->cache << 8) | byte;
+    nr->byte++;
     nr->bits_in_cache += 8;
   }
 
@@ -115,12 +214,26 @@ nal_reader_read (NalReader * nr, guint nbits)
 gboolean
 nal_reader_skip (NalReader * nr, guint nbits)
 {
+  guint n;
+
   g_assert (nbits <= 8 * sizeof (nr->cache));
 
-  if (G_UNLIKELY (!nal_reader_read (nr, nbits)))
+  /* Check up front, so that a failed skip leaves the reader untouched */
+  if (G_UNLIKELY (nal_reader_get_remaining (nr) < nbits)) {
+    GST_DEBUG ("Can not skip %u bits, %u remaining", nbits,
+        nal_reader_get_remaining (nr));
     return FALSE;
+  }
 
-  nr->bits_in_cache -= nbits;
+  while (nbits > 0) {
+    n = MIN (nbits, 32);
+
+    if (G_UNLIKELY (!nal_reader_read (nr, n)))
+      return FALSE;
+
+    nr->bits_in_cache -= n;
+    nbits -= n;
+  }
 
   return TRUE;
 }
@@ -165,22 +278,17 @@ nal_reader_get_epb_count (const NalReader * nr)
 gboolean \
 nal_reader_get_bits_uint##bits (NalReader *nr, guint##bits *val, guint nbits) \
 { \
-  guint shift; \
-  \
   if (!nal_reader_read (nr, nbits)) \
     return FALSE; \
   \
   /* bring the required bits down and truncate */ \
-  shift = nr->bits_in_cache - nbits; \
-  *val = nr->first_byte >> shift; \
+  nr->bits_in_cache -= nbits; \
+  *val = nr->cache >> nr->bits_in_cache; \
   \
-  *val |= nr->cache << (8 - shift); \
   /* mask out required bits */ \
   if (nbits < bits) \
     *val &= ((guint##bits)1 << nbits) - 1; \
   \
-  nr->bits_in_cache = shift; \
-  \
   return TRUE; \
 } \
 
@@ -207,6 +315,26 @@ nal_reader_get_ue (NalReader * nr, guint32 * val)
   guint8 bit;
   guint32 value;
 
+  /* Fast path: the whole code is in the cache, count the leading zeros
+   * at once and read the suffix together with the marker bit */
+  if (nr->bits_in_cache < 32)
+    nal_reader_fill (nr);
+
+  if (G_LIKELY (nr->bits_in_cache > 0)) {
+    guint64 window = nr->cache << (64 - nr->bits_in_cache);
+
+    if (G_LIKELY (window != 0)) {
+      guint len = 2 * nal_reader_clz64 (window) + 1;
+
+      if (G_LIKELY (len <= nr->bits_in_cache)) {
+        nr->bits_in_cache -= len;
+        *val = ((nr->cache >> nr->bits_in_cache) &
+            ((G_GUINT64_CONSTANT (1) << len) - 1)) - 1;
+        return TRUE;
+      }
+    }
+  }
+
   if (G_UNLIKELY (!nal_reader_get_bits_uint8 (nr, &bit, 1)))
     return FALSE;
 
@@ -222,7 +350,7 @@ nal_reader_get_ue (NalReader * nr, guint32 * val)
   if (G_UNLIKELY (!nal_reader_get_bits_uint32 (nr, &value, i)))
     return FALSE;
 
-  *val = (1 << i) - 1 + value;
+  *val = (1U << i) - 1 + value;
 
   return TRUE;
 }
@@ -246,7 +374,7 @@ nal_reader_get_se (NalReader * nr, gint32 * val)
 gboolean
 nal_reader_is_byte_aligned (NalReader * nr)
 {
-  if (nr->bits_in_cache != 0)
+  if (nr->bits_in_cache % 8 != 0)
     return FALSE;
   return TRUE;
 }
@@ -292,15 +420,63 @@ nal_reader_has_more_data (NalReader * nr)
   return FALSE;
 }
 
+/**
+ * nal_fingerprint_init:
+ * @fp: the #NalFingerprint to initialise
+ * @data: the NAL bytes, including the NAL header
+ * @size: the size of @data
+ *
+ * Hashes @data (FNV-1a) and points @fp at it, without copying. The result
+ * is only meant to be used as a lookup key, see nal_fingerprint_store() to
+ * keep it around.
+ */
+void
+nal_fingerprint_init (NalFingerprint * fp, const guint8 * data, guint size)
+{
+  guint32 hash = 2166136261u;
+  guint i;
+
+  for (i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+
+  fp->hash = hash;
+  fp->size = size;
+  fp->data = (guint8 *) data;
+}
+
+gboolean
+nal_fingerprint_equal (const NalFingerprint * stored, const NalFingerprint * fp)
+{
+  if (!stored->data || stored->hash != fp->hash || stored->size != fp->size)
+    return FALSE;
+
+  return memcmp (stored->data, fp->data, fp->size) == 0;
+}
+
+void
+nal_fingerprint_store (NalFingerprint * stored, const NalFingerprint * fp)
+{
+  nal_fingerprint_clear (stored);
+
+  stored->hash = fp->hash;
+  stored->size = fp->size;
+  stored->data = g_memdup (fp->data, fp->size);
+}
+
+void
+nal_fingerprint_clear (NalFingerprint * fp)
+{
+  g_free (fp->data);
+  memset (fp, 0, sizeof (NalFingerprint));
+}
+
 /***********  end of nal parser ***************/
 
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  return scan_for_start_code (data, size);
 }
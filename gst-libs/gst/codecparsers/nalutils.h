@@ -49,9 +49,9 @@ typedef struct
   guint n_epb;                  /* Number of emulation prevention bytes */
   guint byte;                   /* Byte position */
   guint bits_in_cache;          /* bitpos in the cache of next bit */
-  guint8 first_byte;
-  guint32 epb_cache;            /* cache 3 bytes to check emulation prevention bytes */
-  guint64 cache;                /* cached bytes */
+  guint next_epb;               /* Byte position up to which no emulation
+                                 * prevention byte can be found */
+  guint64 cache;                /* cached bits, next bit is bit bits_in_cache-1 */
 } NalReader;
 
 G_GNUC_INTERNAL
@@ -182,3 +182,26 @@ gboolean nal_reader_get_se (NalReader * nr, gint32 * val);
 
 G_GNUC_INTERNAL
 gint scan_for_start_codes (const guint8 * data, guint size);
+
+/* Raw bytes of a parameter set NAL, used to recognise repeated identical
+ * parameter sets without parsing them again */
+typedef struct
+{
+  guint32 hash;
+  guint size;
+  guint8 *data;
+} NalFingerprint;
+
+G_GNUC_INTERNAL
+void nal_fingerprint_init (NalFingerprint * fp, const guint8 * data,
+    guint size);
+
+G_GNUC_INTERNAL
+gboolean nal_fingerprint_equal (const NalFingerprint * stored,
+    const NalFingerprint * fp);
+
+G_GNUC_INTERNAL
+void nal_fingerprint_store (NalFingerprint * stored, const NalFingerprint * fp);
+
+G_GNUC_INTERNAL
+void nal_fingerprint_clear (NalFingerprint * fp);
@@ -22,6 +22,18 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_START_CODE_SSE2 1
+#define HAVE_START_CODE_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_START_CODE_NEON 1
+#include <arm_neon.h>
+#endif
+
 #include "parserutils.h"
 
 gboolean
@@ -58,3 +70,189 @@ failed:
     return FALSE;
   }
 }
+
+/* A start code 00 00 01 can only be reported if at least one byte follows
+ * it, like gst_byte_reader_masked_scan_uint32() with a 0xffffff00 mask */
+static gint
+scan_start_code_c (const guint8 * data, guint size)
+{
+  const guint8 *p = data;
+  const guint8 *end;
+
+  if (size < 4)
+    return -1;
+
+  end = data + size - 3;
+
+  while (p < end) {
+    /* all start codes begin with a zero byte */
+    p = memchr (p, 0, end - p);
+    if (p == NULL)
+      return -1;
+
+    if (p[1] != 0)
+      p += 2;
+    else if (p[2] == 1)
+      return p - data;
+    else if (p[2] != 0)
+      p += 3;
+    else
+      p++;
+  }
+
+  return -1;
+}
+
+static gint
+scan_start_code_tail (const guint8 * data, guint size, guint i)
+{
+  gint ret = scan_start_code_c (data + i, size - i);
+
+  return ret < 0 ? -1 : (gint) (i + ret);
+}
+
+#ifdef HAVE_START_CODE_SSE2
+__attribute__ ((target ("sse2")))
+static gint
+scan_start_code_sse2 (const guint8 * data, guint size)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i one = _mm_set1_epi8 (1);
+  guint i = 0;
+
+  /* the last 3 loaded bytes and the byte following a start code must be
+   * available */
+  while (i + 16 + 3 <= size) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) (data + i));
+    __m128i b, c, m;
+    gint mask;
+
+    a = _mm_cmpeq_epi8 (a, zero);
+    if (!_mm_movemask_epi8 (a)) {
+      i += 16;
+      continue;
+    }
+
+    b = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+    c = _mm_loadu_si128 ((const __m128i *) (data + i + 2));
+    m = _mm_and_si128 (_mm_and_si128 (a, _mm_cmpeq_epi8 (b, zero)),
+        _mm_cmpeq_epi8 (c, one));
+    mask = _mm_movemask_epi8 (m);
+    if (mask)
+      return i + __builtin_ctz (mask);
+
+    i += 16;
+  }
+
+  return scan_start_code_tail (data, size, i);
+}
+#endif
+
+#ifdef HAVE_START_CODE_AVX2
+__attribute__ ((target ("avx2")))
+static gint
+scan_start_code_avx2 (const guint8 * data, guint size)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i one = _mm256_set1_epi8 (1);
+  guint i = 0;
+
+  while (i + 32 + 3 <= size) {
+    __m256i a = _mm256_loadu_si256 ((const __m256i *) (data + i));
+    __m256i b, c, m;
+    guint mask;
+
+    a = _mm256_cmpeq_epi8 (a, zero);
+    if (!_mm256_movemask_epi8 (a)) {
+      i += 32;
+      continue;
+    }
+
+    b = _mm256_loadu_si256 ((const __m256i *) (data + i + 1));
+    c = _mm256_loadu_si256 ((const __m256i *) (data + i + 2));
+    m = _mm256_and_si256 (_mm256_and_si256 (a, _mm256_cmpeq_epi8 (b, zero)),
+        _mm256_cmpeq_epi8 (c, one));
+    mask = (guint) _mm256_movemask_epi8 (m);
+    if (mask)
+      return i + __builtin_ctz (mask);
+
+    i += 32;
+  }
+
+  return scan_start_code_tail (data, size, i);
+}
+#endif
+
+#ifdef HAVE_START_CODE_NEON
+static gint
+scan_start_code_neon (const guint8 * data, guint size)
+{
+  const uint8x16_t one = vdupq_n_u8 (1);
+  guint i = 0;
+
+  while (i + 16 + 3 <= size) {
+    uint8x16_t a = vceqzq_u8 (vld1q_u8 (data + i));
+    uint8x16_t m;
+
+    if (!vmaxvq_u8 (a)) {
+      i += 16;
+      continue;
+    }
+
+    m = vandq_u8 (vandq_u8 (a, vceqzq_u8 (vld1q_u8 (data + i + 1))),
+        vceqq_u8 (vld1q_u8 (data + i + 2), one));
+    if (vmaxvq_u8 (m)) {
+      guint k;
+
+      for (k = 0; k < 16; k++) {
+        if (vgetq_lane_u8 (m, 0))
+          return i + k;
+        m = vextq_u8 (m, m, 1);
+      }
+    }
+
+    i += 16;
+  }
+
+  return scan_start_code_tail (data, size, i);
+}
+#endif
+
+typedef gint (*ScanStartCodeFunc) (const guint8 * data, guint size);
+static ScanStartCodeFunc scan_start_code_func;
+
+static void
+init_scan_start_code (void)
+{
+  static gsize done = 0;
+
+  if (!g_once_init_enter (&done))
+    return;
+
+  scan_start_code_func = scan_start_code_c;
+#ifdef HAVE_START_CODE_SSE2
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse2"))
+    scan_start_code_func = scan_start_code_sse2;
+#endif
+#ifdef HAVE_START_CODE_AVX2
+  if (__builtin_cpu_supports ("avx2"))
+    scan_start_code_func = scan_start_code_avx2;
+#endif
+#ifdef HAVE_START_CODE_NEON
+  scan_start_code_func = scan_start_code_neon;
+#endif
+
+  g_once_init_leave (&done, 1);
+}
+
+/* Finds the first 00 00 01 start code prefix in @data followed by at least
+ * one byte, using the vector instructions of the CPU when available.
+ * Returns its offset in @data, or -1 if there is none */
+gint
+scan_for_start_code (const guint8 * data, guint size)
+{
+  init_scan_start_code ();
+
+  return scan_start_code_func (data, size);
+}
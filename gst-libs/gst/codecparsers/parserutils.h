@@ -105,4 +105,7 @@ G_GNUC_INTERNAL gboolean
 decode_vlc (GstBitReader * br, guint * res, const VLCTable * table,
     guint length);
 
+G_GNUC_INTERNAL gint
+scan_for_start_code (const guint8 * data, guint size);
+
 #endif /* __PARSER_UTILS__ */
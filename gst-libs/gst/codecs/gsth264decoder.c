@@ -53,8 +53,8 @@
 
 #include "gsth264decoder.h"
 
-GST_DEBUG_CATEGORY_EXTERN (gst_d3d11_h264_dec_debug);
-#define GST_CAT_DEFAULT gst_d3d11_h264_dec_debug
+GST_DEBUG_CATEGORY (gst_h264_decoder_debug);
+#define GST_CAT_DEFAULT gst_h264_decoder_debug
 
 typedef enum
 {
@@ -117,13 +117,31 @@ struct _GstH264DecoderPrivate
 
   GstH264PictureField prev_ref_field;
 
-  /* PicOrderCount of the previously outputted frame */
+  /* PicOrderCount of the previously outputted frame, G_MININT32 if unknown
+   * since the last POC reset */
   gint last_output_poc;
+  /* Smallest PicOrderCount difference seen between consecutive output
+   * pictures since the last POC reset, 0 if unknown */
+  gint output_poc_delta;
+
+  /* properties */
+  gboolean low_latency;
+};
+
+#define DEFAULT_LOW_LATENCY FALSE
+
+enum
+{
+  PROP_0,
+  PROP_LOW_LATENCY,
 };
 
 #define parent_class gst_h264_decoder_parent_class
-G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GstH264Decoder, gst_h264_decoder,
-    GST_TYPE_VIDEO_DECODER);
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstH264Decoder, gst_h264_decoder,
+    GST_TYPE_VIDEO_DECODER,
+    G_ADD_PRIVATE (GstH264Decoder);
+    GST_DEBUG_CATEGORY_INIT (gst_h264_decoder_debug, "h264decoder", 0,
+        "H264 Video Decoder"));
 
 static gboolean gst_h264_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_h264_decoder_stop (GstVideoDecoder * decoder);
@@ -151,11 +169,69 @@ static gboolean gst_h264_decoder_finish_current_picture (GstH264Decoder * self);
 static gboolean gst_h264_decoder_finish_picture (GstH264Decoder * self,
     GstH264Picture * picture);
 
+static void
+gst_h264_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstH264Decoder *self = GST_H264_DECODER (object);
+  GstH264DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      GST_OBJECT_LOCK (self);
+      priv->low_latency = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_h264_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstH264Decoder *self = GST_H264_DECODER (object);
+  GstH264DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, priv->low_latency);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_h264_decoder_class_init (GstH264DecoderClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
 
+  gobject_class->set_property = gst_h264_decoder_set_property;
+  gobject_class->get_property = gst_h264_decoder_get_property;
+
+  /**
+   * GstH264Decoder:low-latency:
+   *
+   * Output pictures as soon as they are known to be next in display order
+   * instead of waiting for the reorder depth to be reached. A picture is
+   * known to be next when its PicOrderCount follows the one of the last
+   * output picture by the smallest difference seen between consecutive
+   * output pictures so far.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low Latency",
+          "Output pictures as soon as display order allows it",
+          DEFAULT_LOW_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_h264_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_h264_decoder_stop);
   decoder_class->parse = GST_DEBUG_FUNCPTR (gst_h264_decoder_parse);
@@ -171,6 +247,8 @@ gst_h264_decoder_init (GstH264Decoder * self)
   gst_video_decoder_set_packetized (GST_VIDEO_DECODER (self), FALSE);
 
   self->priv = gst_h264_decoder_get_instance_private (self);
+  self->priv->low_latency = DEFAULT_LOW_LATENCY;
+  self->priv->last_output_poc = G_MININT32;
 }
 
 static gboolean
@@ -181,6 +259,8 @@ gst_h264_decoder_start (GstVideoDecoder * decoder)
 
   priv->parser = gst_h264_nal_parser_new ();
   priv->dpb = gst_h264_dpb_new ();
+  priv->last_output_poc = G_MININT32;
+  priv->output_poc_delta = 0;
 
   return TRUE;
 }
@@ -217,7 +297,8 @@ gst_h264_decoder_clear_dpb (GstH264Decoder * self)
   GstH264DecoderPrivate *priv = self->priv;
 
   gst_h264_dpb_clear (priv->dpb);
-  priv->last_output_poc = -1;
+  priv->last_output_poc = G_MININT32;
+  priv->output_poc_delta = 0;
 }
 
 static gboolean
@@ -257,13 +338,12 @@ static gboolean
 gst_h264_decoder_parse_sps (GstH264Decoder * self, GstH264NalUnit * nalu)
 {
   GstH264DecoderPrivate *priv = self->priv;
-  GstH264SPS sps;
+  GstH264SPS *sps;
   GstH264ParserResult pres;
-  gboolean ret = TRUE;
 
   gst_h264_decoder_finish_current_picture (self);
 
-  pres = gst_h264_parser_parse_sps (priv->parser, nalu, &sps);
+  pres = gst_h264_parser_update_sps (priv->parser, nalu, &sps, NULL);
   if (pres != GST_H264_PARSER_OK) {
     GST_WARNING_OBJECT (self, "Failed to parse SPS, result %d", pres);
     return FALSE;
@@ -271,31 +351,26 @@ gst_h264_decoder_parse_sps (GstH264Decoder * self, GstH264NalUnit * nalu)
 
   GST_LOG_OBJECT (self, "SPS parsed");
 
-  if (!gst_h264_decoder_process_sps (self, &sps))
-    ret = FALSE;
-
-  gst_h264_sps_clear (&sps);
-
-  return ret;
+  /* Processed even if unchanged, the active SPS might have another id */
+  return gst_h264_decoder_process_sps (self, sps);
 }
 
 static gboolean
 gst_h264_decoder_parse_pps (GstH264Decoder * self, GstH264NalUnit * nalu)
 {
   GstH264DecoderPrivate *priv = self->priv;
-  GstH264PPS pps;
+  GstH264PPS *pps;
   GstH264ParserResult pres;
 
   gst_h264_decoder_finish_current_picture (self);
 
-  pres = gst_h264_parser_parse_pps (priv->parser, nalu, &pps);
+  pres = gst_h264_parser_update_pps (priv->parser, nalu, &pps, NULL);
   if (pres != GST_H264_PARSER_OK) {
     GST_WARNING_OBJECT (self, "Failed to parse PPS, result %d", pres);
     return FALSE;
   }
 
   GST_LOG_OBJECT (self, "PPS parsed");
-  gst_h264_pps_clear (&pps);
 
   return TRUE;
 }
@@ -423,8 +498,6 @@ gst_h264_decoder_is_new_au (GstH264Decoder * self, GstH264Slice * slice)
 static gboolean
 gst_h264_decoder_preprocess_slice (GstH264Decoder * self, GstH264Slice * slice)
 {
-  GstH264DecoderPrivate *priv = self->priv;
-
   if (gst_h264_decoder_is_new_au (self, slice)) {
     /* finish previous frame if any */
     if (!gst_h264_decoder_finish_current_picture (self))
@@ -443,7 +516,7 @@ gst_h264_decoder_preprocess_slice (GstH264Decoder * self, GstH264Slice * slice)
       if (!slice->header.dec_ref_pic_marking.no_output_of_prior_pics_flag)
         gst_h264_decoder_flush (GST_VIDEO_DECODER (self));
 
-      gst_h264_dpb_clear (priv->dpb);
+      gst_h264_decoder_clear_dpb (self);
     }
   }
 
@@ -1182,6 +1255,12 @@ gst_h264_decoder_do_output_picture (GstH264Decoder * self,
     GST_WARNING_OBJECT (self,
         "Outputting out of order %d -> %d, likely a broken stream",
         priv->last_output_poc, picture->pic_order_cnt);
+  } else if (priv->last_output_poc != G_MININT32 &&
+      picture->pic_order_cnt > priv->last_output_poc) {
+    gint delta = picture->pic_order_cnt - priv->last_output_poc;
+
+    if (priv->output_poc_delta == 0 || delta < priv->output_poc_delta)
+      priv->output_poc_delta = delta;
   }
 
   priv->last_output_poc = picture->pic_order_cnt;
@@ -1464,6 +1543,20 @@ gst_h264_decoder_reference_picture_marking (GstH264Decoder * self,
   return gst_h264_decoder_sliding_window_picture_marking (self);
 }
 
+static gboolean
+gst_h264_decoder_is_next_output (GstH264Decoder * self,
+    GstH264Picture * picture)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+
+  /* Frame PicOrderCounts usually step by 2, but nothing mandates it. Rely
+   * on the step seen in the stream: a picture coming in between would have
+   * to be closer to its neighbours than any seen so far */
+  return priv->last_output_poc != G_MININT32 &&
+      priv->output_poc_delta > 0 &&
+      picture->pic_order_cnt == priv->last_output_poc + priv->output_poc_delta;
+}
+
 static gboolean
 gst_h264_decoder_finish_picture (GstH264Decoder * self,
     GstH264Picture * picture)
@@ -1471,6 +1564,7 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
   GstH264DecoderPrivate *priv = self->priv;
   GList *not_outputted = NULL;
   guint num_remaining;
+  gboolean low_latency;
   GList *iter;
 #ifndef GST_DISABLE_GST_DEBUG
   gint i;
@@ -1492,6 +1586,13 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
   priv->prev_has_memmgmnt5 = picture->mem_mgmt_5;
   priv->prev_frame_num_offset = picture->frame_num_offset;
 
+  /* POCs restart after memory_management_control_operation 5, and may
+   * step differently from there */
+  if (picture->mem_mgmt_5) {
+    priv->last_output_poc = G_MININT32;
+    priv->output_poc_delta = 0;
+  }
+
   /* Remove unused (for reference or later output) pictures from DPB, marking
    * them as such */
   gst_h264_dpb_delete_unused (priv->dpb);
@@ -1548,7 +1649,15 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
   iter = not_outputted;
   num_remaining = g_list_length (not_outputted);
 
+  GST_OBJECT_LOCK (self);
+  low_latency = priv->low_latency;
+  GST_OBJECT_UNLOCK (self);
+
   while (num_remaining > priv->max_num_reorder_frames ||
+      /* In low-latency mode, don't hold back a picture which directly
+       * follows the last output one, no picture can come in between */
+      (low_latency && num_remaining &&
+          gst_h264_decoder_is_next_output (self, iter->data)) ||
       /* If the condition below is used, this is an invalid stream. We should
        * not be forced to output beyond max_num_reorder_frames in order to
        * make room in DPB to store the current picture (if we need to do so).
@@ -1560,7 +1669,8 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
           && num_remaining)) {
     GstH264Picture *to_output = (GstH264Picture *) iter->data;
 
-    if (num_remaining <= priv->max_num_reorder_frames) {
+    if (num_remaining <= priv->max_num_reorder_frames &&
+        !(low_latency && gst_h264_decoder_is_next_output (self, to_output))) {
       GST_WARNING_OBJECT (self,
           "Invalid stream, max_num_reorder_frames not preserved");
     }
@@ -1604,7 +1714,7 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
 }
 
 static gboolean
-gst_h264_decoder_update_max_num_reorder_frames (GstH264Decoder * self,
+gst_h264_decoder_derive_max_num_reorder_frames (GstH264Decoder * self,
     GstH264SPS * sps)
 {
   GstH264DecoderPrivate *priv = self->priv;
@@ -1626,6 +1736,13 @@ gst_h264_decoder_update_max_num_reorder_frames (GstH264Decoder * self,
     return TRUE;
   }
 
+  /* With pic_order_cnt_type 2, output order is the same as decoding order
+   * (8.2.1.3) */
+  if (sps->pic_order_cnt_type == 2) {
+    priv->max_num_reorder_frames = 0;
+    return TRUE;
+  }
+
   /* max_num_reorder_frames not present, infer from profile/constraints
    * (see VUI semantics in spec) */
   if (sps->constraint_set3_flag) {
@@ -1650,6 +1767,42 @@ gst_h264_decoder_update_max_num_reorder_frames (GstH264Decoder * self,
   return TRUE;
 }
 
+static void
+gst_h264_decoder_update_latency (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  gint fps_n = 25;
+  gint fps_d = 1;
+  GstClockTime latency;
+
+  if (self->input_state && GST_VIDEO_INFO_FPS_N (&self->input_state->info) > 0
+      && GST_VIDEO_INFO_FPS_D (&self->input_state->info) > 0) {
+    fps_n = GST_VIDEO_INFO_FPS_N (&self->input_state->info);
+    fps_d = GST_VIDEO_INFO_FPS_D (&self->input_state->info);
+  }
+
+  /* Worst case, pictures are held back until the reorder depth is reached */
+  latency = gst_util_uint64_scale_int (priv->max_num_reorder_frames *
+      GST_SECOND, fps_d, fps_n);
+
+  GST_DEBUG_OBJECT (self, "Reorder depth %" G_GSIZE_FORMAT ", latency %"
+      GST_TIME_FORMAT, priv->max_num_reorder_frames, GST_TIME_ARGS (latency));
+
+  gst_video_decoder_set_latency (GST_VIDEO_DECODER (self), latency, latency);
+}
+
+static gboolean
+gst_h264_decoder_update_max_num_reorder_frames (GstH264Decoder * self,
+    GstH264SPS * sps)
+{
+  gboolean ret;
+
+  ret = gst_h264_decoder_derive_max_num_reorder_frames (self, sps);
+  gst_h264_decoder_update_latency (self);
+
+  return ret;
+}
+
 typedef enum
 {
   GST_H264_LEVEL_L1 = 10,
@@ -1672,11 +1825,11 @@ typedef enum
   GST_H264_LEVEL_L6 = 60,
   GST_H264_LEVEL_L6_1 = 61,
   GST_H264_LEVEL_L6_2 = 62,
-} GstD3D11H264Level;
+} GstH264DecoderLevel;
 
 typedef struct
 {
-  GstD3D11H264Level level;
+  GstH264DecoderLevel level;
 
   guint32 max_mbps;
   guint32 max_fs;
@@ -1708,7 +1861,7 @@ static const LevelLimits level_limits_map[] = {
 };
 
 static gint
-h264_level_to_max_dpb_mbs (GstD3D11H264Level level)
+h264_level_to_max_dpb_mbs (GstH264DecoderLevel level)
 {
   gint i;
   for (i = 0; i < G_N_ELEMENTS (level_limits_map); i++) {
@@ -1746,7 +1899,7 @@ gst_h264_decoder_process_sps (GstH264Decoder * self, GstH264SPS * sps)
     level = 9;
   }
 
-  max_dpb_mbs = h264_level_to_max_dpb_mbs ((GstD3D11H264Level) level);
+  max_dpb_mbs = h264_level_to_max_dpb_mbs ((GstH264DecoderLevel) level);
   if (!max_dpb_mbs)
     return FALSE;
 
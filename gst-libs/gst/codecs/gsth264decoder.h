@@ -20,10 +20,10 @@
 #ifndef __GST_H264_DECODER_H__
 #define __GST_H264_DECODER_H__
 
-#include <gst/gst.h>
+#include <gst/codecs/codecs-prelude.h>
 #include <gst/video/video.h>
 #include <gst/codecparsers/gsth264parser.h>
-#include "gsth264picture.h"
+#include <gst/codecs/gsth264picture.h>
 
 G_BEGIN_DECLS
 
@@ -105,6 +105,7 @@ struct _GstH264DecoderClass
   gpointer padding[GST_PADDING_LARGE];
 };
 
+GST_CODECS_API
 GType gst_h264_decoder_get_type (void);
 
 G_END_DECLS
@@ -25,8 +25,8 @@
 
 #include "gsth265decoder.h"
 
-GST_DEBUG_CATEGORY_EXTERN (gst_d3d11_h265_dec_debug);
-#define GST_CAT_DEFAULT gst_d3d11_h265_dec_debug
+GST_DEBUG_CATEGORY (gst_h265_decoder_debug);
+#define GST_CAT_DEFAULT gst_h265_decoder_debug
 
 typedef enum
 {
@@ -87,17 +87,35 @@ struct _GstH265DecoderPrivate
   gint32 PocLtCurr[16];
   gint32 PocLtFoll[16];
 
-  /* PicOrderCount of the previously outputted frame */
+  /* PicOrderCount of the previously outputted frame, G_MININT32 if unknown
+   * since the last POC reset */
   gint last_output_poc;
+  /* Smallest PicOrderCount difference seen between consecutive output
+   * pictures since the last POC reset, 0 if unknown */
+  gint output_poc_delta;
 
   gboolean associated_irap_NoRaslOutputFlag;
   gboolean new_bitstream;
   gboolean prev_nal_is_eos;
+
+  /* properties */
+  gboolean low_latency;
+};
+
+#define DEFAULT_LOW_LATENCY FALSE
+
+enum
+{
+  PROP_0,
+  PROP_LOW_LATENCY,
 };
 
 #define parent_class gst_h265_decoder_parent_class
-G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GstH265Decoder, gst_h265_decoder,
-    GST_TYPE_VIDEO_DECODER);
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstH265Decoder, gst_h265_decoder,
+    GST_TYPE_VIDEO_DECODER,
+    G_ADD_PRIVATE (GstH265Decoder);
+    GST_DEBUG_CATEGORY_INIT (gst_h265_decoder_debug, "h265decoder", 0,
+        "H265 Video Decoder"));
 
 static gboolean gst_h265_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_h265_decoder_stop (GstVideoDecoder * decoder);
@@ -115,11 +133,69 @@ static gboolean
 gst_h265_decoder_output_all_remaining_pics (GstH265Decoder * self);
 static gboolean gst_h265_decoder_start_current_picture (GstH265Decoder * self);
 
+static void
+gst_h265_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstH265Decoder *self = GST_H265_DECODER (object);
+  GstH265DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      GST_OBJECT_LOCK (self);
+      priv->low_latency = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_h265_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstH265Decoder *self = GST_H265_DECODER (object);
+  GstH265DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, priv->low_latency);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_h265_decoder_class_init (GstH265DecoderClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
 
+  gobject_class->set_property = gst_h265_decoder_set_property;
+  gobject_class->get_property = gst_h265_decoder_get_property;
+
+  /**
+   * GstH265Decoder:low-latency:
+   *
+   * Output pictures as soon as they are known to be next in display order
+   * instead of waiting for sps_max_num_reorder_pics to be reached. A picture
+   * is known to be next when its PicOrderCount follows the one of the last
+   * output picture by the smallest difference seen between consecutive
+   * output pictures so far.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low Latency",
+          "Output pictures as soon as display order allows it",
+          DEFAULT_LOW_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_h265_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_h265_decoder_stop);
   decoder_class->parse = GST_DEBUG_FUNCPTR (gst_h265_decoder_parse);
@@ -135,6 +211,8 @@ gst_h265_decoder_init (GstH265Decoder * self)
   gst_video_decoder_set_packetized (GST_VIDEO_DECODER (self), FALSE);
 
   self->priv = gst_h265_decoder_get_instance_private (self);
+  self->priv->low_latency = DEFAULT_LOW_LATENCY;
+  self->priv->last_output_poc = G_MININT32;
 }
 
 static gboolean
@@ -147,6 +225,8 @@ gst_h265_decoder_start (GstVideoDecoder * decoder)
   priv->dpb = gst_h265_dpb_new ();
   priv->new_bitstream = TRUE;
   priv->prev_nal_is_eos = FALSE;
+  priv->last_output_poc = G_MININT32;
+  priv->output_poc_delta = 0;
 
   return TRUE;
 }
@@ -181,13 +261,12 @@ static gboolean
 gst_h265_decoder_parse_vps (GstH265Decoder * self, GstH265NalUnit * nalu)
 {
   GstH265DecoderPrivate *priv = self->priv;
-  GstH265VPS vps;
+  GstH265VPS *vps;
   GstH265ParserResult pres;
-  gboolean ret = TRUE;
 
   gst_h265_decoder_finish_current_picture (self);
 
-  pres = gst_h265_parser_parse_vps (priv->parser, nalu, &vps);
+  pres = gst_h265_parser_update_vps (priv->parser, nalu, &vps, NULL);
   if (pres != GST_H265_PARSER_OK) {
     GST_WARNING_OBJECT (self, "Failed to parse VPS, result %d", pres);
     return FALSE;
@@ -195,7 +274,31 @@ gst_h265_decoder_parse_vps (GstH265Decoder * self, GstH265NalUnit * nalu)
 
   GST_LOG_OBJECT (self, "VPS parsed");
 
-  return ret;
+  return TRUE;
+}
+
+static void
+gst_h265_decoder_update_latency (GstH265Decoder * self,
+    const GstH265SPS * sps)
+{
+  guint num_reorder = sps->max_num_reorder_pics[sps->max_sub_layers_minus1];
+  gint fps_n = 25;
+  gint fps_d = 1;
+  GstClockTime latency;
+
+  if (self->input_state && GST_VIDEO_INFO_FPS_N (&self->input_state->info) > 0
+      && GST_VIDEO_INFO_FPS_D (&self->input_state->info) > 0) {
+    fps_n = GST_VIDEO_INFO_FPS_N (&self->input_state->info);
+    fps_d = GST_VIDEO_INFO_FPS_D (&self->input_state->info);
+  }
+
+  /* Worst case, pictures are held back until the reorder depth is reached */
+  latency = gst_util_uint64_scale_int (num_reorder * GST_SECOND, fps_d, fps_n);
+
+  GST_DEBUG_OBJECT (self, "Reorder depth %u, latency %" GST_TIME_FORMAT,
+      num_reorder, GST_TIME_ARGS (latency));
+
+  gst_video_decoder_set_latency (GST_VIDEO_DECODER (self), latency, latency);
 }
 
 static gboolean
@@ -253,6 +356,8 @@ gst_h265_decoder_process_sps (GstH265Decoder * self, GstH265SPS * sps)
         sps->max_latency_increase_plus1[sps->max_sub_layers_minus1] - 1;
   }
 
+  gst_h265_decoder_update_latency (self, sps);
+
   /* Calculate WpOffsetHalfRangeC: (7-34)
    * FIXME: We don't have parser API for sps_range_extension, so
    * assuming high_precision_offsets_enabled_flag as zero */
@@ -269,13 +374,12 @@ static gboolean
 gst_h265_decoder_parse_sps (GstH265Decoder * self, GstH265NalUnit * nalu)
 {
   GstH265DecoderPrivate *priv = self->priv;
-  GstH265SPS sps;
+  GstH265SPS *sps;
   GstH265ParserResult pres;
-  gboolean ret = TRUE;
 
   gst_h265_decoder_finish_current_picture (self);
 
-  pres = gst_h265_parser_parse_sps (priv->parser, nalu, &sps, TRUE);
+  pres = gst_h265_parser_update_sps (priv->parser, nalu, &sps, TRUE, NULL);
   if (pres != GST_H265_PARSER_OK) {
     GST_WARNING_OBJECT (self, "Failed to parse SPS, result %d", pres);
     return FALSE;
@@ -283,22 +387,20 @@ gst_h265_decoder_parse_sps (GstH265Decoder * self, GstH265NalUnit * nalu)
 
   GST_LOG_OBJECT (self, "SPS parsed");
 
-  if (!gst_h265_decoder_process_sps (self, &sps))
-    ret = FALSE;
-
-  return ret;
+  /* Processed even if unchanged, the active SPS might have another id */
+  return gst_h265_decoder_process_sps (self, sps);
 }
 
 static gboolean
 gst_h265_decoder_parse_pps (GstH265Decoder * self, GstH265NalUnit * nalu)
 {
   GstH265DecoderPrivate *priv = self->priv;
-  GstH265PPS pps;
+  GstH265PPS *pps;
   GstH265ParserResult pres;
 
   gst_h265_decoder_finish_current_picture (self);
 
-  pres = gst_h265_parser_parse_pps (priv->parser, nalu, &pps);
+  pres = gst_h265_parser_update_pps (priv->parser, nalu, &pps, NULL);
   if (pres != GST_H265_PARSER_OK) {
     GST_WARNING_OBJECT (self, "Failed to parse PPS, result %d", pres);
     return FALSE;
@@ -1178,7 +1280,8 @@ gst_h265_decoder_clear_dpb (GstH265Decoder * self)
   GstH265DecoderPrivate *priv = self->priv;
 
   gst_h265_dpb_clear (priv->dpb);
-  priv->last_output_poc = -1;
+  priv->last_output_poc = G_MININT32;
+  priv->output_poc_delta = 0;
 }
 
 static void
@@ -1194,6 +1297,12 @@ gst_h265_decoder_do_output_picture (GstH265Decoder * self,
     GST_WARNING_OBJECT (self,
         "Outputting out of order %d -> %d, likely a broken stream",
         priv->last_output_poc, picture->pic_order_cnt);
+  } else if (priv->last_output_poc != G_MININT32 &&
+      picture->pic_order_cnt > priv->last_output_poc) {
+    gint delta = picture->pic_order_cnt - priv->last_output_poc;
+
+    if (priv->output_poc_delta == 0 || delta < priv->output_poc_delta)
+      priv->output_poc_delta = delta;
   }
 
   priv->last_output_poc = picture->pic_order_cnt;
@@ -1257,6 +1366,13 @@ gst_h265_decoder_dpb_init (GstH265Decoder * self, const GstH265Slice * slice,
     }
   }
 
+  /* A new coded video sequence starts, POCs restart and may step
+   * differently from there */
+  if (IS_IRAP (nalu->type) && picture->NoRaslOutputFlag) {
+    priv->last_output_poc = G_MININT32;
+    priv->output_poc_delta = 0;
+  }
+
   return TRUE;
 }
 
@@ -1301,6 +1417,20 @@ gst_h265_decoder_start_current_picture (GstH265Decoder * self)
   return TRUE;
 }
 
+static gboolean
+gst_h265_decoder_is_next_output (GstH265Decoder * self,
+    GstH265Picture * picture)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  /* PicOrderCounts can skip values, rely on the step seen in the stream: a
+   * picture coming in between would have to be closer to its neighbours
+   * than any seen so far */
+  return !picture->outputted && priv->last_output_poc != G_MININT32 &&
+      priv->output_poc_delta > 0 &&
+      picture->pic_order_cnt == priv->last_output_poc + priv->output_poc_delta;
+}
+
 static gboolean
 gst_h265_decoder_finish_picture (GstH265Decoder * self,
     GstH265Picture * picture)
@@ -1309,6 +1439,7 @@ gst_h265_decoder_finish_picture (GstH265Decoder * self,
   const GstH265SPS *sps = priv->active_sps;
   GList *not_outputted = NULL;
   guint num_remaining;
+  gboolean low_latency;
   GList *iter;
 #ifndef GST_DISABLE_GST_DEBUG
   gint i;
@@ -1389,7 +1520,15 @@ gst_h265_decoder_finish_picture (GstH265Decoder * self,
   iter = not_outputted;
   num_remaining = g_list_length (not_outputted);
 
+  GST_OBJECT_LOCK (self);
+  low_latency = priv->low_latency;
+  GST_OBJECT_UNLOCK (self);
+
   while (num_remaining > sps->max_num_reorder_pics[sps->max_sub_layers_minus1]
+      /* In low-latency mode, don't hold back a picture which directly
+       * follows the last output one, no picture can come in between */
+      || (low_latency && num_remaining &&
+          gst_h265_decoder_is_next_output (self, iter->data))
       || (num_remaining &&
           sps->max_latency_increase_plus1[sps->max_sub_layers_minus1] &&
           !GST_H265_PICTURE (iter->data)->outputted &&
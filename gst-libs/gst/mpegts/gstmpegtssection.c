@@ -35,6 +35,16 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_CRC32_PCLMUL 1
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && \
+    !defined(__ARM_BIG_ENDIAN)
+#define HAVE_CRC32_ARMV8 1
+#include <arm_acle.h>
+#endif
+
 #include "mpegts.h"
 #include "gstmpegts-private.h"
 
@@ -171,19 +181,142 @@ static const guint32 crc_tab[256] = {
   0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
+/* Slice-by-8 tables: crc_tab8[n][i] is the CRC of byte i followed by n zero
+ * bytes, crc_tab8[0] being crc_tab */
+static guint32 crc_tab8[8][256];
+
+typedef guint32 (*CalcCrc32Func) (guint32 crc, const guint8 * data,
+    guint datalen);
+static CalcCrc32Func calc_crc32_func;
+
 /* _calc_crc32 relicensed to LGPL from fluendo ts demuxer */
-guint32
-_calc_crc32 (const guint8 * data, guint datalen)
+static guint32
+calc_crc32_slice8 (guint32 crc, const guint8 * data, guint datalen)
 {
-  gint i;
-  guint32 crc = 0xffffffff;
+  while (datalen >= 8) {
+    guint32 hi = crc ^ GST_READ_UINT32_BE (data);
+    guint32 lo = GST_READ_UINT32_BE (data + 4);
+
+    crc = crc_tab8[7][hi >> 24] ^ crc_tab8[6][(hi >> 16) & 0xff] ^
+        crc_tab8[5][(hi >> 8) & 0xff] ^ crc_tab8[4][hi & 0xff] ^
+        crc_tab8[3][lo >> 24] ^ crc_tab8[2][(lo >> 16) & 0xff] ^
+        crc_tab8[1][(lo >> 8) & 0xff] ^ crc_tab8[0][lo & 0xff];
+    data += 8;
+    datalen -= 8;
+  }
 
-  for (i = 0; i < datalen; i++) {
+  while (datalen--)
     crc = (crc << 8) ^ crc_tab[((crc >> 24) ^ *data++) & 0xff];
-  }
+
   return crc;
 }
 
+#ifdef HAVE_CRC32_PCLMUL
+/* x^192 mod P and x^128 mod P, with P the MPEG-2 CRC-32 polynomial */
+#define CRC32_FOLD_K192 G_GUINT64_CONSTANT (0xc5b9cd4c)
+#define CRC32_FOLD_K128 G_GUINT64_CONSTANT (0xe8a45605)
+
+/* Folds the data 16 bytes at a time with carry-less multiplications:
+ * (H.x^64 + L).x^128 = H.(x^192 mod P) + L.(x^128 mod P) modulo P.
+ * The folded remainder has the same CRC as the data it replaces, and is
+ * reduced along with the trailing bytes by the table-driven code */
+__attribute__ ((target ("pclmul,ssse3")))
+static guint32
+calc_crc32_pclmul (guint32 crc, const guint8 * data, guint datalen)
+{
+  const __m128i bswap =
+      _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m128i k = _mm_set_epi64x (CRC32_FOLD_K192, CRC32_FOLD_K128);
+  guint8 folded[16];
+  __m128i r;
+
+  if (datalen < 32)
+    return calc_crc32_slice8 (crc, data, datalen);
+
+  r = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) data), bswap);
+  r = _mm_xor_si128 (r, _mm_set_epi32 (crc, 0, 0, 0));
+  data += 16;
+  datalen -= 16;
+
+  while (datalen >= 16) {
+    __m128i h = _mm_clmulepi64_si128 (r, k, 0x11);
+    __m128i l = _mm_clmulepi64_si128 (r, k, 0x00);
+
+    r = _mm_xor_si128 (_mm_xor_si128 (h, l),
+        _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) data), bswap));
+    data += 16;
+    datalen -= 16;
+  }
+
+  _mm_storeu_si128 ((__m128i *) folded, _mm_shuffle_epi8 (r, bswap));
+  crc = calc_crc32_slice8 (0, folded, 16);
+
+  return calc_crc32_slice8 (crc, data, datalen);
+}
+#endif
+
+#ifdef HAVE_CRC32_ARMV8
+/* The ARMv8 CRC32 instructions implement the bit-reflected variant of the
+ * same polynomial. Feeding them bit-reversed bytes yields the bit-reversed
+ * MPEG-2 CRC */
+static guint32
+calc_crc32_armv8 (guint32 crc, const guint8 * data, guint datalen)
+{
+  crc = __rbit (crc);
+
+  while (datalen >= 8) {
+    guint64 w;
+
+    memcpy (&w, data, 8);
+    crc = __crc32d (crc, __rbitll (__revll (w)));
+    data += 8;
+    datalen -= 8;
+  }
+
+  while (datalen--)
+    crc = __crc32b (crc, __rbit ((guint32) * data++) >> 24);
+
+  return __rbit (crc);
+}
+#endif
+
+static void
+init_crc32 (void)
+{
+  static gsize done = 0;
+  guint i, n;
+
+  if (!g_once_init_enter (&done))
+    return;
+
+  for (i = 0; i < 256; i++) {
+    crc_tab8[0][i] = crc_tab[i];
+    for (n = 1; n < 8; n++)
+      crc_tab8[n][i] = (crc_tab8[n - 1][i] << 8) ^
+          crc_tab[crc_tab8[n - 1][i] >> 24];
+  }
+
+  calc_crc32_func = calc_crc32_slice8;
+#ifdef HAVE_CRC32_PCLMUL
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("pclmul") && __builtin_cpu_supports ("ssse3"))
+    calc_crc32_func = calc_crc32_pclmul;
+#endif
+#ifdef HAVE_CRC32_ARMV8
+  calc_crc32_func = calc_crc32_armv8;
+#endif
+
+  g_once_init_leave (&done, 1);
+}
+
+guint32
+_calc_crc32 (const guint8 * data, guint datalen)
+{
+  init_crc32 ();
+
+  return calc_crc32_func (0xffffffff, data, datalen);
+}
+
 gpointer
 __common_section_checks (GstMpegtsSection * section, guint min_size,
     GstMpegtsParseFunc parsefunc, GDestroyNotify destroynotify)
@@ -51,6 +51,7 @@
 #include <string.h>
 #include <gst/base/gstbytereader.h>
 #include <gst/tag/tag.h>
+#include <gst/codecparsers/gstjpegparser.h>
 
 #include "gstjpegparse.h"
 
@@ -287,20 +288,17 @@ gst_jpeg_parse_get_image_length (GstJpegParse * parse, GstMapInfo * mapinfo)
 
       GST_DEBUG ("0x%08x: finding entropy segment length", offset + 2);
       noffset = offset + 2 + frame_len + eseglen;
-      while (1) {
-        noffset = gst_byte_reader_masked_scan_uint32_peek (&reader, 0x0000ff00,
-            0x0000ff00, noffset, size - noffset, &value);
-        if (noffset < 0) {
-          /* need more data */
-          parse->last_entropy_len = size - offset - 4 - frame_len - 2;
-          goto need_more_data;
-        }
-        if ((value & 0xff) != 0x00) {
-          eseglen = noffset - offset - frame_len - 2;
-          break;
-        }
-        noffset++;
+      /* the scanner skips stuffed 0xff00 bytes, and returns the actual
+       * offset of the next marker */
+      noffset = gst_jpeg_scan_for_marker_code (mapinfo->data, size,
+          noffset + 2);
+      if (noffset < 0) {
+        /* need more data */
+        parse->last_entropy_len = size - offset - 4 - frame_len - 2;
+        goto need_more_data;
       }
+      noffset -= 2;
+      eseglen = noffset - offset - frame_len - 2;
       parse->last_entropy_len = 0;
       frame_len += eseglen;
       GST_DEBUG ("entropy segment length=%u => frame_len=%u", eseglen,
@@ -63,6 +63,8 @@ enum
 {
   PROP_0,
   PROP_PARSE_PRIVATE_SECTIONS,
+  PROP_SECTIONS_PARSED,
+  PROP_SECTIONS_SKIPPED,
   /* FILL ME */
 };
 
@@ -142,6 +144,16 @@ mpegts_base_class_init (MpegTSBaseClass * klass)
           "Parse private sections", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_SECTIONS_PARSED,
+      g_param_spec_uint64 ("sections-parsed", "Sections parsed",
+          "Number of PSI/SI sections assembled for parsing", 0, G_MAXUINT64,
+          0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SECTIONS_SKIPPED,
+      g_param_spec_uint64 ("sections-skipped", "Sections skipped",
+          "Number of already seen PSI/SI sections skipped without parsing",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   klass->sink_query = GST_DEBUG_FUNCPTR (mpegts_base_default_sink_query);
 }
 
@@ -170,6 +182,12 @@ mpegts_base_get_property (GObject * object, guint prop_id,
     case PROP_PARSE_PRIVATE_SECTIONS:
       g_value_set_boolean (value, base->parse_private_sections);
       break;
+    case PROP_SECTIONS_PARSED:
+      g_value_set_uint64 (value, base->packetizer->sections_parsed);
+      break;
+    case PROP_SECTIONS_SKIPPED:
+      g_value_set_uint64 (value, base->packetizer->sections_skipped);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -1429,6 +1447,12 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   mpegts_packetizer_push (base->packetizer, buf);
 
   while (res == GST_FLOW_OK) {
+    /* Drop packets on PIDs we don't handle straight from their batched
+     * header descriptors, without parsing them */
+    if (!klass->inspect_packet)
+      mpegts_packetizer_skip_packets (packetizer, base->is_pes,
+          base->known_psi);
+
     pret = mpegts_packetizer_next_packet (base->packetizer, &packet);
 
     /* If we don't have enough data, return */
@@ -0,0 +1,426 @@
+/*
+ * mpegtsindex.c : MPEG-TS seek index
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "mpegtsindex.h"
+#include "gstmpegdefs.h"
+
+GST_DEBUG_CATEGORY_STATIC (mpegts_index_debug);
+#ifndef GST_CAT_DEFAULT
+#define GST_CAT_DEFAULT mpegts_index_debug
+#endif
+
+#define MPEGTS_INDEX_MAGIC "GSTTSIDX"
+#define MPEGTS_INDEX_HEADER_SIZE 32
+#define MPEGTS_INDEX_ENTRY_SIZE 24
+
+/* PCR jumps bigger than this (or going backward) are discontinuities */
+#define MPEGTS_INDEX_DISCONT_THRESHOLD (PCR_SECOND)
+
+/* Number of consecutive sync bytes needed to detect the packet size */
+#define MPEGTS_INDEX_SYNC_PACKETS 4
+
+/* M2TS packets start with a 4 bytes timestamp, before the sync byte */
+#define MPEGTS_INDEX_M2TS_PACKET_SIZE 192
+#define MPEGTS_INDEX_M2TS_HEADER_SIZE 4
+
+typedef struct
+{
+  guint64 last_pcr;
+  GstClockTime last_time;
+  GstClockTime last_entry_time;
+} MpegTSIndexPCR;
+
+struct _MpegTSIndex
+{
+  /* Sorted by pid, type and time once finished */
+  GArray *entries;
+  guint16 packet_size;
+  guint64 file_size;
+
+  /* Scanning state */
+  GByteArray *pending;
+  /* Offset in the file of the first pending byte */
+  guint64 offset;
+  /* MpegTSIndexPCR indexed by PID */
+  GHashTable *pcrs;
+  /* Time of the last PCR seen on any PID */
+  GstClockTime last_time;
+};
+
+static void
+_init_debug (void)
+{
+  static gsize done = 0;
+
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (mpegts_index_debug, "mpegtsindex", 0,
+        "MPEG transport stream seek index");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+MpegTSIndex *
+mpegts_index_new (void)
+{
+  MpegTSIndex *index = g_new0 (MpegTSIndex, 1);
+
+  _init_debug ();
+
+  index->entries = g_array_new (FALSE, FALSE, sizeof (MpegTSIndexEntry));
+  index->pending = g_byte_array_new ();
+  index->pcrs = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  index->last_time = GST_CLOCK_TIME_NONE;
+
+  return index;
+}
+
+void
+mpegts_index_free (MpegTSIndex * index)
+{
+  g_array_free (index->entries, TRUE);
+  g_byte_array_free (index->pending, TRUE);
+  g_hash_table_destroy (index->pcrs);
+  g_free (index);
+}
+
+static void
+add_entry (MpegTSIndex * index, guint16 pid, MpegTSIndexEntryType type,
+    guint64 offset, GstClockTime time)
+{
+  MpegTSIndexEntry entry = { pid, type, offset, time };
+
+  GST_LOG ("pid 0x%04x type %d offset %" G_GUINT64_FORMAT " time %"
+      GST_TIME_FORMAT, pid, type, offset, GST_TIME_ARGS (time));
+  g_array_append_val (index->entries, entry);
+}
+
+static void
+record_pcr (MpegTSIndex * index, guint16 pid, guint64 pcr, guint64 offset)
+{
+  MpegTSIndexPCR *pcrstate;
+  gboolean discont = FALSE;
+
+  pcrstate = g_hash_table_lookup (index->pcrs, GUINT_TO_POINTER (pid));
+  if (pcrstate == NULL) {
+    pcrstate = g_new0 (MpegTSIndexPCR, 1);
+    /* Join the timeline of the PCRs seen so far */
+    if (GST_CLOCK_TIME_IS_VALID (index->last_time))
+      pcrstate->last_time = index->last_time;
+    g_hash_table_insert (index->pcrs, GUINT_TO_POINTER (pid), pcrstate);
+    discont = TRUE;
+  } else if (pcr < pcrstate->last_pcr ||
+      pcr - pcrstate->last_pcr > MPEGTS_INDEX_DISCONT_THRESHOLD) {
+    /* Wraparound or discontinuity, keep the time continuous */
+    GST_DEBUG ("PCR discont on pid 0x%04x at offset %" G_GUINT64_FORMAT, pid,
+        offset);
+    discont = TRUE;
+  } else {
+    pcrstate->last_time += PCRTIME_TO_GSTTIME (pcr - pcrstate->last_pcr);
+  }
+  pcrstate->last_pcr = pcr;
+  index->last_time = pcrstate->last_time;
+
+  if (discont || pcrstate->last_time - pcrstate->last_entry_time >=
+      MPEGTS_INDEX_PCR_INTERVAL) {
+    add_entry (index, pid, MPEGTS_INDEX_ENTRY_PCR, offset,
+        pcrstate->last_time);
+    pcrstate->last_entry_time = pcrstate->last_time;
+  }
+}
+
+static void
+scan_packet (MpegTSIndex * index, const guint8 * data, guint64 offset)
+{
+  guint16 pid;
+  guint8 afc, af_length, af_flags;
+
+  /* Only packets with an adaptation field are of interest */
+  afc = (data[3] >> 4) & 0x3;
+  if (!(afc & 0x2))
+    return;
+  af_length = data[4];
+  if (af_length == 0 || af_length > 183)
+    return;
+
+  pid = GST_READ_UINT16_BE (data + 1) & 0x1fff;
+  af_flags = data[5];
+
+  /* PCR_flag */
+  if ((af_flags & 0x10) && af_length >= 7) {
+    guint32 pcr1 = GST_READ_UINT32_BE (data + 6);
+    guint16 pcr2 = GST_READ_UINT16_BE (data + 10);
+    guint64 pcr = (((guint64) pcr1) << 1) | ((pcr2 & 0x8000) >> 15);
+
+    record_pcr (index, pid, pcr * 300 + (pcr2 & 0x1ff) % 300, offset);
+  }
+
+  /* random_access_indicator on the first packet of a PES */
+  if ((af_flags & 0x40) && (data[1] & 0x40) &&
+      GST_CLOCK_TIME_IS_VALID (index->last_time))
+    add_entry (index, pid, MPEGTS_INDEX_ENTRY_KEYFRAME, offset,
+        index->last_time);
+}
+
+static gboolean
+detect_packet_size (MpegTSIndex * index, const guint8 * data, gsize size,
+    gsize * sync)
+{
+  static const guint16 sizes[] = { 188, 192, 204, 208 };
+  guint i, k;
+  gsize pos;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    gsize needed = sizes[i] * MPEGTS_INDEX_SYNC_PACKETS;
+
+    for (pos = 0; pos < sizes[i] && pos + needed <= size; pos++) {
+      for (k = 0; k < MPEGTS_INDEX_SYNC_PACKETS; k++)
+        if (data[pos + k * sizes[i]] != 0x47)
+          break;
+      if (k == MPEGTS_INDEX_SYNC_PACKETS) {
+        index->packet_size = sizes[i];
+        *sync = pos;
+        GST_DEBUG ("packet size %u, first sync at %" G_GSIZE_FORMAT,
+            index->packet_size, pos);
+        return TRUE;
+      }
+    }
+  }
+
+  return FALSE;
+}
+
+/* Scans the next @size bytes of the file. The whole file must be passed in
+ * order, starting from its first byte */
+void
+mpegts_index_scan (MpegTSIndex * index, const guint8 * data, gsize size)
+{
+  const guint8 *pdata;
+  gsize psize, pos = 0;
+  guint16 packet_size, header_size;
+
+  index->file_size += size;
+  g_byte_array_append (index->pending, data, size);
+  pdata = index->pending->data;
+  psize = index->pending->len;
+
+  if (index->packet_size == 0) {
+    if (!detect_packet_size (index, pdata, psize, &pos)) {
+      /* Give up on data that can't contain a sync point */
+      if (psize > 4 * 208 * MPEGTS_INDEX_SYNC_PACKETS)
+        pos = psize - 208 * MPEGTS_INDEX_SYNC_PACKETS;
+      goto done;
+    }
+  }
+  packet_size = index->packet_size;
+  header_size = packet_size == MPEGTS_INDEX_M2TS_PACKET_SIZE ?
+      MPEGTS_INDEX_M2TS_HEADER_SIZE : 0;
+
+  while (pos + packet_size <= psize) {
+    if (G_UNLIKELY (pdata[pos] != 0x47 ||
+            (pos + 2 * packet_size <= psize &&
+                pdata[pos + packet_size] != 0x47))) {
+      /* Lost sync, look for the next sync byte */
+      pos++;
+      continue;
+    }
+    /* Entries point to the start of the packets, not to their sync byte */
+    if (G_LIKELY (index->offset + pos >= header_size))
+      scan_packet (index, pdata + pos, index->offset + pos - header_size);
+    pos += packet_size;
+  }
+
+done:
+  g_byte_array_remove_range (index->pending, 0, pos);
+  index->offset += pos;
+}
+
+static gint
+compare_entries (const MpegTSIndexEntry * a, const MpegTSIndexEntry * b)
+{
+  if (a->pid != b->pid)
+    return a->pid < b->pid ? -1 : 1;
+  if (a->type != b->type)
+    return a->type < b->type ? -1 : 1;
+  if (a->time != b->time)
+    return a->time < b->time ? -1 : 1;
+  if (a->offset != b->offset)
+    return a->offset < b->offset ? -1 : 1;
+  return 0;
+}
+
+/* Finishes building @index, making it ready for lookups and saving */
+void
+mpegts_index_finish (MpegTSIndex * index)
+{
+  g_array_sort (index->entries, (GCompareFunc) compare_entries);
+  g_byte_array_set_size (index->pending, 0);
+  g_hash_table_remove_all (index->pcrs);
+
+  GST_DEBUG ("finished index with %u entries", index->entries->len);
+}
+
+gboolean
+mpegts_index_save (MpegTSIndex * index, const gchar * location,
+    GError ** error)
+{
+  gsize size;
+  guint8 *data, *w;
+  gboolean ret;
+  guint i;
+
+  size = MPEGTS_INDEX_HEADER_SIZE +
+      (gsize) index->entries->len * MPEGTS_INDEX_ENTRY_SIZE;
+  w = data = g_malloc0 (size);
+
+  memcpy (w, MPEGTS_INDEX_MAGIC, 8);
+  GST_WRITE_UINT16_BE (w + 8, MPEGTS_INDEX_VERSION);
+  GST_WRITE_UINT16_BE (w + 10, index->packet_size);
+  GST_WRITE_UINT64_BE (w + 16, index->file_size);
+  GST_WRITE_UINT64_BE (w + 24, index->entries->len);
+  w += MPEGTS_INDEX_HEADER_SIZE;
+
+  for (i = 0; i < index->entries->len; i++) {
+    MpegTSIndexEntry *entry =
+        &g_array_index (index->entries, MpegTSIndexEntry, i);
+
+    GST_WRITE_UINT16_BE (w, entry->pid);
+    GST_WRITE_UINT16_BE (w + 2, entry->type);
+    GST_WRITE_UINT64_BE (w + 8, entry->offset);
+    GST_WRITE_UINT64_BE (w + 16, entry->time);
+    w += MPEGTS_INDEX_ENTRY_SIZE;
+  }
+
+  ret = g_file_set_contents (location, (const gchar *) data, size, error);
+  g_free (data);
+
+  return ret;
+}
+
+/* Loads the index stored in @location, reading it in one go. Returns NULL
+ * on error */
+MpegTSIndex *
+mpegts_index_load (const gchar * location, GError ** error)
+{
+  MpegTSIndex *index;
+  gchar *contents;
+  const guint8 *data;
+  gsize size;
+  guint64 n_entries, i;
+  gboolean sorted = TRUE;
+
+  _init_debug ();
+
+  if (!g_file_get_contents (location, &contents, &size, error))
+    return NULL;
+  data = (const guint8 *) contents;
+
+  if (size < MPEGTS_INDEX_HEADER_SIZE ||
+      memcmp (data, MPEGTS_INDEX_MAGIC, 8) != 0)
+    goto invalid;
+  if (GST_READ_UINT16_BE (data + 8) != MPEGTS_INDEX_VERSION)
+    goto invalid;
+  n_entries = GST_READ_UINT64_BE (data + 24);
+  if (n_entries != (size - MPEGTS_INDEX_HEADER_SIZE) / MPEGTS_INDEX_ENTRY_SIZE)
+    goto invalid;
+
+  index = mpegts_index_new ();
+  index->packet_size = GST_READ_UINT16_BE (data + 10);
+  index->file_size = GST_READ_UINT64_BE (data + 16);
+  g_array_set_size (index->entries, n_entries);
+
+  data += MPEGTS_INDEX_HEADER_SIZE;
+  for (i = 0; i < n_entries; i++) {
+    MpegTSIndexEntry *entry =
+        &g_array_index (index->entries, MpegTSIndexEntry, i);
+
+    entry->pid = GST_READ_UINT16_BE (data);
+    entry->type = GST_READ_UINT16_BE (data + 2);
+    entry->offset = GST_READ_UINT64_BE (data + 8);
+    entry->time = GST_READ_UINT64_BE (data + 16);
+    if (i > 0 && compare_entries (entry - 1, entry) > 0)
+      sorted = FALSE;
+    data += MPEGTS_INDEX_ENTRY_SIZE;
+  }
+  g_free (contents);
+
+  if (!sorted)
+    g_array_sort (index->entries, (GCompareFunc) compare_entries);
+
+  GST_DEBUG ("loaded index with %" G_GUINT64_FORMAT " entries for a file of %"
+      G_GUINT64_FORMAT " bytes", n_entries, index->file_size);
+
+  return index;
+
+invalid:
+  g_free (contents);
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+      "%s is not a valid MPEG-TS index", location);
+  return NULL;
+}
+
+guint64
+mpegts_index_get_file_size (MpegTSIndex * index)
+{
+  return index->file_size;
+}
+
+guint
+mpegts_index_get_n_entries (MpegTSIndex * index)
+{
+  return index->entries->len;
+}
+
+/* Looks up the last entry of @type on @pid at or before @time, or the first
+ * one if they are all after @time. Returns FALSE if there is none */
+gboolean
+mpegts_index_lookup (MpegTSIndex * index, guint16 pid,
+    MpegTSIndexEntryType type, GstClockTime time, MpegTSIndexEntry * entry)
+{
+  MpegTSIndexEntry key = { pid, type, G_MAXUINT64, time };
+  MpegTSIndexEntry *entries = (MpegTSIndexEntry *) index->entries->data;
+  guint low = 0, high = index->entries->len;
+
+  /* Find the first entry after the key */
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+
+    if (compare_entries (&entries[mid], &key) <= 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low > 0 && entries[low - 1].pid == pid && entries[low - 1].type == type) {
+    *entry = entries[low - 1];
+    return TRUE;
+  }
+  if (low < index->entries->len && entries[low].pid == pid &&
+      entries[low].type == type) {
+    *entry = entries[low];
+    return TRUE;
+  }
+
+  return FALSE;
+}
@@ -0,0 +1,92 @@
+/*
+ * mpegtsindex.h : MPEG-TS seek index
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __MPEGTS_INDEX_H__
+#define __MPEGTS_INDEX_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Seek index of a MPEG-TS file
+ *
+ * The index maps times to byte offsets of the file, for each PID:
+ * - on PCR PIDs, PCR observations (at most one every
+ *   MPEGTS_INDEX_PCR_INTERVAL),
+ * - on PES PIDs, packets starting a random access point (as signalled by the
+ *   random_access_indicator of the adaptation field).
+ *
+ * Times are expressed in nanoseconds on the PCR clock, starting at 0 at the
+ * first PCR of the file. PCR PIDs showing up later start at the time of the
+ * last PCR seen. PCR wraparounds and discontinuities are smoothed out so that
+ * times keep on increasing through the whole file. Random access points are
+ * timestamped with the last PCR seen before them.
+ *
+ * Indexes are stored as sidecar files, made of a 32 bytes header followed by
+ * the entries, sorted by PID, type and time (all values are big-endian):
+ *
+ *   magic "GSTTSIDX" (8) | version (2) | packet size (2) | reserved (4) |
+ *   size of the indexed file (8) | number of entries (8)
+ *
+ *   entry: pid (2) | type (2) | reserved (4) | offset (8) | time (8)
+ */
+
+#define MPEGTS_INDEX_VERSION 1
+#define MPEGTS_INDEX_PCR_INTERVAL (500 * GST_MSECOND)
+
+typedef enum {
+  MPEGTS_INDEX_ENTRY_PCR = 0,
+  MPEGTS_INDEX_ENTRY_KEYFRAME = 1
+} MpegTSIndexEntryType;
+
+typedef struct
+{
+  guint16 pid;
+  guint16 type;
+  /* Offset of the packet in the file (of its timestamp for M2TS) */
+  guint64 offset;
+  GstClockTime time;
+} MpegTSIndexEntry;
+
+typedef struct _MpegTSIndex MpegTSIndex;
+
+G_GNUC_INTERNAL MpegTSIndex *mpegts_index_new (void);
+G_GNUC_INTERNAL void mpegts_index_free (MpegTSIndex *index);
+
+/* Building */
+G_GNUC_INTERNAL void mpegts_index_scan (MpegTSIndex *index,
+    const guint8 *data, gsize size);
+G_GNUC_INTERNAL void mpegts_index_finish (MpegTSIndex *index);
+
+/* Storage */
+G_GNUC_INTERNAL gboolean mpegts_index_save (MpegTSIndex *index,
+    const gchar *location, GError **error);
+G_GNUC_INTERNAL MpegTSIndex *mpegts_index_load (const gchar *location,
+    GError **error);
+
+/* Lookup (only valid on finished or loaded indexes) */
+G_GNUC_INTERNAL guint64 mpegts_index_get_file_size (MpegTSIndex *index);
+G_GNUC_INTERNAL guint mpegts_index_get_n_entries (MpegTSIndex *index);
+G_GNUC_INTERNAL gboolean mpegts_index_lookup (MpegTSIndex *index, guint16 pid,
+    MpegTSIndexEntryType type, GstClockTime time, MpegTSIndexEntry *entry);
+
+G_END_DECLS
+
+#endif /* __MPEGTS_INDEX_H__ */
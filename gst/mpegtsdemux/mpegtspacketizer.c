@@ -25,6 +25,14 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /* Skew calculation pameters */
 #define MAX_TIME	(2 * GST_SECOND)
 
@@ -66,15 +74,15 @@ get_pcr_table (MpegTSPacketizer2 * packetizer, guint16 pid)
 {
   MpegTSPCR *res;
 
-  res = packetizer->observations[packetizer->pcrtablelut[pid]];
+  res = packetizer->pids[pid].pcrtable;
 
   if (G_UNLIKELY (res == NULL)) {
     /* If we don't have a PCR table for the requested PID, create one .. */
     res = g_new0 (MpegTSPCR, 1);
     /* Add it to the last table position */
     packetizer->observations[packetizer->lastobsid] = res;
-    /* Update the pcrtablelut */
-    packetizer->pcrtablelut[pid] = packetizer->lastobsid;
+    /* Reference it from the PID dispatch table */
+    packetizer->pids[pid].pcrtable = res;
     /* And increment the last know slot */
     packetizer->lastobsid++;
 
@@ -110,6 +118,7 @@ flush_observations (MpegTSPacketizer2 * packetizer)
   gint i;
 
   for (i = 0; i < packetizer->lastobsid; i++) {
+    packetizer->pids[packetizer->observations[i]->pid].pcrtable = NULL;
     g_list_free_full (packetizer->observations[i]->groups,
         (GDestroyNotify) pcr_offset_group_free);
     if (packetizer->observations[i]->current)
@@ -117,7 +126,6 @@ flush_observations (MpegTSPacketizer2 * packetizer)
     g_free (packetizer->observations[i]);
     packetizer->observations[i] = NULL;
   }
-  memset (packetizer->pcrtablelut, 0xff, 0x2000);
   packetizer->lastobsid = 0;
 }
 
@@ -135,20 +143,11 @@ mpegts_packetizer_get_current_time (MpegTSPacketizer2 * packetizer,
 }
 
 static inline MpegTSPacketizerStreamSubtable *
-find_subtable (GSList * subtables, guint8 table_id, guint16 subtable_extension)
+find_subtable (GHashTable * subtables, guint8 table_id,
+    guint16 subtable_extension)
 {
-  GSList *tmp;
-
-  /* FIXME: Make this an array ! */
-  for (tmp = subtables; tmp; tmp = tmp->next) {
-    MpegTSPacketizerStreamSubtable *sub =
-        (MpegTSPacketizerStreamSubtable *) tmp->data;
-    if (sub->table_id == table_id
-        && sub->subtable_extension == subtable_extension)
-      return sub;
-  }
-
-  return NULL;
+  return g_hash_table_lookup (subtables,
+      MPEGTS_SUBTABLE_KEY (table_id, subtable_extension));
 }
 
 static gboolean
@@ -192,6 +191,13 @@ mpegts_packetizer_stream_subtable_new (guint8 table_id,
   return subtable;
 }
 
+static void
+mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
+    subtable)
+{
+  g_free (subtable);
+}
+
 static MpegTSPacketizerStream *
 mpegts_packetizer_stream_new (guint16 pid)
 {
@@ -199,7 +205,8 @@ mpegts_packetizer_stream_new (guint16 pid)
 
   stream = (MpegTSPacketizerStream *) g_new0 (MpegTSPacketizerStream, 1);
   stream->continuity_counter = CONTINUITY_UNSET;
-  stream->subtables = NULL;
+  stream->subtables = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) mpegts_packetizer_stream_subtable_free);
   stream->table_id = TABLE_ID_UNSET;
   stream->pid = pid;
   return stream;
@@ -216,20 +223,11 @@ mpegts_packetizer_clear_section (MpegTSPacketizerStream * stream)
   stream->section_data = NULL;
 }
 
-static void
-mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
-    subtable)
-{
-  g_free (subtable);
-}
-
 static void
 mpegts_packetizer_stream_free (MpegTSPacketizerStream * stream)
 {
   mpegts_packetizer_clear_section (stream);
-  g_slist_foreach (stream->subtables,
-      (GFunc) mpegts_packetizer_stream_subtable_free, NULL);
-  g_slist_free (stream->subtables);
+  g_hash_table_unref (stream->subtables);
   g_free (stream);
 }
 
@@ -252,7 +250,7 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->adapter = gst_adapter_new ();
   packetizer->offset = 0;
   packetizer->empty = TRUE;
-  packetizer->streams = g_new0 (MpegTSPacketizerStream *, 8192);
+  packetizer->pids = g_new0 (MpegTSPacketizerPid, 0x2000);
   packetizer->packet_size = 0;
   packetizer->calculate_skew = FALSE;
   packetizer->calculate_offset = FALSE;
@@ -260,9 +258,11 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->map_buffer = NULL;
   packetizer->need_sync = FALSE;
+  packetizer->batch_offset = 0;
+  packetizer->batch_pos = packetizer->batch_len = 0;
 
-  memset (packetizer->pcrtablelut, 0xff, 0x2000);
   memset (packetizer->observations, 0x0, sizeof (packetizer->observations));
   packetizer->lastobsid = 0;
 
@@ -280,15 +280,15 @@ mpegts_packetizer_dispose (GObject * object)
   if (!packetizer->disposed) {
     if (packetizer->packet_size)
       packetizer->packet_size = 0;
-    if (packetizer->streams) {
+    if (packetizer->pids) {
       int i;
-      for (i = 0; i < 8192; i++) {
-        if (packetizer->streams[i])
-          mpegts_packetizer_stream_free (packetizer->streams[i]);
+      for (i = 0; i < 0x2000; i++) {
+        if (packetizer->pids[i].stream)
+          mpegts_packetizer_stream_free (packetizer->pids[i].stream);
       }
-      g_free (packetizer->streams);
     }
 
+    gst_buffer_replace (&packetizer->map_buffer, NULL);
     gst_adapter_clear (packetizer->adapter);
     g_object_unref (packetizer->adapter);
     g_mutex_clear (&packetizer->group_lock);
@@ -297,6 +297,8 @@ mpegts_packetizer_dispose (GObject * object)
     packetizer->empty = TRUE;
 
     flush_observations (packetizer);
+    g_free (packetizer->pids);
+    packetizer->pids = NULL;
   }
 
   if (G_OBJECT_CLASS (mpegts_packetizer_parent_class)->dispose)
@@ -446,33 +448,30 @@ mpegts_packetizer_parse_adaptation_field_control (MpegTSPacketizer2 *
 
 static MpegTSPacketizerPacketReturn
 mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
-    MpegTSPacketizerPacket * packet)
+    MpegTSPacketizerPacket * packet, const MpegTSPacketizerPacketDesc * desc)
 {
-  guint8 *data;
   guint8 tmp;
 
-  data = packet->data_start;
-  data += 1;
-  tmp = *data;
+  /* The sync byte and the fixed header fields were already validated and
+   * extracted by the batched header scanner */
 
   /* transport_error_indicator 1 */
-  if (G_UNLIKELY (tmp & 0x80))
+  if (G_UNLIKELY (desc->flags & 0x80))
     return PACKET_BAD;
 
   /* payload_unit_start_indicator 1 */
-  packet->payload_unit_start_indicator = tmp & 0x40;
+  packet->payload_unit_start_indicator = desc->flags & 0x40;
 
   /* transport_priority 1 */
   /* PID 13 */
-  packet->pid = GST_READ_UINT16_BE (data) & 0x1FFF;
-  data += 2;
+  packet->pid = desc->pid;
 
-  packet->scram_afc_cc = tmp = *data++;
+  packet->scram_afc_cc = tmp = desc->scram_afc_cc;
   /* transport_scrambling_control 2 */
   if (G_UNLIKELY (tmp & 0xc0))
     return PACKET_BAD;
 
-  packet->data = data;
+  packet->data = packet->data_start + 4;
 
   packet->afc_flags = 0;
   packet->pcr = G_MAXUINT64;
@@ -516,7 +515,9 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
         stream->subtable_extension, stream->last_section_number);
     subtable->version_number = stream->version_number;
 
-    stream->subtables = g_slist_prepend (stream->subtables, subtable);
+    g_hash_table_insert (stream->subtables,
+        MPEGTS_SUBTABLE_KEY (stream->table_id, stream->subtable_extension),
+        subtable);
   }
 
   GST_MEMDUMP ("Full section data", stream->section_data,
@@ -548,6 +549,7 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
      * */
     MPEGTS_BIT_SET (subtable->seen_section, stream->section_number);
     res->offset = stream->offset;
+    packetizer->sections_parsed++;
   }
 
   return res;
@@ -561,14 +563,14 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
 
   packetizer->packet_size = 0;
 
-  if (packetizer->streams) {
+  if (packetizer->pids) {
     int i;
-    for (i = 0; i < 8192; i++) {
-      if (packetizer->streams[i]) {
-        mpegts_packetizer_stream_free (packetizer->streams[i]);
+    for (i = 0; i < 0x2000; i++) {
+      if (packetizer->pids[i].stream) {
+        mpegts_packetizer_stream_free (packetizer->pids[i].stream);
+        packetizer->pids[i].stream = NULL;
       }
     }
-    memset (packetizer->streams, 0, 8192 * sizeof (MpegTSPacketizerStream *));
   }
 
   gst_adapter_clear (packetizer->adapter);
@@ -578,9 +580,11 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->batch_pos = packetizer->batch_len = 0;
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
 
-  pcrtable = packetizer->observations[packetizer->pcrtablelut[0x1fff]];
+  pcrtable = packetizer->pids[0x1fff].pcrtable;
   if (pcrtable)
     pcrtable->base_time = GST_CLOCK_TIME_NONE;
 
@@ -603,10 +607,10 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
   MpegTSPCR *pcrtable;
   GST_DEBUG ("Flushing");
 
-  if (packetizer->streams) {
-    for (i = 0; i < 8192; i++) {
-      if (packetizer->streams[i]) {
-        mpegts_packetizer_clear_section (packetizer->streams[i]);
+  if (packetizer->pids) {
+    for (i = 0; i < 0x2000; i++) {
+      if (packetizer->pids[i].stream) {
+        mpegts_packetizer_clear_section (packetizer->pids[i].stream);
       }
     }
   }
@@ -618,9 +622,11 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->batch_pos = packetizer->batch_len = 0;
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
 
-  pcrtable = packetizer->observations[packetizer->pcrtablelut[0x1fff]];
+  pcrtable = packetizer->pids[0x1fff].pcrtable;
   if (pcrtable)
     pcrtable->base_time = GST_CLOCK_TIME_NONE;
 
@@ -643,11 +649,11 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
 void
 mpegts_packetizer_remove_stream (MpegTSPacketizer2 * packetizer, gint16 pid)
 {
-  MpegTSPacketizerStream *stream = packetizer->streams[pid];
+  MpegTSPacketizerStream *stream = packetizer->pids[pid].stream;
   if (stream) {
     GST_INFO ("Removing stream for PID 0x%04x", pid);
     mpegts_packetizer_stream_free (stream);
-    packetizer->streams[pid] = NULL;
+    packetizer->pids[pid].stream = NULL;
   }
 }
 
@@ -693,6 +699,8 @@ mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->batch_pos = packetizer->batch_len = 0;
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
 }
 
 static gboolean
@@ -722,6 +730,28 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   return TRUE;
 }
 
+/* Returns a buffer referencing (without copying) @size bytes of the upstream
+ * data at @data, which must point within the currently mapped data (i.e. be
+ * part of the packet being processed) */
+GstBuffer *
+mpegts_packetizer_get_buffer_region (MpegTSPacketizer2 * packetizer,
+    const guint8 * data, gsize size)
+{
+  g_return_val_if_fail (packetizer->map_data != NULL, NULL);
+  g_return_val_if_fail (data >= packetizer->map_data &&
+      data + size <= packetizer->map_data + packetizer->map_size, NULL);
+
+  if (G_UNLIKELY (packetizer->map_buffer == NULL)) {
+    packetizer->map_buffer =
+        gst_adapter_get_buffer_fast (packetizer->adapter, packetizer->map_size);
+    if (packetizer->map_buffer == NULL)
+      return NULL;
+  }
+
+  return gst_buffer_copy_region (packetizer->map_buffer,
+      GST_BUFFER_COPY_MEMORY, data - packetizer->map_data, size);
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
@@ -809,6 +839,7 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   }
 
   packetizer->map_offset += i - sync_offset;
+  packetizer->batch_pos = packetizer->batch_len = 0;
 
   if (!found)
     mpegts_packetizer_flush_bytes (packetizer, packetizer->map_offset);
@@ -816,10 +847,174 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   return found;
 }
 
+/* Validates the sync byte of up to @n consecutive packets located @stride
+ * bytes apart starting at @data, and extracts their fixed header fields into
+ * @desc. Returns the number of leading packets that have a valid sync byte */
+static guint
+scan_packet_headers_scalar (const guint8 * data, guint stride, guint n,
+    MpegTSPacketizerPacketDesc * desc)
+{
+  guint i;
+
+  for (i = 0; i < n; i++, data += stride) {
+    if (G_UNLIKELY (data[0] != PACKET_SYNC_BYTE))
+      break;
+    desc[i].flags = data[1] & 0xc0;
+    desc[i].pid = GST_READ_UINT16_BE (data + 1) & 0x1FFF;
+    desc[i].scram_afc_cc = data[3];
+  }
+
+  return i;
+}
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN && \
+    (defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON))
+#define HAVE_SIMD_HEADER_SCAN 1
+
+G_STATIC_ASSERT (sizeof (MpegTSPacketizerPacketDesc) == 4);
+
+/* The vector kernels load the first 4 bytes of each packet as a little-endian
+ * 32 bit word w (sync byte in the lowest byte) and turn it into the
+ * in-memory representation of a MpegTSPacketizerPacketDesc:
+ *
+ *   pid          = (w & 0x00001f00) | ((w >> 16) & 0xff)
+ *   flags        = (w << 8) & 0x00c00000
+ *   scram_afc_cc = w & 0xff000000
+ */
+static guint
+scan_packet_headers (const guint8 * data, guint stride, guint n,
+    MpegTSPacketizerPacketDesc * desc)
+{
+  guint i = 0;
+
+#if defined(__AVX2__)
+  {
+    const __m256i index = _mm256_mullo_epi32 (_mm256_set1_epi32 (stride),
+        _mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i sync_mask = _mm256_set1_epi32 (0xff);
+    const __m256i sync = _mm256_set1_epi32 (PACKET_SYNC_BYTE);
+    const __m256i pid_hi = _mm256_set1_epi32 (0x00001f00);
+    const __m256i low_byte = _mm256_set1_epi32 (0x000000ff);
+    const __m256i flags = _mm256_set1_epi32 (0x00c00000);
+    const __m256i scram_afc_cc = _mm256_set1_epi32 ((gint) 0xff000000);
+
+    for (; i + 8 <= n; i += 8, data += 8 * stride) {
+      __m256i w, d;
+
+      w = _mm256_i32gather_epi32 ((const int *) data, index, 1);
+      if (_mm256_movemask_epi8 (_mm256_cmpeq_epi32 (_mm256_and_si256 (w,
+                      sync_mask), sync)) != -1)
+        break;
+
+      d = _mm256_or_si256 (_mm256_and_si256 (w, pid_hi),
+          _mm256_and_si256 (_mm256_srli_epi32 (w, 16), low_byte));
+      d = _mm256_or_si256 (d, _mm256_and_si256 (_mm256_slli_epi32 (w, 8),
+              flags));
+      d = _mm256_or_si256 (d, _mm256_and_si256 (w, scram_afc_cc));
+      _mm256_storeu_si256 ((__m256i *) (desc + i), d);
+    }
+  }
+#elif defined(__SSE2__)
+  {
+    const __m128i sync_mask = _mm_set1_epi32 (0xff);
+    const __m128i sync = _mm_set1_epi32 (PACKET_SYNC_BYTE);
+    const __m128i pid_hi = _mm_set1_epi32 (0x00001f00);
+    const __m128i low_byte = _mm_set1_epi32 (0x000000ff);
+    const __m128i flags = _mm_set1_epi32 (0x00c00000);
+    const __m128i scram_afc_cc = _mm_set1_epi32 ((gint) 0xff000000);
+
+    for (; i + 4 <= n; i += 4, data += 4 * stride) {
+      __m128i w, d;
+
+      w = _mm_setr_epi32 (GST_READ_UINT32_LE (data),
+          GST_READ_UINT32_LE (data + stride),
+          GST_READ_UINT32_LE (data + 2 * stride),
+          GST_READ_UINT32_LE (data + 3 * stride));
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (_mm_and_si128 (w, sync_mask),
+                  sync)) != 0xffff)
+        break;
+
+      d = _mm_or_si128 (_mm_and_si128 (w, pid_hi),
+          _mm_and_si128 (_mm_srli_epi32 (w, 16), low_byte));
+      d = _mm_or_si128 (d, _mm_and_si128 (_mm_slli_epi32 (w, 8), flags));
+      d = _mm_or_si128 (d, _mm_and_si128 (w, scram_afc_cc));
+      _mm_storeu_si128 ((__m128i *) (desc + i), d);
+    }
+  }
+#elif defined(__ARM_NEON)
+  {
+    const uint32x4_t sync_mask = vdupq_n_u32 (0xff);
+    const uint32x4_t sync = vdupq_n_u32 (PACKET_SYNC_BYTE);
+    const uint32x4_t pid_hi = vdupq_n_u32 (0x00001f00);
+    const uint32x4_t low_byte = vdupq_n_u32 (0x000000ff);
+    const uint32x4_t flags = vdupq_n_u32 (0x00c00000);
+    const uint32x4_t scram_afc_cc = vdupq_n_u32 (0xff000000);
+
+    for (; i + 4 <= n; i += 4, data += 4 * stride) {
+      uint32x4_t w, d;
+      uint64x2_t eq;
+
+      w = vdupq_n_u32 (GST_READ_UINT32_LE (data));
+      w = vsetq_lane_u32 (GST_READ_UINT32_LE (data + stride), w, 1);
+      w = vsetq_lane_u32 (GST_READ_UINT32_LE (data + 2 * stride), w, 2);
+      w = vsetq_lane_u32 (GST_READ_UINT32_LE (data + 3 * stride), w, 3);
+      eq = vreinterpretq_u64_u32 (vceqq_u32 (vandq_u32 (w, sync_mask), sync));
+      if ((vgetq_lane_u64 (eq, 0) & vgetq_lane_u64 (eq, 1)) != G_MAXUINT64)
+        break;
+
+      d = vorrq_u32 (vandq_u32 (w, pid_hi),
+          vandq_u32 (vshrq_n_u32 (w, 16), low_byte));
+      d = vorrq_u32 (d, vandq_u32 (vshlq_n_u32 (w, 8), flags));
+      d = vorrq_u32 (d, vandq_u32 (w, scram_afc_cc));
+      vst1q_u32 ((uint32_t *) (desc + i), d);
+    }
+  }
+#endif
+
+  /* Tail, or the vector containing the first packet with a bad sync byte */
+  return i + scan_packet_headers_scalar (data, stride, n - i, desc + i);
+}
+#else
+#define scan_packet_headers scan_packet_headers_scalar
+#endif
+
+/* Returns the descriptor of the packet at the current map offset, running the
+ * batched header scanner over the following mapped packets if needed.
+ * Returns NULL if the packet doesn't start with a sync byte */
+static inline const MpegTSPacketizerPacketDesc *
+mpegts_packetizer_next_desc (MpegTSPacketizer2 * packetizer,
+    guint packet_size, gsize sync_offset)
+{
+  const MpegTSPacketizerPacketDesc *desc;
+
+  if (G_UNLIKELY (packetizer->batch_pos >= packetizer->batch_len ||
+          packetizer->batch_offset != packetizer->map_offset)) {
+    gsize n =
+        (packetizer->map_size - packetizer->map_offset) / packet_size;
+
+    packetizer->batch_offset = packetizer->map_offset;
+    packetizer->batch_pos = 0;
+    packetizer->batch_len =
+        scan_packet_headers (packetizer->map_data + packetizer->map_offset +
+        sync_offset, packet_size, MIN (n, MPEGTS_PACKETIZER_BATCH_SIZE),
+        packetizer->batch);
+    GST_LOG ("classified %u packets out of %" G_GSIZE_FORMAT,
+        packetizer->batch_len, n);
+    if (packetizer->batch_len == 0)
+      return NULL;
+  }
+
+  desc = &packetizer->batch[packetizer->batch_pos++];
+  packetizer->batch_offset += packet_size;
+
+  return desc;
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerPacket * packet)
 {
+  const MpegTSPacketizerPacketDesc *desc;
   guint8 *packet_data;
   guint packet_size;
   gsize sync_offset;
@@ -848,9 +1043,10 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
       return PACKET_NEED_MORE;
 
     packet_data = &packetizer->map_data[packetizer->map_offset + sync_offset];
+    desc = mpegts_packetizer_next_desc (packetizer, packet_size, sync_offset);
 
     /* Check sync byte */
-    if (G_UNLIKELY (*packet_data != PACKET_SYNC_BYTE)) {
+    if (G_UNLIKELY (desc == NULL)) {
       GST_DEBUG ("lost sync");
       packetizer->need_sync = TRUE;
     } else {
@@ -864,7 +1060,7 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
       packetizer->offset += packet_size;
       GST_MEMDUMP ("data_start", packet->data_start, 16);
 
-      return mpegts_packetizer_parse_packet (packetizer, packet);
+      return mpegts_packetizer_parse_packet (packetizer, packet, desc);
     }
   }
 }
@@ -895,6 +1091,48 @@ mpegts_packetizer_clear_packet (MpegTSPacketizer2 * packetizer,
   }
 }
 
+/* Skips all following packets that are neither on a PES nor on a known PSI
+ * PID, and that don't carry an adaptation field (and hence no PCR), straight
+ * from their batched descriptors without parsing them.
+ * Returns the number of skipped packets */
+guint
+mpegts_packetizer_skip_packets (MpegTSPacketizer2 * packetizer,
+    const guint8 * is_pes, const guint8 * known_psi)
+{
+  guint packet_size = packetizer->packet_size;
+  guint skipped = 0;
+
+  if (G_UNLIKELY (!packet_size || !packetizer->map_data
+          || packetizer->need_sync))
+    return 0;
+
+  while (packetizer->batch_pos < packetizer->batch_len &&
+      packetizer->batch_offset == packetizer->map_offset &&
+      packetizer->map_size - packetizer->map_offset >= packet_size) {
+    const MpegTSPacketizerPacketDesc *desc =
+        &packetizer->batch[packetizer->batch_pos];
+
+    if (MPEGTS_BIT_IS_SET (is_pes, desc->pid) ||
+        MPEGTS_BIT_IS_SET (known_psi, desc->pid) ||
+        FLAGS_HAS_AFC (desc->scram_afc_cc))
+      break;
+
+    packetizer->batch_pos++;
+    packetizer->batch_offset += packet_size;
+    packetizer->map_offset += packet_size;
+    packetizer->offset += packet_size;
+    skipped++;
+  }
+
+  if (skipped) {
+    GST_LOG ("skipped %u packets", skipped);
+    if (packetizer->map_size - packetizer->map_offset < packet_size)
+      mpegts_packetizer_flush_bytes (packetizer, packetizer->map_offset);
+  }
+
+  return skipped;
+}
+
 gboolean
 mpegts_packetizer_has_packets (MpegTSPacketizer2 * packetizer)
 {
@@ -945,7 +1183,7 @@ mpegts_packetizer_push_section (MpegTSPacketizer2 * packetizer,
   packet_cc = FLAGS_CONTINUITY_COUNTER (packet->scram_afc_cc);
 
   /* Get our filter */
-  stream = packetizer->streams[packet->pid];
+  stream = packetizer->pids[packet->pid].stream;
   if (G_UNLIKELY (stream == NULL)) {
     if (!packet->payload_unit_start_indicator) {
       /* Early exit (we need to start with a section start) */
@@ -953,7 +1191,7 @@ mpegts_packetizer_push_section (MpegTSPacketizer2 * packetizer,
       goto out;
     }
     stream = mpegts_packetizer_stream_new (packet->pid);
-    packetizer->streams[packet->pid] = stream;
+    packetizer->pids[packet->pid].stream = stream;
   }
 
   GST_MEMDUMP ("Full packet data", packet->data,
@@ -1097,6 +1335,7 @@ section_start:
               gst_mpegts_section_new (packet->pid, g_memdup (data,
                       section_length), section_length))) {
         GST_DEBUG ("PID 0x%04x Short section complete !", packet->pid);
+        packetizer->sections_parsed++;
         section->offset = packet->offset;
         if (res)
           others = g_list_append (others, section);
@@ -1175,6 +1414,7 @@ section_start:
         ("PID 0x%04x Already processed table_id:0x%02x subtable_extension:0x%04x, version_number:%d, section_number:%d",
         packet->pid, table_id, subtable_extension, version_number,
         section_number);
+    packetizer->sections_skipped++;
     /* skip data and see if we have more sections after */
     data = data_start + to_read;
     if (data == packet->data_end || *data == 0xff)
@@ -66,6 +66,23 @@ G_BEGIN_DECLS
 typedef struct _MpegTSPacketizer2 MpegTSPacketizer2;
 typedef struct _MpegTSPacketizer2Class MpegTSPacketizer2Class;
 
+/* Maximum number of packet headers validated and classified in one go */
+#define MPEGTS_PACKETIZER_BATCH_SIZE 64
+
+/* MpegTSPacketizerPacketDesc: Compact description of a packet header,
+ * as extracted by the batched header scanner.
+ * The layout (4 bytes, no padding) is relied upon by the SIMD kernels */
+typedef struct
+{
+  guint16 pid;
+  /* transport_error_indicator (0x80) and
+   * payload_unit_start_indicator (0x40) */
+  guint8  flags;
+  /* transport_scrambling_control, adaptation_field_control and
+   * continuity_counter, as in MpegTSPacketizerPacket */
+  guint8  scram_afc_cc;
+} MpegTSPacketizerPacketDesc;
+
 typedef struct
 {
   guint16 pid;
@@ -85,7 +102,9 @@ typedef struct
   guint8  section_number;
   guint8  last_section_number;
 
-  GSList *subtables;
+  /* MpegTSPacketizerStreamSubtable hashed by
+   * MPEGTS_SUBTABLE_KEY (table_id, subtable_extension) */
+  GHashTable *subtables;
 
   /* Upstream offset of the data contained in the section */
   guint64 offset;
@@ -241,15 +260,25 @@ typedef struct _MpegTSPCR
   PCROffsetCurrent *current;
 } MpegTSPCR;
 
+/* MpegTSPacketizerPid: Per-PID dispatch entry.
+ * The table of those is indexed directly by PID, so that each packet
+ * is routed to its section filter and PCR observations in O(1) */
+typedef struct
+{
+  /* Section filter (only on PSI PIDs) */
+  MpegTSPacketizerStream *stream;
+  /* PCR observations (only on PCR PIDs) */
+  MpegTSPCR *pcrtable;
+} MpegTSPacketizerPid;
+
 struct _MpegTSPacketizer2 {
   GObject     parent;
 
   GMutex group_lock;
 
   GstAdapter *adapter;
-  /* streams hashed by pid */
-  /* FIXME : be more memory efficient (see how it's done in mpegtsbase) */
-  MpegTSPacketizerStream **streams;
+  /* 0x2000 entries, indexed by pid */
+  MpegTSPacketizerPid *pids;
   gboolean    disposed;
   guint16     packet_size;
 
@@ -268,6 +297,9 @@ struct _MpegTSPacketizer2 {
   gsize map_offset;
   gsize map_size;
   gboolean need_sync;
+  /* Buffer holding the mapped data, only retrieved on demand by
+   * mpegts_packetizer_get_buffer_region() */
+  GstBuffer *map_buffer;
 
   /* Reference offset */
   guint64 refoffset;
@@ -278,11 +310,22 @@ struct _MpegTSPacketizer2 {
   /* Last inputted timestamp */
   GstClockTime last_in_time;
 
-  /* offset to observations table */
-  guint8 pcrtablelut[0x2000];
+  /* All PCR observations, also referenced from pids[] */
   MpegTSPCR *observations[MAX_PCR_OBS_CHANNELS];
   guint8 lastobsid;
   GstClockTime pcr_discont_threshold;
+
+  /* Number of sections assembled, and of already seen sections skipped */
+  guint64 sections_parsed;
+  guint64 sections_skipped;
+
+  /* Batched header classification of the mapped data.
+   * batch[batch_pos] describes the packet located at map_data + batch_offset,
+   * the following entries the packets right after it */
+  MpegTSPacketizerPacketDesc batch[MPEGTS_PACKETIZER_BATCH_SIZE];
+  gsize batch_offset;
+  guint batch_pos;
+  guint batch_len;
 };
 
 struct _MpegTSPacketizer2Class {
@@ -325,6 +368,9 @@ typedef struct
   guint8   seen_section[32];
 } MpegTSPacketizerStreamSubtable;
 
+#define MPEGTS_SUBTABLE_KEY(table_id, ext) \
+  GUINT_TO_POINTER (((guint) (table_id) << 16) | (ext))
+
 #define MPEGTS_BIT_SET(field, offs)    ((field)[(offs) >> 3] |=  (1 << ((offs) & 0x7)))
 #define MPEGTS_BIT_UNSET(field, offs)  ((field)[(offs) >> 3] &= ~(1 << ((offs) & 0x7)))
 #define MPEGTS_BIT_IS_SET(field, offs) ((field)[(offs) >> 3] &   (1 << ((offs) & 0x7)))
@@ -348,6 +394,10 @@ G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet(MpegTSPacketizer2 * packetizer);
 G_GNUC_INTERNAL void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetizer,
 				     MpegTSPacketizerPacket *packet);
+G_GNUC_INTERNAL guint mpegts_packetizer_skip_packets (MpegTSPacketizer2 *packetizer,
+				     const guint8 *is_pes, const guint8 *known_psi);
+G_GNUC_INTERNAL GstBuffer *mpegts_packetizer_get_buffer_region (MpegTSPacketizer2 *packetizer,
+				     const guint8 *data, gsize size);
 G_GNUC_INTERNAL void mpegts_packetizer_remove_stream(MpegTSPacketizer2 *packetizer,
   gint16 pid);
 
@@ -70,6 +70,11 @@
  */
 #define SEEK_TIMESTAMP_OFFSET (2500 * GST_MSECOND)
 
+/* Data stays at most one second in the T-STD buffers (ISO/IEC 13818-1
+ * 2.4.2.3), which bounds how late after its PCR an access unit is presented
+ */
+#define MAX_PTS_PCR_DELAY GST_SECOND
+
 #define GST_FLOW_REWINDING GST_FLOW_CUSTOM_ERROR
 
 /* latency in msecs */
@@ -82,6 +87,11 @@
  * up to this size */
 #define MAX_PES_PAYLOAD (32 * 1024 * 1024)
 
+#define DEFAULT_ZERO_COPY FALSE
+#define DEFAULT_PROGRAM_WORKER FALSE
+#define DEFAULT_WORKER_MAX_BUFFERS 64
+#define DEFAULT_INDEX_LOCATION NULL
+
 GST_DEBUG_CATEGORY_STATIC (ts_demux_debug);
 #define GST_CAT_DEFAULT ts_demux_debug
 
@@ -168,10 +178,14 @@ struct _TSDemuxStream
   /* Data being reconstructed (allocated) */
   guint8 *data;
 
+  /* Data being reconstructed by reference to the input buffers
+   * (zero-copy mode, exclusive with ->data) */
+  GstBuffer *buffer;
+
   /* Size of data being reconstructed (if known, else 0) */
   guint expected_size;
 
-  /* Amount of bytes in current ->data */
+  /* Amount of bytes in current ->data or ->buffer */
   guint current_size;
   /* Size of ->data */
   guint allocated_size;
@@ -290,6 +304,11 @@ enum
   PROP_PROGRAM_NUMBER,
   PROP_EMIT_STATS,
   PROP_LATENCY,
+  PROP_ZERO_COPY,
+  PROP_PROGRAM_WORKER,
+  PROP_WORKER_MAX_BUFFERS,
+  PROP_WORKER_STATS,
+  PROP_INDEX_LOCATION,
   /* FILL ME */
 };
 
@@ -350,13 +369,334 @@ _extra_init (void)
 G_DEFINE_TYPE_WITH_CODE (GstTSDemux, gst_ts_demux, GST_TYPE_MPEGTS_BASE,
     _extra_init ());
 
+/* Output worker
+ *
+ * In program-worker mode, the buffers and serialized events of the current
+ * program's pads are not pushed from the streaming thread but handed to a
+ * worker thread through a bounded queue. Parsing and PES reassembly then run
+ * concurrently with the downstream processing of the program.
+ */
+struct _TSDemuxOutputWorker
+{
+  GstTSDemux *demux;
+
+  GstDataQueue *queue;
+  GstTask *task;
+  GRecMutex task_lock;
+
+  /* protected by lock */
+  GMutex lock;
+  GCond cond;
+  /* Number of items queued or being pushed */
+  guint pending;
+  gboolean flushing;
+  /* Last combined flow return of the worker pushes */
+  GstFlowReturn srcresult;
+
+  /* Statistics (protected by lock) */
+  gint program_number;
+  guint64 n_pushed;
+  guint max_level;
+  GstClockTime total_latency;
+  GstClockTime max_latency;
+};
+
+typedef struct
+{
+  GstDataQueueItem item;
+
+  GstPad *pad;
+  /* Monotonic time at which the item was queued (in us) */
+  gint64 queued_time;
+} TSDemuxOutputItem;
+
+static void
+gst_ts_demux_output_item_free (TSDemuxOutputItem * oitem)
+{
+  if (oitem->item.object)
+    gst_mini_object_unref (oitem->item.object);
+  gst_object_unref (oitem->pad);
+  g_slice_free (TSDemuxOutputItem, oitem);
+}
+
+static gboolean
+gst_ts_demux_output_worker_check_full (GstDataQueue * queue, guint visible,
+    guint bytes, guint64 time, gpointer checkdata)
+{
+  GstTSDemux *demux = (GstTSDemux *) checkdata;
+
+  return visible >= demux->worker_max_buffers;
+}
+
+static void
+gst_ts_demux_output_worker_loop (TSDemuxOutputWorker * worker)
+{
+  GstTSDemux *demux = worker->demux;
+  GstDataQueueItem *item;
+  TSDemuxOutputItem *oitem;
+  GstMiniObject *obj;
+  GstDataQueueSize level;
+  GstClockTime latency;
+  GstFlowReturn res = GST_FLOW_OK;
+
+  gst_data_queue_get_level (worker->queue, &level);
+  if (!gst_data_queue_pop (worker->queue, &item)) {
+    GST_DEBUG_OBJECT (demux, "output worker flushing, pausing");
+    gst_task_pause (worker->task);
+    return;
+  }
+
+  oitem = (TSDemuxOutputItem *) item;
+  obj = item->object;
+  item->object = NULL;
+  latency = (g_get_monotonic_time () - oitem->queued_time) * GST_USECOND;
+
+  if (GST_IS_BUFFER (obj)) {
+    res = gst_pad_push (oitem->pad, GST_BUFFER_CAST (obj));
+  } else if (GST_IS_BUFFER_LIST (obj)) {
+    res = gst_pad_push_list (oitem->pad, GST_BUFFER_LIST_CAST (obj));
+  } else {
+    gst_pad_push_event (oitem->pad, GST_EVENT_CAST (obj));
+    obj = NULL;
+  }
+
+  if (obj) {
+    GST_OBJECT_LOCK (demux);
+    res = gst_flow_combiner_update_pad_flow (demux->flowcombiner, oitem->pad,
+        res);
+    GST_OBJECT_UNLOCK (demux);
+  }
+
+  g_mutex_lock (&worker->lock);
+  if (obj) {
+    worker->srcresult = res;
+    worker->n_pushed++;
+    worker->total_latency += latency;
+    worker->max_latency = MAX (worker->max_latency, latency);
+    worker->max_level = MAX (worker->max_level, level.visible);
+  }
+  if (--worker->pending == 0)
+    g_cond_broadcast (&worker->cond);
+  g_mutex_unlock (&worker->lock);
+
+  gst_ts_demux_output_item_free (oitem);
+}
+
+static TSDemuxOutputWorker *
+gst_ts_demux_output_worker_new (GstTSDemux * demux)
+{
+  TSDemuxOutputWorker *worker = g_new0 (TSDemuxOutputWorker, 1);
+
+  worker->demux = demux;
+  worker->queue = gst_data_queue_new (gst_ts_demux_output_worker_check_full,
+      NULL, NULL, demux);
+  g_mutex_init (&worker->lock);
+  g_cond_init (&worker->cond);
+  g_rec_mutex_init (&worker->task_lock);
+  worker->srcresult = GST_FLOW_OK;
+  worker->program_number = -1;
+
+  worker->task = gst_task_new ((GstTaskFunction)
+      gst_ts_demux_output_worker_loop, worker, NULL);
+  gst_task_set_lock (worker->task, &worker->task_lock);
+  gst_object_set_name (GST_OBJECT_CAST (worker->task), "tsdemux:worker");
+  gst_task_start (worker->task);
+
+  return worker;
+}
+
+/* Drops all queued items and makes pushes fail until flushing is unset */
+static void
+gst_ts_demux_output_worker_set_flushing (TSDemuxOutputWorker * worker,
+    gboolean flushing)
+{
+  if (flushing) {
+    g_mutex_lock (&worker->lock);
+    worker->flushing = TRUE;
+    worker->srcresult = GST_FLOW_FLUSHING;
+    g_cond_broadcast (&worker->cond);
+    g_mutex_unlock (&worker->lock);
+
+    gst_data_queue_set_flushing (worker->queue, TRUE);
+    gst_data_queue_flush (worker->queue);
+  } else {
+    /* Wait for the worker to be done with its current item. FLUSH_STOP can
+     * come without FLUSH_START, so wake it up if it is waiting for data */
+    gst_data_queue_set_flushing (worker->queue, TRUE);
+    gst_task_pause (worker->task);
+    g_rec_mutex_lock (&worker->task_lock);
+    g_rec_mutex_unlock (&worker->task_lock);
+    gst_data_queue_flush (worker->queue);
+
+    g_mutex_lock (&worker->lock);
+    worker->flushing = FALSE;
+    worker->pending = 0;
+    worker->srcresult = GST_FLOW_OK;
+    g_mutex_unlock (&worker->lock);
+
+    gst_data_queue_set_flushing (worker->queue, FALSE);
+    gst_task_start (worker->task);
+  }
+}
+
+static void
+gst_ts_demux_output_worker_free (TSDemuxOutputWorker * worker)
+{
+  gst_ts_demux_output_worker_set_flushing (worker, TRUE);
+  gst_task_stop (worker->task);
+  g_rec_mutex_lock (&worker->task_lock);
+  g_rec_mutex_unlock (&worker->task_lock);
+  gst_task_join (worker->task);
+  gst_object_unref (worker->task);
+  g_rec_mutex_clear (&worker->task_lock);
+
+  gst_data_queue_flush (worker->queue);
+  g_object_unref (worker->queue);
+  g_mutex_clear (&worker->lock);
+  g_cond_clear (&worker->cond);
+  g_free (worker);
+}
+
+/* Queues @obj (a buffer, buffer list or serialized event) to be pushed on
+ * @pad, blocking while the queue is full. Returns the last combined flow
+ * return of the worker */
+static GstFlowReturn
+gst_ts_demux_output_worker_push (TSDemuxOutputWorker * worker, GstPad * pad,
+    GstMiniObject * obj)
+{
+  TSDemuxOutputItem *oitem;
+  GstFlowReturn res;
+
+  oitem = g_slice_new0 (TSDemuxOutputItem);
+  oitem->item.object = obj;
+  oitem->item.destroy = (GDestroyNotify) gst_ts_demux_output_item_free;
+  oitem->pad = gst_object_ref (pad);
+  oitem->queued_time = g_get_monotonic_time ();
+  if (GST_IS_BUFFER (obj)) {
+    oitem->item.visible = TRUE;
+    oitem->item.size = gst_buffer_get_size (GST_BUFFER_CAST (obj));
+  } else if (GST_IS_BUFFER_LIST (obj)) {
+    oitem->item.visible = TRUE;
+    oitem->item.size =
+        gst_buffer_list_calculate_size (GST_BUFFER_LIST_CAST (obj));
+  }
+
+  g_mutex_lock (&worker->lock);
+  worker->pending++;
+  g_mutex_unlock (&worker->lock);
+
+  if (!gst_data_queue_push (worker->queue, (GstDataQueueItem *) oitem)) {
+    gst_ts_demux_output_item_free (oitem);
+    g_mutex_lock (&worker->lock);
+    if (--worker->pending == 0)
+      g_cond_broadcast (&worker->cond);
+    g_mutex_unlock (&worker->lock);
+    return GST_FLOW_FLUSHING;
+  }
+
+  g_mutex_lock (&worker->lock);
+  res = worker->srcresult;
+  g_mutex_unlock (&worker->lock);
+
+  return res;
+}
+
+/* Waits until everything queued so far was pushed downstream */
+static void
+gst_ts_demux_output_worker_drain (TSDemuxOutputWorker * worker)
+{
+  g_mutex_lock (&worker->lock);
+  while (worker->pending > 0 && !worker->flushing)
+    g_cond_wait (&worker->cond, &worker->lock);
+  g_mutex_unlock (&worker->lock);
+}
+
+static GstStructure *
+gst_ts_demux_output_worker_get_stats (TSDemuxOutputWorker * worker)
+{
+  GstDataQueueSize level;
+  GstStructure *s;
+
+  gst_data_queue_get_level (worker->queue, &level);
+
+  g_mutex_lock (&worker->lock);
+  s = gst_structure_new ("application/x-tsdemux-worker-stats",
+      "program-number", G_TYPE_INT, worker->program_number,
+      "pushed", G_TYPE_UINT64, worker->n_pushed,
+      "queued", G_TYPE_UINT, level.visible,
+      "max-queued", G_TYPE_UINT, worker->max_level,
+      "average-latency", G_TYPE_UINT64, worker->n_pushed ?
+      worker->total_latency / worker->n_pushed : (guint64) 0,
+      "max-latency", G_TYPE_UINT64, worker->max_latency, NULL);
+  g_mutex_unlock (&worker->lock);
+
+  return s;
+}
+
+static void
+gst_ts_demux_output_worker_reset_stats (TSDemuxOutputWorker * worker,
+    gint program_number)
+{
+  g_mutex_lock (&worker->lock);
+  worker->program_number = program_number;
+  worker->n_pushed = 0;
+  worker->max_level = 0;
+  worker->total_latency = 0;
+  worker->max_latency = 0;
+  g_mutex_unlock (&worker->lock);
+}
+
+/* Pushes @obj (a buffer or buffer list) on @stream's pad, directly or through
+ * the output worker */
+static inline GstFlowReturn
+gst_ts_demux_stream_push (GstTSDemux * demux, TSDemuxStream * stream,
+    GstMiniObject * obj)
+{
+  if (demux->worker)
+    return gst_ts_demux_output_worker_push (demux->worker, stream->pad, obj);
+
+  if (GST_IS_BUFFER_LIST (obj))
+    return gst_pad_push_list (stream->pad, GST_BUFFER_LIST_CAST (obj));
+
+  return gst_pad_push (stream->pad, GST_BUFFER_CAST (obj));
+}
+
+/* Pushes @event on @stream's pad, through the output worker if it is
+ * serialized with the data flow */
+static inline void
+gst_ts_demux_stream_push_event (GstTSDemux * demux, TSDemuxStream * stream,
+    GstEvent * event)
+{
+  if (demux->worker && GST_EVENT_IS_SERIALIZED (event) &&
+      GST_EVENT_TYPE (event) != GST_EVENT_FLUSH_STOP)
+    gst_ts_demux_output_worker_push (demux->worker, stream->pad,
+        GST_MINI_OBJECT_CAST (event));
+  else
+    gst_pad_push_event (stream->pad, event);
+}
+
 static void
 gst_ts_demux_dispose (GObject * object)
 {
   GstTSDemux *demux = GST_TS_DEMUX_CAST (object);
 
+  if (demux->worker) {
+    TSDemuxOutputWorker *worker = demux->worker;
+
+    GST_OBJECT_LOCK (demux);
+    demux->worker = NULL;
+    GST_OBJECT_UNLOCK (demux);
+    gst_ts_demux_output_worker_free (worker);
+  }
   gst_flow_combiner_free (demux->flowcombiner);
 
+  g_free (demux->index_location);
+  demux->index_location = NULL;
+  if (demux->index) {
+    mpegts_index_free (demux->index);
+    demux->index = NULL;
+  }
+
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
 
@@ -388,6 +728,81 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
           G_MAXINT, DEFAULT_LATENCY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstTSDemux:zero-copy:
+   *
+   * Assemble the output PES from regions of the input buffers instead of
+   * copying their payload. PES spanning more input regions than a #GstBuffer
+   * can hold memories, or that need to be inspected (keyframe search after
+   * seeks, Opus and JPEG 2000 access unit parsing) are still copied.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero copy",
+          "Output PES payload by reference to the input buffers when possible",
+          DEFAULT_ZERO_COPY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:program-worker:
+   *
+   * Push the output of the current program from a dedicated thread. Packets
+   * are parsed and assembled in the streaming thread while a worker pushes
+   * the resulting buffers and serialized events downstream, so that both can
+   * run concurrently. Takes effect when the next program is started.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_PROGRAM_WORKER,
+      g_param_spec_boolean ("program-worker", "Program worker",
+          "Push the program output from a dedicated thread",
+          DEFAULT_PROGRAM_WORKER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:worker-max-buffers:
+   *
+   * Maximum number of buffers (or buffer lists) queued for the program
+   * worker. The streaming thread blocks when the queue is full.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_WORKER_MAX_BUFFERS,
+      g_param_spec_uint ("worker-max-buffers", "Worker max buffers",
+          "Maximum number of buffers queued for the program worker", 1,
+          G_MAXUINT, DEFAULT_WORKER_MAX_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:worker-stats:
+   *
+   * Statistics of the program worker, or %NULL if there is none. The
+   * structure contains the program number, the number of buffers pushed,
+   * the current and maximum queue levels (in buffers) and the average and
+   * maximum time (in nanoseconds) buffers spent in the queue.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_WORKER_STATS,
+      g_param_spec_boxed ("worker-stats", "Worker statistics",
+          "Statistics of the program worker", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:index-location:
+   *
+   * Location of a seek index of the input file, as generated by
+   * gst-tsindex-1.0. When valid for the input, seeks are resolved to the
+   * preceding random access point (or PCR) of the index instead of being
+   * estimated from the PCR observations. The index is loaded on the first
+   * seek.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Location of the seek index of the input file",
+          DEFAULT_INDEX_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class = GST_ELEMENT_CLASS (klass);
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&video_template));
@@ -442,6 +857,21 @@ gst_ts_demux_reset (MpegTSBase * base)
     demux->previous_program = NULL;
   }
 
+  if (demux->worker) {
+    TSDemuxOutputWorker *worker = demux->worker;
+
+    GST_OBJECT_LOCK (demux);
+    demux->worker = NULL;
+    GST_OBJECT_UNLOCK (demux);
+    gst_ts_demux_output_worker_free (worker);
+  }
+
+  if (demux->index) {
+    mpegts_index_free (demux->index);
+    demux->index = NULL;
+  }
+  demux->index_checked = FALSE;
+
   demux->have_group_id = FALSE;
   demux->group_id = G_MAXUINT;
 
@@ -463,6 +893,9 @@ gst_ts_demux_init (GstTSDemux * demux)
   demux->requested_program_number = -1;
   demux->program_number = -1;
   demux->latency = DEFAULT_LATENCY;
+  demux->zero_copy = DEFAULT_ZERO_COPY;
+  demux->program_worker = DEFAULT_PROGRAM_WORKER;
+  demux->worker_max_buffers = DEFAULT_WORKER_MAX_BUFFERS;
   gst_ts_demux_reset (base);
 }
 
@@ -485,6 +918,19 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       demux->latency = g_value_get_int (value);
       break;
+    case PROP_ZERO_COPY:
+      demux->zero_copy = g_value_get_boolean (value);
+      break;
+    case PROP_PROGRAM_WORKER:
+      demux->program_worker = g_value_get_boolean (value);
+      break;
+    case PROP_WORKER_MAX_BUFFERS:
+      demux->worker_max_buffers = g_value_get_uint (value);
+      break;
+    case PROP_INDEX_LOCATION:
+      g_free (demux->index_location);
+      demux->index_location = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -506,6 +952,27 @@ gst_ts_demux_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_int (value, demux->latency);
       break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, demux->zero_copy);
+      break;
+    case PROP_PROGRAM_WORKER:
+      g_value_set_boolean (value, demux->program_worker);
+      break;
+    case PROP_WORKER_MAX_BUFFERS:
+      g_value_set_uint (value, demux->worker_max_buffers);
+      break;
+    case PROP_WORKER_STATS:
+      GST_OBJECT_LOCK (demux);
+      if (demux->worker)
+        g_value_take_boxed (value,
+            gst_ts_demux_output_worker_get_stats (demux->worker));
+      else
+        g_value_set_boxed (value, NULL);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_INDEX_LOCATION:
+      g_value_set_string (value, demux->index_location);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -645,6 +1112,51 @@ gst_ts_demux_srcpad_query (GstPad * pad, GstObject * parent, GstQuery * query)
 
 }
 
+/* Drops the PES payload collected so far */
+static inline void
+gst_ts_demux_stream_clear_data (TSDemuxStream * stream)
+{
+  g_free (stream->data);
+  stream->data = NULL;
+  gst_buffer_replace (&stream->buffer, NULL);
+}
+
+/* Makes @stream collect its PES payload into ->data, copying what was
+ * collected by reference so far. @extra is the amount of bytes about to be
+ * appended */
+static void
+gst_ts_demux_stream_flatten_data (TSDemuxStream * stream, guint extra)
+{
+  if (stream->buffer == NULL)
+    return;
+
+  GST_LOG ("copying %u bytes collected by reference", stream->current_size);
+  stream->allocated_size = MAX (8192, stream->current_size + extra);
+  if (stream->expected_size > stream->allocated_size)
+    stream->allocated_size = stream->expected_size;
+  stream->data = g_malloc (stream->allocated_size);
+  gst_buffer_extract (stream->buffer, 0, stream->data, stream->current_size);
+  gst_buffer_unref (stream->buffer);
+  stream->buffer = NULL;
+}
+
+/* Returns a buffer with the PES payload collected so far */
+static inline GstBuffer *
+gst_ts_demux_stream_take_data (TSDemuxStream * stream)
+{
+  GstBuffer *buffer;
+
+  if (stream->buffer) {
+    buffer = stream->buffer;
+    stream->buffer = NULL;
+  } else {
+    buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+    stream->data = NULL;
+  }
+
+  return buffer;
+}
+
 static void
 clear_simple_buffer (SimpleBuffer * sbuf)
 {
@@ -847,6 +1359,87 @@ gst_ts_demux_adjust_seek_offset_for_keyframe (TSDemuxStream * stream,
   return TRUE;
 }
 
+/* Returns the seek index, loading it if needed */
+static MpegTSIndex *
+gst_ts_demux_get_index (GstTSDemux * demux)
+{
+  MpegTSBase *base = (MpegTSBase *) demux;
+  GError *err = NULL;
+  gint64 size;
+
+  if (demux->index_checked)
+    return demux->index;
+  demux->index_checked = TRUE;
+
+  if (demux->index_location == NULL)
+    return NULL;
+
+  demux->index = mpegts_index_load (demux->index_location, &err);
+  if (demux->index == NULL) {
+    GST_WARNING_OBJECT (demux, "Failed to load index: %s", err->message);
+    g_clear_error (&err);
+    return NULL;
+  }
+
+  /* Make sure the index was built for this file */
+  if (gst_pad_peer_query_duration (base->sinkpad, GST_FORMAT_BYTES, &size) &&
+      size != mpegts_index_get_file_size (demux->index)) {
+    GST_WARNING_OBJECT (demux, "Index is for a file of %" G_GUINT64_FORMAT
+        " bytes, ignoring it", mpegts_index_get_file_size (demux->index));
+    mpegts_index_free (demux->index);
+    demux->index = NULL;
+    return NULL;
+  }
+
+  GST_DEBUG_OBJECT (demux, "Loaded index with %u entries",
+      mpegts_index_get_n_entries (demux->index));
+
+  return demux->index;
+}
+
+/* Finds the offset to resume from to reach the output time @target with the
+ * seek index. That is the earliest of the random access points of all
+ * streams presented before @target or, if the program has none, the last
+ * indexed PCR before the data presented at @target */
+static guint64
+gst_ts_demux_index_seek_offset (GstTSDemux * demux, GstClockTime target)
+{
+  MpegTSIndex *index = gst_ts_demux_get_index (demux);
+  MpegTSIndexEntry entry;
+  GstClockTime index_time;
+  guint64 offset = -1;
+  GList *tmp;
+
+  if (index == NULL)
+    return -1;
+
+  /* Output times are PTS, on the timeline of the PCRs the index stores.
+   * Random access points are stamped with the PCR preceding them, up to
+   * MAX_PTS_PCR_DELAY before their PTS, so look up that much earlier to
+   * never resume past @target */
+  if (target >= MAX_PTS_PCR_DELAY)
+    index_time = target - MAX_PTS_PCR_DELAY;
+  else
+    index_time = 0;
+
+  for (tmp = demux->program->stream_list; tmp; tmp = tmp->next) {
+    MpegTSBaseStream *stream = tmp->data;
+
+    if (mpegts_index_lookup (index, stream->pid, MPEGTS_INDEX_ENTRY_KEYFRAME,
+            index_time, &entry) && entry.offset < offset)
+      offset = entry.offset;
+  }
+
+  if (offset == -1 && mpegts_index_lookup (index, demux->program->pcr_pid,
+          MPEGTS_INDEX_ENTRY_PCR, index_time, &entry))
+    offset = entry.offset;
+
+  GST_DEBUG_OBJECT (demux, "Index offset for %" GST_TIME_FORMAT " : %"
+      G_GINT64_FORMAT, GST_TIME_ARGS (index_time), (gint64) offset);
+
+  return offset;
+}
+
 static GstFlowReturn
 gst_ts_demux_do_seek (MpegTSBase * base, GstEvent * event)
 {
@@ -903,9 +1496,11 @@ gst_ts_demux_do_seek (MpegTSBase * base, GstEvent * event)
     else
       target = 0;
 
-    start_offset =
-        mpegts_packetizer_ts_to_offset (base->packetizer, target,
-        demux->program->pcr_pid);
+    start_offset = gst_ts_demux_index_seek_offset (demux, seeksegment.start);
+    if (start_offset == -1)
+      start_offset =
+          mpegts_packetizer_ts_to_offset (base->packetizer, target,
+          demux->program->pcr_pid);
     if (G_UNLIKELY (start_offset == -1)) {
       GST_WARNING ("Couldn't convert start position to an offset");
       goto done;
@@ -1019,6 +1614,13 @@ push_event (MpegTSBase * base, GstEvent * event)
     early_ret = TRUE;
   }
 
+  if (demux->worker) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_START)
+      gst_ts_demux_output_worker_set_flushing (demux->worker, TRUE);
+    else if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+      gst_ts_demux_output_worker_set_flushing (demux->worker, FALSE);
+  }
+
   if (G_UNLIKELY (demux->program == NULL)) {
     gst_event_unref (event);
     return early_ret;
@@ -1033,7 +1635,7 @@ push_event (MpegTSBase * base, GstEvent * event)
         gst_ts_demux_push_pending_data (demux, stream, NULL);
 
       gst_event_ref (event);
-      gst_pad_push_event (stream->pad, event);
+      gst_ts_demux_stream_push_event (demux, stream, event);
     }
   }
 
@@ -1817,8 +2419,11 @@ gst_ts_demux_stream_added (MpegTSBase * base, MpegTSBaseStream * bstream,
     /* Create the pad */
     if (bstream->stream_type != 0xff) {
       stream->pad = create_pad_for_stream (base, bstream, program);
-      if (stream->pad)
+      if (stream->pad) {
+        GST_OBJECT_LOCK (demux);
         gst_flow_combiner_add_pad (demux->flowcombiner, stream->pad);
+        GST_OBJECT_UNLOCK (demux);
+      }
     }
 
     if (base->mode != BASE_MODE_PUSHING
@@ -1870,20 +2475,25 @@ tsdemux_h264_parsing_info_clear (TSDemuxH264ParsingInfos * h264infos)
 static void
 gst_ts_demux_stream_removed (MpegTSBase * base, MpegTSBaseStream * bstream)
 {
+  GstTSDemux *demux = GST_TS_DEMUX_CAST (base);
   TSDemuxStream *stream = (TSDemuxStream *) bstream;
 
   if (stream->pad) {
-    gst_flow_combiner_remove_pad (GST_TS_DEMUX_CAST (base)->flowcombiner,
-        stream->pad);
+    GST_OBJECT_LOCK (demux);
+    gst_flow_combiner_remove_pad (demux->flowcombiner, stream->pad);
+    GST_OBJECT_UNLOCK (demux);
     if (stream->active) {
 
       if (gst_pad_is_active (stream->pad)) {
         /* Flush out all data */
         GST_DEBUG_OBJECT (stream->pad, "Flushing out pending data");
-        gst_ts_demux_push_pending_data ((GstTSDemux *) base, stream, NULL);
+        gst_ts_demux_push_pending_data (demux, stream, NULL);
 
         GST_DEBUG_OBJECT (stream->pad, "Pushing out EOS");
-        gst_pad_push_event (stream->pad, gst_event_new_eos ());
+        gst_ts_demux_stream_push_event (demux, stream, gst_event_new_eos ());
+        /* The worker must be done with the pad before it goes away */
+        if (demux->worker)
+          gst_ts_demux_output_worker_drain (demux->worker);
         gst_pad_set_active (stream->pad, FALSE);
       }
 
@@ -1929,8 +2539,7 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
 {
   GST_DEBUG ("flushing stream %p", stream);
 
-  g_free (stream->data);
-  stream->data = NULL;
+  gst_ts_demux_stream_clear_data (stream);
   stream->state = PENDING_PACKET_EMPTY;
   stream->expected_size = 0;
   stream->allocated_size = 0;
@@ -2016,7 +2625,8 @@ gst_ts_demux_update_program (MpegTSBase * base, MpegTSBaseProgram * program)
          * or serialized event (which means very late in case of subtitle streams),
          * and playsink waits for stream-start or another serialized event */
         GST_DEBUG_OBJECT (stream->pad, "sparse stream, pushing GAP event");
-        gst_pad_push_event (stream->pad, gst_event_new_gap (0, 0));
+        gst_ts_demux_stream_push_event (demux, stream,
+            gst_event_new_gap (0, 0));
       }
     }
   }
@@ -2040,6 +2650,16 @@ gst_ts_demux_program_started (MpegTSBase * base, MpegTSBaseProgram * program)
     demux->program_number = program->program_number;
     demux->program = program;
 
+    if (demux->program_worker && !demux->worker) {
+      GST_DEBUG_OBJECT (demux, "Starting program output worker");
+      GST_OBJECT_LOCK (demux);
+      demux->worker = gst_ts_demux_output_worker_new (demux);
+      GST_OBJECT_UNLOCK (demux);
+    }
+    if (demux->worker)
+      gst_ts_demux_output_worker_reset_stats (demux->worker,
+          program->program_number);
+
     /* Increment the program_generation counter */
     demux->program_generation = (demux->program_generation + 1) & 0xf;
 
@@ -2104,7 +2724,8 @@ gst_ts_demux_program_started (MpegTSBase * base, MpegTSBaseProgram * program)
          * or serialized event (which means very late in case of subtitle streams),
          * and playsink waits for stream-start or another serialized event */
         GST_DEBUG_OBJECT (stream->pad, "sparse stream, pushing GAP event");
-        gst_pad_push_event (stream->pad, gst_event_new_gap (0, 0));
+        gst_ts_demux_stream_push_event (demux, stream,
+            gst_event_new_gap (0, 0));
       }
     }
 
@@ -2388,15 +3009,25 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
   data += header.header_size;
   length -= header.header_size;
 
-  /* Create the output buffer */
-  if (stream->expected_size)
-    stream->allocated_size = MAX (stream->expected_size, length);
-  else
-    stream->allocated_size = MAX (8192, length);
+  g_assert (stream->data == NULL && stream->buffer == NULL);
 
-  g_assert (stream->data == NULL);
-  stream->data = g_malloc (stream->allocated_size);
-  memcpy (stream->data, data, length);
+  /* Reference the payload if it is bound to fit in a buffer's memories */
+  if (demux->zero_copy && (stream->expected_size == 0 ||
+          stream->expected_size <= gst_buffer_get_max_memory () * 184))
+    stream->buffer =
+        mpegts_packetizer_get_buffer_region (MPEG_TS_BASE_PACKETIZER (demux),
+        data, length);
+
+  if (stream->buffer == NULL) {
+    /* Create the output buffer */
+    if (stream->expected_size)
+      stream->allocated_size = MAX (stream->expected_size, length);
+    else
+      stream->allocated_size = MAX (8192, length);
+
+    stream->data = g_malloc (stream->allocated_size);
+    memcpy (stream->data, data, length);
+  }
   stream->current_size = length;
 
   stream->state = PENDING_PACKET_BUFFER;
@@ -2435,10 +3066,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
       if (packet->payload_unit_start_indicator) {
         /* A mismatch is fatal, except if this is the beginning of a new
          * frame (from which we can recover) */
-        if (G_UNLIKELY (stream->data)) {
-          g_free (stream->data);
-          stream->data = NULL;
-        }
+        gst_ts_demux_stream_clear_data (stream);
         stream->state = PENDING_PACKET_HEADER;
       } else {
         GST_WARNING ("CONTINUITY: Mismatch packet %d, stream %d",
@@ -2471,6 +3099,22 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_BUFFER:
     {
       GST_LOG ("BUFFER: appending data");
+      if (stream->buffer) {
+        if (G_LIKELY (gst_buffer_n_memory (stream->buffer) <
+                gst_buffer_get_max_memory ())) {
+          GstBuffer *region =
+              mpegts_packetizer_get_buffer_region (MPEG_TS_BASE_PACKETIZER
+              (demux), data, size);
+
+          if (G_LIKELY (region)) {
+            stream->buffer = gst_buffer_append (stream->buffer, region);
+            stream->current_size += size;
+            break;
+          }
+        }
+        /* Appending would make the buffer merge its memories, copy instead */
+        gst_ts_demux_stream_flatten_data (stream, size);
+      }
       if (G_UNLIKELY (stream->current_size + size > stream->allocated_size)) {
         GST_LOG ("resizing buffer");
         do {
@@ -2485,10 +3129,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_DISCONT:
     {
       GST_LOG ("DISCONT: not storing/pushing");
-      if (G_UNLIKELY (stream->data)) {
-        g_free (stream->data);
-        stream->data = NULL;
-      }
+      gst_ts_demux_stream_clear_data (stream);
       stream->continuity_counter = CONTINUITY_UNSET;
       break;
     }
@@ -2583,11 +3224,11 @@ push_new_segment:
     if (demux->segment_event) {
       GST_DEBUG_OBJECT (stream->pad, "Pushing newsegment event");
       gst_event_ref (demux->segment_event);
-      gst_pad_push_event (stream->pad, demux->segment_event);
+      gst_ts_demux_stream_push_event (demux, stream, demux->segment_event);
     }
 
     if (demux->global_tags) {
-      gst_pad_push_event (stream->pad,
+      gst_ts_demux_stream_push_event (demux, stream,
           gst_event_new_tag (gst_tag_list_ref (demux->global_tags)));
     }
 
@@ -2595,7 +3236,8 @@ push_new_segment:
     if (stream->taglist) {
       GST_DEBUG_OBJECT (stream->pad, "Sending tags %" GST_PTR_FORMAT,
           stream->taglist);
-      gst_pad_push_event (stream->pad, gst_event_new_tag (stream->taglist));
+      gst_ts_demux_stream_push_event (demux, stream,
+          gst_event_new_tag (stream->taglist));
       stream->taglist = NULL;
     }
 
@@ -2653,7 +3295,7 @@ gst_ts_demux_check_and_sync_streams (GstTSDemux * demux, GstClockTime time)
         calculate_and_push_newsegment (demux, ps, NULL);
 
       /* Now send gap event */
-      gst_pad_push_event (ps->pad, gst_event_new_gap (time, 0));
+      gst_ts_demux_stream_push_event (demux, ps, gst_event_new_gap (time, 0));
     }
 
     /* Update GAP tracking vars so we don't re-check this stream for a while */
@@ -2932,7 +3574,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
       "stream:%p, pid:0x%04x stream_type:%d state:%d", stream, bs->pid,
       bs->stream_type, stream->state);
 
-  if (G_UNLIKELY (stream->data == NULL)) {
+  if (G_UNLIKELY (stream->data == NULL && stream->buffer == NULL)) {
     GST_LOG ("stream->data == NULL");
     goto beach;
   }
@@ -2949,10 +3591,17 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
 
   if (G_UNLIKELY (demux->program == NULL)) {
     GST_LOG_OBJECT (demux, "No program");
-    g_free (stream->data);
+    gst_ts_demux_stream_clear_data (stream);
     goto beach;
   }
 
+  /* Keyframe scanning and access unit parsing need contiguous data */
+  if (stream->buffer && (stream->needs_keyframe ||
+          bs->stream_type == GST_MPEGTS_STREAM_TYPE_VIDEO_JP2K ||
+          (bs->stream_type == GST_MPEGTS_STREAM_TYPE_PRIVATE_PES_PACKETS &&
+              bs->registration_id == DRF_ID_OPUS)))
+    gst_ts_demux_stream_flatten_data (stream, 0);
+
   if (stream->needs_keyframe) {
     MpegTSBase *base = (MpegTSBase *) demux;
 
@@ -2982,7 +3631,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
           goto beach;
         }
       } else {
-        buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+        buffer = gst_ts_demux_stream_take_data (stream);
       }
 
       stream->seeked_pts = stream->pts;
@@ -2998,7 +3647,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
 
       stream->continuity_counter = CONTINUITY_UNSET;
       res = GST_FLOW_REWINDING;
-      g_free (stream->data);
+      gst_ts_demux_stream_clear_data (stream);
       goto beach;
     }
   } else {
@@ -3022,7 +3671,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         goto beach;
       }
     } else {
-      buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+      buffer = gst_ts_demux_stream_take_data (stream);
     }
 
     if (G_UNLIKELY (stream->pending_ts && !check_pending_buffers (demux))) {
@@ -3070,7 +3719,8 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         GST_BUFFER_FLAG_SET (pend->buffer, GST_BUFFER_FLAG_DISCONT);
       stream->discont = FALSE;
 
-      res = gst_pad_push (stream->pad, pend->buffer);
+      res = gst_ts_demux_stream_push (demux, stream,
+          GST_MINI_OBJECT_CAST (pend->buffer));
       stream->nb_out_buffers += 1;
       g_slice_free (PendingBuffer, pend);
     }
@@ -3129,17 +3779,21 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
   }
 
   if (buffer) {
-    res = gst_pad_push (stream->pad, buffer);
+    res = gst_ts_demux_stream_push (demux, stream,
+        GST_MINI_OBJECT_CAST (buffer));
     /* Record that a buffer was pushed */
     stream->nb_out_buffers += 1;
   } else {
     guint n = gst_buffer_list_length (buffer_list);
-    res = gst_pad_push_list (stream->pad, buffer_list);
+    res = gst_ts_demux_stream_push (demux, stream,
+        GST_MINI_OBJECT_CAST (buffer_list));
     /* Record that a buffer was pushed */
     stream->nb_out_buffers += n;
   }
   GST_DEBUG_OBJECT (stream->pad, "Returned %s", gst_flow_get_name (res));
-  res = gst_flow_combiner_update_flow (demux->flowcombiner, res);
+  /* The output worker already returns the combined flow */
+  if (!demux->worker)
+    res = gst_flow_combiner_update_flow (demux->flowcombiner, res);
   GST_DEBUG_OBJECT (stream->pad, "combined %s", gst_flow_get_name (res));
 
   /* GAP / sparse stream tracking */
@@ -3178,6 +3832,7 @@ beach:
       stream->expected_size -= stream->current_size;
   }
   stream->data = NULL;
+  gst_buffer_replace (&stream->buffer, NULL);
   stream->allocated_size = 0;
   stream->current_size = 0;
 
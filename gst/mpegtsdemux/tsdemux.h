@@ -32,6 +32,7 @@
 #include <gst/base/gstflowcombiner.h>
 #include "mpegtsbase.h"
 #include "mpegtspacketizer.h"
+#include "mpegtsindex.h"
 
 /* color specifications for JPEG 2000 stream over MPEG TS */
 typedef enum
@@ -63,6 +64,7 @@ G_BEGIN_DECLS
 #define GST_TS_DEMUX_CAST(obj) ((GstTSDemux*) obj)
 typedef struct _GstTSDemux GstTSDemux;
 typedef struct _GstTSDemuxClass GstTSDemuxClass;
+typedef struct _TSDemuxOutputWorker TSDemuxOutputWorker;
 
 struct _GstTSDemux
 {
@@ -77,6 +79,9 @@ struct _GstTSDemux
   guint program_number;
   gboolean emit_statistics;
   gint latency; /* latency in ms */
+  gboolean zero_copy; /* reference input buffers in output PES */
+  gboolean program_worker; /* push the program output from a worker thread */
+  guint worker_max_buffers;
 
   /*< private >*/
   gint program_generation; /* Incremented each time we switch program 0..15 */
@@ -99,8 +104,17 @@ struct _GstTSDemux
 
   GstFlowCombiner *flowcombiner;
 
+  /* Output worker of the current program (program-worker mode). The pointer
+   * is protected by the OBJECT_LOCK */
+  TSDemuxOutputWorker *worker;
+
   /* Used when seeking for a keyframe to go backward in the stream */
   guint64 last_seek_offset;
+
+  /* Seek index */
+  gchar *index_location;
+  MpegTSIndex *index;
+  gboolean index_checked;
 };
 
 struct _GstTSDemuxClass
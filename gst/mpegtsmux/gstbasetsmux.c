@@ -196,12 +196,18 @@ enum
   PROP_BITRATE,
   PROP_PCR_INTERVAL,
   PROP_SCTE_35_PID,
-  PROP_SCTE_35_NULL_INTERVAL
+  PROP_SCTE_35_NULL_INTERVAL,
+  PROP_ZERO_COPY,
+  PROP_CBR_STATS
 };
 
 #define DEFAULT_SCTE_35_PID 0
 
 #define BASETSMUX_DEFAULT_ALIGNMENT    -1
+#define BASETSMUX_DEFAULT_ZERO_COPY    FALSE
+
+/* Number of packets per output chunk when not aligning */
+#define BASETSMUX_UNALIGNED_CHUNK_PACKETS 32
 
 #define CLOCK_BASE 9LL
 #define CLOCK_FREQ (CLOCK_BASE * 10000) /* 90 kHz PTS clock */
@@ -291,6 +297,53 @@ gst_base_ts_mux_set_header_on_caps (GstBaseTsMux * mux)
   gst_caps_unref (caps);
 }
 
+static GstBufferPool *
+gst_base_ts_mux_create_pool (gsize size)
+{
+  GstBufferPool *pool = gst_buffer_pool_new ();
+  GstStructure *config;
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+  gst_buffer_pool_set_config (pool, config);
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  return pool;
+}
+
+static void
+gst_base_ts_mux_clear_pool (GstBufferPool ** pool)
+{
+  if (*pool) {
+    gst_buffer_pool_set_active (*pool, FALSE);
+    gst_object_unref (*pool);
+    *pool = NULL;
+  }
+}
+
+static void
+gst_base_ts_mux_clear_output (GstBaseTsMux * mux)
+{
+  if (mux->out_buffer) {
+    if (mux->out_map.memory) {
+      gst_buffer_unmap (mux->out_buffer, &mux->out_map);
+      mux->out_map.memory = NULL;
+    }
+    gst_buffer_unref (mux->out_buffer);
+    mux->out_buffer = NULL;
+  }
+  mux->out_offset = 0;
+  gst_buffer_replace (&mux->out_packet, NULL);
+
+  if (mux->out_list) {
+    gst_buffer_list_unref (mux->out_list);
+    mux->out_list = NULL;
+  }
+
+  gst_base_ts_mux_clear_pool (&mux->packet_pool);
+  gst_base_ts_mux_clear_pool (&mux->chunk_pool);
+}
+
 static gboolean
 steal_si_section (GstMpegtsSectionType * type, TsMuxSection * section,
     TsMux * mux)
@@ -318,8 +371,11 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
   mux->pending_key_unit_ts = GST_CLOCK_TIME_NONE;
   gst_event_replace (&mux->force_key_unit_event, NULL);
 
-  if (mux->out_adapter)
-    gst_adapter_clear (mux->out_adapter);
+  gst_base_ts_mux_clear_output (mux);
+
+  GST_OBJECT_LOCK (mux);
+  memset (&mux->cbr_stats, 0, sizeof (mux->cbr_stats));
+  GST_OBJECT_UNLOCK (mux);
 
   if (mux->tsmux) {
     if (mux->tsmux->si_sections)
@@ -338,7 +394,6 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
     gst_buffer_unref (buf);
 
   gst_event_replace (&mux->force_key_unit_event, NULL);
-  gst_buffer_replace (&mux->out_buffer, NULL);
 
   for (l = GST_ELEMENT (mux)->sinkpads; l; l = l->next) {
     gst_base_ts_mux_pad_reset (GST_BASE_TS_MUX_PAD (l->data));
@@ -368,6 +423,16 @@ release_buffer_cb (guint8 * data, void *user_data)
   stream_data_free ((StreamData *) user_data);
 }
 
+static void
+share_buffer_cb (GstBuffer * packet, void *user_data, gsize offset,
+    gsize size)
+{
+  StreamData *stream_data = (StreamData *) user_data;
+
+  gst_buffer_copy_into (packet, stream_data->buffer, GST_BUFFER_COPY_MEMORY,
+      offset, size);
+}
+
 static GstFlowReturn
 gst_base_ts_mux_create_stream (GstBaseTsMux * mux, GstBaseTsMuxPad * ts_pad)
 {
@@ -670,6 +735,10 @@ gst_base_ts_mux_create_stream (GstBaseTsMux * mux, GstBaseTsMuxPad * ts_pad)
     ts_pad->stream->opus_channel_config_code = opus_channel_config_code;
 
     tsmux_stream_set_buffer_release_func (ts_pad->stream, release_buffer_cb);
+    /* The m2ts mode needs to rewrite complete packets */
+    if (mux->zero_copy &&
+        mux->packet_size == GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH)
+      tsmux_stream_set_buffer_share_func (ts_pad->stream, share_buffer_cb);
     tsmux_program_add_stream (ts_pad->prog, ts_pad->stream);
 
     ret = GST_FLOW_OK;
@@ -804,7 +873,8 @@ new_packet_common_init (GstBaseTsMux * mux, GstBuffer * buf, guint8 * data,
         hbuf = gst_buffer_new_and_alloc (len);
         gst_buffer_fill (hbuf, 0, data, len);
       } else {
-        hbuf = gst_buffer_copy (buf);
+        /* Deep copy, the packet memory is recycled */
+        hbuf = gst_buffer_copy_deep (buf);
       }
       GST_LOG_OBJECT (mux,
           "Collecting packet with pid 0x%04x into streamheaders", pid);
@@ -854,112 +924,298 @@ finish_buffer_list (GstBaseTsMux * mux, GstBufferList * list)
   return ret;
 }
 
-static GstFlowReturn
-gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
+static gint
+gst_base_ts_mux_get_alignment (GstBaseTsMux * mux)
 {
-  GstBufferList *buffer_list;
-  gint align = mux->alignment;
-  gint av, packet_size;
+  if (mux->alignment < 0)
+    return mux->automatic_alignment;
 
-  packet_size = mux->packet_size;
+  return mux->alignment;
+}
 
-  if (align < 0)
-    align = mux->automatic_alignment;
+/* Moves the chunk being filled to the list of chunks to output */
+static void
+gst_base_ts_mux_close_chunk (GstBaseTsMux * mux)
+{
+  if (mux->out_buffer == NULL)
+    return;
 
-  av = gst_adapter_available (mux->out_adapter);
-  GST_LOG_OBJECT (mux, "align %d, av %d", align, av);
+  /* The spare packet must not point to the chunk anymore */
+  if (mux->out_packet)
+    gst_buffer_remove_all_memory (mux->out_packet);
 
-  if (av == 0)
-    return GST_FLOW_OK;
+  if (mux->out_map.memory) {
+    gst_buffer_unmap (mux->out_buffer, &mux->out_map);
+    mux->out_map.memory = NULL;
+    gst_buffer_set_size (mux->out_buffer, mux->out_offset);
+  }
+
+  if (mux->out_list == NULL)
+    mux->out_list = gst_buffer_list_new ();
+  gst_buffer_list_add (mux->out_list, mux->out_buffer);
 
-  /* no alignment, just push all available data */
-  if (align == 0) {
-    buffer_list = gst_adapter_take_buffer_list (mux->out_adapter, av);
-    return finish_buffer_list (mux, buffer_list);
+  mux->out_buffer = NULL;
+  mux->out_offset = 0;
+}
+
+/* Fills the chunk being filled with null packets, up to @align packets */
+static void
+gst_base_ts_mux_pad_chunk (GstBaseTsMux * mux, gint align)
+{
+  gsize packet_size = mux->packet_size;
+  gsize missing = align * packet_size - mux->out_offset;
+  GstMemory *mem = NULL;
+  GstMapInfo map;
+  guint8 *data;
+  guint32 header;
+  gint dummy;
+
+  if (mux->out_map.memory) {
+    data = mux->out_map.data + mux->out_offset;
+    header = GST_READ_UINT32_BE (data - packet_size);
+  } else {
+    guint8 last[4];
+
+    /* shared chunk, append a memory with the null packets */
+    gst_buffer_extract (mux->out_buffer, mux->out_offset - packet_size, last,
+        4);
+    header = GST_READ_UINT32_BE (last);
+
+    mem = gst_allocator_alloc (NULL, missing, NULL);
+    gst_memory_map (mem, &map, GST_MAP_WRITE);
+    data = map.data;
   }
 
-  align *= packet_size;
+  dummy = missing / packet_size;
+  GST_LOG_OBJECT (mux, "adding %d null packets", dummy);
 
-  if (!force && align > av)
-    return GST_FLOW_OK;
+  for (; dummy > 0; dummy--) {
+    gint offset;
 
-  buffer_list = gst_buffer_list_new_sized ((av / align) + 1);
+    if (packet_size > GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH) {
+      GST_WRITE_UINT32_BE (data, header);
+      /* simply increase header a bit and never mind too much */
+      header++;
+      offset = 4;
+    } else {
+      offset = 0;
+    }
+    GST_WRITE_UINT8 (data + offset, TSMUX_SYNC_BYTE);
+    /* null packet PID */
+    GST_WRITE_UINT16_BE (data + offset + 1, 0x1FFF);
+    /* no adaptation field exists | continuity counter undefined */
+    GST_WRITE_UINT8 (data + offset + 3, 0x10);
+    /* payload */
+    memset (data + offset + 4, 0, GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH - 4);
+    data += packet_size;
+  }
 
-  GST_LOG_OBJECT (mux, "aligning to %d bytes", align);
-  while (align <= av) {
-    GstBuffer *buf;
-    GstClockTime pts;
+  if (mem) {
+    gst_memory_unmap (mem, &map);
+    gst_buffer_append_memory (mux->out_buffer, mem);
+  }
 
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_adapter_take_buffer (mux->out_adapter, align);
+  mux->out_offset += missing;
+}
 
-    GST_BUFFER_PTS (buf) = pts;
+static GstFlowReturn
+gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
+{
+  GstBufferList *buffer_list;
+  gint align = gst_base_ts_mux_get_alignment (mux);
 
-    gst_buffer_list_add (buffer_list, buf);
-    av -= align;
+  if (mux->tsmux) {
+    GST_OBJECT_LOCK (mux);
+    tsmux_get_cbr_stats (mux->tsmux, &mux->cbr_stats);
+    GST_OBJECT_UNLOCK (mux);
   }
 
-  if (av > 0 && force) {
-    GstBuffer *buf;
-    GstClockTime pts;
-    guint8 *data;
-    guint32 header;
-    gint dummy;
-    GstMapInfo map;
+  GST_LOG_OBJECT (mux, "align %d, %u complete chunks, %" G_GSIZE_FORMAT
+      " pending bytes", align, mux->out_list ?
+      gst_buffer_list_length (mux->out_list) : 0, mux->out_offset);
+
+  /* The chunk being filled is only output as is when not aligning, or padded
+   * with null packets when draining */
+  if (mux->out_buffer && mux->out_offset > 0 && (align == 0 || force)) {
+    if (align > 0) {
+      GST_LOG_OBJECT (mux, "handling %" G_GSIZE_FORMAT " leftover bytes",
+          mux->out_offset);
+      gst_base_ts_mux_pad_chunk (mux, align);
+    }
+    gst_base_ts_mux_close_chunk (mux);
+  }
 
-    GST_LOG_OBJECT (mux, "handling %d leftover bytes", av);
+  if (mux->out_list == NULL)
+    return GST_FLOW_OK;
 
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_buffer_new_and_alloc (align);
+  buffer_list = mux->out_list;
+  mux->out_list = NULL;
 
-    GST_BUFFER_PTS (buf) = pts;
+  return finish_buffer_list (mux, buffer_list);
+}
 
-    gst_buffer_map (buf, &map, GST_MAP_READ);
-    data = map.data;
+/* The chunk takes the timestamp and flags of its first packet, and is a
+ * delta unit only if all of its packets are */
+static void
+gst_base_ts_mux_update_chunk_flags (GstBaseTsMux * mux, GstBuffer * buf,
+    gboolean first)
+{
+  if (first) {
+    GST_BUFFER_PTS (mux->out_buffer) = GST_BUFFER_PTS (buf);
+    GST_BUFFER_FLAGS (mux->out_buffer) |= GST_BUFFER_FLAGS (buf) &
+        (GST_BUFFER_FLAG_HEADER | GST_BUFFER_FLAG_DELTA_UNIT);
+  } else if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    GST_BUFFER_FLAG_UNSET (mux->out_buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+}
 
-    gst_adapter_copy (mux->out_adapter, data, 0, av);
-    gst_adapter_clear (mux->out_adapter);
+/* Appends the packet to the output chunk being filled by reference. With
+ * zero-copy, the packet payload is shared with the input buffers, so that
+ * chunks are made of alternating header and payload memories.
+ *
+ * A chunk must not go over the maximum number of memories of a buffer, as
+ * that would merge all of them. When not aligning, the chunk is closed
+ * early. Aligned chunks must hold @align packets, so the packets that would
+ * not fit anymore are copied into one memory each instead */
+static GstFlowReturn
+gst_base_ts_mux_collect_packet_shared (GstBaseTsMux * mux, GstBuffer * buf)
+{
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  gsize size = gst_buffer_get_size (buf);
+  guint max_memory = gst_buffer_get_max_memory ();
+  guint n_memory = 0;
 
-    data += av;
-    header = GST_READ_UINT32_BE (data - packet_size);
+  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT " in %u "
+      "memories", size, gst_buffer_n_memory (buf));
 
-    dummy = (map.size - av) / packet_size;
-    GST_LOG_OBJECT (mux, "adding %d null packets", dummy);
+  /* Chunks from the pool can't be shared with */
+  if (mux->out_map.memory)
+    gst_base_ts_mux_close_chunk (mux);
 
-    for (; dummy > 0; dummy--) {
-      gint offset;
+  if (mux->out_buffer)
+    n_memory = gst_buffer_n_memory (mux->out_buffer);
 
-      if (packet_size > GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH) {
-        GST_WRITE_UINT32_BE (data, header);
-        /* simply increase header a bit and never mind too much */
-        header++;
-        offset = 4;
-      } else {
-        offset = 0;
-      }
-      GST_WRITE_UINT8 (data + offset, TSMUX_SYNC_BYTE);
-      /* null packet PID */
-      GST_WRITE_UINT16_BE (data + offset + 1, 0x1FFF);
-      /* no adaptation field exists | continuity counter undefined */
-      GST_WRITE_UINT8 (data + offset + 3, 0x10);
-      /* payload */
-      memset (data + offset + 4, 0, GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH - 4);
-      data += packet_size;
-    }
+  if (mux->out_buffer && align == 0 &&
+      n_memory + gst_buffer_n_memory (buf) > max_memory) {
+    gst_base_ts_mux_close_chunk (mux);
+    n_memory = 0;
+  }
+
+  if (mux->out_buffer == NULL) {
+    mux->out_buffer = gst_buffer_new ();
+    mux->out_offset = 0;
+    gst_base_ts_mux_update_chunk_flags (mux, buf, TRUE);
+  } else {
+    gst_base_ts_mux_update_chunk_flags (mux, buf, FALSE);
+  }
 
-    gst_buffer_unmap (buf, &map);
-    gst_buffer_list_add (buffer_list, buf);
+  /* Keep one memory for each of the packets that will follow in the chunk,
+   * and for the null packets padding it when draining */
+  if (align > 0 && n_memory + gst_buffer_n_memory (buf) +
+      (align - 1 - mux->out_offset / mux->packet_size) > max_memory) {
+    GST_LOG_OBJECT (mux, "chunk has %u memories, copying packet", n_memory);
+    gst_buffer_append_memory (mux->out_buffer,
+        gst_buffer_get_all_memory (buf));
+  } else {
+    gst_buffer_copy_into (mux->out_buffer, buf, GST_BUFFER_COPY_MEMORY, 0, -1);
   }
+  mux->out_offset += size;
+  gst_buffer_unref (buf);
 
-  return finish_buffer_list (mux, buffer_list);
+  if (align > 0 && mux->out_offset >= align * mux->packet_size)
+    gst_base_ts_mux_close_chunk (mux);
+
+  return GST_FLOW_OK;
 }
 
+/* Makes sure that the chunk being filled has room for a packet of @size.
+ * Chunks come from a pool and hold as many packets as the alignment, so that
+ * no memory is allocated per output buffer in the steady state */
+static void
+gst_base_ts_mux_ensure_chunk (GstBaseTsMux * mux, gsize size)
+{
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  gsize chunk_size;
+
+  if (mux->out_buffer && (mux->out_map.memory == NULL ||
+          mux->out_offset + size > mux->out_map.size))
+    gst_base_ts_mux_close_chunk (mux);
+
+  if (mux->out_buffer)
+    return;
+
+  chunk_size = (align > 0 ? align : BASETSMUX_UNALIGNED_CHUNK_PACKETS) *
+      mux->packet_size;
+  if (mux->chunk_pool && mux->chunk_size != chunk_size)
+    gst_base_ts_mux_clear_pool (&mux->chunk_pool);
+  if (mux->chunk_pool == NULL) {
+    GST_DEBUG_OBJECT (mux, "creating pool of %" G_GSIZE_FORMAT
+        " bytes chunks", chunk_size);
+    mux->chunk_pool = gst_base_ts_mux_create_pool (chunk_size);
+    mux->chunk_size = chunk_size;
+  }
+
+  if (gst_buffer_pool_acquire_buffer (mux->chunk_pool, &mux->out_buffer,
+          NULL) != GST_FLOW_OK)
+    mux->out_buffer = gst_buffer_new_and_alloc (chunk_size);
+  gst_buffer_map (mux->out_buffer, &mux->out_map, GST_MAP_WRITE);
+  mux->out_offset = 0;
+}
+
+/* Whether @buf was handed out by the default allocate_packet vfunc and
+ * already holds the packet at the current position of the chunk */
+static gboolean
+gst_base_ts_mux_is_chunk_packet (GstBaseTsMux * mux, GstBuffer * buf)
+{
+  GstMapInfo map;
+  gboolean ret;
+
+  if (mux->out_map.memory == NULL || gst_buffer_n_memory (buf) != 1)
+    return FALSE;
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  ret = map.data == mux->out_map.data + mux->out_offset;
+  gst_buffer_unmap (buf, &map);
+
+  return ret;
+}
+
+/* Adds the packet to the output chunk being filled. Packets from the default
+ * allocate_packet vfunc were written in place, others are copied */
 static GstFlowReturn
 gst_base_ts_mux_collect_packet (GstBaseTsMux * mux, GstBuffer * buf)
 {
-  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT,
-      gst_buffer_get_size (buf));
-  gst_adapter_push (mux->out_adapter, buf);
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  gsize size = gst_buffer_get_size (buf);
+
+  /* Aligned chunks of more packets than a buffer can hold memories are
+   * always copied */
+  if (mux->zero_copy &&
+      mux->packet_size == GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH &&
+      align <= (gint) gst_buffer_get_max_memory ())
+    return gst_base_ts_mux_collect_packet_shared (mux, buf);
+
+  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT, size);
+
+  if (gst_base_ts_mux_is_chunk_packet (mux, buf)) {
+    gst_base_ts_mux_update_chunk_flags (mux, buf, mux->out_offset == 0);
+
+    /* Keep the buffer around for the next packet */
+    if (mux->out_packet == NULL && gst_buffer_is_writable (buf))
+      mux->out_packet = buf;
+    else
+      gst_buffer_unref (buf);
+  } else {
+    gst_base_ts_mux_ensure_chunk (mux, size);
+    gst_base_ts_mux_update_chunk_flags (mux, buf, mux->out_offset == 0);
+
+    gst_buffer_extract (buf, 0, mux->out_map.data + mux->out_offset, size);
+    gst_buffer_unref (buf);
+  }
+  mux->out_offset += size;
+
+  if (mux->out_offset == mux->out_map.size)
+    gst_base_ts_mux_close_chunk (mux);
 
   return GST_FLOW_OK;
 }
@@ -1022,19 +1278,20 @@ new_packet_cb (GstBuffer * buf, void *user_data, gint64 new_pcr)
 {
   GstBaseTsMux *mux = (GstBaseTsMux *) user_data;
   GstBaseTsMuxClass *klass = GST_BASE_TS_MUX_GET_CLASS (mux);
-  GstMapInfo map;
+  guint8 header[3];
+  gsize size;
 
   g_assert (klass->output_packet);
 
-  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
+  /* Only the PID is needed; mapping the whole packet would merge its header
+   * and payload memories into a copy */
+  size = gst_buffer_extract (buf, 0, header, sizeof (header));
 
   if (!GST_CLOCK_TIME_IS_VALID (GST_BUFFER_PTS (buf)))
     GST_BUFFER_PTS (buf) = mux->last_ts;
 
   /* do common init (flags and streamheaders) */
-  new_packet_common_init (mux, buf, map.data, map.size);
-
-  gst_buffer_unmap (buf, &map);
+  new_packet_common_init (mux, buf, header, size);
 
   return klass->output_packet (mux, buf, new_pcr);
 }
@@ -1664,10 +1921,6 @@ gst_base_ts_mux_dispose (GObject * object)
 
   gst_base_ts_mux_reset (mux, FALSE);
 
-  if (mux->out_adapter) {
-    g_object_unref (mux->out_adapter);
-    mux->out_adapter = NULL;
-  }
   if (mux->prog_map) {
     gst_structure_free (mux->prog_map);
     mux->prog_map = NULL;
@@ -1747,6 +2000,9 @@ gst_base_ts_mux_set_property (GObject * object, guint prop_id,
     case PROP_SCTE_35_NULL_INTERVAL:
       mux->scte35_null_interval = g_value_get_uint (value);
       break;
+    case PROP_ZERO_COPY:
+      mux->zero_copy = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1787,6 +2043,29 @@ gst_base_ts_mux_get_property (GObject * object, guint prop_id,
     case PROP_SCTE_35_NULL_INTERVAL:
       g_value_set_uint (value, mux->scte35_null_interval);
       break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, mux->zero_copy);
+      break;
+    case PROP_CBR_STATS:
+    {
+      TsMuxCbrStats stats;
+
+      GST_OBJECT_LOCK (mux);
+      stats = mux->cbr_stats;
+      GST_OBJECT_UNLOCK (mux);
+
+      g_value_take_boxed (value,
+          gst_structure_new ("application/x-tsmux-cbr-stats",
+              "bitrate", G_TYPE_UINT64, mux->bitrate,
+              "null-packets", G_TYPE_UINT64, stats.null_packets,
+              "pcr-packets", G_TYPE_UINT64, stats.pcr_packets,
+              "overflows", G_TYPE_UINT64, stats.overflows,
+              "max-late", G_TYPE_UINT64, stats.max_late,
+              "pcr-count", G_TYPE_UINT64, stats.n_pcr,
+              "max-pcr-interval", G_TYPE_UINT64, stats.max_pcr_interval,
+              NULL));
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1806,17 +2085,6 @@ gst_base_ts_mux_default_create_ts_mux (GstBaseTsMux * mux)
   return tsmux;
 }
 
-static void
-gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
-    GstBuffer ** buffer)
-{
-  GstBuffer *buf;
-
-  buf = gst_buffer_new_and_alloc (mux->packet_size);
-
-  *buffer = buf;
-}
-
 static gboolean
 gst_base_ts_mux_default_output_packet (GstBaseTsMux * mux, GstBuffer * buffer,
     gint64 new_pcr)
@@ -1826,6 +2094,60 @@ gst_base_ts_mux_default_output_packet (GstBaseTsMux * mux, GstBuffer * buffer,
   return TRUE;
 }
 
+static void
+gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
+    GstBuffer ** buffer)
+{
+  GstBuffer *buf = NULL;
+  gsize offset;
+
+  /* Without zero-copy, tsmux writes normal packets directly in the chunk
+   * being filled. The packet memory doesn't keep the chunk alive, so this
+   * is only done when the default output_packet vfunc is used, which
+   * collects every packet before the next one is allocated and before the
+   * chunk is closed */
+  if (!mux->zero_copy &&
+      mux->packet_size == GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH &&
+      GST_BASE_TS_MUX_GET_CLASS (mux)->output_packet ==
+      gst_base_ts_mux_default_output_packet) {
+    gst_base_ts_mux_ensure_chunk (mux, mux->packet_size);
+
+    buf = mux->out_packet;
+    mux->out_packet = NULL;
+    if (buf == NULL)
+      buf = gst_buffer_new ();
+
+    if (gst_buffer_n_memory (buf) == 0)
+      gst_buffer_append_memory (buf, gst_memory_new_wrapped (0,
+              mux->out_map.data, mux->out_map.size, 0, mux->out_map.size,
+              NULL, NULL));
+
+    gst_buffer_get_sizes (buf, &offset, NULL);
+    gst_buffer_resize (buf, (gssize) (mux->out_offset - offset),
+        mux->packet_size);
+
+    GST_BUFFER_PTS (buf) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DTS (buf) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_FLAGS (buf) &= GST_BUFFER_FLAG_TAG_MEMORY;
+
+    *buffer = buf;
+    return;
+  }
+
+  if (mux->packet_pool && mux->packet_pool_size != mux->packet_size)
+    gst_base_ts_mux_clear_pool (&mux->packet_pool);
+  if (mux->packet_pool == NULL) {
+    mux->packet_pool = gst_base_ts_mux_create_pool (mux->packet_size);
+    mux->packet_pool_size = mux->packet_size;
+  }
+
+  if (gst_buffer_pool_acquire_buffer (mux->packet_pool, &buf,
+          NULL) != GST_FLOW_OK)
+    buf = gst_buffer_new_and_alloc (mux->packet_size);
+
+  *buffer = buf;
+}
+
 /* Subclass API */
 
 void
@@ -1935,6 +2257,40 @@ gst_base_ts_mux_class_init (GstBaseTsMuxClass * klass)
           TSMUX_DEFAULT_SCTE_35_NULL_INTERVAL,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /**
+   * GstBaseTsMux:zero-copy:
+   *
+   * Reference the payload of the input buffers in the output instead of
+   * copying it, output buffers then being made of one memory for the headers
+   * of each packet followed by the memories of its payload. This is meant
+   * for sinks supporting scatter-gather output, such as udpsink. Only applies
+   * to streams created after it is set, and not in m2ts mode.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero copy",
+          "Reference the input payload in the output packets instead of "
+          "copying it", BASETSMUX_DEFAULT_ZERO_COPY,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  /**
+   * GstBaseTsMux:cbr-stats:
+   *
+   * Statistics of the constant bitrate output, when #GstBaseTsMux:bitrate
+   * is set: the number of null packets and PCR only packets inserted, the
+   * number of packets scheduled after the decoding time of their data
+   * ("overflows", when the input doesn't fit in the bitrate) and their
+   * maximum delay, and the number of PCRs written with their maximum
+   * interval. All times are in nanoseconds.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_CBR_STATS,
+      g_param_spec_boxed ("cbr-stats", "CBR statistics",
+          "Statistics of the constant bitrate output", GST_TYPE_STRUCTURE,
+          (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
       &gst_base_ts_mux_src_factory, GST_TYPE_AGGREGATOR_PAD);
 }
@@ -1942,8 +2298,6 @@ gst_base_ts_mux_class_init (GstBaseTsMuxClass * klass)
 static void
 gst_base_ts_mux_init (GstBaseTsMux * mux)
 {
-  mux->out_adapter = gst_adapter_new ();
-
   /* properties */
   mux->pat_interval = TSMUX_DEFAULT_PAT_INTERVAL;
   mux->pmt_interval = TSMUX_DEFAULT_PMT_INTERVAL;
@@ -1954,6 +2308,7 @@ gst_base_ts_mux_init (GstBaseTsMux * mux)
   mux->bitrate = TSMUX_DEFAULT_BITRATE;
   mux->scte35_pid = DEFAULT_SCTE_35_PID;
   mux->scte35_null_interval = TSMUX_DEFAULT_SCTE_35_NULL_INTERVAL;
+  mux->zero_copy = BASETSMUX_DEFAULT_ZERO_COPY;
 
   mux->packet_size = GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH;
   mux->automatic_alignment = 0;
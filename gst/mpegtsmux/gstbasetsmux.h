@@ -176,6 +176,7 @@ struct GstBaseTsMux {
   guint pcr_interval;
   guint scte35_pid;
   guint scte35_null_interval;
+  gboolean zero_copy;
   
   /* state */
   gboolean first;
@@ -195,8 +196,20 @@ struct GstBaseTsMux {
   gsize automatic_alignment;
 
   /* output buffer aggregation */
-  GstAdapter *out_adapter;
+  GstBufferPool *packet_pool;
+  gsize packet_pool_size;
+  GstBufferPool *chunk_pool;
+  gsize chunk_size;
+  /* chunk being filled, and complete chunks to output */
   GstBuffer *out_buffer;
+  GstMapInfo out_map;
+  gsize out_offset;
+  GstBufferList *out_list;
+  /* spare buffer handed to tsmux to write a packet in the chunk in place */
+  GstBuffer *out_packet;
+
+  /* snapshot of the TsMux statistics, protected by the object lock */
+  TsMuxCbrStats cbr_stats;
 };
 
 /**
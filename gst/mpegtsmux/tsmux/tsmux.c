@@ -106,6 +106,10 @@
  * 1/8 second atm */
 #define TSMUX_PCR_OFFSET (TSMUX_CLOCK_FREQ / 8)
 
+/* The PCR gives the time of the byte containing the last bit of the
+ * program_clock_reference_base, 10 bytes into the packet */
+#define TSMUX_PCR_BYTE_OFFSET 10
+
 /* Base for all written PCR and DTS/PTS,
  * so we have some slack to go backwards */
 #define CLOCK_BASE (TSMUX_CLOCK_FREQ * 10 * 360)
@@ -151,6 +155,8 @@ tsmux_new (void)
 
   mux->next_si_pcr = -1;
 
+  mux->last_pcr = -1;
+
   mux->si_sections = g_hash_table_new_full (g_direct_hash, g_direct_equal,
       NULL, (GDestroyNotify) tsmux_section_free);
 
@@ -746,6 +752,19 @@ tsmux_packet_out (TsMux * mux, GstBuffer * buf, gint64 pcr)
     return TRUE;
   }
 
+  if (pcr != -1) {
+    TsMuxCbrStats *stats = &mux->cbr_stats;
+
+    if (mux->last_pcr != -1 && pcr > mux->last_pcr) {
+      guint64 interval = gst_util_uint64_scale (pcr - mux->last_pcr,
+          GST_SECOND, TSMUX_SYS_CLOCK_FREQ);
+
+      stats->max_pcr_interval = MAX (stats->max_pcr_interval, interval);
+    }
+    mux->last_pcr = pcr;
+    stats->n_pcr++;
+  }
+
   if (mux->bitrate)
     GST_BUFFER_PTS (buf) =
         gst_util_uint64_scale (mux->n_bytes * 8, GST_SECOND, mux->bitrate);
@@ -1187,10 +1206,12 @@ tsmux_write_null_ts_header (guint8 * buf)
 static gint64
 get_current_pcr (TsMux * mux, gint64 cur_ts)
 {
+  /* With a constant bitrate, the PCR is the time of the slot of the packet
+   * about to be written */
   if (mux->bitrate)
     return (CLOCK_BASE - TSMUX_PCR_OFFSET) * 300 +
-        gst_util_uint64_scale (mux->n_bytes * 8, TSMUX_SYS_CLOCK_FREQ,
-        mux->bitrate);
+        gst_util_uint64_scale ((mux->n_bytes + TSMUX_PCR_BYTE_OFFSET) * 8,
+        TSMUX_SYS_CLOCK_FREQ, mux->bitrate);
   else if (cur_ts != G_MININT64)
     return (cur_ts -
         TSMUX_PCR_OFFSET) * (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
@@ -1320,75 +1341,144 @@ rewrite_si (TsMux * mux, gint64 cur_ts)
   return TRUE;
 }
 
+/* Writes a packet of the PCR stream @stream with only an adaptation field
+ * carrying @pcr */
 static gboolean
-pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+write_pcr_packet (TsMux * mux, TsMuxStream * stream, gint64 pcr)
 {
-  guint64 bitrate;
+  TsMuxPacketInfo *pi = &stream->pi;
+  gboolean pusi = pi->packet_start_unit_indicator;
+  guint payload_len, payload_offs;
   GstBuffer *buf = NULL;
   GstMapInfo map;
-  gboolean ret = TRUE;
+  gboolean ret;
 
-  if (!mux->bitrate)
-    goto done;
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
 
-  do {
-    if (GST_CLOCK_STIME_IS_VALID (cur_ts)) {
-      GstClockTimeDiff diff;
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  pi->packet_start_unit_indicator = FALSE;
+  ret = tsmux_write_ts_header (mux, map.data, pi, &payload_len, &payload_offs,
+      0);
+  pi->packet_start_unit_indicator = pusi;
+  gst_buffer_unmap (buf, &map);
+
+  /* Reset all dynamic flags */
+  pi->flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
+
+  if (!ret) {
+    gst_buffer_unref (buf);
+    return FALSE;
+  }
 
-      if (!GST_CLOCK_STIME_IS_VALID (stream->first_ts))
-        stream->first_ts = cur_ts;
+  mux->cbr_stats.pcr_packets++;
 
-      diff = GST_CLOCK_DIFF (stream->first_ts, cur_ts);
+  return tsmux_packet_out (mux, buf, pcr);
+}
 
-      if (diff) {
-        bitrate =
-            gst_util_uint64_scale (mux->n_bytes * 8, TSMUX_CLOCK_FREQ, diff);
+static gboolean
+write_null_packet (TsMux * mux)
+{
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
 
-        GST_LOG ("Transport stream bitrate: %" G_GUINT64_FORMAT, bitrate);
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
 
-        if (bitrate < mux->bitrate) {
-          gint64 new_pcr;
-          guint payload_len, payload_offs;
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  tsmux_write_null_ts_header (map.data);
+  memset (map.data + TSMUX_HEADER_LENGTH, 0xff, TSMUX_PAYLOAD_LENGTH);
+  gst_buffer_unmap (buf, &map);
 
-          GST_LOG ("Padding transport stream");
+  mux->cbr_stats.null_packets++;
+
+  return tsmux_packet_out (mux, buf, -1);
+}
 
-          if (!rewrite_si (mux, cur_ts)) {
-            ret = FALSE;
-            goto done;
-          }
+/* Returns the PCR stream of a program which is due to send a PCR, and sets
+ * up the packet info of that stream to write it */
+static TsMuxStream *
+get_due_pcr_stream (TsMux * mux, gint64 * pcr)
+{
+  GList *cur;
 
-          if (!tsmux_get_buffer (mux, &buf)) {
-            ret = FALSE;
-            goto done;
-          }
+  for (cur = mux->programs; cur; cur = cur->next) {
+    TsMuxProgram *program = (TsMuxProgram *) cur->data;
+    TsMuxStream *stream = program->pcr_stream;
 
-          gst_buffer_map (buf, &map, GST_MAP_READ);
+    /* PCRs only start with the data of the PCR stream */
+    if (stream == NULL || stream->next_pcr == -1)
+      continue;
 
-          if ((new_pcr =
-                  write_new_pcr (mux, stream, get_current_pcr (mux,
-                          cur_ts)) != -1))
-            tsmux_write_ts_header (mux, map.data, &stream->pi, &payload_len,
-                &payload_offs, 0);
-          else
-            tsmux_write_null_ts_header (map.data);
+    *pcr = write_new_pcr (mux, stream, get_current_pcr (mux, G_MININT64));
+    if (*pcr != -1)
+      return stream;
+  }
 
-          gst_buffer_unmap (buf, &map);
+  return NULL;
+}
 
-          stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
+/* Constant bitrate scheduling: packets are output in fixed size slots at the
+ * target bitrate, so that the time of a slot is given by its position in the
+ * output, and PCRs are computed from it. Before writing data at @cur_ts, the
+ * slots up to that time are filled with tables and PCRs when due, and null
+ * packets otherwise. */
+static gboolean
+pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+{
+  guint64 target = 0;
 
-          if (!(ret = tsmux_packet_out (mux, buf, new_pcr)))
-            goto done;
-        }
-      } else {
-        break;
-      }
-    } else {
+  if (!mux->bitrate)
+    return TRUE;
+
+  /* Position of the slot of cur_ts */
+  if (cur_ts > CLOCK_BASE)
+    target = gst_util_uint64_scale (cur_ts - CLOCK_BASE, mux->bitrate,
+        8 * TSMUX_CLOCK_FREQ);
+
+  if (!mux->cbr_started) {
+    /* Start the schedule at the first data so that the PCRs match its
+     * timestamps, without stuffing up to it */
+    target -= target % TSMUX_PACKET_LENGTH;
+    mux->n_bytes = MAX (mux->n_bytes, target);
+    mux->cbr_started = TRUE;
+  }
+
+  while (mux->n_bytes < target) {
+    TsMuxStream *pcr_stream;
+    gint64 pcr;
+    gboolean ret;
+
+    if (!rewrite_si (mux, cur_ts))
+      return FALSE;
+    if (mux->n_bytes >= target)
       break;
+
+    if ((pcr_stream = get_due_pcr_stream (mux, &pcr)))
+      ret = write_pcr_packet (mux, pcr_stream, pcr);
+    else
+      ret = write_null_packet (mux);
+
+    if (!ret)
+      return FALSE;
+  }
+
+  if (mux->n_bytes > target) {
+    guint64 late = gst_util_uint64_scale (mux->n_bytes - target,
+        8 * GST_SECOND, mux->bitrate);
+
+    mux->cbr_stats.max_late = MAX (mux->cbr_stats.max_late, late);
+
+    /* Data would reach the decoder after its decoding time */
+    if (late > gst_util_uint64_scale (TSMUX_PCR_OFFSET, GST_SECOND,
+            TSMUX_CLOCK_FREQ)) {
+      GST_LOG ("Stream 0x%04x is late by %" GST_TIME_FORMAT, stream->pi.pid,
+          GST_TIME_ARGS (late));
+      mux->cbr_stats.overflows++;
     }
-  } while (bitrate < mux->bitrate);
+  }
 
-done:
-  return ret;
+  return TRUE;
 }
 
 /**
@@ -1413,21 +1503,35 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
 
-  if (tsmux_stream_is_pcr (stream)) {
+  if (tsmux_stream_is_pcr (stream) || mux->bitrate) {
     gint64 cur_ts = CLOCK_BASE;
 
+    /* With a constant bitrate, all streams are scheduled at the time of
+     * their next data */
+    if (mux->bitrate && tsmux_stream_get_next_ts (stream) != G_MININT64 &&
+        !pad_stream (mux, stream,
+            CLOCK_BASE + tsmux_stream_get_next_ts (stream)))
+      goto fail;
+
     if (tsmux_stream_get_dts (stream) != G_MININT64)
       cur_ts += tsmux_stream_get_dts (stream);
     else
       cur_ts += tsmux_stream_get_pts (stream);
 
-    if (!rewrite_si (mux, cur_ts))
-      goto fail;
+    if (tsmux_stream_is_pcr (stream)) {
+      if (!rewrite_si (mux, cur_ts))
+        goto fail;
 
-    if (!pad_stream (mux, stream, cur_ts))
-      goto fail;
+      new_pcr = write_new_pcr (mux, stream, get_current_pcr (mux, cur_ts));
+    } else {
+      TsMuxStream *pcr_stream;
+      gint64 pcr;
 
-    new_pcr = write_new_pcr (mux, stream, get_current_pcr (mux, cur_ts));
+      /* Keep the PCR interval when the PCR stream has no data */
+      if ((pcr_stream = get_due_pcr_stream (mux, &pcr)) &&
+          !write_pcr_packet (mux, pcr_stream, pcr))
+        goto fail;
+    }
   }
 
   pi->packet_start_unit_indicator = tsmux_stream_at_pes_start (stream);
@@ -1450,11 +1554,19 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
           pi->stream_avail))
     goto fail;
 
+  if (stream->buffer_share) {
+    /* Payload is referenced from the stream data instead of copied */
+    gst_buffer_unmap (buf, &map);
+    map.memory = NULL;
 
-  if (!tsmux_stream_get_data (stream, map.data + payload_offs, payload_len))
-    goto fail;
+    if (!tsmux_stream_get_data_shared (stream, buf, payload_offs, payload_len))
+      goto fail;
+  } else {
+    if (!tsmux_stream_get_data (stream, map.data + payload_offs, payload_len))
+      goto fail;
 
-  gst_buffer_unmap (buf, &map);
+    gst_buffer_unmap (buf, &map);
+  }
 
   GST_DEBUG ("Writing PES of size %d", (int) gst_buffer_get_size (buf));
   res = tsmux_packet_out (mux, buf, new_pcr);
@@ -1468,7 +1580,8 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
 fail:
   {
     if (buf) {
-      gst_buffer_unmap (buf, &map);
+      if (map.memory)
+        gst_buffer_unmap (buf, &map);
       gst_buffer_unref (buf);
     }
     return FALSE;
@@ -1653,3 +1766,21 @@ tsmux_set_bitrate (TsMux * mux, guint64 bitrate)
 {
   mux->bitrate = bitrate;
 }
+
+/**
+ * tsmux_get_cbr_stats:
+ * @mux: a #TsMux
+ * @stats: (out): the statistics
+ *
+ * Get the statistics of the constant bitrate output of @mux, as configured
+ * with tsmux_set_bitrate(). The PCR count and interval are also gathered
+ * without a constant bitrate.
+ */
+void
+tsmux_get_cbr_stats (TsMux * mux, TsMuxCbrStats * stats)
+{
+  g_return_if_fail (mux != NULL);
+  g_return_if_fail (stats != NULL);
+
+  *stats = mux->cbr_stats;
+}
@@ -99,11 +99,29 @@ G_BEGIN_DECLS
 
 typedef struct TsMuxSection TsMuxSection;
 typedef struct TsMux TsMux;
+typedef struct TsMuxCbrStats TsMuxCbrStats;
 
 typedef gboolean (*TsMuxWriteFunc) (GstBuffer * buf, void *user_data, gint64 new_pcr);
 typedef void (*TsMuxAllocFunc) (GstBuffer ** buf, void *user_data);
 typedef TsMuxStream * (*TsMuxNewStreamFunc) (guint16 new_pid, guint stream_type, void *user_data);
 
+/* Statistics of the constant bitrate output, times in nanoseconds */
+struct TsMuxCbrStats {
+  /* stuffing packets inserted */
+  guint64 null_packets;
+  /* adaptation field only packets inserted to carry PCRs */
+  guint64 pcr_packets;
+  /* packets scheduled after the decoding time of their data, because the
+   * input doesn't fit in the bitrate */
+  guint64 overflows;
+  /* maximum delay of a packet behind its slot */
+  guint64 max_late;
+
+  /* PCRs written and largest interval between them */
+  guint64 n_pcr;
+  guint64 max_pcr_interval;
+};
+
 struct TsMuxSection {
   TsMuxPacketInfo pi;
   GstMpegtsSection *section;
@@ -198,6 +216,11 @@ struct TsMux {
   guint64 bitrate;
   guint64 n_bytes;
 
+  /* constant bitrate scheduling */
+  gboolean cbr_started;
+  gint64 last_pcr;
+  TsMuxCbrStats cbr_stats;
+
   /* For the per-PID continuity counter */
   guint8 pid_packet_counts[8192];
 };
@@ -215,6 +238,7 @@ guint 		tsmux_get_pat_interval          (TsMux *mux);
 void 		tsmux_resend_pat                (TsMux *mux);
 guint16		tsmux_get_new_pid 		(TsMux *mux);
 void    tsmux_set_bitrate       (TsMux *mux, guint64 bitrate);
+void    tsmux_get_cbr_stats     (TsMux *mux, TsMuxCbrStats *stats);
 
 /* pid/program management */
 TsMuxProgram *	tsmux_program_new 		(TsMux *mux, gint prog_id);
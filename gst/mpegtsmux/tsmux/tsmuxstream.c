@@ -299,6 +299,27 @@ tsmux_stream_set_buffer_release_func (TsMuxStream * stream,
   stream->buffer_release = func;
 }
 
+/**
+ * tsmux_stream_set_buffer_share_func:
+ * @stream: a #TsMuxStream
+ * @func: the new #TsMuxStreamBufferShareFunc
+ *
+ * Set the function that will be called to append part of a piece of data fed
+ * to @stream to a packet without copying it. @func will be called with user
+ * data as provided with the call to tsmux_stream_add_data(), and the offset
+ * and size of the payload within that data.
+ *
+ * When set, packets are written with tsmux_stream_get_data_shared().
+ */
+void
+tsmux_stream_set_buffer_share_func (TsMuxStream * stream,
+    TsMuxStreamBufferShareFunc func)
+{
+  g_return_if_fail (stream != NULL);
+
+  stream->buffer_share = func;
+}
+
 /**
  * tsmux_stream_set_get_es_descriptors_func:
  * @stream: a #TsMuxStream
@@ -486,21 +507,13 @@ tsmux_stream_initialize_pes_packet (TsMuxStream * stream)
   return TRUE;
 }
 
-/**
- * tsmux_stream_get_data:
- * @stream: a #TsMuxStream
- * @buf: a buffer to hold the result
- * @len: the length of @buf
- *
- * Copy up to @len available data in @stream into the buffer @buf.
- *
- * Returns: TRUE if @len bytes could be retrieved.
- */
-gboolean
-tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
+/* Writes the PES header if at the start of a PES packet, and accounts for
+ * the payload to be retrieved. On return, @len is the payload length */
+static gboolean
+tsmux_stream_begin_data (TsMuxStream * stream, guint8 * buf, guint * len,
+    guint * header_len)
 {
-  g_return_val_if_fail (stream != NULL, FALSE);
-  g_return_val_if_fail (buf != NULL, FALSE);
+  *header_len = 0;
 
   if (stream->state == TSMUX_STREAM_STATE_HEADER) {
     guint8 pes_hdr_length;
@@ -508,23 +521,23 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
     pes_hdr_length = tsmux_stream_pes_header_length (stream);
 
     /* Submitted buffer must be at least as large as the PES header */
-    if (len < pes_hdr_length)
+    if (*len < pes_hdr_length)
       return FALSE;
 
     TS_DEBUG ("Writing PES header of length %u and payload %d",
         pes_hdr_length, stream->cur_pes_payload_size);
     tsmux_stream_write_pes_header (stream, buf);
 
-    len -= pes_hdr_length;
-    buf += pes_hdr_length;
+    *len -= pes_hdr_length;
+    *header_len = pes_hdr_length;
 
     stream->state = TSMUX_STREAM_STATE_PACKET;
   }
 
-  if (len > (guint) _tsmux_stream_bytes_avail (stream))
+  if (*len > (guint) _tsmux_stream_bytes_avail (stream))
     return FALSE;
 
-  stream->pes_bytes_written += len;
+  stream->pes_bytes_written += *len;
 
   if (stream->cur_pes_payload_size != 0 &&
       stream->pes_bytes_written == stream->cur_pes_payload_size) {
@@ -533,6 +546,32 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
     stream->pes_bytes_written = 0;
   }
 
+  return TRUE;
+}
+
+/**
+ * tsmux_stream_get_data:
+ * @stream: a #TsMuxStream
+ * @buf: a buffer to hold the result
+ * @len: the length of @buf
+ *
+ * Copy up to @len available data in @stream into the buffer @buf.
+ *
+ * Returns: TRUE if @len bytes could be retrieved.
+ */
+gboolean
+tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
+{
+  guint header_len;
+
+  g_return_val_if_fail (stream != NULL, FALSE);
+  g_return_val_if_fail (buf != NULL, FALSE);
+
+  if (!tsmux_stream_begin_data (stream, buf, &len, &header_len))
+    return FALSE;
+
+  buf += header_len;
+
   while (len > 0) {
     guint32 avail;
     guint8 *cur;
@@ -565,6 +604,72 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
   return TRUE;
 }
 
+/**
+ * tsmux_stream_get_data_shared:
+ * @stream: a #TsMuxStream
+ * @packet: the packet being written
+ * @offset: the offset of the data in @packet
+ * @len: the length of the data
+ *
+ * Retrieve @len available data in @stream into @packet, starting at @offset.
+ * The PES header, if any, is written in @packet, which is then truncated
+ * after it. The payload is appended to @packet by reference with the
+ * function set with tsmux_stream_set_buffer_share_func(), so that @packet
+ * ends up made of a header memory and one or more payload memories.
+ *
+ * @packet must not be mapped.
+ *
+ * Returns: TRUE if @len bytes could be retrieved.
+ */
+gboolean
+tsmux_stream_get_data_shared (TsMuxStream * stream, GstBuffer * packet,
+    gsize offset, guint len)
+{
+  GstMapInfo map;
+  guint header_len;
+  gboolean ret;
+
+  g_return_val_if_fail (stream != NULL, FALSE);
+  g_return_val_if_fail (packet != NULL, FALSE);
+  g_return_val_if_fail (stream->buffer_share != NULL, FALSE);
+
+  if (!gst_buffer_map (packet, &map, GST_MAP_WRITE))
+    return FALSE;
+  if (offset + len > map.size) {
+    gst_buffer_unmap (packet, &map);
+    return FALSE;
+  }
+  ret = tsmux_stream_begin_data (stream, map.data + offset, &len, &header_len);
+  gst_buffer_unmap (packet, &map);
+
+  if (!ret)
+    return FALSE;
+
+  gst_buffer_resize (packet, 0, offset + header_len);
+
+  while (len > 0) {
+    guint32 avail;
+
+    if (stream->cur_buffer == NULL) {
+      /* Start next packet */
+      if (stream->buffers == NULL)
+        return FALSE;
+      stream->cur_buffer = (TsMuxStreamBuffer *) (stream->buffers->data);
+      stream->cur_buffer_consumed = 0;
+    }
+
+    /* Reference as much as we can from the current buffer */
+    avail = MIN (len, stream->cur_buffer->size - stream->cur_buffer_consumed);
+    stream->buffer_share (packet, stream->cur_buffer->user_data,
+        stream->cur_buffer_consumed, avail);
+    tsmux_stream_consume (stream, avail);
+
+    len -= avail;
+  }
+
+  return TRUE;
+}
+
 static guint8
 tsmux_stream_pes_header_length (TsMuxStream * stream)
 {
@@ -1141,6 +1246,41 @@ tsmux_stream_get_pts (TsMuxStream * stream)
   return stream->last_pts;
 }
 
+/**
+ * tsmux_stream_get_next_ts:
+ * @stream: a #TsMuxStream
+ *
+ * Return the DTS, or the PTS if it has none, of the next bytes to be written
+ * from @stream, or of the last buffer that had bytes written if the next
+ * bytes don't start a buffer with a timestamp.
+ *
+ * Returns: the timestamp of the next bytes of @stream.
+ */
+gint64
+tsmux_stream_get_next_ts (TsMuxStream * stream)
+{
+  TsMuxStreamBuffer *buf = NULL;
+
+  g_return_val_if_fail (stream != NULL, GST_CLOCK_STIME_NONE);
+
+  if (stream->cur_buffer == NULL && stream->buffers)
+    buf = (TsMuxStreamBuffer *) stream->buffers->data;
+  else if (stream->cur_buffer && stream->cur_buffer_consumed == 0)
+    buf = stream->cur_buffer;
+
+  if (buf) {
+    if (GST_CLOCK_STIME_IS_VALID (buf->dts))
+      return buf->dts;
+    if (GST_CLOCK_STIME_IS_VALID (buf->pts))
+      return buf->pts;
+  }
+
+  if (GST_CLOCK_STIME_IS_VALID (stream->last_dts))
+    return stream->last_dts;
+
+  return stream->last_pts;
+}
+
 /**
  * tsmux_stream_get_dts:
  * @stream: a #TsMuxStream
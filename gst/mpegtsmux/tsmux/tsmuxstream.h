@@ -91,6 +91,7 @@ typedef enum TsMuxStreamState TsMuxStreamState;
 typedef struct TsMuxStreamBuffer TsMuxStreamBuffer;
 
 typedef void (*TsMuxStreamBufferReleaseFunc) (guint8 *data, void *user_data);
+typedef void (*TsMuxStreamBufferShareFunc) (GstBuffer *packet, void *user_data, gsize offset, gsize size);
 typedef void (*TsMuxStreamGetESDescriptorsFunc) (TsMuxStream *stream, GstMpegtsPMTStream *pmt_stream, void *user_data);
 
 /* Stream type assignments
@@ -181,6 +182,8 @@ struct TsMuxStream {
 
   /* helper to release collected buffers */
   TsMuxStreamBufferReleaseFunc buffer_release;
+  /* optional helper to reference payload instead of copying it */
+  TsMuxStreamBufferShareFunc buffer_share;
 
   /* Override or extend the default Elementary Stream descriptors */
   TsMuxStreamGetESDescriptorsFunc get_es_descrs;
@@ -244,6 +247,8 @@ guint16         tsmux_stream_get_pid            (TsMuxStream *stream);
 
 void 		tsmux_stream_set_buffer_release_func 	(TsMuxStream *stream,
        							 TsMuxStreamBufferReleaseFunc func);
+void 		tsmux_stream_set_buffer_share_func 	(TsMuxStream *stream,
+       							 TsMuxStreamBufferShareFunc func);
 
 void 		tsmux_stream_set_get_es_descriptors_func 	(TsMuxStream *stream,
                                                    TsMuxStreamGetESDescriptorsFunc func,
@@ -267,9 +272,12 @@ gint 		tsmux_stream_bytes_in_buffer 	(TsMuxStream *stream);
 gint 		tsmux_stream_bytes_avail 	(TsMuxStream *stream);
 gboolean 	tsmux_stream_initialize_pes_packet (TsMuxStream *stream);
 gboolean 	tsmux_stream_get_data 		(TsMuxStream *stream, guint8 *buf, guint len);
+gboolean 	tsmux_stream_get_data_shared 	(TsMuxStream *stream, GstBuffer *packet,
+       						 gsize offset, guint len);
 
 gint64 	tsmux_stream_get_pts 		(TsMuxStream *stream);
 gint64 	tsmux_stream_get_dts 		(TsMuxStream *stream);
+gint64 	tsmux_stream_get_next_ts 	(TsMuxStream *stream);
 
 G_END_DECLS
 
@@ -0,0 +1,900 @@
+/* GStreamer AV1 Parser
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-av1parse
+ * @title: av1parse
+ *
+ * Parses AV1 streams, either in the low overhead bitstream format
+ * (`stream-format=obu-stream`) or in the length delimited format of Annex B
+ * (`stream-format=annexb`), and converts between them. The output is
+ * aligned on temporal units (`alignment=tu`), or on single OBUs
+ * (`alignment=obu`) for the low overhead format.
+ *
+ * Temporal units holding a shown key frame are marked by clearing
+ * %GST_BUFFER_FLAG_DELTA_UNIT, and the resolution and profile are exposed in
+ * the caps.
+ *
+ * The OBU payloads are never copied: output buffers reference the input
+ * memory, with only the OBU headers and sizes that need rewriting put in
+ * new memory.
+ *
+ * Upstream elements delivering one temporal unit per buffer must signal
+ * it with `alignment=tu` in their caps. The last OBU of such buffers may
+ * then omit its obu_size field.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.obu ! av1parse ! video/x-av1,stream-format=annexb ! filesink location=video.annexb
+ * ]|
+ *
+ * Since: 1.18
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstav1parse.h"
+
+GST_DEBUG_CATEGORY (av1_parse_debug);
+#define GST_CAT_DEFAULT av1_parse_debug
+
+enum
+{
+  GST_AV1_PARSE_FORMAT_NONE = 0,
+  GST_AV1_PARSE_FORMAT_OBU_STREAM,
+  GST_AV1_PARSE_FORMAT_ANNEXB,
+};
+
+enum
+{
+  GST_AV1_PARSE_ALIGN_NONE = 0,
+  GST_AV1_PARSE_ALIGN_OBU,
+  GST_AV1_PARSE_ALIGN_TU,
+};
+
+typedef struct
+{
+  /* where the OBU starts in the input, including an Annex B obu_length */
+  guint32 start;
+  /* where the OBU header starts in the input */
+  guint32 header_offset;
+  /* the OBU header, for rewriting it with an obu_size field */
+  guint8 header[2];
+
+  GstAV1OBU obu;
+} GstAV1ParseOBU;
+
+/* Collects the sizes and OBU headers to output in a small piece of memory,
+ * which is appended to the output buffer whenever a region of the input
+ * buffer follows */
+typedef struct
+{
+  GstBuffer *input;
+  GstBuffer *output;
+
+  guint8 pending[32];
+  guint pending_size;
+} GstAV1ParseWriter;
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-av1, parsed = (boolean) true, "
+        "stream-format = (string) obu-stream, "
+        "alignment = (string) { tu, obu }; "
+        "video/x-av1, parsed = (boolean) true, "
+        "stream-format = (string) annexb, alignment = (string) tu")
+    );
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-av1")
+    );
+
+#define parent_class gst_av1_parse_parent_class
+G_DEFINE_TYPE (GstAV1Parse, gst_av1_parse, GST_TYPE_BASE_PARSE);
+
+static gboolean gst_av1_parse_start (GstBaseParse * parse);
+static gboolean gst_av1_parse_stop (GstBaseParse * parse);
+static gboolean gst_av1_parse_set_sink_caps (GstBaseParse * parse,
+    GstCaps * caps);
+static GstFlowReturn gst_av1_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+
+static void
+gst_av1_parse_class_init (GstAV1ParseClass * klass)
+{
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (av1_parse_debug, "av1parse", 0, "av1 parser");
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+  gst_element_class_set_static_metadata (gstelement_class, "AV1 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses AV1 streams", "GStreamer developers");
+
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_av1_parse_start);
+  parse_class->stop = GST_DEBUG_FUNCPTR (gst_av1_parse_stop);
+  parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_av1_parse_set_sink_caps);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_av1_parse_handle_frame);
+}
+
+static void
+gst_av1_parse_init (GstAV1Parse * self)
+{
+  /* frames that are not displayed have no timestamp of their own */
+  gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (self), FALSE);
+  gst_base_parse_set_infer_ts (GST_BASE_PARSE (self), FALSE);
+
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (self));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (self));
+}
+
+static void
+gst_av1_parse_reset_frame (GstAV1Parse * self)
+{
+  g_array_set_size (self->obus, 0);
+  self->scan_offset = 0;
+}
+
+static gboolean
+gst_av1_parse_start (GstBaseParse * parse)
+{
+  GstAV1Parse *self = GST_AV1_PARSE (parse);
+
+  GST_DEBUG_OBJECT (self, "start");
+
+  self->parser = gst_av1_parser_new ();
+  self->obus = g_array_new (FALSE, FALSE, sizeof (GstAV1ParseOBU));
+  self->width = 0;
+  self->height = 0;
+  self->profile = GST_AV1_PROFILE_UNDEFINED;
+  self->in_format = GST_AV1_PARSE_FORMAT_OBU_STREAM;
+  self->in_packetized = FALSE;
+  self->format = GST_AV1_PARSE_FORMAT_NONE;
+  self->align = GST_AV1_PARSE_ALIGN_NONE;
+  self->update_caps = TRUE;
+  gst_av1_parse_reset_frame (self);
+
+  return TRUE;
+}
+
+static gboolean
+gst_av1_parse_stop (GstBaseParse * parse)
+{
+  GstAV1Parse *self = GST_AV1_PARSE (parse);
+
+  GST_DEBUG_OBJECT (self, "stop");
+
+  g_clear_pointer (&self->parser, gst_av1_parser_free);
+  g_clear_pointer (&self->obus, g_array_unref);
+
+  return TRUE;
+}
+
+static const gchar *
+gst_av1_parse_format_to_string (guint format)
+{
+  return format == GST_AV1_PARSE_FORMAT_ANNEXB ? "annexb" : "obu-stream";
+}
+
+static const gchar *
+gst_av1_parse_profile_to_string (GstAV1Profile profile)
+{
+  switch (profile) {
+    case GST_AV1_PROFILE_0:
+      return "main";
+    case GST_AV1_PROFILE_1:
+      return "high";
+    case GST_AV1_PROFILE_2:
+      return "professional";
+    default:
+      break;
+  }
+
+  return NULL;
+}
+
+static gboolean
+gst_av1_parse_set_sink_caps (GstBaseParse * parse, GstCaps * caps)
+{
+  GstAV1Parse *self = GST_AV1_PARSE (parse);
+  GstStructure *s = gst_caps_get_structure (caps, 0);
+  const gchar *str;
+
+  str = gst_structure_get_string (s, "stream-format");
+  if (g_strcmp0 (str, "annexb") == 0)
+    self->in_format = GST_AV1_PARSE_FORMAT_ANNEXB;
+  else
+    self->in_format = GST_AV1_PARSE_FORMAT_OBU_STREAM;
+
+  str = gst_structure_get_string (s, "alignment");
+  self->in_packetized = g_strcmp0 (str, "tu") == 0;
+
+  GST_DEBUG_OBJECT (self, "input %s%s",
+      gst_av1_parse_format_to_string (self->in_format),
+      self->in_packetized ? ", one temporal unit per buffer" : "");
+
+  /* the output format may prefer the new input format */
+  self->format = GST_AV1_PARSE_FORMAT_NONE;
+  self->update_caps = TRUE;
+
+  return TRUE;
+}
+
+/* check downstream caps to configure format and alignment */
+static void
+gst_av1_parse_negotiate (GstAV1Parse * self)
+{
+  GstCaps *caps;
+  guint format = GST_AV1_PARSE_FORMAT_OBU_STREAM;
+  guint align = GST_AV1_PARSE_ALIGN_TU;
+
+  caps = gst_pad_get_allowed_caps (GST_BASE_PARSE_SRC_PAD (self));
+  GST_DEBUG_OBJECT (self, "allowed caps: %" GST_PTR_FORMAT, caps);
+
+  if (caps && !gst_caps_is_empty (caps)) {
+    GstCaps *in_caps, *tmp;
+    GstStructure *s;
+    const gchar *str;
+
+    /* prefer the input format, no conversion is needed then */
+    in_caps = gst_caps_new_simple ("video/x-av1", "stream-format",
+        G_TYPE_STRING, gst_av1_parse_format_to_string (self->in_format),
+        NULL);
+    if (gst_caps_can_intersect (caps, in_caps)) {
+      tmp = gst_caps_intersect (caps, in_caps);
+      gst_caps_unref (caps);
+      caps = tmp;
+    }
+    gst_caps_unref (in_caps);
+
+    /* fixate to avoid ambiguity with lists when parsing */
+    caps = gst_caps_fixate (gst_caps_truncate (caps));
+    s = gst_caps_get_structure (caps, 0);
+
+    str = gst_structure_get_string (s, "stream-format");
+    if (g_strcmp0 (str, "annexb") == 0)
+      format = GST_AV1_PARSE_FORMAT_ANNEXB;
+
+    /* Annex B is only produced in temporal units */
+    str = gst_structure_get_string (s, "alignment");
+    if (format == GST_AV1_PARSE_FORMAT_OBU_STREAM &&
+        g_strcmp0 (str, "obu") == 0)
+      align = GST_AV1_PARSE_ALIGN_OBU;
+  }
+
+  if (caps)
+    gst_caps_unref (caps);
+
+  GST_DEBUG_OBJECT (self, "selected format %s, alignment %s",
+      gst_av1_parse_format_to_string (format),
+      align == GST_AV1_PARSE_ALIGN_OBU ? "obu" : "tu");
+
+  if (format != self->format || align != self->align) {
+    self->format = format;
+    self->align = align;
+    self->update_caps = TRUE;
+  }
+}
+
+static void
+gst_av1_parse_update_src_caps (GstAV1Parse * self)
+{
+  GstCaps *sink_caps, *src_caps, *caps;
+  const gchar *profile;
+
+  if (!self->update_caps)
+    return;
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (self));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-av1");
+  }
+
+  if (self->width > 0 && self->height > 0) {
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, self->width,
+        "height", G_TYPE_INT, self->height, NULL);
+  }
+
+  profile = gst_av1_parse_profile_to_string (self->profile);
+  if (profile)
+    gst_caps_set_simple (caps, "profile", G_TYPE_STRING, profile, NULL);
+
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE,
+      "stream-format", G_TYPE_STRING,
+      gst_av1_parse_format_to_string (self->format),
+      "alignment", G_TYPE_STRING,
+      self->align == GST_AV1_PARSE_ALIGN_OBU ? "obu" : "tu", NULL);
+
+  src_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SRC_PAD (self));
+  if (!src_caps || !gst_caps_is_strictly_equal (src_caps, caps)) {
+    GST_DEBUG_OBJECT (self, "setting caps %" GST_PTR_FORMAT, caps);
+    gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (self), caps);
+  }
+
+  if (src_caps)
+    gst_caps_unref (src_caps);
+  gst_caps_unref (caps);
+
+  self->update_caps = FALSE;
+}
+
+static void
+gst_av1_parse_add_obu (GstAV1Parse * self, const guint8 * data,
+    guint32 start, const GstAV1OBU * obu)
+{
+  GstAV1ParseOBU entry;
+
+  entry.start = start;
+  entry.header_offset = start + obu->offset;
+  entry.header[0] = data[entry.header_offset];
+  entry.header[1] = obu->header.obu_extention_flag ?
+      data[entry.header_offset + 1] : 0;
+  entry.obu = *obu;
+
+  g_array_append_val (self->obus, entry);
+}
+
+/* Identifies the OBUs of the temporal unit at the start of @data in the low
+ * overhead format. Without one temporal unit per buffer, the unit ends
+ * with the next temporal delimiter. Scanning resumes where the last call
+ * stopped when more data was needed */
+static GstAV1ParserResult
+gst_av1_parse_collect_obu_stream (GstAV1Parse * self, const guint8 * data,
+    guint32 size, gboolean drain, guint32 * tu_size)
+{
+  GstAV1ParserResult res;
+  GstAV1OBU obu;
+  guint32 offset = self->scan_offset;
+  guint32 consumed;
+
+  while (offset < size) {
+    res = gst_av1_parser_identify_one_obu (self->parser, data + offset,
+        size - offset, &obu, &consumed);
+
+    if (res == GST_AV1_PARSER_OK && !self->in_packetized &&
+        !obu.header.obu_has_size_field) {
+      GST_WARNING_OBJECT (self, "OBU without obu_size in a byte stream");
+      res = GST_AV1_PARSER_BITSTREAM_ERROR;
+    }
+
+    if (res == GST_AV1_PARSER_NO_MORE_DATA && drain) {
+      GST_DEBUG_OBJECT (self, "dropping incomplete OBU at the end");
+      break;
+    } else if (res == GST_AV1_PARSER_NO_MORE_DATA) {
+      self->scan_offset = offset;
+      return res;
+    } else if (res != GST_AV1_PARSER_OK) {
+      if (self->obus->len == 0)
+        return res;
+      /* output what was identified, and skip from here later on */
+      break;
+    }
+
+    if (!self->in_packetized && self->obus->len > 0 &&
+        obu.obu_type == GST_AV1_OBU_TEMPORAL_DELIMITER)
+      break;
+
+    gst_av1_parse_add_obu (self, data, offset, &obu);
+    offset += consumed;
+  }
+
+  if (offset >= size && !drain) {
+    /* the next temporal delimiter is needed to know the unit is complete */
+    self->scan_offset = offset;
+    return GST_AV1_PARSER_NO_MORE_DATA;
+  }
+
+  if (self->obus->len == 0)
+    return GST_AV1_PARSER_NO_MORE_DATA;
+
+  *tu_size = offset;
+
+  return GST_AV1_PARSER_OK;
+}
+
+/* Identifies the OBUs of the temporal_unit() at the start of @data */
+static GstAV1ParserResult
+gst_av1_parse_collect_annexb (GstAV1Parse * self, const guint8 * data,
+    guint32 size, guint32 * tu_size)
+{
+  GstAV1ParserResult res;
+  GstAV1OBU obu;
+  guint32 unit_size, leb_size, consumed;
+  guint32 offset, tu_end, fu_end;
+
+  res = gst_av1_parse_leb128 (data, size, &unit_size, &leb_size);
+  if (res != GST_AV1_PARSER_OK)
+    return res;
+
+  if (unit_size > G_MAXUINT32 - leb_size)
+    return GST_AV1_PARSER_BITSTREAM_ERROR;
+
+  tu_end = leb_size + unit_size;
+  if (tu_end > size)
+    return GST_AV1_PARSER_NO_MORE_DATA;
+
+  offset = leb_size;
+  while (offset < tu_end) {
+    if (gst_av1_parse_leb128 (data + offset, tu_end - offset, &unit_size,
+            &leb_size) != GST_AV1_PARSER_OK)
+      goto broken;
+
+    offset += leb_size;
+    if (unit_size > tu_end - offset)
+      goto broken;
+    fu_end = offset + unit_size;
+
+    while (offset < fu_end) {
+      if (gst_av1_parser_identify_one_obu_annexb (self->parser, data + offset,
+              fu_end - offset, &obu, &consumed) != GST_AV1_PARSER_OK)
+        goto broken;
+
+      gst_av1_parse_add_obu (self, data, offset, &obu);
+      offset += consumed;
+    }
+  }
+
+  *tu_size = tu_end;
+
+  return GST_AV1_PARSER_OK;
+
+broken:
+  GST_WARNING_OBJECT (self, "invalid temporal unit of %u bytes", tu_end);
+  return GST_AV1_PARSER_BITSTREAM_ERROR;
+}
+
+static void
+gst_av1_parse_set_resolution (GstAV1Parse * self, gint width, gint height)
+{
+  if (self->width == width && self->height == height)
+    return;
+
+  GST_INFO_OBJECT (self, "resolution changed %dx%d -> %dx%d",
+      self->width, self->height, width, height);
+  self->width = width;
+  self->height = height;
+  self->update_caps = TRUE;
+}
+
+/* Parses the sequence and frame headers of the collected OBUs, and returns
+ * whether the temporal unit shows a key frame */
+static gboolean
+gst_av1_parse_process_obus (GstAV1Parse * self, const guint8 * data)
+{
+  GstAV1SequenceHeaderOBU seq_header;
+  GstAV1FrameHeaderOBU frame_header;
+  gboolean key_frame = FALSE;
+  guint i;
+
+  for (i = 0; i < self->obus->len; i++) {
+    GstAV1ParseOBU *entry = &g_array_index (self->obus, GstAV1ParseOBU, i);
+    GstAV1OBU *obu = &entry->obu;
+
+    /* the data may have been mapped elsewhere while collecting */
+    obu->data = data + entry->header_offset + obu->header_size;
+
+    switch (obu->obu_type) {
+      case GST_AV1_OBU_SEQUENCE_HEADER:
+        if (gst_av1_parser_parse_sequence_header_obu (self->parser, obu,
+                &seq_header) != GST_AV1_PARSER_OK) {
+          GST_WARNING_OBJECT (self, "Failed to parse sequence header");
+          break;
+        }
+
+        if (self->profile != seq_header.seq_profile) {
+          GST_INFO_OBJECT (self, "profile changed %d -> %d", self->profile,
+              seq_header.seq_profile);
+          self->profile = seq_header.seq_profile;
+          self->update_caps = TRUE;
+        }
+
+        /* key frames tell the actual size later on */
+        if (self->width == 0 || self->height == 0)
+          gst_av1_parse_set_resolution (self,
+              seq_header.max_frame_width_minus_1 + 1,
+              seq_header.max_frame_height_minus_1 + 1);
+        break;
+      case GST_AV1_OBU_FRAME_HEADER:
+      case GST_AV1_OBU_FRAME:
+        if (gst_av1_parser_parse_frame_header_obu (self->parser, obu,
+                &frame_header) != GST_AV1_PARSER_OK) {
+          GST_WARNING_OBJECT (self, "Failed to parse frame header");
+          break;
+        }
+
+        if (frame_header.frame_type == GST_AV1_KEY_FRAME &&
+            frame_header.show_frame)
+          key_frame = TRUE;
+
+        /* inter frames may take their size from a reference frame */
+        if (frame_header.frame_is_intra && !frame_header.show_existing_frame)
+          gst_av1_parse_set_resolution (self, frame_header.upscaled_width,
+              frame_header.frame_height);
+        break;
+      default:
+        break;
+    }
+  }
+
+  return key_frame;
+}
+
+static void
+gst_av1_parse_writer_init (GstAV1ParseWriter * writer, GstBuffer * input)
+{
+  writer->input = input;
+  writer->output = gst_buffer_new ();
+  writer->pending_size = 0;
+}
+
+static void
+gst_av1_parse_writer_put_leb128 (GstAV1ParseWriter * writer, guint32 value)
+{
+  do {
+    guint8 byte = value & 0x7f;
+
+    value >>= 7;
+    if (value)
+      byte |= 0x80;
+
+    g_assert (writer->pending_size < sizeof (writer->pending));
+    writer->pending[writer->pending_size++] = byte;
+  } while (value);
+}
+
+static void
+gst_av1_parse_writer_put_bytes (GstAV1ParseWriter * writer,
+    const guint8 * data, guint size)
+{
+  g_assert (writer->pending_size + size <= sizeof (writer->pending));
+
+  memcpy (writer->pending + writer->pending_size, data, size);
+  writer->pending_size += size;
+}
+
+static void
+gst_av1_parse_writer_flush (GstAV1ParseWriter * writer)
+{
+  gpointer data;
+
+  if (writer->pending_size == 0)
+    return;
+
+  data = g_memdup (writer->pending, writer->pending_size);
+  gst_buffer_append_memory (writer->output,
+      gst_memory_new_wrapped (0, data, writer->pending_size, 0,
+          writer->pending_size, data, g_free));
+  writer->pending_size = 0;
+}
+
+static void
+gst_av1_parse_writer_put_region (GstAV1ParseWriter * writer, guint32 offset,
+    guint32 size)
+{
+  gst_av1_parse_writer_flush (writer);
+
+  if (size > 0)
+    gst_buffer_copy_into (writer->output, writer->input,
+        GST_BUFFER_COPY_MEMORY, offset, size);
+}
+
+/* Writes an OBU in the low overhead format, adding the obu_size field if
+ * the OBU doesn't have one */
+static void
+gst_av1_parse_writer_put_obu (GstAV1ParseWriter * writer,
+    const GstAV1ParseOBU * entry)
+{
+  const GstAV1OBU *obu = &entry->obu;
+  guint8 header[2];
+
+  if (obu->header.obu_has_size_field) {
+    gst_av1_parse_writer_put_region (writer, entry->header_offset,
+        obu->header_size + obu->obu_size);
+    return;
+  }
+
+  header[0] = entry->header[0] | 0x02;
+  header[1] = entry->header[1];
+  gst_av1_parse_writer_put_bytes (writer, header,
+      obu->header.obu_extention_flag ? 2 : 1);
+  gst_av1_parse_writer_put_leb128 (writer, obu->obu_size);
+  gst_av1_parse_writer_put_region (writer,
+      entry->header_offset + obu->header_size, obu->obu_size);
+}
+
+static GstBuffer *
+gst_av1_parse_writer_finish (GstAV1ParseWriter * writer)
+{
+  gst_av1_parse_writer_flush (writer);
+  gst_buffer_copy_into (writer->output, writer->input,
+      GST_BUFFER_COPY_METADATA, 0, -1);
+
+  return writer->output;
+}
+
+static guint
+gst_av1_parse_leb128_size (guint32 value)
+{
+  guint size = 1;
+
+  while (value >>= 7)
+    size++;
+
+  return size;
+}
+
+static gboolean
+gst_av1_parse_is_frame_header (const GstAV1ParseOBU * entry)
+{
+  return entry->obu.obu_type == GST_AV1_OBU_FRAME_HEADER ||
+      entry->obu.obu_type == GST_AV1_OBU_FRAME;
+}
+
+/* Builds the temporal unit in Annex B format. Each frame header starts a
+ * new frame unit, the OBUs before the first one go to the first unit */
+static GstBuffer *
+gst_av1_parse_build_annexb (GstAV1Parse * self, GstBuffer * buffer)
+{
+  GstAV1ParseWriter writer;
+  GArray *fu_sizes;
+  guint32 fu_size = 0, tu_size = 0;
+  gboolean seen_frame_header = FALSE;
+  guint i, fu = 0;
+
+  fu_sizes = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  for (i = 0; i < self->obus->len; i++) {
+    GstAV1ParseOBU *entry = &g_array_index (self->obus, GstAV1ParseOBU, i);
+    guint32 obu_length = entry->obu.header_size + entry->obu.obu_size;
+
+    if (gst_av1_parse_is_frame_header (entry)) {
+      if (seen_frame_header) {
+        g_array_append_val (fu_sizes, fu_size);
+        tu_size += gst_av1_parse_leb128_size (fu_size) + fu_size;
+        fu_size = 0;
+      }
+      seen_frame_header = TRUE;
+    }
+
+    fu_size += gst_av1_parse_leb128_size (obu_length) + obu_length;
+  }
+  g_array_append_val (fu_sizes, fu_size);
+  tu_size += gst_av1_parse_leb128_size (fu_size) + fu_size;
+
+  gst_av1_parse_writer_init (&writer, buffer);
+  gst_av1_parse_writer_put_leb128 (&writer, tu_size);
+  gst_av1_parse_writer_put_leb128 (&writer,
+      g_array_index (fu_sizes, guint32, 0));
+
+  seen_frame_header = FALSE;
+  for (i = 0; i < self->obus->len; i++) {
+    GstAV1ParseOBU *entry = &g_array_index (self->obus, GstAV1ParseOBU, i);
+    guint32 obu_length = entry->obu.header_size + entry->obu.obu_size;
+
+    if (gst_av1_parse_is_frame_header (entry)) {
+      if (seen_frame_header)
+        gst_av1_parse_writer_put_leb128 (&writer,
+            g_array_index (fu_sizes, guint32, ++fu));
+      seen_frame_header = TRUE;
+    }
+
+    gst_av1_parse_writer_put_leb128 (&writer, obu_length);
+    gst_av1_parse_writer_put_region (&writer, entry->header_offset,
+        obu_length);
+  }
+
+  g_array_unref (fu_sizes);
+
+  return gst_av1_parse_writer_finish (&writer);
+}
+
+/* Builds the temporal unit in low overhead format, starting with a
+ * temporal delimiter and with all OBUs having an obu_size field */
+static GstBuffer *
+gst_av1_parse_build_obu_stream (GstAV1Parse * self, GstBuffer * buffer)
+{
+  static const guint8 temporal_delimiter[] = { 0x12, 0x00 };
+  GstAV1ParseWriter writer;
+  guint i;
+
+  gst_av1_parse_writer_init (&writer, buffer);
+
+  if (g_array_index (self->obus, GstAV1ParseOBU, 0).obu.obu_type !=
+      GST_AV1_OBU_TEMPORAL_DELIMITER)
+    gst_av1_parse_writer_put_bytes (&writer, temporal_delimiter,
+        sizeof (temporal_delimiter));
+
+  for (i = 0; i < self->obus->len; i++)
+    gst_av1_parse_writer_put_obu (&writer,
+        &g_array_index (self->obus, GstAV1ParseOBU, i));
+
+  return gst_av1_parse_writer_finish (&writer);
+}
+
+/* Whether the collected temporal unit can be output as is */
+static gboolean
+gst_av1_parse_is_passthrough (GstAV1Parse * self)
+{
+  guint i;
+
+  if (self->in_format != self->format)
+    return FALSE;
+
+  if (self->format == GST_AV1_PARSE_FORMAT_ANNEXB)
+    return TRUE;
+
+  if (g_array_index (self->obus, GstAV1ParseOBU, 0).obu.obu_type !=
+      GST_AV1_OBU_TEMPORAL_DELIMITER)
+    return FALSE;
+
+  for (i = 0; i < self->obus->len; i++) {
+    GstAV1ParseOBU *entry = &g_array_index (self->obus, GstAV1ParseOBU, i);
+
+    if (!entry->obu.header.obu_has_size_field)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_av1_parse_annotate (GstBuffer * buffer, gboolean key_frame)
+{
+  if (key_frame)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+}
+
+/* Outputs each OBU of the temporal unit in its own buffer */
+static GstFlowReturn
+gst_av1_parse_finish_obus (GstAV1Parse * self, GstBaseParseFrame * frame,
+    guint32 tu_size, gboolean key_frame)
+{
+  GstBaseParse *parse = GST_BASE_PARSE (self);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buffer;
+  guint32 prev_end = 0;
+  guint i;
+
+  /* need to save buffer from invalidation upon _finish_frame */
+  buffer = gst_buffer_copy (frame->buffer);
+
+  for (i = 0; i < self->obus->len && ret == GST_FLOW_OK; i++) {
+    GstAV1ParseOBU *entry = &g_array_index (self->obus, GstAV1ParseOBU, i);
+    GstBaseParseFrame tmp_frame;
+    guint32 end;
+
+    gst_base_parse_frame_init (&tmp_frame);
+    tmp_frame.flags |= frame->flags;
+    tmp_frame.offset = frame->offset;
+    tmp_frame.overhead = frame->overhead;
+
+    if (entry->obu.header.obu_has_size_field) {
+      tmp_frame.buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+          entry->header_offset,
+          entry->obu.header_size + entry->obu.obu_size);
+    } else {
+      GstAV1ParseWriter writer;
+
+      gst_av1_parse_writer_init (&writer, buffer);
+      gst_av1_parse_writer_put_obu (&writer, entry);
+      tmp_frame.buffer = gst_av1_parse_writer_finish (&writer);
+    }
+    gst_av1_parse_annotate (tmp_frame.buffer, key_frame);
+    tmp_frame.out_buffer = gst_buffer_ref (tmp_frame.buffer);
+
+    /* sizes and trailing data of the input go along with the OBUs */
+    if (i + 1 < self->obus->len)
+      end = g_array_index (self->obus, GstAV1ParseOBU, i + 1).start;
+    else
+      end = tu_size;
+
+    ret = gst_base_parse_finish_frame (parse, &tmp_frame, end - prev_end);
+    prev_end = end;
+  }
+
+  gst_buffer_unref (buffer);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_av1_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
+    gint * skipsize)
+{
+  GstAV1Parse *self = GST_AV1_PARSE (parse);
+  GstBuffer *buffer = frame->buffer;
+  GstAV1ParserResult res;
+  GstFlowReturn ret;
+  GstMapInfo map;
+  gboolean drain, key_frame;
+  guint32 tu_size = 0;
+
+  if (self->format == GST_AV1_PARSE_FORMAT_NONE ||
+      gst_pad_check_reconfigure (GST_BASE_PARSE_SRC_PAD (parse)))
+    gst_av1_parse_negotiate (self);
+
+  /* avoid stale cached parsing state */
+  if (frame->flags & GST_BASE_PARSE_FRAME_FLAG_NEW_FRAME)
+    gst_av1_parse_reset_frame (self);
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (parse, CORE, NOT_IMPLEMENTED, (NULL),
+        ("Couldn't map incoming buffer"));
+    return GST_FLOW_ERROR;
+  }
+
+  /* the whole input buffer is consumed with one temporal unit per buffer */
+  drain = GST_BASE_PARSE_DRAINING (parse) || self->in_packetized;
+
+  if (self->in_format == GST_AV1_PARSE_FORMAT_ANNEXB)
+    res = gst_av1_parse_collect_annexb (self, map.data, map.size, &tu_size);
+  else
+    res = gst_av1_parse_collect_obu_stream (self, map.data, map.size, drain,
+        &tu_size);
+
+  if (res == GST_AV1_PARSER_NO_MORE_DATA) {
+    gst_buffer_unmap (buffer, &map);
+    *skipsize = 0;
+    return GST_FLOW_OK;
+  } else if (res != GST_AV1_PARSER_OK) {
+    GST_DEBUG_OBJECT (self, "invalid data, skipping");
+    gst_buffer_unmap (buffer, &map);
+    gst_av1_parse_reset_frame (self);
+    *skipsize = 1;
+    return GST_FLOW_OK;
+  }
+
+  key_frame = gst_av1_parse_process_obus (self, map.data);
+  gst_buffer_unmap (buffer, &map);
+
+  gst_av1_parse_update_src_caps (self);
+
+  if (self->align == GST_AV1_PARSE_ALIGN_OBU) {
+    ret = gst_av1_parse_finish_obus (self, frame, tu_size, key_frame);
+  } else {
+    if (!gst_av1_parse_is_passthrough (self)) {
+      if (self->format == GST_AV1_PARSE_FORMAT_ANNEXB)
+        frame->out_buffer = gst_av1_parse_build_annexb (self, buffer);
+      else
+        frame->out_buffer = gst_av1_parse_build_obu_stream (self, buffer);
+      gst_av1_parse_annotate (frame->out_buffer, key_frame);
+    }
+
+    gst_av1_parse_annotate (buffer, key_frame);
+    ret = gst_base_parse_finish_frame (parse, frame, tu_size);
+  }
+
+  gst_av1_parse_reset_frame (self);
+
+  return ret;
+}
@@ -0,0 +1,73 @@
+/* GStreamer AV1 Parser
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_AV1_PARSE_H__
+#define __GST_AV1_PARSE_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbaseparse.h>
+#include <gst/codecparsers/gstav1parser.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_AV1_PARSE \
+  (gst_av1_parse_get_type())
+#define GST_AV1_PARSE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_AV1_PARSE,GstAV1Parse))
+#define GST_AV1_PARSE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_AV1_PARSE,GstAV1ParseClass))
+#define GST_IS_AV1_PARSE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_AV1_PARSE))
+#define GST_IS_AV1_PARSE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_AV1_PARSE))
+
+GType gst_av1_parse_get_type (void);
+
+typedef struct _GstAV1Parse GstAV1Parse;
+typedef struct _GstAV1ParseClass GstAV1ParseClass;
+
+struct _GstAV1Parse
+{
+  GstBaseParse baseparse;
+
+  /* stream */
+  gint width, height;
+  GstAV1Profile profile;
+  gboolean update_caps;
+
+  /* input and output configuration */
+  guint in_format;
+  gboolean in_packetized;
+  guint format;
+  guint align;
+
+  /* state */
+  GstAV1Parser *parser;
+  GArray *obus;
+  guint32 scan_offset;
+};
+
+struct _GstAV1ParseClass
+{
+  GstBaseParseClass parent_class;
+};
+
+G_END_DECLS
+
+#endif
@@ -37,11 +37,13 @@ GST_DEBUG_CATEGORY (h264_parse_debug);
 #define GST_CAT_DEFAULT h264_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_LIGHT_PARSE          FALSE
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_LIGHT_PARSE
 };
 
 enum
@@ -144,6 +146,25 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
           -1, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstH264Parse:light-parse:
+   *
+   * Only look at NAL unit headers to find access unit boundaries and key
+   * frames (IDR pictures). Slice headers and SEI messages are not parsed,
+   * so no closed captions, timecodes or HDR metadata are extracted and
+   * intra-only (non-IDR) pictures are not flagged as key frames.
+   *
+   * When both input and output are byte-stream with au alignment, the
+   * input buffers are pushed as is and the slice data is not scanned.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_LIGHT_PARSE,
+      g_param_spec_boolean ("light-parse", "Light parse",
+          "Only parse NAL unit headers to find access units and key frames",
+          DEFAULT_LIGHT_PARSE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h264_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h264_parse_stop);
@@ -208,6 +229,7 @@ gst_h264_parse_reset_frame (GstH264Parse * h264parse)
   h264parse->aud_insert = TRUE;
   h264parse->have_sps_in_frame = FALSE;
   h264parse->have_pps_in_frame = FALSE;
+  h264parse->frame_in_start = h264parse->frame_in_end = 0;
   gst_adapter_clear (h264parse->frame_out);
 }
 
@@ -240,6 +262,7 @@ gst_h264_parse_reset_stream_info (GstH264Parse * h264parse)
   h264parse->format = GST_H264_PARSE_FORMAT_NONE;
 
   h264parse->transform = FALSE;
+  h264parse->light_au = FALSE;
   h264parse->nal_length_size = 4;
   h264parse->packetized = FALSE;
   h264parse->push_codec = FALSE;
@@ -438,21 +461,27 @@ gst_h264_parse_negotiate (GstH264Parse * h264parse, gint in_format,
   h264parse->transform = in_format != h264parse->format ||
       align == GST_H264_PARSE_ALIGN_AU;
 
+  /* in light mode, AU aligned byte-stream is forwarded untouched */
+  h264parse->light_au = h264parse->light_parse &&
+      in_format == GST_H264_PARSE_FORMAT_BYTE && in_format == format &&
+      h264parse->in_align == GST_H264_PARSE_ALIGN_AU &&
+      align == GST_H264_PARSE_ALIGN_AU;
+  if (h264parse->light_au)
+    h264parse->transform = FALSE;
+
   if (caps)
     gst_caps_unref (caps);
 }
 
-static GstBuffer *
-gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
-    guint size)
+/* fills in the start code or length prefix of a @size bytes NAL in @format
+ * and returns its length */
+static guint
+gst_h264_parse_nal_prefix (GstH264Parse * h264parse, guint format, guint size,
+    guint8 * prefix)
 {
-  GstBuffer *buf;
   guint nl = h264parse->nal_length_size;
   guint32 tmp;
 
-  GST_DEBUG_OBJECT (h264parse, "nal length %d", size);
-
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   if (format == GST_H264_PARSE_FORMAT_AVC
       || format == GST_H264_PARSE_FORMAT_AVC3) {
     tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
@@ -464,13 +493,104 @@ gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
     tmp = GUINT32_TO_BE (1);
   }
 
-  gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
+  memcpy (prefix, &tmp, sizeof (guint32));
+
+  return nl;
+}
+
+static GstBuffer *
+gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
+    guint size)
+{
+  GstBuffer *buf;
+  guint8 prefix[4];
+  guint nl;
+
+  GST_DEBUG_OBJECT (h264parse, "nal length %d", size);
+
+  nl = gst_h264_parse_nal_prefix (h264parse, format, size, prefix);
+  buf = gst_buffer_new_allocate (NULL, nl + size, NULL);
+  gst_buffer_fill (buf, 0, prefix, nl);
   gst_buffer_fill (buf, nl, data, size);
-  gst_buffer_set_size (buf, size + nl);
 
   return buf;
 }
 
+/* moves the pending region of the input buffer to frame_out */
+static void
+gst_h264_parse_flush_frame_in (GstH264Parse * h264parse)
+{
+  if (h264parse->frame_in_end > h264parse->frame_in_start) {
+    gst_adapter_push (h264parse->frame_out,
+        gst_buffer_copy_region (h264parse->frame_in, GST_BUFFER_COPY_MEMORY,
+            h264parse->frame_in_start,
+            h264parse->frame_in_end - h264parse->frame_in_start));
+  }
+  h264parse->frame_in_start = h264parse->frame_in_end = 0;
+}
+
+/* sets the buffer, mapped at @data, that subsequently processed NALs come
+ * from; NULL when done with it */
+static void
+gst_h264_parse_set_frame_in (GstH264Parse * h264parse, GstBuffer * buffer,
+    const guint8 * data)
+{
+  gst_h264_parse_flush_frame_in (h264parse);
+  h264parse->frame_in = buffer;
+  h264parse->frame_in_data = data;
+}
+
+/* size of the transformed frame collected so far */
+static guint
+gst_h264_parse_frame_out_size (GstH264Parse * h264parse)
+{
+  return gst_adapter_available (h264parse->frame_out) +
+      h264parse->frame_in_end - h264parse->frame_in_start;
+}
+
+/* collects properly prefixed @nalu in frame_out. NALs of the input buffer
+ * are referenced rather than copied, and those already carrying the right
+ * prefix are merged with their neighbours, so only converted prefixes need
+ * new memory */
+static void
+gst_h264_parse_collect_frame_out (GstH264Parse * h264parse,
+    GstH264NalUnit * nalu)
+{
+  GstBuffer *buf;
+  guint8 prefix[4];
+  gint start, nl;
+
+  if (h264parse->frame_in == NULL || nalu->data != h264parse->frame_in_data) {
+    gst_h264_parse_flush_frame_in (h264parse);
+    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
+        nalu->data + nalu->offset, nalu->size);
+    gst_adapter_push (h264parse->frame_out, buf);
+    return;
+  }
+
+  nl = gst_h264_parse_nal_prefix (h264parse, h264parse->format, nalu->size,
+      prefix);
+  start = nalu->offset - nl;
+
+  if (start >= (gint) nalu->sc_offset
+      && memcmp (nalu->data + start, prefix, nl) == 0) {
+    if (h264parse->frame_in_end <= h264parse->frame_in_start
+        || h264parse->frame_in_end != start) {
+      gst_h264_parse_flush_frame_in (h264parse);
+      h264parse->frame_in_start = start;
+    }
+    h264parse->frame_in_end = nalu->offset + nalu->size;
+    return;
+  }
+
+  gst_h264_parse_flush_frame_in (h264parse);
+  buf = gst_buffer_new_allocate (NULL, nl, NULL);
+  gst_buffer_fill (buf, 0, prefix, nl);
+  gst_buffer_copy_into (buf, h264parse->frame_in, GST_BUFFER_COPY_MEMORY,
+      nalu->offset, nalu->size);
+  gst_adapter_push (h264parse->frame_out, buf);
+}
+
 static void
 gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     GstH264NalUnitType naltype, GstH264NalUnit * nalu)
@@ -875,8 +995,10 @@ static gboolean
 gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
 {
   guint nal_type;
-  GstH264PPS pps = { 0, };
-  GstH264SPS sps = { 0, };
+  GstH264PPS *pps;
+  GstH264SPS *sps;
+  GstH264PPS broken_pps = { 0, };
+  guint pps_id;
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264ParserResult pres;
   GstH264SliceHdr slice;
@@ -897,16 +1019,15 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     case GST_H264_NAL_SUBSET_SPS:
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
-      pres = gst_h264_parser_parse_subset_sps (nalparser, nalu, &sps);
       goto process_sps;
 
     case GST_H264_NAL_SPS:
       /* reset state, everything else is obsolete */
       h264parse->state = 0;
-      pres = gst_h264_parser_parse_sps (nalparser, nalu, &sps);
 
     process_sps:
-      /* arranged for a fallback sps.id, so use that one and only warn */
+      /* the SPS stays in nalparser, a repeated one is not parsed again */
+      pres = gst_h264_parser_update_sps (nalparser, nalu, &sps, NULL);
       if (pres != GST_H264_PARSER_OK) {
         GST_WARNING_OBJECT (h264parse, "failed to parse SPS:");
         h264parse->state |= GST_H264_PARSE_STATE_GOT_SPS;
@@ -927,8 +1048,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
-      gst_h264_sps_clear (&sps);
+      gst_h264_parser_store_nal (h264parse, sps->id, nal_type, nalu);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_SPS;
       h264parse->header = TRUE;
       break;
@@ -938,12 +1058,19 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
 
-      pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
-      /* arranged for a fallback pps.id, so use that one and only warn */
-      if (pres != GST_H264_PARSER_OK) {
+      pres = gst_h264_parser_update_pps (nalparser, nalu, &pps, NULL);
+      if (pres == GST_H264_PARSER_OK) {
+        pps_id = pps->id;
+      } else {
         GST_WARNING_OBJECT (h264parse, "failed to parse PPS:");
         if (pres != GST_H264_PARSER_BROKEN_LINK)
           return FALSE;
+
+        /* not stored, but arranged for a fallback pps.id, so use that one
+         * and only warn */
+        gst_h264_parse_pps (nalparser, nalu, &broken_pps);
+        pps_id = broken_pps.id;
+        gst_h264_pps_clear (&broken_pps);
       }
 
       /* parameters might have changed, force caps check */
@@ -962,8 +1089,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
-      gst_h264_pps_clear (&pps);
+      gst_h264_parser_store_nal (h264parse, pps_id, nal_type, nalu);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_PPS;
       h264parse->header = TRUE;
       break;
@@ -973,11 +1099,12 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         return FALSE;
 
       h264parse->header = TRUE;
-      gst_h264_parse_process_sei (h264parse, nalu);
+      if (!h264parse->light_parse)
+        gst_h264_parse_process_sei (h264parse, nalu);
       /* mark SEI pos */
       if (h264parse->sei_pos == -1) {
         if (h264parse->transform)
-          h264parse->sei_pos = gst_adapter_available (h264parse->frame_out);
+          h264parse->sei_pos = gst_h264_parse_frame_out_size (h264parse);
         else
           h264parse->sei_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h264parse, "marking SEI in frame at offset %d",
@@ -1008,6 +1135,17 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (nal_type == GST_H264_NAL_SLICE_EXT && !GST_H264_IS_MVC_NALU (nalu))
         break;
 
+      if (h264parse->light_parse) {
+        /* only the NAL unit type tells about key frames */
+        if (nal_type == GST_H264_NAL_SLICE_IDR)
+          h264parse->keyframe = TRUE;
+        h264parse->state |= GST_H264_PARSE_STATE_GOT_SLICE;
+        /* all that is known is whether first_mb_in_slice is 0 */
+        slice.first_mb_in_slice = (nalu->size > nalu->header_bytes &&
+            (nalu->data[nalu->offset + nalu->header_bytes] & 0x80)) ? 0 : 1;
+        goto slice_done;
+      }
+
       pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
           FALSE, FALSE);
       GST_DEBUG_OBJECT (h264parse,
@@ -1026,6 +1164,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->field_pic_flag = slice.field_pic_flag;
       }
 
+    slice_done:
       if (G_LIKELY (nal_type != GST_H264_NAL_SLICE_IDR &&
               !h264parse->push_codec))
         break;
@@ -1037,7 +1176,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       /* mind replacement buffer if applicable */
       if (h264parse->idr_pos == -1) {
         if (h264parse->transform)
-          h264parse->idr_pos = gst_adapter_available (h264parse->frame_out);
+          h264parse->idr_pos = gst_h264_parse_frame_out_size (h264parse);
         else
           h264parse->idr_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h264parse, "marking IDR in frame at offset %d",
@@ -1086,12 +1225,8 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   /* if AVC output needed, collect properly prefixed nal in adapter,
    * and use that to replace outgoing buffer data later on */
   if (h264parse->transform) {
-    GstBuffer *buf;
-
     GST_LOG_OBJECT (h264parse, "collecting NAL in AVC frame");
-    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-        nalu->data + nalu->offset, nalu->size);
-    gst_adapter_push (h264parse->frame_out, buf);
+    gst_h264_parse_collect_frame_out (h264parse, nalu);
   }
   return TRUE;
 }
@@ -1176,6 +1311,7 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
     buffer = gst_buffer_copy (frame->buffer);
 
   gst_buffer_map (buffer, &map, GST_MAP_READ);
+  gst_h264_parse_set_frame_in (h264parse, buffer, map.data);
 
   left = map.size;
 
@@ -1215,6 +1351,7 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
         map.data, nalu.offset + nalu.size, map.size, nl, &nalu);
   }
 
+  gst_h264_parse_set_frame_in (h264parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
 
   if (!h264parse->split_packetized) {
@@ -1350,10 +1487,22 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
     }
   }
 
+  gst_h264_parse_set_frame_in (h264parse, buffer, data);
+
   while (TRUE) {
-    pres =
-        gst_h264_parser_identify_nalu (nalparser, data, current_off, size,
-        &nalu);
+    /* in light mode, the first slice ends the AU: whatever follows is
+     * pushed along with it without scanning for more start codes */
+    if (h264parse->light_au) {
+      pres = gst_h264_parser_identify_nalu_unchecked (nalparser, data,
+          current_off, size, &nalu);
+      nonext = pres == GST_H264_PARSER_OK &&
+          nalu.type >= GST_H264_NAL_SLICE &&
+          nalu.type <= GST_H264_NAL_SLICE_IDR;
+    }
+
+    if (!nonext)
+      pres = gst_h264_parser_identify_nalu (nalparser, data, current_off,
+          size, &nalu);
 
     switch (pres) {
       case GST_H264_PARSER_OK:
@@ -1472,6 +1621,7 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
 end:
   framesize = nalu.offset + nalu.size;
 
+  gst_h264_parse_set_frame_in (h264parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
 
   gst_h264_parse_parse_frame (parse, frame);
@@ -1487,6 +1637,7 @@ more:
 
   /* Fall-through. */
 out:
+  gst_h264_parse_set_frame_in (h264parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
   return GST_FLOW_OK;
 
@@ -1506,6 +1657,7 @@ skip:
   goto out;
 
 invalid_stream:
+  gst_h264_parse_set_frame_in (h264parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
   return GST_FLOW_ERROR;
 }
@@ -2465,12 +2617,14 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     h264parse->discont = FALSE;
   }
 
-  /* replace with transformed AVC output if applicable */
+  /* replace with transformed AVC output if applicable, made up of the
+   * collected memories as is */
+  gst_h264_parse_flush_frame_in (h264parse);
   av = gst_adapter_available (h264parse->frame_out);
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h264parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h264parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2633,15 +2787,15 @@ gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
       }
     }
   } else {
-    /* insert config NALs into AU */
+    /* insert config NALs into AU, in between references to its data */
     GstByteWriter bw;
-    GstBuffer *new_buf;
+    GstBuffer *new_buf, *config;
     const gboolean bs = h264parse->format == GST_H264_PARSE_FORMAT_BYTE;
     const gint nls = 4 - h264parse->nal_length_size;
     gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h264parse->idr_pos);
+    gst_byte_writer_init (&bw);
+    ok = TRUE;
     GST_DEBUG_OBJECT (h264parse, "- inserting SPS/PPS");
     for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
       if ((codec_nal = h264parse->sps_nals[i])) {
@@ -2674,9 +2828,15 @@ gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
         send_done = TRUE;
       }
     }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h264parse->idr_pos, -1);
+    config = gst_byte_writer_reset_and_get_buffer (&bw);
+    new_buf = gst_buffer_new ();
+    if (h264parse->idr_pos > 0)
+      ok &= gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY, 0,
+          h264parse->idr_pos);
+    new_buf = gst_buffer_append (new_buf, config);
+    ok &= gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY,
+        h264parse->idr_pos, -1);
     /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
     gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     /* should already be keyframe/IDR, but it may not have been,
      * so mark it as such to avoid being discarded by picky decoder */
@@ -2739,7 +2899,11 @@ gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
           gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, (guint8 *) au_delim,
           sizeof (au_delim), 0, sizeof (au_delim), NULL, NULL);
 
-      frame->out_buffer = gst_buffer_copy (frame->buffer);
+      /* keep a transformed AU, prepending to it doesn't copy either */
+      if (frame->out_buffer)
+        frame->out_buffer = gst_buffer_make_writable (frame->out_buffer);
+      else
+        frame->out_buffer = gst_buffer_copy (frame->buffer);
       gst_buffer_prepend_memory (frame->out_buffer, mem);
       if (h264parse->idr_pos >= 0)
         h264parse->idr_pos += sizeof (au_delim);
@@ -3105,6 +3269,8 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
     /* probably AVC3 without codec_data field, anything to do here? */
   }
 
+  h264parse->in_align = align;
+
   {
     GstCaps *in_caps;
 
@@ -3136,8 +3302,6 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
     h264parse->packetized = TRUE;
   }
 
-  h264parse->in_align = align;
-
   return TRUE;
 
   /* ERRORS */
@@ -3363,6 +3527,9 @@ gst_h264_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_int (value);
       break;
+    case PROP_LIGHT_PARSE:
+      parse->light_parse = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3381,6 +3548,9 @@ gst_h264_parse_get_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       g_value_set_int (value, parse->interval);
       break;
+    case PROP_LIGHT_PARSE:
+      g_value_set_boolean (value, parse->light_parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -70,6 +70,8 @@ struct _GstH264Parse
   gboolean packetized;
   gboolean split_packetized;
   gboolean transform;
+  /* light parsing of AU aligned byte-stream, passed through untouched */
+  gboolean light_au;
 
   /* state */
   GstH264NalParser *nalparser;
@@ -123,6 +125,11 @@ struct _GstH264Parse
   gint idr_pos, sei_pos;
   gboolean update_caps;
   GstAdapter *frame_out;
+  /* input buffer the NALs being processed point into, and the region of it
+   * that can go to frame_out as is, so payloads are referenced, not copied */
+  GstBuffer *frame_in;
+  const guint8 *frame_in_data;
+  gint frame_in_start, frame_in_end;
   gboolean keyframe;
   gboolean predicted;
   gboolean bidirectional;
@@ -133,6 +140,7 @@ struct _GstH264Parse
 
   /* props */
   gint interval;
+  gboolean light_parse;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
@@ -32,11 +32,13 @@ GST_DEBUG_CATEGORY (h265_parse_debug);
 #define GST_CAT_DEFAULT h265_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_LIGHT_PARSE          FALSE
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_LIGHT_PARSE
 };
 
 enum
@@ -139,6 +141,26 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
           "(0 = disabled, -1 = send with every IDR frame)",
           -1, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstH265Parse:light-parse:
+   *
+   * Only look at NAL unit headers to find access unit boundaries and key
+   * frames (IRAP pictures). Slice segment headers and SEI messages are not
+   * parsed, so no closed captions, timecodes or HDR metadata are extracted
+   * and intra-only pictures that are not IRAP are not flagged as key frames.
+   *
+   * When both input and output are byte-stream with au alignment, the
+   * input buffers are pushed as is and the slice data is not scanned.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_LIGHT_PARSE,
+      g_param_spec_boolean ("light-parse", "Light parse",
+          "Only parse NAL unit headers to find access units and key frames",
+          DEFAULT_LIGHT_PARSE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h265_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h265_parse_stop);
@@ -199,6 +221,7 @@ gst_h265_parse_reset_frame (GstH265Parse * h265parse)
   h265parse->have_vps_in_frame = FALSE;
   h265parse->have_sps_in_frame = FALSE;
   h265parse->have_pps_in_frame = FALSE;
+  h265parse->frame_in_start = h265parse->frame_in_end = 0;
   gst_adapter_clear (h265parse->frame_out);
 }
 
@@ -227,6 +250,7 @@ gst_h265_parse_reset_stream_info (GstH265Parse * h265parse)
   h265parse->format = GST_H265_PARSE_FORMAT_NONE;
 
   h265parse->transform = FALSE;
+  h265parse->light_au = FALSE;
   h265parse->nal_length_size = 4;
   h265parse->packetized = FALSE;
   h265parse->push_codec = FALSE;
@@ -414,21 +438,27 @@ gst_h265_parse_negotiate (GstH265Parse * h265parse, gint in_format,
   h265parse->transform = in_format != h265parse->format ||
       align == GST_H265_PARSE_ALIGN_AU;
 
+  /* in light mode, AU aligned byte-stream is forwarded untouched */
+  h265parse->light_au = h265parse->light_parse &&
+      in_format == GST_H265_PARSE_FORMAT_BYTE && in_format == format &&
+      h265parse->in_align == GST_H265_PARSE_ALIGN_AU &&
+      align == GST_H265_PARSE_ALIGN_AU;
+  if (h265parse->light_au)
+    h265parse->transform = FALSE;
+
   if (caps)
     gst_caps_unref (caps);
 }
 
-static GstBuffer *
-gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
-    guint size)
+/* fills in the start code or length prefix of a @size bytes NAL in @format
+ * and returns its length */
+static guint
+gst_h265_parse_nal_prefix (GstH265Parse * h265parse, guint format, guint size,
+    guint8 * prefix)
 {
-  GstBuffer *buf;
   guint nl = h265parse->nal_length_size;
   guint32 tmp;
 
-  GST_DEBUG_OBJECT (h265parse, "nal length %d", size);
-
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   if (format == GST_H265_PARSE_FORMAT_HVC1
       || format == GST_H265_PARSE_FORMAT_HEV1) {
     tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
@@ -440,13 +470,104 @@ gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
     tmp = GUINT32_TO_BE (1);
   }
 
-  gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
+  memcpy (prefix, &tmp, sizeof (guint32));
+
+  return nl;
+}
+
+static GstBuffer *
+gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
+    guint size)
+{
+  GstBuffer *buf;
+  guint8 prefix[4];
+  guint nl;
+
+  GST_DEBUG_OBJECT (h265parse, "nal length %d", size);
+
+  nl = gst_h265_parse_nal_prefix (h265parse, format, size, prefix);
+  buf = gst_buffer_new_allocate (NULL, nl + size, NULL);
+  gst_buffer_fill (buf, 0, prefix, nl);
   gst_buffer_fill (buf, nl, data, size);
-  gst_buffer_set_size (buf, size + nl);
 
   return buf;
 }
 
+/* moves the pending region of the input buffer to frame_out */
+static void
+gst_h265_parse_flush_frame_in (GstH265Parse * h265parse)
+{
+  if (h265parse->frame_in_end > h265parse->frame_in_start) {
+    gst_adapter_push (h265parse->frame_out,
+        gst_buffer_copy_region (h265parse->frame_in, GST_BUFFER_COPY_MEMORY,
+            h265parse->frame_in_start,
+            h265parse->frame_in_end - h265parse->frame_in_start));
+  }
+  h265parse->frame_in_start = h265parse->frame_in_end = 0;
+}
+
+/* sets the buffer, mapped at @data, that subsequently processed NALs come
+ * from; NULL when done with it */
+static void
+gst_h265_parse_set_frame_in (GstH265Parse * h265parse, GstBuffer * buffer,
+    const guint8 * data)
+{
+  gst_h265_parse_flush_frame_in (h265parse);
+  h265parse->frame_in = buffer;
+  h265parse->frame_in_data = data;
+}
+
+/* size of the transformed frame collected so far */
+static guint
+gst_h265_parse_frame_out_size (GstH265Parse * h265parse)
+{
+  return gst_adapter_available (h265parse->frame_out) +
+      h265parse->frame_in_end - h265parse->frame_in_start;
+}
+
+/* collects properly prefixed @nalu in frame_out. NALs of the input buffer
+ * are referenced rather than copied, and those already carrying the right
+ * prefix are merged with their neighbours, so only converted prefixes need
+ * new memory */
+static void
+gst_h265_parse_collect_frame_out (GstH265Parse * h265parse,
+    GstH265NalUnit * nalu)
+{
+  GstBuffer *buf;
+  guint8 prefix[4];
+  gint start, nl;
+
+  if (h265parse->frame_in == NULL || nalu->data != h265parse->frame_in_data) {
+    gst_h265_parse_flush_frame_in (h265parse);
+    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
+        nalu->data + nalu->offset, nalu->size);
+    gst_adapter_push (h265parse->frame_out, buf);
+    return;
+  }
+
+  nl = gst_h265_parse_nal_prefix (h265parse, h265parse->format, nalu->size,
+      prefix);
+  start = nalu->offset - nl;
+
+  if (start >= (gint) nalu->sc_offset
+      && memcmp (nalu->data + start, prefix, nl) == 0) {
+    if (h265parse->frame_in_end <= h265parse->frame_in_start
+        || h265parse->frame_in_end != start) {
+      gst_h265_parse_flush_frame_in (h265parse);
+      h265parse->frame_in_start = start;
+    }
+    h265parse->frame_in_end = nalu->offset + nalu->size;
+    return;
+  }
+
+  gst_h265_parse_flush_frame_in (h265parse);
+  buf = gst_buffer_new_allocate (NULL, nl, NULL);
+  gst_buffer_fill (buf, 0, prefix, nl);
+  gst_buffer_copy_into (buf, h265parse->frame_in, GST_BUFFER_COPY_MEMORY,
+      nalu->offset, nalu->size);
+  gst_adapter_push (h265parse->frame_out, buf);
+}
+
 static void
 gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     GstH265NalUnitType naltype, GstH265NalUnit * nalu)
@@ -714,9 +835,11 @@ gst_h265_parse_process_sei_user_data (GstH265Parse * h265parse,
 static gboolean
 gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
 {
-  GstH265PPS pps = { 0, };
-  GstH265SPS sps = { 0, };
-  GstH265VPS vps = { 0, };
+  GstH265PPS *pps;
+  GstH265SPS *sps;
+  GstH265VPS *vps;
+  GstH265PPS broken_pps = { 0, };
+  guint pps_id;
   guint nal_type;
   GstH265Parser *nalparser = h265parse->nalparser;
   GstH265ParserResult pres = GST_H265_PARSER_ERROR;
@@ -736,7 +859,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     case GST_H265_NAL_VPS:
       /* It is not mandatory to have VPS in the stream. But it might
        * be needed for other extensions like svc */
-      pres = gst_h265_parser_parse_vps (nalparser, nalu, &vps);
+      pres = gst_h265_parser_update_vps (nalparser, nalu, &vps, NULL);
       if (pres != GST_H265_PARSER_OK) {
         GST_WARNING_OBJECT (h265parse, "failed to parse VPS");
         return FALSE;
@@ -756,20 +879,18 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, vps.id, nal_type, nalu);
+      gst_h265_parser_store_nal (h265parse, vps->id, nal_type, nalu);
       h265parse->header = TRUE;
       break;
     case GST_H265_NAL_SPS:
       /* reset state, everything else is obsolete */
       h265parse->state = 0;
 
-      pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, TRUE);
-
-
-      /* arranged for a fallback sps.id, so use that one and only warn */
+      /* the SPS stays in nalparser, a repeated one is not parsed again */
+      pres = gst_h265_parser_update_sps (nalparser, nalu, &sps, TRUE, NULL);
       if (pres != GST_H265_PARSER_OK) {
         /* try to not parse VUI */
-        pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, FALSE);
+        pres = gst_h265_parser_update_sps (nalparser, nalu, &sps, FALSE, NULL);
         if (pres != GST_H265_PARSER_OK) {
           GST_WARNING_OBJECT (h265parse, "failed to parse SPS:");
           h265parse->state |= GST_H265_PARSE_STATE_GOT_SPS;
@@ -793,7 +914,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, sps.id, nal_type, nalu);
+      gst_h265_parser_store_nal (h265parse, sps->id, nal_type, nalu);
       h265parse->header = TRUE;
       h265parse->state |= GST_H265_PARSE_STATE_GOT_SPS;
       break;
@@ -803,14 +924,18 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       if (!GST_H265_PARSE_STATE_VALID (h265parse, GST_H265_PARSE_STATE_GOT_SPS))
         return FALSE;
 
-      pres = gst_h265_parser_parse_pps (nalparser, nalu, &pps);
-
-
-      /* arranged for a fallback pps.id, so use that one and only warn */
-      if (pres != GST_H265_PARSER_OK) {
+      pres = gst_h265_parser_update_pps (nalparser, nalu, &pps, NULL);
+      if (pres == GST_H265_PARSER_OK) {
+        pps_id = pps->id;
+      } else {
         GST_WARNING_OBJECT (h265parse, "failed to parse PPS:");
         if (pres != GST_H265_PARSER_BROKEN_LINK)
           return FALSE;
+
+        /* not stored, but arranged for a fallback pps.id, so use that one
+         * and only warn */
+        gst_h265_parse_pps (nalparser, nalu, &broken_pps);
+        pps_id = broken_pps.id;
       }
 
       /* parameters might have changed, force caps check */
@@ -829,7 +954,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, pps.id, nal_type, nalu);
+      gst_h265_parser_store_nal (h265parse, pps_id, nal_type, nalu);
       h265parse->header = TRUE;
       h265parse->state |= GST_H265_PARSE_STATE_GOT_PPS;
       break;
@@ -841,12 +966,13 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
 
       h265parse->header = TRUE;
 
-      gst_h265_parse_process_sei (h265parse, nalu);
+      if (!h265parse->light_parse)
+        gst_h265_parse_process_sei (h265parse, nalu);
 
       /* mark SEI pos */
       if (h265parse->sei_pos == -1) {
         if (h265parse->transform)
-          h265parse->sei_pos = gst_adapter_available (h265parse->frame_out);
+          h265parse->sei_pos = gst_h265_parse_frame_out_size (h265parse);
         else
           h265parse->sei_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h265parse, "marking SEI in frame at offset %d",
@@ -881,6 +1007,20 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
               GST_H265_PARSE_STATE_VALID_PICTURE_HEADERS))
         return FALSE;
 
+      is_irap = ((nal_type >= GST_H265_NAL_SLICE_BLA_W_LP)
+          && (nal_type <= GST_H265_NAL_SLICE_CRA_NUT)) ? TRUE : FALSE;
+
+      if (h265parse->light_parse) {
+        /* only the NAL unit type tells about key frames */
+        if (is_irap)
+          h265parse->keyframe = TRUE;
+        h265parse->state |= GST_H265_PARSE_STATE_GOT_SLICE;
+        slice.first_slice_segment_in_pic_flag =
+            nalu->size > nalu->header_bytes &&
+            (nalu->data[nalu->offset + nalu->header_bytes] & 0x80);
+        goto slice_done;
+      }
+
       pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
 
       if (pres == GST_H265_PARSER_OK) {
@@ -903,6 +1043,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
 
       gst_h265_slice_hdr_free (&slice);
 
+    slice_done:
       /* FIXME: NoRaslOutputFlag can be equal to 1 for CRA if
        * 1) the first AU in bitstream is CRA
        * 2) or the first AU following EOS nal is CRA
@@ -918,9 +1059,6 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         no_rasl_output_flag = TRUE;
       }
 
-      is_irap = ((nal_type >= GST_H265_NAL_SLICE_BLA_W_LP)
-          && (nal_type <= GST_H265_NAL_SLICE_CRA_NUT)) ? TRUE : FALSE;
-
       if (no_rasl_output_flag && is_irap
           && slice.first_slice_segment_in_pic_flag == 1) {
         if (h265parse->mastering_display_info_state ==
@@ -946,7 +1084,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       /* mind replacement buffer if applicable */
       if (h265parse->idr_pos == -1) {
         if (h265parse->transform)
-          h265parse->idr_pos = gst_adapter_available (h265parse->frame_out);
+          h265parse->idr_pos = gst_h265_parse_frame_out_size (h265parse);
         else
           h265parse->idr_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h265parse, "marking IDR in frame at offset %d",
@@ -980,12 +1118,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
   /* if HEVC output needed, collect properly prefixed nal in adapter,
    * and use that to replace outgoing buffer data later on */
   if (h265parse->transform) {
-    GstBuffer *buf;
-
     GST_LOG_OBJECT (h265parse, "collecting NAL in HEVC frame");
-    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-        nalu->data + nalu->offset, nalu->size);
-    gst_adapter_push (h265parse->frame_out, buf);
+    gst_h265_parse_collect_frame_out (h265parse, nalu);
   }
 
   return TRUE;
@@ -1065,6 +1199,7 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
     buffer = gst_buffer_copy (frame->buffer);
 
   gst_buffer_map (buffer, &map, GST_MAP_READ);
+  gst_h265_parse_set_frame_in (h265parse, buffer, map.data);
 
   left = map.size;
 
@@ -1104,6 +1239,7 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
         map.data, nalu.offset + nalu.size, map.size, nl, &nalu);
   }
 
+  gst_h265_parse_set_frame_in (h265parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
 
   if (!h265parse->split_packetized) {
@@ -1186,7 +1322,8 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
     GST_LOG_OBJECT (h265parse, "resuming frame parsing");
   }
 
-  drain = GST_BASE_PARSE_DRAINING (parse);
+  /* in light mode, input buffers are complete AUs */
+  drain = GST_BASE_PARSE_DRAINING (parse) || h265parse->light_au;
   nonext = FALSE;
 
   current_off = h265parse->current_off;
@@ -1218,10 +1355,21 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
     }
   }
 
+  gst_h265_parse_set_frame_in (h265parse, buffer, data);
+
   while (TRUE) {
-    pres =
-        gst_h265_parser_identify_nalu (nalparser, data, current_off, size,
-        &nalu);
+    /* in light mode, the first slice ends the AU: whatever follows is
+     * pushed along with it without scanning for more start codes */
+    if (h265parse->light_au) {
+      pres = gst_h265_parser_identify_nalu_unchecked (nalparser, data,
+          current_off, size, &nalu);
+      nonext = pres == GST_H265_PARSER_OK &&
+          nalu.type <= GST_H265_NAL_SLICE_CRA_NUT;
+    }
+
+    if (!nonext)
+      pres = gst_h265_parser_identify_nalu (nalparser, data, current_off,
+          size, &nalu);
 
     switch (pres) {
       case GST_H265_PARSER_OK:
@@ -1323,6 +1471,7 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
 end:
   framesize = nalu.offset + nalu.size;
 
+  gst_h265_parse_set_frame_in (h265parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
 
   gst_h265_parse_parse_frame (parse, frame);
@@ -1338,6 +1487,7 @@ more:
 
   /* Fall-through. */
 out:
+  gst_h265_parse_set_frame_in (h265parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
   return GST_FLOW_OK;
 
@@ -1353,6 +1503,7 @@ skip:
   goto out;
 
 invalid_stream:
+  gst_h265_parse_set_frame_in (h265parse, NULL, NULL);
   gst_buffer_unmap (buffer, &map);
   return GST_FLOW_ERROR;
 }
@@ -2256,12 +2407,14 @@ gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     h265parse->discont = FALSE;
   }
 
-  /* replace with transformed HEVC output if applicable */
+  /* replace with transformed HEVC output if applicable, made up of the
+   * collected memories as is */
+  gst_h265_parse_flush_frame_in (h265parse);
   av = gst_adapter_available (h265parse->frame_out);
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h265parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h265parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2438,15 +2591,15 @@ gst_h265_parse_handle_vps_sps_pps_nals (GstH265Parse * h265parse,
       }
     }
   } else {
-    /* insert config NALs into AU */
+    /* insert config NALs into AU, in between references to its data */
     GstByteWriter bw;
-    GstBuffer *new_buf;
+    GstBuffer *new_buf, *config;
     const gboolean bs = h265parse->format == GST_H265_PARSE_FORMAT_BYTE;
     const gint nls = 4 - h265parse->nal_length_size;
     gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h265parse->idr_pos);
+    gst_byte_writer_init (&bw);
+    ok = TRUE;
     GST_DEBUG_OBJECT (h265parse, "- inserting VPS/SPS/PPS");
     for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
       if ((codec_nal = h265parse->vps_nals[i])) {
@@ -2495,9 +2648,15 @@ gst_h265_parse_handle_vps_sps_pps_nals (GstH265Parse * h265parse,
         send_done = TRUE;
       }
     }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h265parse->idr_pos, -1);
+    config = gst_byte_writer_reset_and_get_buffer (&bw);
+    new_buf = gst_buffer_new ();
+    if (h265parse->idr_pos > 0)
+      ok &= gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY, 0,
+          h265parse->idr_pos);
+    new_buf = gst_buffer_append (new_buf, config);
+    ok &= gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY,
+        h265parse->idr_pos, -1);
     /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
     gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     /* should already be keyframe/IDR, but it may not have been,
      * so mark it as such to avoid being discarded by picky decoder */
@@ -2834,6 +2993,8 @@ gst_h265_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
     }
   }
 
+  h265parse->in_align = align;
+
   {
     GstCaps *in_caps;
 
@@ -3069,6 +3230,9 @@ gst_h265_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_int (value);
       break;
+    case PROP_LIGHT_PARSE:
+      parse->light_parse = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3086,6 +3250,9 @@ gst_h265_parse_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CONFIG_INTERVAL:
       g_value_set_int (value, parse->interval);
       break;
+    case PROP_LIGHT_PARSE:
+      g_value_set_boolean (value, parse->light_parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
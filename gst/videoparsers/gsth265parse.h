@@ -64,10 +64,13 @@ struct _GstH265Parse
   gboolean packetized;
   gboolean split_packetized;
   gboolean transform;
+  /* light parsing of AU aligned byte-stream, passed through untouched */
+  gboolean light_au;
 
   /* state */
   GstH265Parser *nalparser;
   guint state;
+  guint in_align;
   guint align;
   guint format;
   gint current_off;
@@ -102,6 +105,11 @@ struct _GstH265Parse
   gint idr_pos, sei_pos;
   gboolean update_caps;
   GstAdapter *frame_out;
+  /* input buffer the NALs being processed point into, and the region of it
+   * that can go to frame_out as is, so payloads are referenced, not copied */
+  GstBuffer *frame_in;
+  const guint8 *frame_in_data;
+  gint frame_in_start, frame_in_end;
   gboolean keyframe;
   gboolean predicted;
   gboolean bidirectional;
@@ -113,6 +121,7 @@ struct _GstH265Parse
 
   /* props */
   gint interval;
+  gboolean light_parse;
 
   gboolean sent_codec_tag;
 
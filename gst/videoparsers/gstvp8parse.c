@@ -0,0 +1,212 @@
+/* GStreamer VP8 Parser
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vp8parse
+ * @title: vp8parse
+ *
+ * Parses framed VP8 streams, as produced by the IVF and WebM/Matroska
+ * demuxers. Without decoding anything, it marks key frames (by clearing
+ * %GST_BUFFER_FLAG_DELTA_UNIT), frames that are not displayed (with
+ * %GST_BUFFER_FLAG_DECODE_ONLY), and exposes the resolution in the caps.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.webm ! matroskademux ! vp8parse ! fakesink
+ * ]|
+ *
+ * Since: 1.18
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstvp8parse.h"
+
+GST_DEBUG_CATEGORY (vp8_parse_debug);
+#define GST_CAT_DEFAULT vp8_parse_debug
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp8, parsed = (boolean) true")
+    );
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp8")
+    );
+
+#define parent_class gst_vp8_parse_parent_class
+G_DEFINE_TYPE (GstVp8Parse, gst_vp8_parse, GST_TYPE_BASE_PARSE);
+
+static gboolean gst_vp8_parse_start (GstBaseParse * parse);
+static gboolean gst_vp8_parse_set_sink_caps (GstBaseParse * parse,
+    GstCaps * caps);
+static GstFlowReturn gst_vp8_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+
+static void
+gst_vp8_parse_class_init (GstVp8ParseClass * klass)
+{
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (vp8_parse_debug, "vp8parse", 0, "vp8 parser");
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+  gst_element_class_set_static_metadata (gstelement_class, "VP8 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses VP8 streams", "GStreamer developers");
+
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_vp8_parse_start);
+  parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_vp8_parse_set_sink_caps);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_vp8_parse_handle_frame);
+}
+
+static void
+gst_vp8_parse_init (GstVp8Parse * self)
+{
+  /* frames that are not displayed have no timestamp of their own */
+  gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (self), FALSE);
+  gst_base_parse_set_infer_ts (GST_BASE_PARSE (self), FALSE);
+
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (self));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (self));
+}
+
+static gboolean
+gst_vp8_parse_start (GstBaseParse * parse)
+{
+  GstVp8Parse *self = GST_VP8_PARSE (parse);
+
+  GST_DEBUG_OBJECT (self, "start");
+
+  gst_vp8_parser_init (&self->parser);
+  self->width = 0;
+  self->height = 0;
+  self->update_caps = TRUE;
+
+  /* the frame tag */
+  gst_base_parse_set_min_frame_size (parse, 3);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp8_parse_set_sink_caps (GstBaseParse * parse, GstCaps * caps)
+{
+  GstVp8Parse *self = GST_VP8_PARSE (parse);
+
+  /* framerate and the like are taken over from upstream */
+  self->update_caps = TRUE;
+
+  return TRUE;
+}
+
+static void
+gst_vp8_parse_update_src_caps (GstVp8Parse * self)
+{
+  GstCaps *sink_caps, *src_caps, *caps;
+
+  if (!self->update_caps)
+    return;
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (self));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-vp8");
+  }
+
+  if (self->width > 0 && self->height > 0) {
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, self->width,
+        "height", G_TYPE_INT, self->height, NULL);
+  }
+
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE, NULL);
+
+  src_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SRC_PAD (self));
+  if (!src_caps || !gst_caps_is_strictly_equal (src_caps, caps)) {
+    GST_DEBUG_OBJECT (self, "setting caps %" GST_PTR_FORMAT, caps);
+    gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (self), caps);
+  }
+
+  if (src_caps)
+    gst_caps_unref (src_caps);
+  gst_caps_unref (caps);
+
+  self->update_caps = FALSE;
+}
+
+static GstFlowReturn
+gst_vp8_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
+    gint * skipsize)
+{
+  GstVp8Parse *self = GST_VP8_PARSE (parse);
+  GstBuffer *buffer = frame->buffer;
+  GstVp8FrameHdr frame_hdr;
+  GstVp8ParserResult pres;
+  GstMapInfo map;
+  gsize size;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (parse, CORE, NOT_IMPLEMENTED, (NULL),
+        ("Couldn't map incoming buffer"));
+    return GST_FLOW_ERROR;
+  }
+  size = map.size;
+
+  pres = gst_vp8_parser_parse_frame_header (&self->parser, &frame_hdr,
+      map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+
+  if (pres != GST_VP8_PARSER_OK) {
+    GST_WARNING_OBJECT (self, "Failed to parse frame header, pushing as is");
+    goto done;
+  }
+
+  if (frame_hdr.key_frame) {
+    if (self->width != frame_hdr.width || self->height != frame_hdr.height) {
+      GST_INFO_OBJECT (self, "resolution changed %dx%d -> %ux%u",
+          self->width, self->height, frame_hdr.width, frame_hdr.height);
+      self->width = frame_hdr.width;
+      self->height = frame_hdr.height;
+      self->update_caps = TRUE;
+    }
+
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  } else {
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+
+  if (frame_hdr.show_frame)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+
+done:
+  gst_vp8_parse_update_src_caps (self);
+
+  return gst_base_parse_finish_frame (parse, frame, size);
+}
@@ -0,0 +1,393 @@
+/* GStreamer VP9 Parser
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vp9parse
+ * @title: vp9parse
+ *
+ * Parses framed VP9 streams, as produced by the IVF and WebM/Matroska
+ * demuxers. Without decoding anything, it marks key frames (by clearing
+ * %GST_BUFFER_FLAG_DELTA_UNIT), frames that are not displayed (with
+ * %GST_BUFFER_FLAG_DECODE_ONLY), and exposes the resolution and profile in
+ * the caps.
+ *
+ * When downstream asks for `alignment=frame`, superframes are split into
+ * their frames. The resulting buffers reference the memory of the
+ * superframe, no data is copied.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.webm ! matroskademux ! vp9parse ! fakesink
+ * ]|
+ *
+ * Since: 1.18
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstvp9parse.h"
+
+GST_DEBUG_CATEGORY (vp9_parse_debug);
+#define GST_CAT_DEFAULT vp9_parse_debug
+
+enum
+{
+  GST_VP9_PARSE_ALIGN_NONE = 0,
+  GST_VP9_PARSE_ALIGN_SUPER_FRAME,
+  GST_VP9_PARSE_ALIGN_FRAME,
+};
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9, parsed = (boolean) true, "
+        "alignment = (string) { super-frame, frame }")
+    );
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9")
+    );
+
+#define parent_class gst_vp9_parse_parent_class
+G_DEFINE_TYPE (GstVp9Parse, gst_vp9_parse, GST_TYPE_BASE_PARSE);
+
+static gboolean gst_vp9_parse_start (GstBaseParse * parse);
+static gboolean gst_vp9_parse_stop (GstBaseParse * parse);
+static gboolean gst_vp9_parse_set_sink_caps (GstBaseParse * parse,
+    GstCaps * caps);
+static GstFlowReturn gst_vp9_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+
+static void
+gst_vp9_parse_class_init (GstVp9ParseClass * klass)
+{
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (vp9_parse_debug, "vp9parse", 0, "vp9 parser");
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+  gst_element_class_set_static_metadata (gstelement_class, "VP9 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses VP9 streams", "GStreamer developers");
+
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_vp9_parse_start);
+  parse_class->stop = GST_DEBUG_FUNCPTR (gst_vp9_parse_stop);
+  parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_vp9_parse_set_sink_caps);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_vp9_parse_handle_frame);
+}
+
+static void
+gst_vp9_parse_init (GstVp9Parse * self)
+{
+  /* frames that are not displayed have no timestamp of their own */
+  gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (self), FALSE);
+  gst_base_parse_set_infer_ts (GST_BASE_PARSE (self), FALSE);
+
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (self));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (self));
+}
+
+static gboolean
+gst_vp9_parse_start (GstBaseParse * parse)
+{
+  GstVp9Parse *self = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (self, "start");
+
+  self->parser = gst_vp9_parser_new ();
+  self->width = 0;
+  self->height = 0;
+  self->profile = GST_VP9_PROFILE_UNDEFINED;
+  self->align = GST_VP9_PARSE_ALIGN_NONE;
+  self->update_caps = TRUE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp9_parse_stop (GstBaseParse * parse)
+{
+  GstVp9Parse *self = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (self, "stop");
+
+  g_clear_pointer (&self->parser, gst_vp9_parser_free);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp9_parse_set_sink_caps (GstBaseParse * parse, GstCaps * caps)
+{
+  GstVp9Parse *self = GST_VP9_PARSE (parse);
+
+  /* framerate and the like are taken over from upstream */
+  self->update_caps = TRUE;
+
+  return TRUE;
+}
+
+static const gchar *
+gst_vp9_parse_profile_to_string (GstVP9Profile profile)
+{
+  switch (profile) {
+    case GST_VP9_PROFILE_0:
+      return "0";
+    case GST_VP9_PROFILE_1:
+      return "1";
+    case GST_VP9_PROFILE_2:
+      return "2";
+    case GST_VP9_PROFILE_3:
+      return "3";
+    default:
+      break;
+  }
+
+  return NULL;
+}
+
+/* check downstream caps to configure alignment */
+static void
+gst_vp9_parse_negotiate (GstVp9Parse * self)
+{
+  GstCaps *caps;
+  guint align = GST_VP9_PARSE_ALIGN_SUPER_FRAME;
+
+  caps = gst_pad_get_allowed_caps (GST_BASE_PARSE_SRC_PAD (self));
+  GST_DEBUG_OBJECT (self, "allowed caps: %" GST_PTR_FORMAT, caps);
+
+  /* concentrate on leading structure, since decodebin parser
+   * capsfilter always includes parser template caps */
+  if (caps && !gst_caps_is_empty (caps)) {
+    const gchar *str;
+
+    /* fixate to avoid ambiguity with lists when parsing */
+    caps = gst_caps_fixate (gst_caps_truncate (caps));
+    str = gst_structure_get_string (gst_caps_get_structure (caps, 0),
+        "alignment");
+    if (g_strcmp0 (str, "frame") == 0)
+      align = GST_VP9_PARSE_ALIGN_FRAME;
+  }
+
+  if (caps)
+    gst_caps_unref (caps);
+
+  GST_DEBUG_OBJECT (self, "selected alignment %s",
+      align == GST_VP9_PARSE_ALIGN_FRAME ? "frame" : "super-frame");
+
+  if (align != self->align) {
+    self->align = align;
+    self->update_caps = TRUE;
+  }
+}
+
+static void
+gst_vp9_parse_update_src_caps (GstVp9Parse * self)
+{
+  GstCaps *sink_caps, *src_caps, *caps;
+  const gchar *profile;
+
+  if (!self->update_caps)
+    return;
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (self));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-vp9");
+  }
+
+  if (self->width > 0 && self->height > 0) {
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, self->width,
+        "height", G_TYPE_INT, self->height, NULL);
+  }
+
+  profile = gst_vp9_parse_profile_to_string (self->profile);
+  if (profile)
+    gst_caps_set_simple (caps, "profile", G_TYPE_STRING, profile, NULL);
+
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE,
+      "alignment", G_TYPE_STRING,
+      self->align == GST_VP9_PARSE_ALIGN_FRAME ? "frame" : "super-frame",
+      NULL);
+
+  src_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SRC_PAD (self));
+  if (!src_caps || !gst_caps_is_strictly_equal (src_caps, caps)) {
+    GST_DEBUG_OBJECT (self, "setting caps %" GST_PTR_FORMAT, caps);
+    gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (self), caps);
+  }
+
+  if (src_caps)
+    gst_caps_unref (src_caps);
+  gst_caps_unref (caps);
+
+  self->update_caps = FALSE;
+}
+
+/* Parses the header of one frame of a superframe, and picks up resolution
+ * and profile changes from it */
+static gboolean
+gst_vp9_parse_process_frame (GstVp9Parse * self, const guint8 * data,
+    gsize size, gboolean * key_frame, gboolean * shown)
+{
+  GstVp9FrameHdr frame_hdr;
+
+  if (gst_vp9_parser_parse_frame_header (self->parser, &frame_hdr, data,
+          size) != GST_VP9_PARSER_OK) {
+    GST_WARNING_OBJECT (self, "Failed to parse frame header");
+    return FALSE;
+  }
+
+  if (frame_hdr.show_existing_frame) {
+    *key_frame = FALSE;
+    *shown = TRUE;
+    return TRUE;
+  }
+
+  *key_frame = frame_hdr.frame_type == GST_VP9_KEY_FRAME;
+  *shown = frame_hdr.show_frame;
+
+  /* inter frames may take their size from a reference frame */
+  if ((*key_frame || frame_hdr.intra_only) &&
+      (self->width != frame_hdr.width || self->height != frame_hdr.height)) {
+    GST_INFO_OBJECT (self, "resolution changed %dx%d -> %ux%u",
+        self->width, self->height, frame_hdr.width, frame_hdr.height);
+    self->width = frame_hdr.width;
+    self->height = frame_hdr.height;
+    self->update_caps = TRUE;
+  }
+
+  if (self->profile != frame_hdr.profile) {
+    GST_INFO_OBJECT (self, "profile changed %d -> %d", self->profile,
+        frame_hdr.profile);
+    self->profile = frame_hdr.profile;
+    self->update_caps = TRUE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_vp9_parse_annotate (GstBuffer * buffer, gboolean key_frame,
+    gboolean shown)
+{
+  if (key_frame)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  if (shown)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+}
+
+static GstFlowReturn
+gst_vp9_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
+    gint * skipsize)
+{
+  GstVp9Parse *self = GST_VP9_PARSE (parse);
+  GstBuffer *buffer = frame->buffer;
+  GstVp9SuperframeInfo superframe_info;
+  gboolean key_frame[GST_VP9_MAX_FRAMES_IN_SUPERFRAME];
+  gboolean shown[GST_VP9_MAX_FRAMES_IN_SUPERFRAME];
+  gboolean any_shown = FALSE;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstMapInfo map;
+  gsize offset = 0, size;
+  guint i, n_frames;
+
+  if (self->align == GST_VP9_PARSE_ALIGN_NONE ||
+      gst_pad_check_reconfigure (GST_BASE_PARSE_SRC_PAD (parse)))
+    gst_vp9_parse_negotiate (self);
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (parse, CORE, NOT_IMPLEMENTED, (NULL),
+        ("Couldn't map incoming buffer"));
+    return GST_FLOW_ERROR;
+  }
+  size = map.size;
+
+  if (gst_vp9_parser_parse_superframe_info (self->parser, &superframe_info,
+          map.data, map.size) != GST_VP9_PARSER_OK) {
+    GST_WARNING_OBJECT (self, "Invalid superframe index, pushing as is");
+    goto passthrough;
+  }
+
+  n_frames = superframe_info.frames_in_superframe;
+  for (i = 0; i < n_frames; i++) {
+    if (!gst_vp9_parse_process_frame (self, map.data + offset,
+            superframe_info.frame_sizes[i], &key_frame[i], &shown[i]))
+      goto passthrough;
+
+    any_shown |= shown[i];
+    offset += superframe_info.frame_sizes[i];
+  }
+
+  gst_buffer_unmap (buffer, &map);
+  gst_vp9_parse_update_src_caps (self);
+
+  if (self->align != GST_VP9_PARSE_ALIGN_FRAME || n_frames == 1) {
+    gst_vp9_parse_annotate (buffer, key_frame[0], any_shown);
+    return gst_base_parse_finish_frame (parse, frame, size);
+  }
+
+  /* need to save buffer from invalidation upon _finish_frame */
+  buffer = gst_buffer_copy (frame->buffer);
+
+  offset = 0;
+  for (i = 0; i < n_frames && ret == GST_FLOW_OK; i++) {
+    GstBaseParseFrame tmp_frame;
+    gsize frame_size = superframe_info.frame_sizes[i];
+
+    gst_base_parse_frame_init (&tmp_frame);
+    tmp_frame.flags |= frame->flags;
+    tmp_frame.offset = frame->offset;
+    tmp_frame.overhead = frame->overhead;
+    tmp_frame.buffer =
+        gst_vp9_superframe_info_get_frame (&superframe_info, buffer, i);
+    gst_vp9_parse_annotate (tmp_frame.buffer, key_frame[i], shown[i]);
+
+    /* the last frame also swallows the superframe index, but must not
+     * output it */
+    tmp_frame.out_buffer = gst_buffer_ref (tmp_frame.buffer);
+    if (i == n_frames - 1)
+      frame_size = size - offset;
+
+    ret = gst_base_parse_finish_frame (parse, &tmp_frame, frame_size);
+    offset += frame_size;
+  }
+
+  gst_buffer_unref (buffer);
+
+  return ret;
+
+passthrough:
+  gst_buffer_unmap (buffer, &map);
+  gst_vp9_parse_update_src_caps (self);
+
+  return gst_base_parse_finish_frame (parse, frame, size);
+}
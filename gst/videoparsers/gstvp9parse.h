@@ -0,0 +1,66 @@
+/* GStreamer VP9 Parser
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VP9_PARSE_H__
+#define __GST_VP9_PARSE_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbaseparse.h>
+#include <gst/codecparsers/gstvp9parser.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VP9_PARSE \
+  (gst_vp9_parse_get_type())
+#define GST_VP9_PARSE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_VP9_PARSE,GstVp9Parse))
+#define GST_VP9_PARSE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_VP9_PARSE,GstVp9ParseClass))
+#define GST_IS_VP9_PARSE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_VP9_PARSE))
+#define GST_IS_VP9_PARSE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_VP9_PARSE))
+
+GType gst_vp9_parse_get_type (void);
+
+typedef struct _GstVp9Parse GstVp9Parse;
+typedef struct _GstVp9ParseClass GstVp9ParseClass;
+
+struct _GstVp9Parse
+{
+  GstBaseParse baseparse;
+
+  /* stream */
+  gint width, height;
+  GstVP9Profile profile;
+  guint align;
+  gboolean update_caps;
+
+  /* state */
+  GstVp9Parser *parser;
+};
+
+struct _GstVp9ParseClass
+{
+  GstBaseParseClass parent_class;
+};
+
+G_END_DECLS
+
+#endif
@@ -31,6 +31,9 @@
 #include "gstjpeg2000parse.h"
 #include "gstvc1parse.h"
 #include "gsth265parse.h"
+#include "gstvp8parse.h"
+#include "gstvp9parse.h"
+#include "gstav1parse.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -55,6 +58,12 @@ plugin_init (GstPlugin * plugin)
       GST_RANK_SECONDARY, GST_TYPE_H265_PARSE);
   ret |= gst_element_register (plugin, "vc1parse",
       GST_RANK_NONE, GST_TYPE_VC1_PARSE);
+  ret |= gst_element_register (plugin, "vp8parse",
+      GST_RANK_SECONDARY, GST_TYPE_VP8_PARSE);
+  ret |= gst_element_register (plugin, "vp9parse",
+      GST_RANK_SECONDARY, GST_TYPE_VP9_PARSE);
+  ret |= gst_element_register (plugin, "av1parse",
+      GST_RANK_SECONDARY, GST_TYPE_AV1_PARSE);
 
   return ret;
 }
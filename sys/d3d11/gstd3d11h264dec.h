@@ -20,8 +20,8 @@
 #ifndef __GST_D3D11_H264_DEC_H__
 #define __GST_D3D11_H264_DEC_H__
 
-#include "gsth264decoder.h"
-#include "gsth264picture.h"
+#include <gst/codecs/gsth264decoder.h>
+#include <gst/codecs/gsth264picture.h>
 #include "gstd3d11decoder.h"
 
 G_BEGIN_DECLS
@@ -20,8 +20,8 @@
 #ifndef __GST_D3D11_H265_DEC_H__
 #define __GST_D3D11_H265_DEC_H__
 
-#include "gsth265decoder.h"
-#include "gsth265picture.h"
+#include <gst/codecs/gsth265decoder.h>
+#include <gst/codecs/gsth265picture.h>
 #include "gstd3d11decoder.h"
 
 G_BEGIN_DECLS
@@ -20,8 +20,8 @@
 #ifndef __GST_D3D11_VP9_DEC_H__
 #define __GST_D3D11_VP9_DEC_H__
 
-#include "gstvp9decoder.h"
-#include "gstvp9picture.h"
+#include <gst/codecs/gstvp9decoder.h>
+#include <gst/codecs/gstvp9picture.h>
 #include "gstd3d11decoder.h"
 
 G_BEGIN_DECLS
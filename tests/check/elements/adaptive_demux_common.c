@@ -457,6 +457,9 @@ testSeekPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
   g_signal_connect (bus, "message::state-changed",
       G_CALLBACK (testSeekOnStateChanged), testData);
   gst_object_unref (bus);
+
+  if (testData->seek_pre_test)
+    testData->seek_pre_test (engine, user_data);
 }
 
 static void
@@ -114,6 +114,10 @@ typedef struct _GstAdaptiveDemuxTestCase
   guint64 threshold_for_seek;
   GstEvent *seek_event;
   gboolean seeked;
+  /* optionally called by the seek test before the pipeline is started,
+   * to configure the demuxer */
+  void (*seek_pre_test) (GstAdaptiveDemuxTestEngine *engine,
+      gpointer user_data);
 
   gpointer signal_context;
 } GstAdaptiveDemuxTestCase;
@@ -0,0 +1,269 @@
+/* GStreamer
+ *
+ * unit test for av1parse
+ *
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/check.h>
+
+/* A temporal delimiter, a main profile 640x480 sequence header, and the
+ * frame header of a shown key frame, in the low overhead format */
+static guint8 av1_obu_stream[] = {
+  0x12, 0x00,
+  0x0a, 0x0b, 0x00, 0x00, 0x00, 0x42, 0x62, 0x7f, 0xef, 0x98, 0x4f, 0x30,
+  0x08,
+  0x1a, 0x02, 0x10, 0x01,
+};
+
+/* The same OBUs, without obu_size fields, in a single frame unit of an
+ * Annex B temporal unit */
+static guint8 av1_annexb[] = {
+  0x14, 0x13,
+  0x01, 0x10,
+  0x0c, 0x08, 0x00, 0x00, 0x00, 0x42, 0x62, 0x7f, 0xef, 0x98, 0x4f, 0x30,
+  0x08,
+  0x03, 0x18, 0x10, 0x01,
+};
+
+/* The low overhead OBUs in an Annex B temporal unit, as the parser writes
+ * them: the obu_size fields are kept */
+static guint8 av1_annexb_with_sizes[] = {
+  0x17, 0x16,
+  0x02, 0x12, 0x00,
+  0x0d, 0x0a, 0x0b, 0x00, 0x00, 0x00, 0x42, 0x62, 0x7f, 0xef, 0x98, 0x4f,
+  0x30, 0x08,
+  0x04, 0x1a, 0x02, 0x10, 0x01,
+};
+
+/* offset and size of each OBU in av1_obu_stream */
+static const struct
+{
+  guint offset;
+  guint size;
+} av1_obus[] = {
+  {0, 2}, {2, 13}, {15, 4}
+};
+
+#define OBU_STREAM_CAPS "video/x-av1, stream-format=(string)obu-stream"
+#define ANNEXB_CAPS "video/x-av1, stream-format=(string)annexb"
+
+static GstBuffer *
+wrap_data (guint8 * data, gsize size)
+{
+  return gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, data, size,
+      0, size, NULL, NULL);
+}
+
+static void
+check_output (GstBuffer * out, const guint8 * data, gsize size,
+    gboolean key_frame)
+{
+  fail_unless_equals_int (gst_buffer_get_size (out), size);
+  fail_unless (gst_buffer_memcmp (out, 0, data, size) == 0);
+  fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (out,
+          GST_BUFFER_FLAG_DELTA_UNIT), !key_frame);
+}
+
+/* number of bytes of @out in memories pointing into @data */
+static gsize
+count_referenced_bytes (GstBuffer * out, const guint8 * data, gsize size)
+{
+  GstMapInfo map;
+  gsize referenced = 0;
+  guint i;
+
+  for (i = 0; i < gst_buffer_n_memory (out); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (out, i);
+
+    fail_unless (gst_memory_map (mem, &map, GST_MAP_READ));
+    if (map.data >= data && map.data + map.size <= data + size)
+      referenced += map.size;
+    gst_memory_unmap (mem, &map);
+  }
+
+  return referenced;
+}
+
+/* pushes @data as one temporal unit and checks the output temporal unit */
+static void
+run_tu_conversion (const gchar * in_caps, guint8 * in_data, gsize in_size,
+    const gchar * out_caps, const guint8 * out_data, gsize out_size)
+{
+  GstHarness *h;
+  GstBuffer *out;
+
+  h = gst_harness_new ("av1parse");
+  gst_harness_set_caps_str (h, in_caps, out_caps);
+
+  fail_unless_equals_int (gst_harness_push (h, wrap_data (in_data, in_size)),
+      GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  out = gst_harness_pull (h);
+  check_output (out, out_data, out_size, TRUE);
+
+  /* the sequence header payload is referenced, not copied */
+  fail_unless (count_referenced_bytes (out, in_data, in_size) >= 11);
+
+  gst_buffer_unref (out);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_parse_obu_stream_to_annexb)
+{
+  run_tu_conversion (OBU_STREAM_CAPS ", alignment=(string)tu",
+      av1_obu_stream, sizeof (av1_obu_stream),
+      ANNEXB_CAPS ", alignment=(string)tu",
+      av1_annexb_with_sizes, sizeof (av1_annexb_with_sizes));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_annexb_to_obu_stream)
+{
+  run_tu_conversion (ANNEXB_CAPS ", alignment=(string)tu",
+      av1_annexb, sizeof (av1_annexb),
+      OBU_STREAM_CAPS ", alignment=(string)tu",
+      av1_obu_stream, sizeof (av1_obu_stream));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_passthrough)
+{
+  run_tu_conversion (OBU_STREAM_CAPS ", alignment=(string)tu",
+      av1_obu_stream, sizeof (av1_obu_stream),
+      OBU_STREAM_CAPS ", alignment=(string)tu",
+      av1_obu_stream, sizeof (av1_obu_stream));
+  run_tu_conversion (ANNEXB_CAPS ", alignment=(string)tu",
+      av1_annexb, sizeof (av1_annexb),
+      ANNEXB_CAPS ", alignment=(string)tu",
+      av1_annexb, sizeof (av1_annexb));
+}
+
+GST_END_TEST;
+
+/* a byte stream of two temporal units, output one OBU per buffer */
+GST_START_TEST (test_parse_obu_alignment)
+{
+  GstHarness *h;
+  GstBuffer *in, *out;
+  guint i, j;
+
+  h = gst_harness_new ("av1parse");
+  gst_harness_set_caps_str (h, OBU_STREAM_CAPS,
+      OBU_STREAM_CAPS ", alignment=(string)obu");
+
+  in = gst_buffer_new ();
+  gst_buffer_append (in, wrap_data (av1_obu_stream, sizeof (av1_obu_stream)));
+  gst_buffer_append (in, wrap_data (av1_obu_stream, sizeof (av1_obu_stream)));
+  fail_unless_equals_int (gst_harness_push (h, in), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h),
+      2 * G_N_ELEMENTS (av1_obus));
+  for (i = 0; i < 2; i++) {
+    for (j = 0; j < G_N_ELEMENTS (av1_obus); j++) {
+      out = gst_harness_pull (h);
+      check_output (out, av1_obu_stream + av1_obus[j].offset,
+          av1_obus[j].size, TRUE);
+      gst_buffer_unref (out);
+    }
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* the temporal unit is assembled from input split in single bytes */
+GST_START_TEST (test_parse_split)
+{
+  GstHarness *h;
+  GstBuffer *out;
+  guint i;
+
+  h = gst_harness_new ("av1parse");
+  gst_harness_set_caps_str (h, OBU_STREAM_CAPS,
+      ANNEXB_CAPS ", alignment=(string)tu");
+
+  for (i = 0; i < sizeof (av1_obu_stream); i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            wrap_data (av1_obu_stream + i, 1)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  out = gst_harness_pull (h);
+  check_output (out, av1_annexb_with_sizes, sizeof (av1_annexb_with_sizes),
+      TRUE);
+  gst_buffer_unref (out);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_caps)
+{
+  GstHarness *h;
+  GstCaps *caps, *expected;
+
+  h = gst_harness_new ("av1parse");
+  gst_harness_set_caps_str (h, ANNEXB_CAPS ", alignment=(string)tu",
+      "video/x-av1");
+
+  fail_unless_equals_int (gst_harness_push (h, wrap_data (av1_annexb,
+              sizeof (av1_annexb))), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  /* the input format is preferred when downstream accepts anything */
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps != NULL);
+  expected = gst_caps_from_string (ANNEXB_CAPS ", alignment=(string)tu, "
+      "parsed=(boolean)true, width=(int)640, height=(int)480, "
+      "profile=(string)main");
+  fail_unless (gst_caps_is_equal (caps, expected),
+      "Unexpected caps %" GST_PTR_FORMAT, caps);
+  gst_caps_unref (expected);
+  gst_caps_unref (caps);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+av1parse_suite (void)
+{
+  Suite *s = suite_create ("av1parse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_parse_obu_stream_to_annexb);
+  tcase_add_test (tc_chain, test_parse_annexb_to_obu_stream);
+  tcase_add_test (tc_chain, test_parse_passthrough);
+  tcase_add_test (tc_chain, test_parse_obu_alignment);
+  tcase_add_test (tc_chain, test_parse_split);
+  tcase_add_test (tc_chain, test_parse_caps);
+
+  return s;
+}
+
+GST_CHECK_MAIN (av1parse);
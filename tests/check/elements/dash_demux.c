@@ -19,6 +19,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
 #include "adaptive_demux_common.h"
 
 #define DEMUX_ELEMENT_NAME "dashdemux"
@@ -1188,6 +1189,181 @@ GST_START_TEST (testMediaDownloadErrorMiddleFragment)
 
 GST_END_TEST;
 
+/* ABR algorithm picking the highest bitrate it is offered, recording the
+ * ladder it was given */
+static guint abr_test_calls;
+static guint64 abr_test_bitrates[3];
+static guint abr_test_n_bitrates;
+
+static gpointer
+abr_test_create (void)
+{
+  return g_new0 (guint, 1);
+}
+
+static void
+abr_test_fragment_downloaded (gpointer state,
+    const GstAdaptiveDemuxAbrFragment * fragment)
+{
+}
+
+static guint
+abr_test_select_representation (gpointer state,
+    const GstAdaptiveDemuxAbrContext * context)
+{
+  guint i;
+
+  abr_test_calls++;
+  abr_test_n_bitrates = context->n_bitrates;
+  for (i = 0; i < MIN (context->n_bitrates, G_N_ELEMENTS (abr_test_bitrates));
+      i++)
+    abr_test_bitrates[i] = context->bitrates[i];
+
+  return context->n_bitrates - 1;
+}
+
+static const GstAdaptiveDemuxAbrAlgorithm abr_test_algorithm = {
+  "test-highest",
+  abr_test_create,
+  g_free,
+  abr_test_fragment_downloaded,
+  abr_test_select_representation,
+};
+
+/* counts the requests of each file in the test data structure */
+static gboolean
+testAbrSrcStart (GstTestHTTPSrc * src, const gchar * uri,
+    GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  GstTestHTTPSrcTestData *http_src_test_data = user_data;
+  const gchar *name = strrchr (uri, '/') + 1;
+  guint requests = 0;
+
+  gst_structure_get_uint (http_src_test_data->data, name, &requests);
+  gst_structure_set (http_src_test_data->data, name, G_TYPE_UINT,
+      requests + 1, NULL);
+
+  return gst_dashdemux_http_src_start (src, uri, input_data, user_data);
+}
+
+static void
+testAbrPreTest (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  g_object_set (engine->demux, "abr-algorithm", "test-highest",
+      "max-video-width", 640, NULL);
+}
+
+/*
+ * Test that the abr-algorithm property selects the algorithm, and that it
+ * is only offered the representations allowed by the max-video-* properties
+ *
+ */
+GST_START_TEST (testAbrAlgorithm)
+{
+  const gchar *mpd =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+      "     xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+      "     xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011 DASH-MPD.xsd\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-on-demand:2011\""
+      "     type=\"static\""
+      "     minBufferTime=\"PT1.500S\""
+      "     mediaPresentationDuration=\"PT4S\">"
+      "  <Period>"
+      "    <AdaptationSet mimeType=\"video/webm\""
+      "                   subsegmentAlignment=\"true\">"
+      "      <Representation id=\"low\" codecs=\"vp9\""
+      "                      width=\"320\" height=\"180\""
+      "                      bandwidth=\"250000\">"
+      "        <BaseURL>low.webm</BaseURL>"
+      "        <SegmentList duration=\"1\">"
+      "          <SegmentURL mediaRange=\"0-99\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"100-199\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"200-299\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"300-399\"></SegmentURL>"
+      "        </SegmentList>"
+      "      </Representation>"
+      "      <Representation id=\"mid\" codecs=\"vp9\""
+      "                      width=\"640\" height=\"360\""
+      "                      bandwidth=\"500000\">"
+      "        <BaseURL>mid.webm</BaseURL>"
+      "        <SegmentList duration=\"1\">"
+      "          <SegmentURL mediaRange=\"0-99\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"100-199\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"200-299\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"300-399\"></SegmentURL>"
+      "        </SegmentList>"
+      "      </Representation>"
+      "      <Representation id=\"high\" codecs=\"vp9\""
+      "                      width=\"1280\" height=\"720\""
+      "                      bandwidth=\"1000000\">"
+      "        <BaseURL>high.webm</BaseURL>"
+      "        <SegmentList duration=\"1\">"
+      "          <SegmentURL mediaRange=\"0-99\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"100-199\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"200-299\"></SegmentURL>"
+      "          <SegmentURL mediaRange=\"300-399\"></SegmentURL>"
+      "        </SegmentList>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  GstDashDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/test.mpd", (guint8 *) mpd, 0},
+    {"http://unit.test/low.webm", NULL, 400},
+    {"http://unit.test/mid.webm", NULL, 400},
+    {"http://unit.test/high.webm", NULL, 400},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"video_00", 400, NULL},
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstTestHTTPSrcTestData http_src_test_data = { 0 };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstDashDemuxTestCase *testData;
+  guint requests;
+
+  gst_adaptive_demux_abr_register (&abr_test_algorithm);
+  abr_test_calls = 0;
+
+  http_src_callbacks.src_start = testAbrSrcStart;
+  http_src_callbacks.src_create = gst_dashdemux_http_src_create;
+  http_src_test_data.data = gst_structure_new_empty (__FUNCTION__);
+  http_src_test_data.input = inputTestData;
+  gst_test_http_src_install_callbacks (&http_src_callbacks,
+      &http_src_test_data);
+
+  test_callbacks.pre_test = testAbrPreTest;
+  test_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  test_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  testData = gst_dash_demux_test_case_new ();
+  COPY_OUTPUT_TEST_DATA (outputTestData, testData);
+
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, "http://unit.test/test.mpd",
+      &test_callbacks, testData);
+
+  /* the 1280 pixels wide representation is never offered */
+  fail_unless (abr_test_calls > 0);
+  fail_unless_equals_int (abr_test_n_bitrates, 2);
+  fail_unless_equals_uint64 (abr_test_bitrates[0], 250000);
+  fail_unless_equals_uint64 (abr_test_bitrates[1], 500000);
+
+  /* streaming starts with the lowest representation, then follows the
+   * algorithm */
+  fail_unless (gst_structure_get_uint (http_src_test_data.data, "mid.webm",
+          &requests));
+  fail_unless (requests > 0);
+  fail_if (gst_structure_has_field (http_src_test_data.data, "high.webm"));
+
+  g_object_unref (testData);
+  if (http_src_test_data.data)
+    gst_structure_free (http_src_test_data.data);
+}
+
+GST_END_TEST;
+
 /* generate queries to adaptive demux */
 static gboolean
 testQueryCheckDataReceived (GstAdaptiveDemuxTestEngine * engine,
@@ -1543,6 +1719,7 @@ dash_demux_suite (void)
   tcase_add_test (tc_basicTest, testHeaderDownloadError);
   tcase_add_test (tc_basicTest, testMediaDownloadErrorLastFragment);
   tcase_add_test (tc_basicTest, testMediaDownloadErrorMiddleFragment);
+  tcase_add_test (tc_basicTest, testAbrAlgorithm);
   tcase_add_test (tc_basicTest, testQuery);
   tcase_add_test (tc_basicTest, testContentProtection);
 
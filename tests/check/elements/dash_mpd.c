@@ -27,6 +27,7 @@
 #include "../../ext/dash/gstmpdrootnode.c"
 #include "../../ext/dash/gstmpdbaseurlnode.c"
 #include "../../ext/dash/gstmpdutctimingnode.c"
+#include "../../ext/dash/gstmpdservicedescriptionnode.c"
 #include "../../ext/dash/gstmpdmetricsnode.c"
 #include "../../ext/dash/gstmpdmetricsrangenode.c"
 #include "../../ext/dash/gstmpdsnode.c"
@@ -2745,6 +2746,95 @@ GST_START_TEST (dash_mpdparser_utctiming_invalid_value)
 
 GST_END_TEST;
 
+/*
+ * Test parsing ServiceDescription attributes
+ *
+ */
+GST_START_TEST (dash_mpdparser_service_description)
+{
+  const GstMPDServiceDescriptionNode *service;
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\">"
+      "  <ServiceDescription id=\"1\">"
+      "    <Latency target=\"3000\" min=\"2000\" max=\"6000\"/>"
+      "    <PlaybackRate min=\"0.9\" max=\"1.1\"/>"
+      "  </ServiceDescription>"
+      "  <ServiceDescription id=\"2\">"
+      "    <Latency target=\"5000\"/>"
+      "  </ServiceDescription></MPD>";
+  gboolean ret;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_client_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  assert_equals_int (g_list_length (mpdclient->
+          mpd_root_node->ServiceDescriptions), 2);
+  service = gst_mpd_client_get_service_description (mpdclient);
+  fail_if (service == NULL);
+  assert_equals_int (service->id, 1);
+  assert_equals_int (service->latency_target, 3000);
+  assert_equals_int (service->latency_min, 2000);
+  assert_equals_int (service->latency_max, 6000);
+  assert_equals_float (service->playback_rate_min, 0.9);
+  assert_equals_float (service->playback_rate_max, 1.1);
+
+  service = mpdclient->mpd_root_node->ServiceDescriptions->next->data;
+  assert_equals_int (service->latency_target, 5000);
+  assert_equals_int (service->latency_min, 0);
+  assert_equals_float (service->playback_rate_max, 0);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test the playback rate suggested to catch up with the target latency
+ *
+ */
+GST_START_TEST (dash_mpdparser_catch_up_rate)
+{
+  gdouble rate, prev;
+  gint i;
+
+  /* within the tolerance, play at normal speed */
+  assert_equals_float (gst_mpd_helper_get_catch_up_rate (0, 0.9, 1.1), 1.0);
+  assert_equals_float (gst_mpd_helper_get_catch_up_rate (40 * GST_MSECOND,
+          0.9, 1.1), 1.0);
+  assert_equals_float (gst_mpd_helper_get_catch_up_rate (-40 * GST_MSECOND,
+          0.9, 1.1), 1.0);
+
+  /* speed up when behind the target, slow down when ahead of it */
+  rate = gst_mpd_helper_get_catch_up_rate (GST_SECOND / 2, 0.9, 1.1);
+  fail_unless (rate > 1.0 && rate < 1.1);
+  rate = gst_mpd_helper_get_catch_up_rate (-GST_SECOND / 2, 0.9, 1.1);
+  fail_unless (rate < 1.0 && rate > 0.9);
+
+  /* monotonic, and tending to the bounds without crossing them */
+  prev = 0;
+  for (i = -100; i <= 100; i++) {
+    rate = gst_mpd_helper_get_catch_up_rate (i * GST_SECOND / 10, 0.9, 1.1);
+    fail_unless (rate >= prev);
+    fail_unless (rate >= 0.9 && rate <= 1.1);
+    prev = rate;
+  }
+  fail_unless (gst_mpd_helper_get_catch_up_rate (10 * GST_SECOND, 0.9,
+          1.1) > 1.099);
+  fail_unless (gst_mpd_helper_get_catch_up_rate (-10 * GST_SECOND, 0.9,
+          1.1) < 0.901);
+
+  /* the bounds apply independently on each side */
+  rate = gst_mpd_helper_get_catch_up_rate (10 * GST_SECOND, 0.5, 1.02);
+  fail_unless (rate > 1.0 && rate <= 1.02);
+  rate = gst_mpd_helper_get_catch_up_rate (-10 * GST_SECOND, 0.96, 2.0);
+  fail_unless (rate < 1.0 && rate >= 0.96);
+}
+
+GST_END_TEST;
+
 /*
  * Test parsing the type property: value "dynamic"
  *
@@ -4799,6 +4889,83 @@ GST_START_TEST (dash_mpdparser_segment_template)
 
 GST_END_TEST;
 
+/*
+ * Test the availabilityTimeOffset of low latency streams
+ *
+ */
+GST_START_TEST (dash_mpdparser_availability_time_offset)
+{
+  GstMPDPeriodNode *periodNode;
+  GstMPDAdaptationSetNode *adaptationSet;
+  GstMPDRepresentationNode *representation;
+  GstMPDSegmentBaseNode *segmentBase;
+  GList *adaptationSets;
+  GstActiveStream *activeStream;
+  GstDateTime *segmentAvailability;
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period start=\"P0Y0M0DT0H0M10S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <SegmentTemplate duration=\"2\""
+      "                       availabilityTimeOffset=\"1.5\""
+      "                       availabilityTimeComplete=\"false\">"
+      "      </SegmentTemplate>"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"TestMedia$Number$\">"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+  gboolean ret;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_client_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  /* the attributes are inherited from the AdaptationSet template */
+  periodNode = (GstMPDPeriodNode *) mpdclient->mpd_root_node->Periods->data;
+  adaptationSet = (GstMPDAdaptationSetNode *) periodNode->AdaptationSets->data;
+  representation =
+      (GstMPDRepresentationNode *) adaptationSet->Representations->data;
+  segmentBase =
+      GST_MPD_MULT_SEGMENT_BASE_NODE (representation->SegmentTemplate)->
+      SegmentBase;
+  assert_equals_float (segmentBase->availabilityTimeOffset, 1.5);
+  assert_equals_int (segmentBase->availabilityTimeComplete, FALSE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adaptationSets->data);
+  assert_equals_int (ret, TRUE);
+  activeStream = gst_mpd_client_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_uint64 (activeStream->availabilityTimeOffset,
+      1500 * GST_MSECOND);
+  assert_equals_uint64 (gst_mpd_client_get_availability_time_offset
+      (mpdclient), 1500 * GST_MSECOND);
+
+  /* the first segment ends 2s after the period start (10s) but can be
+   * requested 1.5s earlier */
+  segmentAvailability =
+      gst_mpd_client_get_next_segment_availability_start_time (mpdclient,
+      activeStream);
+  fail_unless (segmentAvailability != NULL);
+  assert_equals_int (gst_date_time_get_minute (segmentAvailability), 0);
+  assert_equals_int (gst_date_time_get_second (segmentAvailability), 10);
+  assert_equals_int (gst_date_time_get_microsecond (segmentAvailability),
+      500000);
+  gst_date_time_unref (segmentAvailability);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test segment timeline
  *
@@ -6439,6 +6606,8 @@ dash_suite (void)
   tcase_add_test (tc_simpleMPD, dash_mpdparser_period_subset);
   tcase_add_test (tc_simpleMPD, dash_mpdparser_utctiming);
   tcase_add_test (tc_simpleMPD, dash_mpdparser_utctiming_invalid_value);
+  tcase_add_test (tc_simpleMPD, dash_mpdparser_service_description);
+  tcase_add_test (tc_simpleMPD, dash_mpdparser_catch_up_rate);
 
   /* tests checking other possible values for attributes */
   tcase_add_test (tc_simpleMPD, dash_mpdparser_type_dynamic);
@@ -6482,6 +6651,7 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_inherited_segmentURL);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_availability_time_offset);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
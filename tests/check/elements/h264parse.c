@@ -851,6 +851,210 @@ GST_START_TEST (test_parse_sei_closedcaptions)
 
 GST_END_TEST;
 
+#define LIGHT_AU_SIZE (256 * 1024)
+#define LIGHT_N_AUS 60
+#define LIGHT_GOP_SIZE 15
+
+/* AUD + slice with LIGHT_AU_SIZE bytes of start code free slice data,
+ * with SPS/PPS and an IDR slice at the start of each GOP */
+static GstBuffer *
+create_light_au (guint n, const guint8 * payload)
+{
+  static const guint8 idr_slice[] = {
+    0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x10, 0xff, 0xfe, 0xf6,
+    0xf0, 0xfe
+  };
+  static const guint8 p_slice[] = { 0x00, 0x00, 0x00, 0x01, 0x41, 0x9a };
+  gboolean idr = n % LIGHT_GOP_SIZE == 0;
+  GstBuffer *buf;
+  gsize offset = 0;
+
+  buf = gst_buffer_new_allocate (NULL, sizeof (h264_aud) + sizeof (h264_sps) +
+      sizeof (h264_pps) + sizeof (idr_slice) + LIGHT_AU_SIZE, NULL);
+
+  offset += gst_buffer_fill (buf, offset, h264_aud, sizeof (h264_aud));
+  if (idr) {
+    offset += gst_buffer_fill (buf, offset, h264_sps, sizeof (h264_sps));
+    offset += gst_buffer_fill (buf, offset, h264_pps, sizeof (h264_pps));
+    offset += gst_buffer_fill (buf, offset, idr_slice, sizeof (idr_slice));
+  } else {
+    offset += gst_buffer_fill (buf, offset, p_slice, sizeof (p_slice));
+  }
+  offset += gst_buffer_fill (buf, offset, payload, LIGHT_AU_SIZE);
+  gst_buffer_set_size (buf, offset);
+
+  GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = n * 40 * GST_MSECOND;
+
+  return buf;
+}
+
+static gint64
+run_light_au (gboolean light_parse, const guint8 * payload)
+{
+  GstHarness *h;
+  GstBuffer *in, *out;
+  GstMapInfo in_map, out_map;
+  gint64 start, elapsed = 0;
+  guint i;
+
+  h = gst_harness_new ("h264parse");
+  g_object_set (h->element, "light-parse", light_parse, NULL);
+
+  gst_harness_set_caps_str (h,
+      "video/x-h264, stream-format=byte-stream, alignment=au",
+      "video/x-h264, stream-format=byte-stream, alignment=au");
+
+  for (i = 0; i < LIGHT_N_AUS; i++) {
+    in = create_light_au (i, payload);
+
+    start = g_get_monotonic_time ();
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in)),
+        GST_FLOW_OK);
+    elapsed += g_get_monotonic_time () - start;
+
+    out = gst_harness_pull (h);
+    fail_unless_equals_int (gst_buffer_get_size (out),
+        gst_buffer_get_size (in));
+    fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (out,
+            GST_BUFFER_FLAG_DELTA_UNIT), i % LIGHT_GOP_SIZE != 0);
+
+    /* light parsing pushes the input memory along */
+    gst_buffer_map (in, &in_map, GST_MAP_READ);
+    gst_buffer_map (out, &out_map, GST_MAP_READ);
+    if (light_parse)
+      fail_unless (in_map.data == out_map.data);
+    fail_unless (memcmp (in_map.data, out_map.data, in_map.size) == 0);
+    gst_buffer_unmap (out, &out_map);
+    gst_buffer_unmap (in, &in_map);
+
+    gst_buffer_unref (out);
+    gst_buffer_unref (in);
+  }
+
+  gst_harness_teardown (h);
+
+  return elapsed;
+}
+
+GST_START_TEST (test_parse_light_au)
+{
+  GRand *rand = g_rand_new_with_seed (0x264);
+  guint8 *payload = g_malloc (LIGHT_AU_SIZE);
+  gint64 full_time, light_time;
+  guint i;
+
+  /* no zero bytes, so no start codes nor emulation prevention */
+  for (i = 0; i < LIGHT_AU_SIZE; i++)
+    payload[i] = g_rand_int_range (rand, 1, 256);
+
+  full_time = run_light_au (FALSE, payload);
+  light_time = run_light_au (TRUE, payload);
+
+  GST_INFO ("%d AUs of %d kB: full parse %" G_GINT64_FORMAT " us, "
+      "light parse %" G_GINT64_FORMAT " us", LIGHT_N_AUS, LIGHT_AU_SIZE / 1024,
+      full_time, light_time);
+
+  g_free (payload);
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+#define ZERO_COPY_SLICE_SIZE (64 * 1024)
+
+/* number of bytes of @out in memories pointing into @in_map */
+static gsize
+count_referenced_bytes (GstBuffer * out, GstMapInfo * in_map)
+{
+  GstMapInfo map;
+  gsize referenced = 0;
+  guint i;
+
+  for (i = 0; i < gst_buffer_n_memory (out); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (out, i);
+
+    fail_unless (gst_memory_map (mem, &map, GST_MAP_READ));
+    if (map.data >= in_map->data &&
+        map.data + map.size <= in_map->data + in_map->size)
+      referenced += map.size;
+    gst_memory_unmap (mem, &map);
+  }
+
+  return referenced;
+}
+
+/* converts an AU with a large IDR slice and checks that its payload is
+ * referenced by the output, not copied */
+static void
+run_zero_copy (const gchar * in_caps, const gchar * out_caps,
+    gboolean from_avc)
+{
+  GstHarness *h;
+  GstBuffer *in, *out;
+  GstMapInfo in_map;
+  guint8 *slice;
+  gsize slice_size, offset = 0, size;
+  guint i;
+
+  /* IDR slice header followed by zero free slice data */
+  slice_size = sizeof (h264_idrframe) - 4 + ZERO_COPY_SLICE_SIZE;
+  slice = g_malloc (slice_size);
+  memcpy (slice, h264_idrframe + 4, sizeof (h264_idrframe) - 4);
+  for (i = sizeof (h264_idrframe) - 4; i < slice_size; i++)
+    slice[i] = 1 + i % 255;
+
+  size = sizeof (h264_sps) + sizeof (h264_pps) + 4 + slice_size;
+  in = gst_buffer_new_allocate (NULL, size, NULL);
+  if (from_avc) {
+    guint8 len[4];
+
+    GST_WRITE_UINT32_BE (len, slice_size);
+    offset += gst_buffer_fill (in, offset, len, 4);
+  } else {
+    offset += gst_buffer_fill (in, offset, h264_sps, sizeof (h264_sps));
+    offset += gst_buffer_fill (in, offset, h264_pps, sizeof (h264_pps));
+    offset += gst_buffer_fill (in, offset, h264_idrframe, 4);
+  }
+  offset += gst_buffer_fill (in, offset, slice, slice_size);
+  gst_buffer_set_size (in, offset);
+
+  h = gst_harness_new ("h264parse");
+  gst_harness_set_caps_str (h, in_caps, out_caps);
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in)),
+      GST_FLOW_OK);
+  out = gst_harness_pull (h);
+
+  /* the slice data ends the output, after a converted prefix */
+  size = gst_buffer_get_size (out);
+  fail_unless (size > slice_size + 4);
+  fail_unless (gst_buffer_memcmp (out, size - slice_size, slice,
+          slice_size) == 0);
+  GST_DEBUG ("output of %" G_GSIZE_FORMAT " bytes in %u memories", size,
+      gst_buffer_n_memory (out));
+
+  gst_buffer_map (in, &in_map, GST_MAP_READ);
+  fail_unless (count_referenced_bytes (out, &in_map) >= slice_size);
+  gst_buffer_unmap (in, &in_map);
+
+  gst_buffer_unref (out);
+  gst_buffer_unref (in);
+  g_free (slice);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_parse_zero_copy_conversion)
+{
+  run_zero_copy ("video/x-h264, stream-format=(string)avc, "
+      "alignment=(string)au, codec_data=(buffer)014d4015ffe10017674d4015eca4"
+      "bf2e0220000003002ee6b28001e2c5b2c001000468ebecb2",
+      "video/x-h264, stream-format=byte-stream, alignment=au", TRUE);
+  run_zero_copy ("video/x-h264, stream-format=byte-stream, alignment=au",
+      "video/x-h264, stream-format=avc, alignment=au", FALSE);
+}
+
+GST_END_TEST;
+
 /*
  * TODO:
  *   - Both push- and pull-modes need to be tested
@@ -957,6 +1161,8 @@ main (int argc, char **argv)
     suite_add_tcase (s, tc_chain);
     tcase_add_test (tc_chain, test_parse_sei_closedcaptions);
     tcase_add_test (tc_chain, test_parse_compatible_caps);
+    tcase_add_test (tc_chain, test_parse_light_au);
+    tcase_add_test (tc_chain, test_parse_zero_copy_conversion);
     nf += gst_check_run_suite (s, "h264parse", __FILE__);
   }
 
@@ -22,6 +22,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 #include "parser.h"
 
 #define SRC_CAPS_TMPL   "video/x-h265, parsed=(boolean)false"
@@ -248,6 +249,211 @@ GST_START_TEST (test_parse_detect_stream_with_hdr_sei)
 
 GST_END_TEST;
 
+static GstBuffer *
+concat_nals (const guint8 ** nals, const gsize * sizes, guint n_nals)
+{
+  GstBuffer *buf;
+  gsize size = 0, offset = 0;
+  guint i;
+
+  for (i = 0; i < n_nals; i++)
+    size += sizes[i];
+
+  buf = gst_buffer_new_allocate (NULL, size, NULL);
+  for (i = 0; i < n_nals; i++)
+    offset += gst_buffer_fill (buf, offset, nals[i], sizes[i]);
+
+  return buf;
+}
+
+GST_START_TEST (test_parse_light_au)
+{
+  GstHarness *h;
+  GstBuffer *in[2], *out;
+  GstMapInfo in_map, out_map;
+  const guint8 *nals[4] = { h265_vps, h265_sps, h265_pps, h265_idr };
+  gsize sizes[4] = { sizeof (h265_vps), sizeof (h265_sps),
+    sizeof (h265_pps), sizeof (h265_idr)
+  };
+  guint8 *trail;
+  guint i;
+
+  /* same slice data as a TRAIL_R picture, which light parsing does not
+   * look into */
+  trail = g_memdup (h265_idr, sizeof (h265_idr));
+  trail[4] = 0x02;              /* nal_unit_type 1, TRAIL_R */
+
+  in[0] = concat_nals (nals, sizes, 4);
+  in[1] = gst_buffer_new_wrapped (trail, sizeof (h265_idr));
+
+  h = gst_harness_new ("h265parse");
+  g_object_set (h->element, "light-parse", TRUE, NULL);
+  gst_harness_set_caps_str (h,
+      "video/x-h265, stream-format=byte-stream, alignment=au",
+      "video/x-h265, stream-format=byte-stream, alignment=au");
+
+  for (i = 0; i < 2; i++) {
+    GST_BUFFER_PTS (in[i]) = GST_BUFFER_DTS (in[i]) = i * 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in[i])),
+        GST_FLOW_OK);
+
+    out = gst_harness_pull (h);
+    fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (out,
+            GST_BUFFER_FLAG_DELTA_UNIT), i != 0);
+
+    /* the input memory is pushed as is */
+    gst_buffer_map (in[i], &in_map, GST_MAP_READ);
+    gst_buffer_map (out, &out_map, GST_MAP_READ);
+    fail_unless_equals_int (out_map.size, in_map.size);
+    fail_unless (out_map.data == in_map.data);
+    gst_buffer_unmap (out, &out_map);
+    gst_buffer_unmap (in[i], &in_map);
+
+    gst_buffer_unref (out);
+    gst_buffer_unref (in[i]);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+#define ZERO_COPY_SLICE_SIZE (64 * 1024)
+
+/* number of bytes of @out in memories pointing into @in_map */
+static gsize
+count_referenced_bytes (GstBuffer * out, GstMapInfo * in_map)
+{
+  GstMapInfo map;
+  gsize referenced = 0;
+  guint i;
+
+  for (i = 0; i < gst_buffer_n_memory (out); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (out, i);
+
+    fail_unless (gst_memory_map (mem, &map, GST_MAP_READ));
+    if (map.data >= in_map->data &&
+        map.data + map.size <= in_map->data + in_map->size)
+      referenced += map.size;
+    gst_memory_unmap (mem, &map);
+  }
+
+  return referenced;
+}
+
+/* hvcC with 4 bytes NAL lengths and one array for each of the VPS, SPS and
+ * PPS, the fields the parser does not use are left to 0 */
+static GstBuffer *
+create_hvcc (void)
+{
+  const guint8 *nals[3] = { h265_vps, h265_sps, h265_pps };
+  gsize sizes[3] = { sizeof (h265_vps), sizeof (h265_sps), sizeof (h265_pps) };
+  guint8 header[23] = { 0x01, };
+  GstBuffer *hvcc;
+  gsize offset = 0;
+  guint i;
+
+  header[21] = 0x03;
+  header[22] = G_N_ELEMENTS (nals);
+
+  hvcc = gst_buffer_new_allocate (NULL, 1024, NULL);
+  offset += gst_buffer_fill (hvcc, offset, header, sizeof (header));
+  for (i = 0; i < G_N_ELEMENTS (nals); i++) {
+    guint8 array[5];
+
+    array[0] = (nals[i][4] >> 1) & 0x3f;        /* NAL unit type */
+    GST_WRITE_UINT16_BE (array + 1, 1);
+    GST_WRITE_UINT16_BE (array + 3, sizes[i] - 4);
+    offset += gst_buffer_fill (hvcc, offset, array, sizeof (array));
+    offset += gst_buffer_fill (hvcc, offset, nals[i] + 4, sizes[i] - 4);
+  }
+  gst_buffer_set_size (hvcc, offset);
+
+  return hvcc;
+}
+
+/* converts an AU with a large IDR slice and checks that its payload is
+ * referenced by the output, not copied */
+static void
+run_zero_copy (const gchar * in_caps, const gchar * out_caps,
+    gboolean from_hvc)
+{
+  GstHarness *h;
+  GstBuffer *in, *out;
+  GstCaps *caps;
+  GstMapInfo in_map;
+  guint8 *slice;
+  gsize slice_size, offset = 0, size;
+  guint i;
+
+  /* IDR slice header followed by zero free slice data */
+  slice_size = sizeof (h265_idr) - 4 + ZERO_COPY_SLICE_SIZE;
+  slice = g_malloc (slice_size);
+  memcpy (slice, h265_idr + 4, sizeof (h265_idr) - 4);
+  for (i = sizeof (h265_idr) - 4; i < slice_size; i++)
+    slice[i] = 1 + i % 255;
+
+  size = sizeof (h265_vps) + sizeof (h265_sps) + sizeof (h265_pps) + 4 +
+      slice_size;
+  in = gst_buffer_new_allocate (NULL, size, NULL);
+  if (from_hvc) {
+    guint8 len[4];
+
+    GST_WRITE_UINT32_BE (len, slice_size);
+    offset += gst_buffer_fill (in, offset, len, 4);
+  } else {
+    offset += gst_buffer_fill (in, offset, h265_vps, sizeof (h265_vps));
+    offset += gst_buffer_fill (in, offset, h265_sps, sizeof (h265_sps));
+    offset += gst_buffer_fill (in, offset, h265_pps, sizeof (h265_pps));
+    offset += gst_buffer_fill (in, offset, h265_idr, 4);
+  }
+  offset += gst_buffer_fill (in, offset, slice, slice_size);
+  gst_buffer_set_size (in, offset);
+
+  caps = gst_caps_from_string (in_caps);
+  if (from_hvc) {
+    GstBuffer *hvcc = create_hvcc ();
+
+    gst_caps_set_simple (caps, "codec_data", GST_TYPE_BUFFER, hvcc, NULL);
+    gst_buffer_unref (hvcc);
+  }
+
+  h = gst_harness_new ("h265parse");
+  gst_harness_set_caps (h, caps, gst_caps_from_string (out_caps));
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in)),
+      GST_FLOW_OK);
+  out = gst_harness_pull (h);
+
+  /* the slice data ends the output, after a converted prefix */
+  size = gst_buffer_get_size (out);
+  fail_unless (size >= slice_size + 4);
+  fail_unless (gst_buffer_memcmp (out, size - slice_size, slice,
+          slice_size) == 0);
+  GST_DEBUG ("output of %" G_GSIZE_FORMAT " bytes in %u memories", size,
+      gst_buffer_n_memory (out));
+
+  gst_buffer_map (in, &in_map, GST_MAP_READ);
+  fail_unless (count_referenced_bytes (out, &in_map) >= slice_size);
+  gst_buffer_unmap (in, &in_map);
+
+  gst_buffer_unref (out);
+  gst_buffer_unref (in);
+  g_free (slice);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_parse_zero_copy_conversion)
+{
+  run_zero_copy ("video/x-h265, stream-format=(string)hvc1, "
+      "alignment=(string)au",
+      "video/x-h265, stream-format=byte-stream, alignment=au", TRUE);
+  run_zero_copy ("video/x-h265, stream-format=byte-stream, alignment=au",
+      "video/x-h265, stream-format=hvc1, alignment=au", FALSE);
+}
+
+GST_END_TEST;
+
 static Suite *
 h265parse_suite (void)
 {
@@ -260,6 +466,8 @@ h265parse_suite (void)
   tcase_add_test (tc_chain, test_parse_split);
   tcase_add_test (tc_chain, test_parse_detect_stream);
   tcase_add_test (tc_chain, test_parse_detect_stream_with_hdr_sei);
+  tcase_add_test (tc_chain, test_parse_light_au);
+  tcase_add_test (tc_chain, test_parse_zero_copy_conversion);
 
   return s;
 }
@@ -52,6 +52,10 @@ typedef struct _GstHlsDemuxTestSelectBitrateContext
   gulong signal_handle;
 } GstHlsDemuxTestSelectBitrateContext;
 
+/* protects the test case state, prefetching makes the http sources run
+ * from several threads */
+static GMutex test_state_lock;
+
 static GByteArray *
 generate_transport_stream (guint length)
 {
@@ -186,10 +190,12 @@ gst_hlsdemux_test_src_start (GstTestHTTPSrc * src,
   guint i;
 
   GST_DEBUG ("src_start %s", uri);
+  g_mutex_lock (&test_state_lock);
   for (i = 0; test_case->input[i].uri; ++i) {
     if (strcmp (test_case->input[i].uri, uri) == 0) {
       gst_hlsdemux_test_set_input_data (test_case, &test_case->input[i],
           input_data);
+      g_mutex_unlock (&test_state_lock);
       GST_DEBUG ("open URI %s", uri);
       return TRUE;
     }
@@ -198,6 +204,7 @@ gst_hlsdemux_test_src_start (GstTestHTTPSrc * src,
   fail_count++;
   gst_structure_set (test_case->state, "failure-count", G_TYPE_UINT,
       fail_count, NULL);
+  g_mutex_unlock (&test_state_lock);
   return FALSE;
 }
 
@@ -726,6 +733,302 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+static void
+testPrefetchStatisticsMessage (GstBus * bus, GstMessage * msg,
+    GstHlsDemuxTestCase * test_case)
+{
+  const GstStructure *s = gst_message_get_structure (msg);
+  guint hits, misses;
+
+  if (gst_structure_has_name (s, "adaptive-streaming-statistics")
+      && gst_structure_get_uint (s, "prefetch-hits", &hits)
+      && gst_structure_get_uint (s, "prefetch-misses", &misses)) {
+    g_mutex_lock (&test_state_lock);
+    gst_structure_set (test_case->state, "prefetch-hits", G_TYPE_UINT, hits,
+        "prefetch-misses", G_TYPE_UINT, misses, NULL);
+    g_mutex_unlock (&test_state_lock);
+  }
+}
+
+static void
+testPrefetchPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  GstHlsDemuxTestCase *test_case =
+      g_object_get_data (G_OBJECT (user_data), "hls-test-case");
+  GstBus *bus;
+
+  g_object_set (engine->demux, "prefetch-depth", 2, NULL);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (engine->pipeline));
+  g_signal_connect (bus, "message::element",
+      G_CALLBACK (testPrefetchStatisticsMessage), test_case);
+  gst_object_unref (bus);
+}
+
+/*
+ * Test downloading the next fragments in advance.
+ * Every fragment must be requested once and the demuxer must report
+ * that it used prefetched fragments.
+ */
+GST_START_TEST (testPrefetch)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n"
+      "#EXTINF:1,Test\n" "004.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {"http://unit.test/004.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 4 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  guint hits = 0;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = testPrefetchPreTestCallback;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+  g_object_set_data (G_OBJECT (engineTestData), "hls-test-case", &hlsTestCase);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  assert_equals_uint64 (gst_value_array_get_size (requests), 5);
+  fail_unless (gst_structure_get_uint (hlsTestCase.state, "prefetch-hits",
+          &hits));
+  fail_unless (hits > 0);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+/*
+ * Test that a seek drops the prefetched fragments.
+ * The seek back to the start happens while the first fragment is downloaded
+ * and the next ones are prefetched. Prefetched fragments left over from
+ * before the seek would not match the fragment the stream continues with,
+ * and be reported as misses.
+ */
+GST_START_TEST (testPrefetchCancelledOnSeek)
+{
+  const guint segment_size = 60 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n"
+      "#EXTINF:1,Test\n" "004.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {"http://unit.test/004.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 4 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestCase *engineTestData;
+  GstHlsDemuxTestCase hlsTestCase = { 0 };
+  GByteArray *mpeg_ts = NULL;
+  guint misses = 0;
+
+  engineTestData = gst_adaptive_demux_test_case_new ();
+  mpeg_ts = setup_test_variables (__FUNCTION__, inputTestData, outputTestData,
+      &hlsTestCase, engineTestData, segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engineTestData->seek_pre_test = testPrefetchPreTestCallback;
+  engineTestData->threshold_for_seek = 20 * TS_PACKET_LEN;
+  engineTestData->seek_event =
+      gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_NONE, 0);
+  g_object_set_data (G_OBJECT (engineTestData), "hls-test-case", &hlsTestCase);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_seek (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, engineTestData);
+
+  fail_unless (gst_structure_get_uint (hlsTestCase.state, "prefetch-misses",
+          &misses));
+  assert_equals_int (misses, 0);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+/*
+ * Test that switching variants drops the prefetched fragments.
+ * The first fragment is downloaded from the first listed variant, the
+ * download rate measured on it then selects the high bitrate variant. The
+ * fragments prefetched from the low bitrate variant must not be reported as
+ * misses by the new variant.
+ */
+GST_START_TEST (testPrefetchCancelledOnBitrateSwitch)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *master_playlist =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:4\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=100000\n"
+      "low.m3u8\n"
+      "#EXT-X-STREAM-INF:PROGRAM-ID=1, BANDWIDTH=200000\n" "high.m3u8\n";
+  const gchar *low_playlist =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "low001.ts\n"
+      "#EXTINF:1,Test\n" "low002.ts\n"
+      "#EXTINF:1,Test\n" "low003.ts\n"
+      "#EXTINF:1,Test\n" "low004.ts\n" "#EXT-X-ENDLIST\n";
+  const gchar *high_playlist =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "high001.ts\n"
+      "#EXTINF:1,Test\n" "high002.ts\n"
+      "#EXTINF:1,Test\n" "high003.ts\n"
+      "#EXTINF:1,Test\n" "high004.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/master.m3u8", (guint8 *) master_playlist, 0},
+    {"http://unit.test/low.m3u8", (guint8 *) low_playlist, 0},
+    {"http://unit.test/high.m3u8", (guint8 *) high_playlist, 0},
+    {"http://unit.test/low001.ts", NULL, segment_size},
+    {"http://unit.test/low002.ts", NULL, segment_size},
+    {"http://unit.test/low003.ts", NULL, segment_size},
+    {"http://unit.test/low004.ts", NULL, segment_size},
+    {"http://unit.test/high001.ts", NULL, segment_size},
+    {"http://unit.test/high002.ts", NULL, segment_size},
+    {"http://unit.test/high003.ts", NULL, segment_size},
+    {"http://unit.test/high004.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 4 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  gboolean switched = FALSE;
+  guint i, misses = 0;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = testPrefetchPreTestCallback;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+  g_object_set_data (G_OBJECT (engineTestData), "hls-test-case", &hlsTestCase);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  for (i = 0; i < gst_value_array_get_size (requests); i++) {
+    const GValue *uri = gst_value_array_get_value (requests, i);
+
+    if (g_strcmp0 (g_value_get_string (uri), inputTestData[2].uri) == 0)
+      switched = TRUE;
+  }
+  fail_unless (switched);
+  fail_unless (gst_structure_get_uint (hlsTestCase.state, "prefetch-misses",
+          &misses));
+  assert_equals_int (misses, 0);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+/*
+ * Test updating a live playlist with blocking reloads.
+ * The server answers the request for the segment after the last listed one
+ * with the final playlist, which must be used instead of waiting for a
+ * regular update.
+ */
+GST_START_TEST (testBlockingPlaylistReload)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES\n"
+      "#EXTINF:1,Test\n" "001.ts\n" "#EXTINF:1,Test\n" "002.ts\n";
+  const gchar *reloaded_manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/media.m3u8?_HLS_msn=2", (guint8 *) reloaded_manifest,
+        0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 3 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  gboolean blocking_reload = FALSE;
+  guint i;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  for (i = 0; i < gst_value_array_get_size (requests); i++) {
+    const GValue *uri = gst_value_array_get_value (requests, i);
+
+    if (g_strcmp0 (g_value_get_string (uri), inputTestData[1].uri) == 0)
+      blocking_reload = TRUE;
+  }
+  fail_unless (blocking_reload);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -745,6 +1048,10 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testSeekSnapAfterPosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapBeforePosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapAfterPosition);
+  tcase_add_test (tc_basicTest, testPrefetch);
+  tcase_add_test (tc_basicTest, testPrefetchCancelledOnSeek);
+  tcase_add_test (tc_basicTest, testPrefetchCancelledOnBitrateSwitch);
+  tcase_add_test (tc_basicTest, testBlockingPlaylistReload);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
@@ -335,6 +335,62 @@ main.mp4\n\
 main.mp4\n\
 #EXT-X-ENDLIST";
 
+static const gchar *LOW_LATENCY_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:2\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.0\n\
+#EXT-X-PART-INF:PART-TARGET=0.5\n\
+#EXT-X-MEDIA-SEQUENCE:100\n\
+#EXTINF:2.0,\n\
+fileSequence100.mp4\n\
+#EXTINF:2.0,\n\
+fileSequence101.mp4\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart102.0.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart102.1.mp4\"\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart102.2.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart102.3.mp4\"\n\
+#EXTINF:2.0,\n\
+fileSequence102.mp4\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart103.0.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart103.1.mp4\"\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"filePart103.2.mp4\"\n\
+#EXT-X-RENDITION-REPORT:URI=\"audio.m3u8\",LAST-MSN=103,LAST-PART=1\n";
+
+static const gchar *LOW_LATENCY_PLAYLIST_UPDATED = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:2\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.0\n\
+#EXT-X-PART-INF:PART-TARGET=0.5\n\
+#EXT-X-MEDIA-SEQUENCE:101\n\
+#EXTINF:2.0,\n\
+fileSequence101.mp4\n\
+#EXTINF:2.0,\n\
+fileSequence102.mp4\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart103.0.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart103.1.mp4\"\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart103.2.mp4\"\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart103.3.mp4\"\n\
+#EXTINF:2.0,\n\
+fileSequence103.mp4\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart104.0.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"filePart104.1.mp4\"\n";
+
+/* same as LOW_LATENCY_PLAYLIST_UPDATED, without the parts of segment 103 */
+static const gchar *LOW_LATENCY_PLAYLIST_PARTS_REMOVED = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:2\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.0\n\
+#EXT-X-PART-INF:PART-TARGET=0.5\n\
+#EXT-X-MEDIA-SEQUENCE:101\n\
+#EXTINF:2.0,\n\
+fileSequence101.mp4\n\
+#EXTINF:2.0,\n\
+fileSequence102.mp4\n\
+#EXTINF:2.0,\n\
+fileSequence103.mp4\n\
+#EXT-X-PART:DURATION=0.5,URI=\"filePart104.0.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"filePart104.1.mp4\"\n";
+
 static GstHLSMasterPlaylist *
 load_playlist (const gchar * data)
 {
@@ -366,7 +422,7 @@ GST_START_TEST (test_load_main_playlist_rendition)
   master = load_playlist (ON_DEMAND_PLAYLIST);
   variant = master->default_variant;
 
-  assert_equals_int (g_list_length (variant->m3u8->files), 4);
+  assert_equals_int (variant->m3u8->files->len, 4);
   assert_equals_int (master->version, 0);
 
   gst_hls_master_playlist_unref (master);
@@ -476,13 +532,14 @@ check_on_demand_playlist (const gchar * data)
   /* Check that we are not live */
   assert_equals_int (gst_m3u8_is_live (pl), FALSE);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/004.ts");
   assert_equals_int (file->sequence, 3);
 
@@ -532,14 +589,15 @@ GST_START_TEST (test_live_playlist)
   assert_equals_int (gst_m3u8_is_live (pl), TRUE);
   assert_equals_int (pl->sequence, 2680);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2680.ts");
   assert_equals_int (file->sequence, 2680);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2683.ts");
   assert_equals_int (file->sequence, 2683);
@@ -567,7 +625,7 @@ GST_START_TEST (test_live_playlist_rotated)
 
   assert_equals_int (pl->sequence, 2680);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 2680);
 
   ret = gst_m3u8_update (pl, g_strdup (LIVE_ROTATED_PLAYLIST));
@@ -579,7 +637,7 @@ GST_START_TEST (test_live_playlist_rotated)
   /* FIXME: Sequence should last - 3. Should it? */
   assert_equals_int (pl->sequence, 3001);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 3001);
 
   gst_hls_master_playlist_unref (master);
@@ -599,13 +657,13 @@ GST_START_TEST (test_playlist_with_doubles_duration)
   pl = master->default_variant->m3u8;
 
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.321);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.6789);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.2344);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.92);
   fail_unless (gst_m3u8_get_seek_range (pl, &start, &stop));
   assert_equals_int64 (start, 0);
@@ -631,26 +689,26 @@ GST_START_TEST (test_playlist_with_encryption)
   master = load_playlist (AES_128_ENCRYPTED_PLAYLIST);
   pl = master->default_variant->m3u8;
 
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
 
   /* Check all media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key.bin");
   fail_unless (memcmp (&file->iv, iv2, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 4));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 4));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
@@ -670,7 +728,7 @@ GST_START_TEST (test_update_invalid_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup ("#INVALID"));
   assert_equals_int (ret, FALSE);
 
@@ -689,26 +747,26 @@ GST_START_TEST (test_update_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup (ON_DEMAND_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   gst_hls_master_playlist_unref (master);
 
   /* Test updates in live playlists */
   master = load_playlist (LIVE_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Add a new entry to the playlist and check the update */
   live_pl = g_strdup_printf ("%s\n%s\n%s", LIVE_PLAYLIST, "#EXTINF:8",
       "https://priv.example.com/fileSequence2683.ts");
   ret = gst_m3u8_update (pl, live_pl);
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
   /* Test sliding window */
   ret = gst_m3u8_update (pl, g_strdup (LIVE_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   gst_hls_master_playlist_unref (master);
 }
 
@@ -724,9 +782,9 @@ GST_START_TEST (test_playlist_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -749,16 +807,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 100);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -772,16 +831,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 0);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -1413,8 +1473,9 @@ GST_START_TEST (test_map_tag)
   GstHLSMasterPlaylist *master;
   GstHLSVariantStream *stream;
   GstM3U8 *m3u8;
-  GList *files, *walk;
+  GPtrArray *files;
   GstM3U8MediaFile *seg1, *seg2, *seg3;
+  guint i;
   GstM3U8InitFile *init1, *init2;
 
   /* Test EXT-X-MAP tag
@@ -1434,18 +1495,18 @@ GST_START_TEST (test_map_tag)
 
   files = m3u8->files;
   fail_unless (m3u8 != NULL);
-  assert_equals_int (g_list_length (files), 3);
-  for (walk = files; walk; walk = g_list_next (walk)) {
-    GstM3U8MediaFile *file = (GstM3U8MediaFile *) walk->data;
+  assert_equals_int (files->len, 3);
+  for (i = 0; i < files->len; i++) {
+    GstM3U8MediaFile *file = g_ptr_array_index (files, i);
 
     GstM3U8InitFile *init_file = file->init_file;
     fail_unless (init_file != NULL);
     fail_unless (init_file->uri != NULL);
   }
 
-  seg1 = g_list_nth_data (files, 0);
-  seg2 = g_list_nth_data (files, 1);
-  seg3 = g_list_nth_data (files, 2);
+  seg1 = g_ptr_array_index (files, 0);
+  seg2 = g_ptr_array_index (files, 1);
+  seg3 = g_ptr_array_index (files, 2);
 
   /* Segment 1 and 2 share the identical init segment */
   fail_unless (seg1->init_file == seg2->init_file);
@@ -1469,6 +1530,324 @@ GST_START_TEST (test_map_tag)
 
 GST_END_TEST;
 
+static void
+check_next_fragment (GstM3U8 * pl, const gchar * uri, GstClockTime timestamp)
+{
+  GstM3U8MediaFile *mf;
+  GstClockTime position;
+
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, &position, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_string (mf->uri, uri);
+  assert_equals_uint64 (position, timestamp);
+  gst_m3u8_media_file_unref (mf);
+}
+
+GST_START_TEST (test_low_latency_playlist)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8MediaFile *file;
+  GstM3U8 *pl;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  assert_equals_uint64 (pl->partial_targetduration, 500 * GST_MSECOND);
+  assert_equals_uint64 (pl->part_hold_back, GST_SECOND);
+  assert_equals_int (pl->can_block_reload, TRUE);
+
+  /* complete segments keep their parts */
+  assert_equals_int (pl->files->len, 3);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
+  fail_unless (file->partial_segments == NULL);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
+  assert_equals_int (file->sequence, 102);
+  assert_equals_int (file->partial_segments->len, 4);
+  file = g_ptr_array_index (file->partial_segments, 2);
+  assert_equals_string (file->uri, "http://localhost/filePart102.2.mp4");
+  assert_equals_int (file->sequence, 102);
+  assert_equals_int (file->independent, TRUE);
+  assert_equals_uint64 (file->duration, 500 * GST_MSECOND);
+
+  /* the segment being produced is only known by its parts */
+  fail_unless (pl->partial_file != NULL);
+  assert_equals_int (pl->partial_file->sequence, 103);
+  assert_equals_int (pl->partial_file->partial_segments->len, 2);
+  fail_unless (pl->preload_hint != NULL);
+  assert_equals_int (pl->preload_hint->sequence, 103);
+  assert_equals_int (pl->preload_hint_part, 2);
+  assert_equals_int (g_list_length (pl->rendition_reports), 1);
+
+  /* playback starts PART-HOLD-BACK from the end, on an independent part */
+  assert_equals_int (pl->sequence, 103);
+  assert_equals_int (pl->part_index, 0);
+  check_next_fragment (pl, "http://localhost/filePart103.0.mp4",
+      6 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_fragment (pl, "http://localhost/filePart103.1.mp4",
+      6500 * GST_MSECOND);
+  fail_unless (gst_m3u8_has_next_fragment (pl, TRUE));
+
+  /* the hinted part is downloaded before it is listed */
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_fragment (pl, "http://localhost/filePart103.2.mp4",
+      7 * GST_SECOND);
+  fail_if (gst_m3u8_has_next_fragment (pl, TRUE));
+  gst_m3u8_advance_fragment (pl, TRUE);
+  fail_unless (gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL) == NULL);
+
+  /* once the segment is complete, continue with the parts of the next */
+  fail_unless (gst_m3u8_update (pl, g_strdup (LOW_LATENCY_PLAYLIST_UPDATED)));
+  fail_unless (pl->partial_file != NULL);
+  assert_equals_int (pl->partial_file->sequence, 104);
+  check_next_fragment (pl, "http://localhost/filePart103.3.mp4",
+      7500 * GST_MSECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_fragment (pl, "http://localhost/filePart104.0.mp4",
+      8 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_fragment (pl, "http://localhost/filePart104.1.mp4",
+      8500 * GST_MSECOND);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_low_latency_removed_parts)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  /* stop in the middle of segment 103 */
+  check_next_fragment (pl, "http://localhost/filePart103.0.mp4",
+      6 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_fragment (pl, "http://localhost/filePart103.1.mp4",
+      6500 * GST_MSECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  assert_equals_int (pl->part_index, 2);
+
+  /* the reload only lists segment 103 as a whole, continue with the parts
+   * of the next segment instead of waiting for the removed ones */
+  fail_unless (gst_m3u8_update (pl,
+          g_strdup (LOW_LATENCY_PLAYLIST_PARTS_REMOVED)));
+  fail_unless (gst_m3u8_has_next_fragment (pl, TRUE));
+  check_next_fragment (pl, "http://localhost/filePart104.0.mp4",
+      8 * GST_SECOND);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  check_next_fragment (pl, "http://localhost/filePart104.1.mp4",
+      8500 * GST_MSECOND);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_low_latency_reload_uris)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  gchar *uri;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  /* request the part after the last listed one */
+  uri = gst_m3u8_get_blocking_reload_uri (pl);
+  assert_equals_string (uri,
+      "http://localhost/test.m3u8?_HLS_msn=103&_HLS_part=2");
+  g_free (uri);
+
+  /* renditions are requested as far as the playlist reported them */
+  uri = gst_m3u8_get_rendition_report_uri (pl, "http://localhost/audio.m3u8");
+  assert_equals_string (uri,
+      "http://localhost/audio.m3u8?_HLS_msn=103&_HLS_part=1");
+  g_free (uri);
+  fail_unless (gst_m3u8_get_rendition_report_uri (pl,
+          "http://localhost/video.m3u8") == NULL);
+
+  /* previous delivery directives are replaced, other parameters kept */
+  gst_m3u8_set_uri (pl,
+      "http://localhost/test.m3u8?token=abc&_HLS_msn=99&_HLS_part=1", NULL,
+      NULL);
+  uri = gst_m3u8_get_blocking_reload_uri (pl);
+  assert_equals_string (uri,
+      "http://localhost/test.m3u8?token=abc&_HLS_msn=103&_HLS_part=2");
+  g_free (uri);
+
+  /* a server answering right away doesn't support blocking reloads */
+  fail_unless (gst_m3u8_update (pl, g_strdup (LOW_LATENCY_PLAYLIST)));
+  fail_unless (gst_m3u8_get_blocking_reload_uri (pl) == NULL);
+
+  /* regular live playlists are reloaded every target duration */
+  gst_hls_master_playlist_unref (master);
+  master = load_playlist (LIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+  fail_unless (gst_m3u8_get_blocking_reload_uri (pl) == NULL);
+  assert_equals_uint64 (gst_m3u8_get_update_interval (pl), 8 * GST_SECOND);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+/* Live playlist of @n_segments 2 seconds segments, starting at @first */
+static gchar *
+generate_live_playlist (gint64 first, guint n_segments, gboolean with_seqnum)
+{
+  GString *str;
+  guint i;
+
+  str = g_string_new ("#EXTM3U\n#EXT-X-TARGETDURATION:2\n");
+  if (with_seqnum)
+    g_string_append_printf (str, "#EXT-X-MEDIA-SEQUENCE:%" G_GINT64_FORMAT
+        "\n", first);
+  for (i = 0; i < n_segments; i++)
+    g_string_append_printf (str, "#EXTINF:2.0,\nsegment%" G_GINT64_FORMAT
+        ".ts\n", first + i);
+
+  return g_string_free (str, FALSE);
+}
+
+static GstHLSMasterPlaylist *
+load_live_playlist (gint64 first, guint n_segments, gboolean with_seqnum)
+{
+  GstHLSMasterPlaylist *master;
+  gchar *data;
+
+  data = generate_live_playlist (first, n_segments, with_seqnum);
+  master = load_playlist (data);
+  g_free (data);
+
+  return master;
+}
+
+GST_START_TEST (test_live_playlist_update_reuse)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8MediaFile *file, *reused;
+  GstM3U8 *pl;
+
+  master = load_live_playlist (100, 5, TRUE);
+  pl = master->default_variant->m3u8;
+  reused = gst_m3u8_media_file_ref (g_ptr_array_index (pl->files, 1));
+
+  /* entries still in the playlist are kept, new ones appended */
+  fail_unless (gst_m3u8_update (pl, generate_live_playlist (101, 5, TRUE)));
+  assert_equals_int (pl->files->len, 5);
+  fail_unless (g_ptr_array_index (pl->files, 0) == reused);
+  assert_equals_uint64 (reused->start, 2 * GST_SECOND);
+  file = g_ptr_array_index (pl->files, 4);
+  assert_equals_int (file->sequence, 105);
+  assert_equals_string (file->uri, "http://localhost/segment105.ts");
+  assert_equals_uint64 (file->start, 10 * GST_SECOND);
+
+  /* lookups by position */
+  assert_equals_int (gst_m3u8_find_fragment_index (pl, 0), 0);
+  assert_equals_int (gst_m3u8_find_fragment_index (pl, 2 * GST_SECOND), 0);
+  assert_equals_int (gst_m3u8_find_fragment_index (pl, 9 * GST_SECOND), 3);
+  assert_equals_int (gst_m3u8_find_fragment_index (pl, 10 * GST_SECOND), 4);
+  assert_equals_int (gst_m3u8_find_fragment_index (pl, 12 * GST_SECOND), 5);
+
+  /* changed entries are parsed again */
+  fail_unless (gst_m3u8_update (pl, g_strdup ("#EXTM3U\n\
+#EXT-X-TARGETDURATION:2\n\
+#EXT-X-MEDIA-SEQUENCE:101\n\
+#EXTINF:1.5,\n\
+segment101.ts\n")));
+  file = g_ptr_array_index (pl->files, 0);
+  fail_unless (file != reused);
+  assert_equals_uint64 (file->duration, 1500 * GST_MSECOND);
+
+  /* the same sequence with another URI is an error */
+  fail_if (gst_m3u8_update (pl, g_strdup ("#EXTM3U\n\
+#EXT-X-TARGETDURATION:2\n\
+#EXT-X-MEDIA-SEQUENCE:101\n\
+#EXTINF:1.5,\n\
+other101.ts\n")));
+
+  gst_m3u8_media_file_unref (reused);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_live_playlist_update_without_seqnum)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8MediaFile *file;
+  GstM3U8 *pl;
+
+  master = load_live_playlist (100, 5, FALSE);
+  pl = master->default_variant->m3u8;
+  file = g_ptr_array_index (pl->files, 0);
+  assert_equals_int (file->sequence, 0);
+
+  /* same URIs get the same sequence */
+  fail_unless (gst_m3u8_update (pl, generate_live_playlist (102, 5, FALSE)));
+  file = g_ptr_array_index (pl->files, 0);
+  assert_equals_string (file->uri, "http://localhost/segment102.ts");
+  assert_equals_int (file->sequence, 2);
+  file = g_ptr_array_index (pl->files, 4);
+  assert_equals_int (file->sequence, 6);
+
+  /* unknown URIs continue after the previous playlist */
+  fail_unless (gst_m3u8_update (pl, generate_live_playlist (200, 2, FALSE)));
+  file = g_ptr_array_index (pl->files, 0);
+  assert_equals_int (file->sequence, 7);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_live_playlist_update_perf)
+{
+  /* 6 hours sliding window of 2 seconds segments */
+  const guint n_segments = 6 * 3600 / 2, n_updates = 100;
+  GstHLSMasterPlaylist *master;
+  GstM3U8MediaFile *file;
+  GstM3U8 *pl;
+  gint64 start, parse_time, update_time = 0;
+  gchar *data;
+  guint i;
+
+  data = generate_live_playlist (0, n_segments, TRUE);
+  start = g_get_monotonic_time ();
+  master = load_playlist (data);
+  parse_time = g_get_monotonic_time () - start;
+  g_free (data);
+  pl = master->default_variant->m3u8;
+
+  for (i = 1; i <= n_updates; i++) {
+    data = generate_live_playlist (i, n_segments, TRUE);
+    start = g_get_monotonic_time ();
+    fail_unless (gst_m3u8_update (pl, data));
+    update_time += g_get_monotonic_time () - start;
+
+    gst_m3u8_advance_fragment (pl, TRUE);
+  }
+
+  assert_equals_int (pl->files->len, n_segments);
+  file = g_ptr_array_index (pl->files, 0);
+  assert_equals_int (file->sequence, n_updates);
+  assert_equals_uint64 (file->start, n_updates * 2 * GST_SECOND);
+  assert_equals_int (gst_m3u8_find_fragment_index (pl,
+          (n_updates + 100) * 2 * GST_SECOND + GST_SECOND), 100);
+
+  GST_INFO ("%u segments: parse: %" G_GINT64_FORMAT " us, update: %.1f us",
+      n_segments, parse_time, (gdouble) update_time / n_updates);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 static Suite *
 hlsdemux_suite (void)
 {
@@ -1512,6 +1891,12 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_url_with_slash_query_param);
   tcase_add_test (tc_m3u8, test_stream_inf_tag);
   tcase_add_test (tc_m3u8, test_map_tag);
+  tcase_add_test (tc_m3u8, test_low_latency_playlist);
+  tcase_add_test (tc_m3u8, test_low_latency_removed_parts);
+  tcase_add_test (tc_m3u8, test_low_latency_reload_uris);
+  tcase_add_test (tc_m3u8, test_live_playlist_update_reuse);
+  tcase_add_test (tc_m3u8, test_live_playlist_update_without_seqnum);
+  tcase_add_test (tc_m3u8, test_live_playlist_update_perf);
   return s;
 }
 
@@ -478,6 +478,341 @@ GST_START_TEST (test_keyframe_flag_propagation)
 
 GST_END_TEST;
 
+typedef struct
+{
+  /* expected size of every output buffer */
+  gsize buffer_size;
+  guint n_buffers;
+  guint64 n_bytes;
+  /* distinct output memory areas, to count allocations */
+  GHashTable *chunks;
+} OutputStats;
+
+static GstPadProbeReturn
+output_stats_probe (GstPad * pad, GstPadProbeInfo * info, OutputStats * stats)
+{
+  GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstMapInfo map;
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, stats->buffer_size);
+  fail_unless (map.data[0] == 0x47);
+  g_hash_table_add (stats->chunks, map.data);
+  stats->n_bytes += map.size;
+  gst_buffer_unmap (buf, &map);
+  stats->n_buffers++;
+
+  /* release output right away, so that it can be recycled */
+  return GST_PAD_PROBE_DROP;
+}
+
+GST_START_TEST (test_output_batching)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GstQuery *drain;
+  OutputStats stats = { 7 * 188, };
+  GstClockTime ts = 0;
+  guint n_chunks;
+  gint i;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "alignment", 7, NULL);
+  stats.chunks = g_hash_table_new (NULL, NULL);
+  gst_pad_add_probe (mysinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) output_stats_probe, &stats, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  for (i = 0; i < 1000; i++) {
+    GstBuffer *inbuffer = gst_buffer_new_and_alloc (16 * 1024);
+
+    gst_buffer_memset (inbuffer, 0, 0, 16 * 1024);
+    GST_BUFFER_PTS (inbuffer) = ts;
+    if (i % KEYFRAME_DISTANCE != 0)
+      GST_BUFFER_FLAG_SET (inbuffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+    ts += 40 * GST_MSECOND;
+  }
+
+  drain = gst_query_new_drain ();
+  gst_pad_peer_query (mysrcpad, drain);
+  gst_query_unref (drain);
+
+  /* every output buffer holds 7 packets */
+  n_chunks = g_hash_table_size (stats.chunks);
+  fail_unless (stats.n_buffers > 1000);
+  fail_unless_equals_uint64 (stats.n_bytes, stats.n_buffers * 7 * 188);
+  /* output chunks are recycled instead of being allocated per buffer */
+  fail_unless (n_chunks < 16, "%u chunks allocated for %u buffers",
+      n_chunks, stats.n_buffers);
+  /* nothing was collected by the sink pad */
+  fail_unless (buffers == NULL);
+
+  g_hash_table_unref (stats.chunks);
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+/* Muxes a few video frames, made of memories of @mem_size bytes each if
+ * not 0. Returns the output, whether it references the payload of the input
+ * buffers, and the size of the largest memory of the output buffers before
+ * the last one, which is padded when draining */
+static GByteArray *
+mux_video_frames (gboolean zero_copy, gsize mem_size, gboolean * shared,
+    gsize * max_mem_size)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GstQuery *drain;
+  GByteArray *output = g_byte_array_new ();
+  GstBuffer *inbufs[20];
+  guint8 *indata[20];
+  gsize insize[20];
+  GstClockTime ts = 0;
+  gint i;
+
+  *shared = FALSE;
+  *max_mem_size = 0;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "alignment", 7, "zero-copy", zero_copy, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  for (i = 0; i < G_N_ELEMENTS (inbufs); i++) {
+    gsize size = 1000 + i * 777;
+    guint8 *data = g_malloc (size);
+    gsize j;
+
+    for (j = 0; j < size; j++)
+      data[j] = (i + j) & 0xff;
+    indata[i] = data;
+    insize[i] = size;
+
+    inbufs[i] = gst_buffer_new ();
+    for (j = 0; j < size; j += mem_size ? mem_size : size) {
+      gsize len = mem_size ? MIN (mem_size, size - j) : size;
+
+      gst_buffer_append_memory (inbufs[i], gst_memory_new_wrapped (0, data,
+              size, j, len, NULL, NULL));
+    }
+    GST_BUFFER_PTS (inbufs[i]) = ts;
+    if (i % KEYFRAME_DISTANCE != 0)
+      GST_BUFFER_FLAG_SET (inbufs[i], GST_BUFFER_FLAG_DELTA_UNIT);
+    fail_unless_equals_int (gst_pad_push (mysrcpad,
+            gst_buffer_ref (inbufs[i])), GST_FLOW_OK);
+    ts += 40 * GST_MSECOND;
+  }
+
+  drain = gst_query_new_drain ();
+  gst_pad_peer_query (mysrcpad, drain);
+  gst_query_unref (drain);
+
+  while (buffers != NULL) {
+    GstBuffer *buf = buffers->data;
+    guint m, n_mem = gst_buffer_n_memory (buf);
+    GstMapInfo map;
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), 7 * 188);
+
+    for (m = 0; m < n_mem; m++) {
+      GstMemory *mem = gst_buffer_peek_memory (buf, m);
+
+      gst_memory_map (mem, &map, GST_MAP_READ);
+      for (i = 0; i < G_N_ELEMENTS (inbufs); i++) {
+        if (map.data >= indata[i] && map.data < indata[i] + insize[i])
+          *shared = TRUE;
+      }
+      if (buffers->next)
+        *max_mem_size = MAX (*max_mem_size, map.size);
+      gst_memory_unmap (mem, &map);
+    }
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    g_byte_array_append (output, map.data, map.size);
+    gst_buffer_unmap (buf, &map);
+
+    buffers = g_list_remove (buffers, buf);
+    gst_buffer_unref (buf);
+  }
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+
+  for (i = 0; i < G_N_ELEMENTS (inbufs); i++) {
+    gst_buffer_unref (inbufs[i]);
+    g_free (indata[i]);
+  }
+
+  return output;
+}
+
+GST_START_TEST (test_zero_copy)
+{
+  GByteArray *copied, *referenced, *split;
+  gboolean shared;
+  gsize max_mem_size;
+
+  copied = mux_video_frames (FALSE, 0, &shared, &max_mem_size);
+  fail_if (shared);
+  referenced = mux_video_frames (TRUE, 0, &shared, &max_mem_size);
+  fail_unless (shared);
+
+  /* With payloads spread over many memories, packets have more memories
+   * than fit in an aligned chunk. Those must be copied one by one instead
+   * of merging the whole chunk into a single memory */
+  split = mux_video_frames (TRUE, 50, &shared, &max_mem_size);
+  fail_unless (shared);
+  fail_unless (max_mem_size <= 188);
+
+  fail_unless (copied->len > 0);
+  fail_unless_equals_int (copied->len, referenced->len);
+  fail_unless (memcmp (copied->data, referenced->data, copied->len) == 0);
+  fail_unless_equals_int (copied->len, split->len);
+  fail_unless (memcmp (copied->data, split->data, copied->len) == 0);
+
+  g_byte_array_unref (copied);
+  g_byte_array_unref (referenced);
+  g_byte_array_unref (split);
+}
+
+GST_END_TEST;
+
+#define CBR_BITRATE 2000000
+
+GST_START_TEST (test_cbr_pcr_accuracy)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GstQuery *drain;
+  GstStructure *stats;
+  GstClockTime ts = 0;
+  guint64 offset = 0, first_offset = 0, last_pcr = 0, max_interval = 0;
+  guint64 first_pcr = 0, n_pcr = 0, n_null = 0, value;
+  gdouble max_error = 0;
+  gint i;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  /* 30 ms PCR interval, for the 40 ms of TR 101 290 */
+  g_object_set (mux, "bitrate", (guint64) CBR_BITRATE, "pcr-interval", 2700,
+      NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* about 1 Mbps of video, with larger keyframes */
+  for (i = 0; i < 100; i++) {
+    GstBuffer *inbuffer;
+
+    inbuffer = gst_buffer_new_and_alloc (i % KEYFRAME_DISTANCE ? 4000 : 12000);
+    gst_buffer_memset (inbuffer, 0, 0, gst_buffer_get_size (inbuffer));
+    GST_BUFFER_PTS (inbuffer) = ts;
+    if (i % KEYFRAME_DISTANCE != 0)
+      GST_BUFFER_FLAG_SET (inbuffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+    ts += 40 * GST_MSECOND;
+  }
+
+  drain = gst_query_new_drain ();
+  gst_pad_peer_query (mysrcpad, drain);
+  gst_query_unref (drain);
+
+  while (buffers != NULL) {
+    GstBuffer *buf = buffers->data;
+    GstMapInfo map;
+    gsize pos;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    fail_unless (map.size % 188 == 0);
+
+    for (pos = 0; pos < map.size; pos += 188, offset += 188) {
+      const guint8 *p = map.data + pos;
+      guint16 pid = GST_READ_UINT16_BE (p + 1) & 0x1fff;
+      guint64 pcr;
+
+      fail_unless (p[0] == 0x47);
+      if (pid == 0x1fff)
+        n_null++;
+
+      /* adaptation field with PCR */
+      if (!(p[3] & 0x20) || p[4] == 0 || !(p[5] & 0x10))
+        continue;
+
+      pcr = ((guint64) GST_READ_UINT32_BE (p + 6) << 1 | p[10] >> 7) * 300 +
+          ((p[10] & 1) << 8 | p[11]);
+
+      if (n_pcr == 0) {
+        first_pcr = pcr;
+        first_offset = offset;
+      } else {
+        gdouble expected, error;
+
+        /* the PCR gives the time of its packet slot at the output bitrate */
+        expected = first_pcr + (offset - first_offset) * 8 * 27000000.0 /
+            CBR_BITRATE;
+        error = ABS (pcr - expected) / 27.0;
+        max_error = MAX (max_error, error);
+
+        fail_unless (pcr > last_pcr);
+        max_interval = MAX (max_interval, (pcr - last_pcr) / 27);
+      }
+      last_pcr = pcr;
+      n_pcr++;
+    }
+
+    gst_buffer_unmap (buf, &map);
+    buffers = g_list_remove (buffers, buf);
+    gst_buffer_unref (buf);
+  }
+
+  GST_INFO ("%" G_GUINT64_FORMAT " packets, %" G_GUINT64_FORMAT " null, %"
+      G_GUINT64_FORMAT " PCRs, max interval %" G_GUINT64_FORMAT " us, max "
+      "error %.1f ns", offset / 188, n_null, n_pcr, max_interval, max_error);
+
+  /* 4 s of output at the bitrate, less the drained tail */
+  fail_unless (offset >= (guint64) CBR_BITRATE / 8 * 39 / 10);
+  fail_unless (n_null > 0);
+  fail_unless (n_pcr > 100);
+  fail_unless (max_error <= 500.0, "PCR off by %.1f ns", max_error);
+  fail_unless (max_interval <= 40000, "PCR interval of %" G_GUINT64_FORMAT
+      " us", max_interval);
+
+  g_object_get (mux, "cbr-stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "null-packets", &value));
+  fail_unless (value > 0);
+  fail_unless (gst_structure_get_uint64 (stats, "overflows", &value));
+  fail_unless_equals_int (value, 0);
+  fail_unless (gst_structure_get_uint64 (stats, "max-pcr-interval", &value));
+  fail_unless (value <= 40 * GST_MSECOND);
+  gst_structure_free (stats);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsmux_suite (void)
 {
@@ -491,6 +826,9 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_multiple_state_change);
   tcase_add_test (tc_chain, test_align);
   tcase_add_test (tc_chain, test_keyframe_flag_propagation);
+  tcase_add_test (tc_chain, test_output_batching);
+  tcase_add_test (tc_chain, test_zero_copy);
+  tcase_add_test (tc_chain, test_cbr_pcr_accuracy);
 
   return s;
 }
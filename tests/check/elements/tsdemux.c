@@ -0,0 +1,642 @@
+/* GStreamer
+ *
+ * unit test for tsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "../../gst/mpegtsdemux/mpegtsindex.c"
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/mpegts, systemstream = (boolean) true")
+    );
+
+static GstPad *mysrcpad;
+
+#define TS_PACKET_SIZE 188
+#define PMT_PID_BASE 0x100
+#define ES_PID_BASE 0x200
+/* Synthetic multiplex bitrate, used to generate PCR/PTS values */
+#define MPTS_BITRATE 80000000
+/* PSI repetition interval, in packets */
+#define PSI_INTERVAL 500
+/* Number of packets making up each PES */
+#define PES_PACKETS 8
+/* Delay of the PTS after the PCR of the packet starting the PES, which is the
+ * largest one allowed */
+#define PTS_DELAY GST_SECOND
+
+typedef struct
+{
+  guint n_programs;
+  guint8 *cc;
+  guint64 n_packets;
+  guint64 bitrate;
+  /* Every rai_interval-th PES of a program is a random access point */
+  guint rai_interval;
+  /* when set, counts the PES started for each program */
+  guint *pes_count;
+} MptsGenerator;
+
+static guint buffer_count;
+static guint64 buffer_bytes;
+/* when set, fed with the timestamps, size and content of each buffer */
+static GChecksum *buffer_checksum;
+/* when set, every output memory must be a share of it */
+static GstMemory *zero_copy_source;
+static gboolean have_eos;
+static GMutex eos_lock;
+static GCond eos_cond;
+
+static guint32
+mpegts_crc32 (const guint8 * data, guint len)
+{
+  guint32 crc = 0xffffffff;
+  guint i, j;
+
+  for (i = 0; i < len; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+static void
+write_header (MptsGenerator * gen, guint8 * data, guint16 pid,
+    gboolean pusi, gboolean afc)
+{
+  data[0] = 0x47;
+  GST_WRITE_UINT16_BE (data + 1, (pusi ? 0x4000 : 0) | pid);
+  data[3] = (afc ? 0x30 : 0x10) | (gen->cc[pid]++ & 0x0f);
+}
+
+/* Writes a PSI packet for @section, which gets its length and CRC filled in */
+static void
+write_section (MptsGenerator * gen, guint8 * data, guint16 pid,
+    guint8 * section, guint len)
+{
+  guint32 crc;
+
+  GST_WRITE_UINT16_BE (section + 1, 0xb000 | (len + 4 - 3));
+  crc = mpegts_crc32 (section, len);
+  GST_WRITE_UINT32_BE (section + len, crc);
+
+  write_header (gen, data, pid, TRUE, FALSE);
+  data[4] = 0;
+  memset (data + 5, 0xff, TS_PACKET_SIZE - 5);
+  memcpy (data + 5, section, len + 4);
+}
+
+static void
+write_pat (MptsGenerator * gen, guint8 * data)
+{
+  guint8 section[TS_PACKET_SIZE];
+  guint i, len = 8;
+
+  section[0] = 0x00;
+  GST_WRITE_UINT16_BE (section + 3, 1);
+  section[5] = 0xc1;
+  section[6] = section[7] = 0;
+  for (i = 0; i < gen->n_programs; i++, len += 4) {
+    GST_WRITE_UINT16_BE (section + len, i + 1);
+    GST_WRITE_UINT16_BE (section + len + 2, 0xe000 | (PMT_PID_BASE + i));
+  }
+
+  write_section (gen, data, 0, section, len);
+}
+
+static void
+write_pmt (MptsGenerator * gen, guint8 * data, guint program)
+{
+  guint8 section[TS_PACKET_SIZE];
+
+  section[0] = 0x02;
+  GST_WRITE_UINT16_BE (section + 3, program + 1);
+  section[5] = 0xc1;
+  section[6] = section[7] = 0;
+  GST_WRITE_UINT16_BE (section + 8, 0xe000 | (ES_PID_BASE + program));
+  GST_WRITE_UINT16_BE (section + 10, 0xf000);
+  /* MPEG-1 audio */
+  section[12] = 0x03;
+  GST_WRITE_UINT16_BE (section + 13, 0xe000 | (ES_PID_BASE + program));
+  GST_WRITE_UINT16_BE (section + 15, 0xf000);
+
+  write_section (gen, data, PMT_PID_BASE + program, section, 17);
+}
+
+static void
+write_pes (MptsGenerator * gen, guint8 * data, guint program, guint64 pcr,
+    gboolean start, gboolean random_access)
+{
+  guint16 pid = ES_PID_BASE + program;
+  guint8 *p = data + 4;
+
+  memset (data, 0xff, TS_PACKET_SIZE);
+  write_header (gen, data, pid, start, start);
+  if (!start)
+    return;
+
+  /* adaptation field with PCR */
+  *p++ = 7;
+  *p++ = random_access ? 0x50 : 0x10;
+  GST_WRITE_UINT32_BE (p, (guint32) ((pcr / 300) >> 1));
+  p[4] = (((pcr / 300) & 1) << 7) | 0x7e | (((pcr % 300) >> 8) & 1);
+  p[5] = (pcr % 300) & 0xff;
+  p += 6;
+
+  /* PES header with PTS */
+  GST_WRITE_UINT32_BE (p, 0x000001c0);
+  GST_WRITE_UINT16_BE (p + 4, 0);
+  p[6] = 0x80;
+  p[7] = 0x80;
+  p[8] = 5;
+  pcr = pcr / 300 + gst_util_uint64_scale (PTS_DELAY, 90000, GST_SECOND);
+  p[9] = 0x21 | ((pcr >> 29) & 0x0e);
+  GST_WRITE_UINT16_BE (p + 10, ((pcr >> 14) & 0xfffe) | 1);
+  GST_WRITE_UINT16_BE (p + 12, ((pcr << 1) & 0xfffe) | 1);
+}
+
+/* Generates @n_packets of a multiple program transport stream where the
+ * programs' PES packets are interleaved */
+static GstBuffer *
+generate_mpts (MptsGenerator * gen, guint n_packets)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint8 *data;
+  guint i;
+
+  buf = gst_buffer_new_allocate (NULL, n_packets * TS_PACKET_SIZE, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  data = map.data;
+
+  for (i = 0; i < n_packets; i++, gen->n_packets++, data += TS_PACKET_SIZE) {
+    guint64 pcr = gen->n_packets * TS_PACKET_SIZE * 8 * G_GUINT64_CONSTANT (27)
+        * 1000000 / gen->bitrate;
+    guint slot = gen->n_packets % PSI_INTERVAL;
+
+    if (slot == 0) {
+      write_pat (gen, data);
+    } else if (slot <= gen->n_programs) {
+      write_pmt (gen, data, slot - 1);
+    } else {
+      guint program = gen->n_packets % gen->n_programs;
+      guint64 pes = gen->n_packets / gen->n_programs / PES_PACKETS;
+      guint pes_packet = (gen->n_packets / gen->n_programs) % PES_PACKETS;
+
+      write_pes (gen, data, program, pcr, pes_packet == 0,
+          gen->rai_interval && pes % gen->rai_interval == 0);
+      if (gen->pes_count && pes_packet == 0)
+        gen->pes_count[program]++;
+    }
+  }
+
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstPadProbeReturn
+count_buffers_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  buffer_count++;
+  buffer_bytes += gst_buffer_get_size (buffer);
+
+  if (buffer_checksum) {
+    guint64 header[3] = { GST_BUFFER_PTS (buffer), GST_BUFFER_DTS (buffer),
+      gst_buffer_get_size (buffer)
+    };
+    GstMapInfo map;
+
+    g_checksum_update (buffer_checksum, (const guchar *) header,
+        sizeof (header));
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    g_checksum_update (buffer_checksum, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+  }
+
+  if (zero_copy_source) {
+    guint i;
+
+    for (i = 0; i < gst_buffer_n_memory (buffer); i++)
+      fail_unless (gst_buffer_peek_memory (buffer, i)->parent ==
+          zero_copy_source);
+  }
+
+  return GST_PAD_PROBE_DROP;
+}
+
+static GstPadProbeReturn
+eos_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS) {
+    g_mutex_lock (&eos_lock);
+    have_eos = TRUE;
+    g_cond_broadcast (&eos_cond);
+    g_mutex_unlock (&eos_lock);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+pad_added_cb (GstElement * demux, GstPad * pad, gpointer user_data)
+{
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, count_buffers_probe,
+      NULL, NULL);
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, eos_probe,
+      NULL, NULL);
+}
+
+/* Pushes EOS and waits for it to come out of the demuxer */
+static void
+push_eos_and_wait (void)
+{
+  gst_pad_push_event (mysrcpad, gst_event_new_eos ());
+
+  g_mutex_lock (&eos_lock);
+  while (!have_eos)
+    g_cond_wait (&eos_cond, &eos_lock);
+  g_mutex_unlock (&eos_lock);
+}
+
+static GstElement *
+setup_tsdemux (const gchar * first_prop_name, ...)
+{
+  GstElement *demux;
+  GstCaps *caps;
+  va_list args;
+
+  demux = gst_check_setup_element ("tsdemux");
+  va_start (args, first_prop_name);
+  g_object_set_valist (G_OBJECT (demux), first_prop_name, args);
+  va_end (args);
+  g_signal_connect (demux, "pad-added", G_CALLBACK (pad_added_cb), NULL);
+
+  mysrcpad = gst_check_setup_src_pad (demux, &src_template);
+  gst_pad_set_active (mysrcpad, TRUE);
+  fail_unless (gst_element_set_state (demux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_pad_get_pad_template_caps (mysrcpad);
+  gst_check_setup_events (mysrcpad, demux, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+  buffer_count = 0;
+  buffer_bytes = 0;
+  have_eos = FALSE;
+
+  return demux;
+}
+
+static void
+cleanup_tsdemux (GstElement * demux)
+{
+  gst_element_set_state (demux, GST_STATE_NULL);
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_check_teardown_src_pad (demux);
+  gst_check_teardown_element (demux);
+}
+
+/* Pushes @n_chunks buffers of @chunk_packets packets each of a multiplex with
+ * @n_programs, counting the PES started for each program in @pes_count if not
+ * %NULL */
+static void
+push_mpts (guint n_programs, guint n_chunks, guint chunk_packets,
+    guint * pes_count)
+{
+  MptsGenerator gen = { n_programs, g_new0 (guint8, 0x2000), 0,
+    MPTS_BITRATE, 0, pes_count
+  };
+  GstBuffer **chunks;
+  guint64 offset = 0;
+  guint i;
+
+  chunks = g_new (GstBuffer *, n_chunks);
+  for (i = 0; i < n_chunks; i++) {
+    chunks[i] = generate_mpts (&gen, chunk_packets);
+    GST_BUFFER_OFFSET (chunks[i]) = offset;
+    offset += chunk_packets * TS_PACKET_SIZE;
+  }
+
+  for (i = 0; i < n_chunks; i++)
+    fail_unless_equals_int (gst_pad_push (mysrcpad, chunks[i]), GST_FLOW_OK);
+
+  g_free (chunks);
+  g_free (gen.cc);
+}
+
+GST_START_TEST (test_mpts_program_selection)
+{
+  guint pes_count[32] = { 0, };
+  GstElement *demux;
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  gchar *name;
+
+  demux = setup_tsdemux ("program-number", 5, NULL);
+  push_mpts (32, 20, 1000, pes_count);
+  push_eos_and_wait ();
+
+  /* Only the stream of program 5 is exposed */
+  it = gst_element_iterate_src_pads (demux);
+  fail_unless_equals_int (gst_iterator_next (it, &item), GST_ITERATOR_OK);
+  name = gst_pad_get_name (g_value_get_object (&item));
+  fail_unless (g_str_has_suffix (name, "_0204"), "unexpected pad %s", name);
+  g_free (name);
+  g_value_unset (&item);
+  fail_unless_equals_int (gst_iterator_next (it, &item), GST_ITERATOR_DONE);
+  gst_iterator_free (it);
+
+  /* and outputs every PES of the program */
+  fail_unless (pes_count[4] > 0);
+  fail_unless_equals_int (buffer_count, pes_count[4]);
+  cleanup_tsdemux (demux);
+}
+
+GST_END_TEST;
+
+/* Both modes output the same PES */
+GST_START_TEST (test_zero_copy_output)
+{
+  GstElement *demux;
+  guint copy_count;
+  guint64 copy_bytes;
+  gchar *copy_digest;
+
+  buffer_checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  demux = setup_tsdemux ("program-number", 1, "zero-copy", FALSE, NULL);
+  push_mpts (1, 200, 1000, NULL);
+  copy_count = buffer_count;
+  copy_bytes = buffer_bytes;
+  copy_digest = g_strdup (g_checksum_get_string (buffer_checksum));
+  cleanup_tsdemux (demux);
+
+  g_checksum_reset (buffer_checksum);
+  demux = setup_tsdemux ("program-number", 1, "zero-copy", TRUE, NULL);
+  push_mpts (1, 200, 1000, NULL);
+  cleanup_tsdemux (demux);
+
+  fail_unless (copy_count > 0);
+  fail_unless_equals_int (buffer_count, copy_count);
+  fail_unless_equals_uint64 (buffer_bytes, copy_bytes);
+  fail_unless_equals_string (g_checksum_get_string (buffer_checksum),
+      copy_digest);
+
+  g_free (copy_digest);
+  g_checksum_free (buffer_checksum);
+  buffer_checksum = NULL;
+}
+
+GST_END_TEST;
+
+/* Input not aligned on packets makes the PES span several upstream buffers,
+ * which must still be referenced rather than copied */
+GST_START_TEST (test_zero_copy_unaligned_input)
+{
+  MptsGenerator gen = { 1, g_new0 (guint8, 0x2000), 0, MPTS_BITRATE, 0, NULL };
+  GstElement *demux;
+  GstBuffer *stream;
+  guint copy_count;
+  gchar *copy_digest;
+  gsize size, offset;
+
+  stream = generate_mpts (&gen, 2000);
+  size = gst_buffer_get_size (stream);
+
+  buffer_checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  demux = setup_tsdemux ("program-number", 1, "zero-copy", FALSE, NULL);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, gst_buffer_ref (stream)),
+      GST_FLOW_OK);
+  push_eos_and_wait ();
+  copy_count = buffer_count;
+  copy_digest = g_strdup (g_checksum_get_string (buffer_checksum));
+  cleanup_tsdemux (demux);
+
+  g_checksum_reset (buffer_checksum);
+  demux = setup_tsdemux ("program-number", 1, "zero-copy", TRUE, NULL);
+  zero_copy_source = gst_buffer_peek_memory (stream, 0);
+  /* 1000 bytes is not a multiple of the packet size */
+  for (offset = 0; offset < size; offset += 1000) {
+    GstBuffer *chunk = gst_buffer_copy_region (stream, GST_BUFFER_COPY_MEMORY,
+        offset, MIN (1000, size - offset));
+
+    GST_BUFFER_OFFSET (chunk) = offset;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, chunk), GST_FLOW_OK);
+  }
+  push_eos_and_wait ();
+  zero_copy_source = NULL;
+  cleanup_tsdemux (demux);
+
+  fail_unless (copy_count > 0);
+  fail_unless_equals_int (buffer_count, copy_count);
+  fail_unless_equals_string (g_checksum_get_string (buffer_checksum),
+      copy_digest);
+
+  g_free (copy_digest);
+  g_checksum_free (buffer_checksum);
+  buffer_checksum = NULL;
+  gst_buffer_unref (stream);
+  g_free (gen.cc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_program_worker)
+{
+  GstElement *demux;
+  GstStructure *stats;
+  guint direct_count;
+  guint64 direct_bytes, pushed;
+  gint program_number;
+
+  demux = setup_tsdemux ("program-number", 3, NULL);
+  push_mpts (8, 200, 1000, NULL);
+  push_eos_and_wait ();
+  direct_count = buffer_count;
+  direct_bytes = buffer_bytes;
+  g_object_get (demux, "worker-stats", &stats, NULL);
+  fail_unless (stats == NULL);
+  cleanup_tsdemux (demux);
+
+  demux = setup_tsdemux ("program-number", 3, "program-worker", TRUE,
+      "worker-max-buffers", 16, NULL);
+  push_mpts (8, 200, 1000, NULL);
+  push_eos_and_wait ();
+
+  g_object_get (demux, "worker-stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  GST_INFO ("worker stats %" GST_PTR_FORMAT, stats);
+  fail_unless (gst_structure_get_int (stats, "program-number",
+          &program_number));
+  fail_unless_equals_int (program_number, 3);
+  fail_unless (gst_structure_get_uint64 (stats, "pushed", &pushed));
+  fail_unless_equals_uint64 (pushed, buffer_count);
+  gst_structure_free (stats);
+  cleanup_tsdemux (demux);
+
+  /* The worker outputs the same PES */
+  fail_unless (direct_count > 0);
+  fail_unless_equals_int (buffer_count, direct_count);
+  fail_unless_equals_uint64 (buffer_bytes, direct_bytes);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_program_worker_flush_stop)
+{
+  GstElement *demux;
+  GstSegment segment;
+  guint count;
+
+  demux = setup_tsdemux ("program-number", 1, "program-worker", TRUE, NULL);
+  push_mpts (2, 20, 1000, NULL);
+
+  /* A FLUSH_STOP without FLUSH_START while the worker waits for data must
+   * not block */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_stop (TRUE)));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  count = buffer_count;
+  push_mpts (2, 20, 1000, NULL);
+  push_eos_and_wait ();
+  fail_unless (buffer_count > count);
+  cleanup_tsdemux (demux);
+}
+
+GST_END_TEST;
+
+static guint64 upstream_seek_offset;
+
+static gboolean
+upstream_seek_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstFormat format;
+  gint64 start;
+  gboolean res = FALSE;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK) {
+    /* Only byte seeks are supported, like a plain source */
+    gst_event_parse_seek (event, NULL, &format, NULL, NULL, &start, NULL,
+        NULL);
+    if (format == GST_FORMAT_BYTES) {
+      upstream_seek_offset = start;
+      res = TRUE;
+    }
+  }
+  gst_event_unref (event);
+
+  return res;
+}
+
+GST_START_TEST (test_index_seek)
+{
+  /* 1 Mbit/s with a random access point every 64 PES (about 0.8s) */
+  MptsGenerator gen = { 1, g_new0 (guint8, 0x2000), 0, 1000000, 64, NULL };
+  GstBuffer *chunks[20];
+  MpegTSIndex *index;
+  MpegTSIndexEntry entry;
+  GstElement *demux;
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GstEvent *seek;
+  GError *err = NULL;
+  gchar *location;
+  guint64 offset = 0;
+  gint fd;
+  guint i;
+
+  /* Build the index of the whole stream (about 28s) */
+  fd = g_file_open_tmp ("tsdemux-XXXXXX.idx", &location, &err);
+  fail_unless (fd != -1, "%s", err ? err->message : "");
+  g_close (fd, NULL);
+
+  index = mpegts_index_new ();
+  for (i = 0; i < G_N_ELEMENTS (chunks); i++) {
+    GstMapInfo map;
+
+    chunks[i] = generate_mpts (&gen, 1000);
+    GST_BUFFER_OFFSET (chunks[i]) = offset;
+    offset += gst_buffer_get_size (chunks[i]);
+    gst_buffer_map (chunks[i], &map, GST_MAP_READ);
+    mpegts_index_scan (index, map.data, map.size);
+    gst_buffer_unmap (chunks[i], &map);
+  }
+  mpegts_index_finish (index);
+  fail_unless (mpegts_index_save (index, location, NULL));
+
+  /* The seek should resume from the last random access point presented
+   * before 10s, which is stamped with its PCR */
+  fail_unless (mpegts_index_lookup (index, ES_PID_BASE,
+          MPEGTS_INDEX_ENTRY_KEYFRAME, 10 * GST_SECOND - PTS_DELAY, &entry));
+  fail_unless (entry.time + PTS_DELAY <= 10 * GST_SECOND);
+  fail_unless (entry.time + PTS_DELAY > 9 * GST_SECOND);
+  fail_unless_equals_int (entry.offset % TS_PACKET_SIZE, 0);
+  mpegts_index_free (index);
+
+  demux = setup_tsdemux ("program-number", 1, "index-location", location,
+      NULL);
+  gst_pad_set_event_function (mysrcpad, upstream_seek_event);
+  for (i = 0; i < G_N_ELEMENTS (chunks); i++)
+    fail_unless_equals_int (gst_pad_push (mysrcpad, chunks[i]), GST_FLOW_OK);
+
+  it = gst_element_iterate_src_pads (demux);
+  fail_unless_equals_int (gst_iterator_next (it, &item), GST_ITERATOR_OK);
+  upstream_seek_offset = -1;
+  seek = gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+      GST_SEEK_TYPE_SET, 10 * GST_SECOND, GST_SEEK_TYPE_NONE, -1);
+  fail_unless (gst_pad_send_event (g_value_get_object (&item), seek));
+  fail_unless_equals_uint64 (upstream_seek_offset, entry.offset);
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  cleanup_tsdemux (demux);
+  g_unlink (location);
+  g_free (location);
+  g_free (gen.cc);
+}
+
+GST_END_TEST;
+
+static Suite *
+tsdemux_suite (void)
+{
+  Suite *s = suite_create ("tsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+
+  tcase_add_test (tc_chain, test_mpts_program_selection);
+  tcase_add_test (tc_chain, test_zero_copy_output);
+  tcase_add_test (tc_chain, test_zero_copy_unaligned_input);
+  tcase_add_test (tc_chain, test_program_worker);
+  tcase_add_test (tc_chain, test_program_worker_flush_stop);
+  tcase_add_test (tc_chain, test_index_seek);
+
+  return s;
+}
+
+GST_CHECK_MAIN (tsdemux);
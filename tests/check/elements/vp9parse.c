@@ -0,0 +1,249 @@
+/* GStreamer
+ *
+ * unit test for vp9parse
+ *
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/check.h>
+#include <gst/base/gstbitwriter.h>
+
+/* frame header showing the frame in the first reference slot */
+#define SHOW_EXISTING_FRAME 0x88
+
+/* Writes the uncompressed header of a profile 0 key frame, followed by a
+ * stand-in for the compressed data */
+static guint8 *
+create_key_frame (guint width, guint height, gboolean show_frame,
+    gsize * size)
+{
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, 2, 2);   /* frame_marker */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 2);   /* profile */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* show_existing_frame */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* frame_type */
+  gst_bit_writer_put_bits_uint32 (&bw, show_frame, 1);
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* error_resilient_mode */
+  gst_bit_writer_put_bits_uint32 (&bw, 0x498342, 24);   /* sync code */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 3);   /* color_space */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* color_range */
+  gst_bit_writer_put_bits_uint32 (&bw, width - 1, 16);
+  gst_bit_writer_put_bits_uint32 (&bw, height - 1, 16);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* display size */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 2);   /* frame_context_idx */
+  gst_bit_writer_put_bits_uint32 (&bw, 10, 6);  /* filter_level */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 3);   /* sharpness_level */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* mode_ref_delta_enabled */
+  gst_bit_writer_put_bits_uint32 (&bw, 60, 8);  /* base_q_idx */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 3);   /* no delta_q */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* segmentation */
+  /* no tile columns bits below 256 pixels, and one tile row */
+  fail_unless (width <= 256);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);
+  gst_bit_writer_put_bits_uint32 (&bw, 4, 16);  /* first_partition_size */
+  gst_bit_writer_align_bytes (&bw, 0);
+  gst_bit_writer_put_bits_uint32 (&bw, 0xa5a5a5a5, 32);
+
+  *size = gst_bit_writer_get_size (&bw) / 8;
+
+  return gst_bit_writer_reset_and_get_data (&bw);
+}
+
+/* A hidden key frame followed by a frame showing it, with a superframe
+ * index of one byte per frame size */
+static guint8 *
+create_superframe (gsize * key_frame_size, gsize * size)
+{
+  guint8 *key_frame, *data;
+
+  key_frame = create_key_frame (176, 144, FALSE, key_frame_size);
+  fail_unless (*key_frame_size < 256);
+
+  *size = *key_frame_size + 1 + 4;
+  data = g_malloc (*size);
+  memcpy (data, key_frame, *key_frame_size);
+  data[*key_frame_size] = SHOW_EXISTING_FRAME;
+  data[*key_frame_size + 1] = 0xc1;
+  data[*key_frame_size + 2] = *key_frame_size;
+  data[*key_frame_size + 3] = 1;
+  data[*key_frame_size + 4] = 0xc1;
+
+  g_free (key_frame);
+
+  return data;
+}
+
+static void
+check_flags (GstBuffer * buffer, gboolean key_frame, gboolean shown)
+{
+  fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buffer,
+          GST_BUFFER_FLAG_DELTA_UNIT), !key_frame);
+  fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buffer,
+          GST_BUFFER_FLAG_DECODE_ONLY), !shown);
+}
+
+GST_START_TEST (test_parse_superframe)
+{
+  GstHarness *h;
+  GstBuffer *out;
+  guint8 *data;
+  gsize key_frame_size, size;
+
+  data = create_superframe (&key_frame_size, &size);
+
+  h = gst_harness_new ("vp9parse");
+  gst_harness_set_caps_str (h, "video/x-vp9",
+      "video/x-vp9, alignment=(string)super-frame");
+
+  fail_unless_equals_int (gst_harness_push (h,
+          gst_buffer_new_wrapped (g_memdup (data, size), size)), GST_FLOW_OK);
+
+  /* the superframe is output as is, and is shown */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  out = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (out), size);
+  fail_unless (gst_buffer_memcmp (out, 0, data, size) == 0);
+  check_flags (out, TRUE, TRUE);
+  gst_buffer_unref (out);
+
+  gst_harness_teardown (h);
+  g_free (data);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_split_superframe)
+{
+  GstHarness *h;
+  GstBuffer *in, *out;
+  GstMapInfo in_map, map;
+  guint8 *data;
+  gsize key_frame_size, size;
+
+  data = create_superframe (&key_frame_size, &size);
+  in = gst_buffer_new_wrapped (g_memdup (data, size), size);
+  GST_BUFFER_PTS (in) = GST_SECOND;
+
+  h = gst_harness_new ("vp9parse");
+  gst_harness_set_caps_str (h, "video/x-vp9",
+      "video/x-vp9, alignment=(string)frame");
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+  gst_buffer_map (in, &in_map, GST_MAP_READ);
+
+  /* the hidden key frame, referencing the superframe memory */
+  out = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (out), key_frame_size);
+  fail_unless (gst_buffer_memcmp (out, 0, data, key_frame_size) == 0);
+  check_flags (out, TRUE, FALSE);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (out), GST_SECOND);
+  gst_buffer_map (out, &map, GST_MAP_READ);
+  fail_unless (map.data == in_map.data);
+  gst_buffer_unmap (out, &map);
+  gst_buffer_unref (out);
+
+  /* the frame showing it, without the superframe index */
+  out = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (out), 1);
+  fail_unless (gst_buffer_memcmp (out, 0, data + key_frame_size, 1) == 0);
+  check_flags (out, FALSE, TRUE);
+  gst_buffer_map (out, &map, GST_MAP_READ);
+  fail_unless (map.data == in_map.data + key_frame_size);
+  gst_buffer_unmap (out, &map);
+  gst_buffer_unref (out);
+
+  gst_buffer_unmap (in, &in_map);
+  gst_buffer_unref (in);
+  gst_harness_teardown (h);
+  g_free (data);
+}
+
+GST_END_TEST;
+
+static void
+check_caps (GstHarness * h, const gchar * str)
+{
+  GstCaps *caps, *expected;
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps != NULL);
+  expected = gst_caps_from_string (str);
+  fail_unless (gst_caps_is_equal (caps, expected),
+      "Unexpected caps %" GST_PTR_FORMAT, caps);
+  gst_caps_unref (expected);
+  gst_caps_unref (caps);
+}
+
+GST_START_TEST (test_parse_caps)
+{
+  GstHarness *h;
+  GstBuffer *out;
+  guint8 *data;
+  gsize size;
+
+  h = gst_harness_new ("vp9parse");
+  gst_harness_set_caps_str (h, "video/x-vp9, framerate=(fraction)30/1",
+      "video/x-vp9");
+
+  /* a single frame is output as is with either alignment */
+  data = create_key_frame (176, 144, TRUE, &size);
+  fail_unless_equals_int (gst_harness_push (h,
+          gst_buffer_new_wrapped (data, size)), GST_FLOW_OK);
+  out = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (out), size);
+  check_flags (out, TRUE, TRUE);
+  gst_buffer_unref (out);
+
+  check_caps (h, "video/x-vp9, framerate=(fraction)30/1, "
+      "parsed=(boolean)true, alignment=(string)super-frame, "
+      "width=(int)176, height=(int)144, profile=(string)0");
+
+  /* key frames update the resolution */
+  data = create_key_frame (128, 96, TRUE, &size);
+  fail_unless_equals_int (gst_harness_push (h,
+          gst_buffer_new_wrapped (data, size)), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  check_caps (h, "video/x-vp9, framerate=(fraction)30/1, "
+      "parsed=(boolean)true, alignment=(string)super-frame, "
+      "width=(int)128, height=(int)96, profile=(string)0");
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+vp9parse_suite (void)
+{
+  Suite *s = suite_create ("vp9parse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_parse_superframe);
+  tcase_add_test (tc_chain, test_parse_split_superframe);
+  tcase_add_test (tc_chain, test_parse_caps);
+
+  return s;
+}
+
+GST_CHECK_MAIN (vp9parse);
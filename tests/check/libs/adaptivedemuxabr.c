@@ -0,0 +1,331 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
+
+/* The simulator downloads fragments of a stream with the representations
+ * of the ladder over a link following a throughput trace, and plays them
+ * back as a player with a bounded buffer would. Time is simulated, so the
+ * results only depend on the algorithm and the trace. */
+
+#define FRAGMENT_DURATION 2.0
+#define REQUEST_LATENCY 0.05
+#define MAX_BUFFER 30.0
+#define STARTUP_BUFFER 4.0
+
+static const guint64 ladder[] = { 350000, 700000, 1400000, 2800000, 5000000 };
+
+/* throughput of a cellular link in kbps, one value per second */
+static const guint mobile_trace[] = {
+  2750, 3300, 2350, 2200, 3150, 3450, 1900, 2600, 1450, 800,
+  850, 850, 950, 1100, 1350, 2000, 1800, 1700, 1450, 1050,
+  800, 850, 900, 1400, 1350, 1000, 600, 800, 1350, 1500,
+  1900, 1500, 1100, 900, 550, 600, 300, 300, 100, 300,
+  350, 400, 450, 550, 750, 950, 1250, 650, 400, 750,
+  800, 1050, 200, 300, 300, 400, 300, 300, 500, 350,
+  300, 350, 400, 450, 100, 300, 100, 300, 300, 300,
+  300, 350, 300, 350, 300, 400, 900, 1000, 900, 900,
+  1300, 850, 1150, 1950, 1750, 2150, 3150, 1900, 2000, 750,
+  1000, 1050, 1550, 1400, 1900, 1750, 1900, 2350, 2900, 2100,
+  3250, 4200, 4200, 2800, 2050, 3550, 1800, 2900, 3350, 3900,
+  5800, 9000, 6950, 2250, 3700, 3400, 1750, 2350, 2350, 3150,
+  3050, 4400, 3500, 4750, 2400, 3500, 3250, 3200, 6000, 6100,
+  5700, 3650, 2050, 1650, 1700, 2200, 1300, 1050, 750, 550,
+  400, 450, 350, 300, 300, 300, 400, 500, 800, 1050,
+  1400, 2250, 4400, 2350, 1700, 2200, 2650, 3650, 4050, 1350,
+  250, 300, 300, 300, 350, 300, 550, 650, 300, 450,
+  750, 1350, 1500, 1600, 3400, 4900, 8850, 9000, 6650, 7250,
+  7100, 8550, 9000, 9000, 8050, 9000, 7250, 1800, 1800, 1900,
+  2250, 3200, 3750, 2700, 1950, 2500, 1750, 3050, 2300, 2800,
+  4700, 6000, 9000, 9000, 8550, 9000, 9000, 9000, 9000, 8350,
+  1850, 2500, 1650, 1800, 2350, 2350, 2550, 2600, 1800, 1450,
+  1250, 600, 750, 750, 1400, 1650, 1550, 800, 400, 400,
+  300, 300, 300, 350, 550, 850, 600, 100, 300, 300
+};
+
+typedef struct
+{
+  guint switches;
+  guint stalls;
+  gdouble stall_time;
+  guint64 average_bitrate;
+  guint last;
+} SimResult;
+
+/* seconds needed to download @bits starting at @start, the trace is
+ * replayed in a loop */
+static gdouble
+trace_download_time (const guint * trace, guint trace_len, gdouble start,
+    gdouble bits)
+{
+  gdouble t = start;
+
+  while (bits > 0) {
+    guint sec = (guint) t;
+    gdouble rate = trace[sec % trace_len] * 1000.0;
+    gdouble left = (sec + 1) - t;
+
+    if (rate * left >= bits)
+      return t + bits / rate - start;
+
+    bits -= rate * left;
+    t = sec + 1;
+  }
+
+  return t - start;
+}
+
+static void
+simulate (const GstAdaptiveDemuxAbrAlgorithm * algorithm,
+    const guint * trace, guint trace_len, guint n_fragments,
+    SimResult * result)
+{
+  gpointer state = algorithm->create ();
+  gdouble t = 0.0, buffer = 0.0;
+  gboolean playing = FALSE;
+  guint64 total = 0;
+  guint current = 0;
+  guint i;
+
+  memset (result, 0, sizeof (SimResult));
+
+  for (i = 0; i < n_fragments; i++) {
+    GstAdaptiveDemuxAbrFragment fragment;
+    GstAdaptiveDemuxAbrContext context;
+    gdouble bits, download_time;
+    guint next;
+
+    /* wait for room in the buffer */
+    if (buffer + FRAGMENT_DURATION > MAX_BUFFER) {
+      gdouble wait = buffer + FRAGMENT_DURATION - MAX_BUFFER;
+
+      t += wait;
+      buffer -= wait;
+    }
+
+    bits = ladder[current] * FRAGMENT_DURATION;
+    download_time = REQUEST_LATENCY +
+        trace_download_time (trace, trace_len, t + REQUEST_LATENCY, bits);
+
+    if (playing) {
+      if (download_time > buffer) {
+        result->stalls++;
+        result->stall_time += download_time - buffer;
+        buffer = 0.0;
+        playing = FALSE;
+      } else {
+        buffer -= download_time;
+      }
+    }
+
+    t += download_time;
+    buffer += FRAGMENT_DURATION;
+    total += ladder[current];
+    if (!playing && buffer >= STARTUP_BUFFER)
+      playing = TRUE;
+
+    fragment.size = bits / 8;
+    fragment.duration = FRAGMENT_DURATION * GST_SECOND;
+    fragment.download_time = download_time * GST_SECOND;
+    fragment.latency = REQUEST_LATENCY * GST_SECOND;
+    algorithm->fragment_downloaded (state, &fragment);
+
+    context.bitrates = ladder;
+    context.n_bitrates = G_N_ELEMENTS (ladder);
+    context.current = current;
+    context.buffer_level =
+        playing ? (GstClockTime) (buffer * GST_SECOND) : GST_CLOCK_TIME_NONE;
+    context.fragment_duration = FRAGMENT_DURATION * GST_SECOND;
+    next = algorithm->select_representation (state, &context);
+    fail_unless (next < G_N_ELEMENTS (ladder));
+
+    if (i < n_fragments - 1 && next != current)
+      result->switches++;
+    current = next;
+  }
+
+  result->average_bitrate = total / n_fragments;
+  result->last = current;
+
+  algorithm->free (state);
+
+  GST_INFO ("%s: %u switches, %u stalls (%.2fs), average bitrate %"
+      G_GUINT64_FORMAT, algorithm->name, result->switches, result->stalls,
+      result->stall_time, result->average_bitrate);
+}
+
+/* The default selection of adaptivedemux: the highest bitrate below the
+ * minimum of the last fragment's download rate and the average of the last
+ * 3 fragments, scaled by the default bitrate-limit */
+typedef struct
+{
+  guint64 rates[3];
+  guint n_rates;
+  guint64 last_rate;
+} ThroughputState;
+
+static gpointer
+throughput_create (void)
+{
+  return g_new0 (ThroughputState, 1);
+}
+
+static void
+throughput_free (gpointer state)
+{
+  g_free (state);
+}
+
+static void
+throughput_fragment_downloaded (gpointer state,
+    const GstAdaptiveDemuxAbrFragment * fragment)
+{
+  ThroughputState *throughput = state;
+
+  throughput->last_rate = gst_util_uint64_scale (fragment->size,
+      8 * GST_SECOND, fragment->download_time);
+  throughput->rates[throughput->n_rates % 3] = throughput->last_rate;
+  throughput->n_rates++;
+}
+
+static guint
+throughput_select_representation (gpointer state,
+    const GstAdaptiveDemuxAbrContext * context)
+{
+  ThroughputState *throughput = state;
+  guint64 average;
+  gdouble rate;
+  guint i, n = MIN (throughput->n_rates, 3);
+
+  if (n == 0)
+    return context->current;
+
+  average = (throughput->rates[0] + throughput->rates[1] +
+      throughput->rates[2]) / n;
+  rate = MIN (average, throughput->last_rate) * 0.8;
+
+  for (i = context->n_bitrates - 1; i > 0; i--) {
+    if (context->bitrates[i] <= rate)
+      break;
+  }
+
+  return i;
+}
+
+static const GstAdaptiveDemuxAbrAlgorithm throughput_algorithm = {
+  "test-throughput",
+  throughput_create,
+  throughput_free,
+  throughput_fragment_downloaded,
+  throughput_select_representation,
+};
+
+GST_START_TEST (test_abr_registry)
+{
+  const GstAdaptiveDemuxAbrAlgorithm *bola;
+
+  bola = gst_adaptive_demux_abr_find (GST_ADAPTIVE_DEMUX_ABR_BOLA);
+  fail_unless (bola != NULL);
+  fail_unless_equals_string (bola->name, "bola");
+
+  fail_unless (gst_adaptive_demux_abr_find ("test-throughput") == NULL);
+  gst_adaptive_demux_abr_register (&throughput_algorithm);
+  fail_unless (gst_adaptive_demux_abr_find ("test-throughput") ==
+      &throughput_algorithm);
+  fail_unless (gst_adaptive_demux_abr_find (GST_ADAPTIVE_DEMUX_ABR_BOLA) ==
+      bola);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_abr_bola_constant_rate)
+{
+  static const guint trace[] = { 4000 };
+  SimResult result;
+
+  simulate (gst_adaptive_demux_abr_find (GST_ADAPTIVE_DEMUX_ABR_BOLA),
+      trace, G_N_ELEMENTS (trace), 40, &result);
+
+  /* goes up one representation at a time to the highest one below 4 Mbps
+   * and stays there */
+  assert_equals_int (result.last, 3);
+  assert_equals_int (result.switches, 3);
+  assert_equals_int (result.stalls, 0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_abr_bola_rate_drop)
+{
+  guint trace[480];
+  SimResult result;
+  guint i;
+
+  /* 4 Mbps for 80 seconds, then 500 kbps */
+  for (i = 0; i < G_N_ELEMENTS (trace); i++)
+    trace[i] = i < 80 ? 4000 : 500;
+
+  simulate (gst_adaptive_demux_abr_find (GST_ADAPTIVE_DEMUX_ABR_BOLA),
+      trace, G_N_ELEMENTS (trace), 100, &result);
+
+  /* the buffer absorbs the drop until the lowest representation is used */
+  assert_equals_int (result.last, 0);
+  assert_equals_int (result.stalls, 0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_abr_bola_mobile_trace)
+{
+  SimResult bola, throughput;
+
+  simulate (&throughput_algorithm, mobile_trace,
+      G_N_ELEMENTS (mobile_trace), 100, &throughput);
+  simulate (gst_adaptive_demux_abr_find (GST_ADAPTIVE_DEMUX_ABR_BOLA),
+      mobile_trace, G_N_ELEMENTS (mobile_trace), 100, &bola);
+
+  /* the throughput heuristic follows every change of the link, the buffer
+   * lets BOLA keep its representation through them without stalling */
+  fail_unless (bola.switches * 2 < throughput.switches,
+      "%u switches with BOLA, %u with the throughput heuristic",
+      bola.switches, throughput.switches);
+  fail_unless (bola.stalls <= throughput.stalls);
+  fail_unless (bola.average_bitrate >= throughput.average_bitrate);
+}
+
+GST_END_TEST;
+
+static Suite *
+adaptivedemuxabr_suite (void)
+{
+  Suite *s = suite_create ("adaptivedemux ABR algorithms");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_abr_registry);
+  tcase_add_test (tc_chain, test_abr_bola_constant_rate);
+  tcase_add_test (tc_chain, test_abr_bola_rate_drop);
+  tcase_add_test (tc_chain, test_abr_bola_mobile_trace);
+
+  return s;
+}
+
+GST_CHECK_MAIN (adaptivedemuxabr);
@@ -0,0 +1,224 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstav1parser.h>
+
+/* A temporal delimiter, a main profile 640x480 sequence header with order
+ * hints of 7 bits, and the frame header of a shown key frame, in the low
+ * overhead format */
+static const guint8 obu_stream[] = {
+  0x12, 0x00,
+  0x0a, 0x0b, 0x00, 0x00, 0x00, 0x42, 0x62, 0x7f, 0xef, 0x98, 0x4f, 0x30,
+  0x08,
+  0x1a, 0x02, 0x10, 0x01,
+};
+
+/* The same OBUs, without obu_size fields, in a single frame unit of an
+ * Annex B temporal unit */
+static const guint8 annexb[] = {
+  0x14, 0x13,
+  0x01, 0x10,
+  0x0c, 0x08, 0x00, 0x00, 0x00, 0x42, 0x62, 0x7f, 0xef, 0x98, 0x4f, 0x30,
+  0x08,
+  0x03, 0x18, 0x10, 0x01,
+};
+
+GST_START_TEST (test_av1_parse_leb128)
+{
+  static const guint8 one_byte[] = { 0x05 };
+  static const guint8 two_bytes[] = { 0x80, 0x01 };
+  static const guint8 too_long[] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01
+  };
+  guint32 value, consumed;
+
+  assert_equals_int (gst_av1_parse_leb128 (one_byte, sizeof (one_byte),
+          &value, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (value, 5);
+  assert_equals_int (consumed, 1);
+
+  assert_equals_int (gst_av1_parse_leb128 (two_bytes, sizeof (two_bytes),
+          &value, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (value, 128);
+  assert_equals_int (consumed, 2);
+
+  assert_equals_int (gst_av1_parse_leb128 (two_bytes, 1, &value, &consumed),
+      GST_AV1_PARSER_NO_MORE_DATA);
+  assert_equals_int (gst_av1_parse_leb128 (too_long, sizeof (too_long),
+          &value, &consumed), GST_AV1_PARSER_BITSTREAM_ERROR);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_av1_identify_obu)
+{
+  GstAV1Parser *parser = gst_av1_parser_new ();
+  GstAV1OBU obu;
+  guint32 offset = 0, consumed;
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, obu_stream,
+          sizeof (obu_stream), &obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_TEMPORAL_DELIMITER);
+  assert_equals_int (obu.obu_size, 0);
+  assert_equals_int (consumed, 2);
+  offset += consumed;
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser,
+          obu_stream + offset, sizeof (obu_stream) - offset, &obu,
+          &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_SEQUENCE_HEADER);
+  assert_equals_int (obu.header_size, 2);
+  assert_equals_int (obu.obu_size, 11);
+  fail_unless (obu.data == obu_stream + offset + 2);
+  offset += consumed;
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser,
+          obu_stream + offset, sizeof (obu_stream) - offset, &obu,
+          &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_FRAME_HEADER);
+  assert_equals_int (obu.obu_size, 2);
+  offset += consumed;
+  assert_equals_int (offset, sizeof (obu_stream));
+
+  /* incomplete OBU */
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, obu_stream + 2,
+          6, &obu, &consumed), GST_AV1_PARSER_NO_MORE_DATA);
+
+  /* without obu_size field, the OBU spans the rest of the data */
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, annexb + 18,
+          3, &obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (obu.obu_type, GST_AV1_OBU_FRAME_HEADER);
+  assert_equals_int (obu.header_size, 1);
+  assert_equals_int (obu.obu_size, 2);
+  assert_equals_int (consumed, 3);
+
+  gst_av1_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_av1_identify_obu_annexb)
+{
+  GstAV1Parser *parser = gst_av1_parser_new ();
+  static const GstAV1OBUType types[] = {
+    GST_AV1_OBU_TEMPORAL_DELIMITER, GST_AV1_OBU_SEQUENCE_HEADER,
+    GST_AV1_OBU_FRAME_HEADER
+  };
+  GstAV1OBU obu;
+  guint32 unit_size, offset, consumed;
+  guint i;
+
+  assert_equals_int (gst_av1_parse_leb128 (annexb, sizeof (annexb),
+          &unit_size, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (consumed + unit_size, sizeof (annexb));
+  offset = consumed;
+
+  assert_equals_int (gst_av1_parse_leb128 (annexb + offset,
+          sizeof (annexb) - offset, &unit_size, &consumed), GST_AV1_PARSER_OK);
+  offset += consumed;
+  assert_equals_int (offset + unit_size, sizeof (annexb));
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++) {
+    assert_equals_int (gst_av1_parser_identify_one_obu_annexb (parser,
+            annexb + offset, sizeof (annexb) - offset, &obu, &consumed),
+        GST_AV1_PARSER_OK);
+    assert_equals_int (obu.obu_type, types[i]);
+    assert_equals_int (obu.offset, 1);
+    fail_unless (obu.data == annexb + offset + 2);
+    offset += consumed;
+  }
+  assert_equals_int (offset, sizeof (annexb));
+
+  gst_av1_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_av1_parse_headers)
+{
+  GstAV1Parser *parser = gst_av1_parser_new ();
+  GstAV1SequenceHeaderOBU seq_header;
+  GstAV1FrameHeaderOBU frame_header;
+  GstAV1OBU seq_obu, frame_obu;
+  guint32 consumed;
+
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser, obu_stream + 2,
+          sizeof (obu_stream) - 2, &seq_obu, &consumed), GST_AV1_PARSER_OK);
+  assert_equals_int (gst_av1_parser_identify_one_obu (parser,
+          obu_stream + 2 + consumed, sizeof (obu_stream) - 2 - consumed,
+          &frame_obu, &consumed), GST_AV1_PARSER_OK);
+
+  /* frame headers need the sequence header */
+  assert_equals_int (gst_av1_parser_parse_frame_header_obu (parser,
+          &frame_obu, &frame_header), GST_AV1_PARSER_MISSING_OBU_REFERENCE);
+
+  assert_equals_int (gst_av1_parser_parse_sequence_header_obu (parser,
+          &seq_obu, &seq_header), GST_AV1_PARSER_OK);
+  assert_equals_int (seq_header.seq_profile, GST_AV1_PROFILE_0);
+  assert_equals_int (seq_header.operating_points_cnt_minus_1, 0);
+  assert_equals_int (seq_header.operating_points[0].seq_level_idx, 8);
+  assert_equals_int (seq_header.max_frame_width_minus_1, 639);
+  assert_equals_int (seq_header.max_frame_height_minus_1, 479);
+  assert_equals_int (seq_header.enable_order_hint, TRUE);
+  assert_equals_int (seq_header.order_hint_bits, 7);
+  assert_equals_int (seq_header.seq_force_screen_content_tools,
+      GST_AV1_SELECT_SCREEN_CONTENT_TOOLS);
+  assert_equals_int (seq_header.enable_cdef, TRUE);
+  assert_equals_int (seq_header.color_config.bit_depth, 8);
+  assert_equals_int (seq_header.color_config.subsampling_x, 1);
+  assert_equals_int (seq_header.color_config.subsampling_y, 1);
+  assert_equals_int (seq_header.film_grain_params_present, FALSE);
+
+  assert_equals_int (gst_av1_parser_parse_frame_header_obu (parser,
+          &frame_obu, &frame_header), GST_AV1_PARSER_OK);
+  assert_equals_int (frame_header.show_existing_frame, FALSE);
+  assert_equals_int (frame_header.frame_type, GST_AV1_KEY_FRAME);
+  assert_equals_int (frame_header.show_frame, TRUE);
+  assert_equals_int (frame_header.error_resilient_mode, TRUE);
+  assert_equals_int (frame_header.refresh_frame_flags, 0xff);
+  assert_equals_int (frame_header.primary_ref_frame,
+      GST_AV1_PRIMARY_REF_NONE);
+  assert_equals_int (frame_header.frame_width, 640);
+  assert_equals_int (frame_header.frame_height, 480);
+  assert_equals_int (frame_header.render_width, 640);
+  assert_equals_int (frame_header.render_height, 480);
+
+  gst_av1_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static Suite *
+av1parsers_suite (void)
+{
+  Suite *s = suite_create ("AV1 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_av1_parse_leb128);
+  tcase_add_test (tc_chain, test_av1_identify_obu);
+  tcase_add_test (tc_chain, test_av1_identify_obu_annexb);
+  tcase_add_test (tc_chain, test_av1_parse_headers);
+
+  return s;
+}
+
+GST_CHECK_MAIN (av1parsers);
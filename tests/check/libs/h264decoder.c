@@ -0,0 +1,549 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/base/gstbitwriter.h>
+#include <gst/codecs/gsth264decoder.h>
+
+#define FRAME_DURATION (40 * GST_MSECOND)
+#define WIDTH_MBS 20
+#define HEIGHT_MBS 15
+
+/* Mock accelerator: pictures are not decoded, the decoder only records in
+ * which order they come out of the DPB */
+typedef struct _GstTestH264Dec
+{
+  GstH264Decoder parent;
+
+  GstH264Picture *current_picture;
+  GstVideoCodecState *output_state;
+} GstTestH264Dec;
+
+typedef struct _GstTestH264DecClass
+{
+  GstH264DecoderClass parent_class;
+} GstTestH264DecClass;
+
+static GType gst_test_h264_dec_get_type (void);
+#define GST_TEST_H264_DEC(obj) ((GstTestH264Dec *) (obj))
+
+G_DEFINE_TYPE (GstTestH264Dec, gst_test_h264_dec, GST_TYPE_H264_DECODER);
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-h264"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-raw"));
+
+static gboolean
+gst_test_h264_dec_stop (GstVideoDecoder * decoder)
+{
+  GstTestH264Dec *self = GST_TEST_H264_DEC (decoder);
+
+  gst_h264_picture_clear (&self->current_picture);
+  g_clear_pointer (&self->output_state, gst_video_codec_state_unref);
+
+  return GST_VIDEO_DECODER_CLASS (gst_test_h264_dec_parent_class)->stop
+      (decoder);
+}
+
+static GstFlowReturn
+gst_test_h264_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstTestH264Dec *self = GST_TEST_H264_DEC (decoder);
+
+  fail_unless (self->current_picture != NULL);
+
+  gst_video_codec_frame_set_user_data (frame, self->current_picture,
+      (GDestroyNotify) gst_h264_picture_unref);
+  self->current_picture = NULL;
+  gst_video_codec_frame_unref (frame);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_test_h264_dec_new_sequence (GstH264Decoder * decoder,
+    const GstH264SPS * sps)
+{
+  GstTestH264Dec *self = GST_TEST_H264_DEC (decoder);
+
+  if (self->output_state)
+    gst_video_codec_state_unref (self->output_state);
+
+  self->output_state =
+      gst_video_decoder_set_output_state (GST_VIDEO_DECODER (self),
+      GST_VIDEO_FORMAT_GRAY8, sps->width, sps->height, decoder->input_state);
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_h264_dec_new_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture)
+{
+  GstTestH264Dec *self = GST_TEST_H264_DEC (decoder);
+
+  gst_h264_picture_replace (&self->current_picture, picture);
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_h264_dec_decode_slice (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_test_h264_dec_output_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture)
+{
+  GstVideoDecoder *vdec = GST_VIDEO_DECODER (decoder);
+  GstVideoCodecFrame *frame = NULL;
+  GList *frames, *iter;
+  GstFlowReturn ret;
+
+  frames = gst_video_decoder_get_frames (vdec);
+  for (iter = frames; iter; iter = g_list_next (iter)) {
+    GstVideoCodecFrame *tmp = (GstVideoCodecFrame *) iter->data;
+
+    if (gst_video_codec_frame_get_user_data (tmp) == picture) {
+      frame = gst_video_codec_frame_ref (tmp);
+      break;
+    }
+  }
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
+
+  fail_unless (frame != NULL);
+
+  ret = gst_video_decoder_allocate_output_frame (vdec, frame);
+  if (ret != GST_FLOW_OK) {
+    gst_video_decoder_drop_frame (vdec, frame);
+    return ret;
+  }
+
+  return gst_video_decoder_finish_frame (vdec, frame);
+}
+
+static void
+gst_test_h264_dec_class_init (GstTestH264DecClass * klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "Test H.264 decoder", "Codec/Decoder/Video",
+      "Mock GstH264Decoder subclass", "GStreamer developers");
+
+  decoder_class->stop = GST_DEBUG_FUNCPTR (gst_test_h264_dec_stop);
+  decoder_class->handle_frame =
+      GST_DEBUG_FUNCPTR (gst_test_h264_dec_handle_frame);
+
+  h264decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_test_h264_dec_new_sequence);
+  h264decoder_class->new_picture =
+      GST_DEBUG_FUNCPTR (gst_test_h264_dec_new_picture);
+  h264decoder_class->decode_slice =
+      GST_DEBUG_FUNCPTR (gst_test_h264_dec_decode_slice);
+  h264decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_test_h264_dec_output_picture);
+}
+
+static void
+gst_test_h264_dec_init (GstTestH264Dec * self)
+{
+}
+
+/* Bitstream generation: just enough of SPS, PPS and slice headers for the
+ * decoder to do its reference and output bookkeeping */
+typedef struct
+{
+  guint8 profile_idc;
+  guint8 poc_type;
+  gboolean b_frames;
+  /* signalled in the VUI if not negative */
+  gint num_reorder_frames;
+} TestStream;
+
+typedef struct
+{
+  GstH264SliceType type;
+  gboolean ref;
+  gint frame_num;
+  gint poc;
+} TestPicture;
+
+static const TestStream main_stream = { 77, 0, TRUE, -1 };
+static const TestStream main_vui_stream = { 77, 0, TRUE, 1 };
+static const TestStream baseline_stream = { 66, 0, FALSE, -1 };
+static const TestStream poc_type_2_stream = { 77, 2, FALSE, -1 };
+
+static void
+put_ue (GstBitWriter * bw, guint32 val)
+{
+  guint len = g_bit_storage (val + 1);
+
+  if (len > 1)
+    gst_bit_writer_put_bits_uint32 (bw, 0, len - 1);
+  gst_bit_writer_put_bits_uint32 (bw, val + 1, len);
+}
+
+static void
+put_se (GstBitWriter * bw, gint32 val)
+{
+  put_ue (bw, val > 0 ? 2 * val - 1 : -2 * val);
+}
+
+/* terminates the RBSP in @bw and appends it as a byte-stream NAL */
+static void
+append_nal (GByteArray * au, guint8 header, GstBitWriter * bw)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+  const guint8 *data;
+  guint i, size, zeros = 0;
+
+  gst_bit_writer_put_bits_uint32 (bw, 1, 1);
+  gst_bit_writer_align_bytes (bw, 0);
+  data = gst_bit_writer_get_data (bw);
+  size = gst_bit_writer_get_size (bw) / 8;
+
+  g_byte_array_append (au, start_code, sizeof (start_code));
+  g_byte_array_append (au, &header, 1);
+  for (i = 0; i < size; i++) {
+    if (zeros >= 2 && data[i] <= 0x03) {
+      static const guint8 epb = 0x03;
+
+      g_byte_array_append (au, &epb, 1);
+      zeros = 0;
+    }
+    g_byte_array_append (au, &data[i], 1);
+    zeros = data[i] == 0x00 ? zeros + 1 : 0;
+  }
+
+  gst_bit_writer_reset (bw);
+}
+
+/* level 3, 320x240 */
+static void
+append_sps (GByteArray * au, const TestStream * stream)
+{
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, stream->profile_idc, 8);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 8);   /* constraint flags */
+  gst_bit_writer_put_bits_uint32 (&bw, 30, 8);  /* level_idc */
+  put_ue (&bw, 0);              /* seq_parameter_set_id */
+  put_ue (&bw, 0);              /* log2_max_frame_num_minus4 */
+  put_ue (&bw, stream->poc_type);
+  if (stream->poc_type == 0)
+    put_ue (&bw, 2);            /* log2_max_pic_order_cnt_lsb_minus4 */
+  put_ue (&bw, 2);              /* num_ref_frames */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* gaps_in_frame_num */
+  put_ue (&bw, WIDTH_MBS - 1);
+  put_ue (&bw, HEIGHT_MBS - 1);
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* frame_mbs_only_flag */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* direct_8x8_inference */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* frame_cropping_flag */
+  gst_bit_writer_put_bits_uint32 (&bw, stream->num_reorder_frames >= 0, 1);
+  if (stream->num_reorder_frames >= 0) {
+    /* no aspect ratio, overscan, signal type, chroma location, timing,
+     * hrd nor pic_struct info */
+    gst_bit_writer_put_bits_uint32 (&bw, 0, 9);
+    gst_bit_writer_put_bits_uint32 (&bw, 1, 1); /* bitstream_restriction */
+    gst_bit_writer_put_bits_uint32 (&bw, 1, 1); /* mvs over pic boundaries */
+    put_ue (&bw, 0);            /* max_bytes_per_pic_denom */
+    put_ue (&bw, 0);            /* max_bits_per_mb_denom */
+    put_ue (&bw, 16);           /* log2_max_mv_length_horizontal */
+    put_ue (&bw, 16);           /* log2_max_mv_length_vertical */
+    put_ue (&bw, stream->num_reorder_frames);
+    put_ue (&bw, 2);            /* max_dec_frame_buffering */
+  }
+  append_nal (au, 0x67, &bw);
+}
+
+static void
+append_pps (GByteArray * au)
+{
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  put_ue (&bw, 0);              /* pic_parameter_set_id */
+  put_ue (&bw, 0);              /* seq_parameter_set_id */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* entropy_coding_mode */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* bottom_field_pic_order */
+  put_ue (&bw, 0);              /* num_slice_groups_minus1 */
+  put_ue (&bw, 0);              /* num_ref_idx_l0_default_active_minus1 */
+  put_ue (&bw, 0);              /* num_ref_idx_l1_default_active_minus1 */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 3);   /* weighted pred/bipred */
+  put_se (&bw, 0);              /* pic_init_qp_minus26 */
+  put_se (&bw, 0);              /* pic_init_qs_minus26 */
+  put_se (&bw, 0);              /* chroma_qp_index_offset */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* deblocking_filter_ctrl */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 2);   /* constrained intra, rpc */
+  append_nal (au, 0x68, &bw);
+}
+
+static void
+append_slice (GByteArray * au, const TestStream * stream,
+    const TestPicture * pic)
+{
+  gboolean idr = pic->type == GST_H264_I_SLICE;
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  put_ue (&bw, 0);              /* first_mb_in_slice */
+  put_ue (&bw, pic->type + 5);
+  put_ue (&bw, 0);              /* pic_parameter_set_id */
+  gst_bit_writer_put_bits_uint32 (&bw, pic->frame_num % 16, 4);
+  if (idr)
+    put_ue (&bw, 0);            /* idr_pic_id */
+  if (stream->poc_type == 0)
+    gst_bit_writer_put_bits_uint32 (&bw, pic->poc % 64, 6);
+  if (pic->type == GST_H264_B_SLICE)
+    gst_bit_writer_put_bits_uint32 (&bw, 1, 1); /* direct_spatial_mv_pred */
+  if (pic->type != GST_H264_I_SLICE) {
+    gst_bit_writer_put_bits_uint32 (&bw, 0, 1); /* num_ref_idx_override */
+    gst_bit_writer_put_bits_uint32 (&bw, 0, 1); /* ref_pic_list_mod_l0 */
+  }
+  if (pic->type == GST_H264_B_SLICE)
+    gst_bit_writer_put_bits_uint32 (&bw, 0, 1); /* ref_pic_list_mod_l1 */
+  if (pic->ref) {
+    if (idr)
+      gst_bit_writer_put_bits_uint32 (&bw, 0, 2);       /* no_output, long_term */
+    else
+      gst_bit_writer_put_bits_uint32 (&bw, 0, 1);       /* adaptive marking */
+  }
+  put_se (&bw, 0);              /* slice_qp_delta */
+  put_ue (&bw, 1);              /* disable_deblocking_filter_idc */
+  /* stand-in for the slice data */
+  gst_bit_writer_put_bits_uint32 (&bw, 0xa5a5a5a5, 32);
+  append_nal (au, (idr ? 0x05 : 0x01) | (pic->ref ? 0x60 : 0x00), &bw);
+}
+
+/* IDR followed by P B B mini-GOPs or by P pictures only, in decoding order */
+static GArray *
+create_pictures (const TestStream * stream, guint n_pictures)
+{
+  GArray *pictures = g_array_new (FALSE, TRUE, sizeof (TestPicture));
+  TestPicture pic = { GST_H264_I_SLICE, TRUE, 0, 0 };
+  gint frame_num = 0;
+  guint i;
+
+  g_array_append_val (pictures, pic);
+  for (i = 1; i < n_pictures; i++) {
+    guint display = ((i - 1) / 3) * 3;
+
+    if (!stream->b_frames) {
+      pic.type = GST_H264_P_SLICE;
+      pic.frame_num = ++frame_num;
+      pic.poc = 2 * i;
+    } else if ((i - 1) % 3 == 0) {
+      pic.type = GST_H264_P_SLICE;
+      pic.ref = TRUE;
+      pic.frame_num = ++frame_num;
+      pic.poc = 2 * (display + 3);
+    } else {
+      pic.type = GST_H264_B_SLICE;
+      pic.ref = FALSE;
+      pic.frame_num = frame_num + 1;
+      pic.poc = 2 * (display + (i - 1) % 3);
+    }
+    g_array_append_val (pictures, pic);
+  }
+
+  return pictures;
+}
+
+static GstBuffer *
+create_au (const TestStream * stream, const TestPicture * pic)
+{
+  GByteArray *au = g_byte_array_new ();
+  GstBuffer *buf;
+
+  if (pic->type == GST_H264_I_SLICE) {
+    append_sps (au, stream);
+    append_pps (au);
+  }
+  append_slice (au, stream, pic);
+
+  buf = gst_buffer_new_wrapped (au->data, au->len);
+  g_byte_array_free (au, FALSE);
+
+  GST_BUFFER_PTS (buf) = pic->poc / 2 * FRAME_DURATION;
+
+  return buf;
+}
+
+static GstHarness *
+create_harness (gboolean low_latency)
+{
+  GstHarness *h;
+
+  gst_element_register (NULL, "testh264dec", GST_RANK_NONE,
+      gst_test_h264_dec_get_type ());
+
+  h = gst_harness_new ("testh264dec");
+  g_object_set (h->element, "low-latency", low_latency, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264, stream-format=byte-stream, alignment=au, "
+      "framerate=25/1");
+
+  return h;
+}
+
+/* decodes @n_pictures and checks that all of them are output in display
+ * order, returns the largest number of pictures held back by the DPB and
+ * in @end_delay the number held back after the last one was decoded */
+static guint
+run_decoder (const TestStream * stream, gboolean low_latency,
+    guint n_pictures, GstClockTime * latency, guint * end_delay)
+{
+  GArray *pictures = create_pictures (stream, n_pictures);
+  GstHarness *h = create_harness (low_latency);
+  GstBuffer *out;
+  guint i, n_out = 0, max_delay = 0;
+
+  for (i = 0; i < pictures->len; i++) {
+    TestPicture *pic = &g_array_index (pictures, TestPicture, i);
+
+    fail_unless_equals_int (gst_harness_push (h, create_au (stream, pic)),
+        GST_FLOW_OK);
+
+    while ((out = gst_harness_try_pull (h))) {
+      fail_unless_equals_uint64 (GST_BUFFER_PTS (out),
+          n_out * FRAME_DURATION);
+      gst_buffer_unref (out);
+      n_out++;
+    }
+    max_delay = MAX (max_delay, i + 1 - n_out);
+  }
+
+  if (latency)
+    *latency = gst_harness_query_latency (h);
+  if (end_delay)
+    *end_delay = n_pictures - n_out;
+
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  while ((out = gst_harness_try_pull (h))) {
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (out), n_out * FRAME_DURATION);
+    gst_buffer_unref (out);
+    n_out++;
+  }
+  fail_unless_equals_int (n_out, n_pictures);
+
+  gst_harness_teardown (h);
+  g_array_unref (pictures);
+
+  return max_delay;
+}
+
+GST_START_TEST (test_h264_decoder_output_order)
+{
+  /* reordering inferred from the level limits: only the DPB size bounds the
+   * delay */
+  run_decoder (&main_stream, FALSE, 31, NULL, NULL);
+  /* signalled reordering, the B pictures need a single picture delay */
+  fail_unless_equals_int (run_decoder (&main_vui_stream, FALSE, 31, NULL,
+          NULL), 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h264_decoder_low_latency)
+{
+  GstClockTime latency;
+  guint end_delay;
+
+  /* output order is decoding order with POC type 2, in any mode */
+  fail_unless_equals_int (run_decoder (&poc_type_2_stream, FALSE, 31,
+          &latency, NULL), 0);
+  fail_unless_equals_uint64 (latency, 0);
+
+  /* baseline profile without VUI: the whole DPB is used for reordering */
+  fail_unless (run_decoder (&baseline_stream, FALSE, 31, &latency,
+          &end_delay) > 1);
+  fail_unless (end_delay > 1);
+  fail_unless (latency > FRAME_DURATION);
+
+  /* in low-latency mode, pictures are output as soon as they are decoded
+   * once the POC step is known, but the worst case latency is still
+   * reported since the reorder depth isn't */
+  fail_unless (run_decoder (&baseline_stream, TRUE, 31, &latency,
+          &end_delay) > 1);
+  fail_unless_equals_int (end_delay, 0);
+  fail_unless (latency > FRAME_DURATION);
+
+  /* the reported latency follows the signalled reorder depth */
+  run_decoder (&main_vui_stream, TRUE, 31, &latency, NULL);
+  fail_unless_equals_uint64 (latency, FRAME_DURATION);
+
+  /* B pictures: the P picture is held back until the B pictures preceding
+   * it in display order are decoded */
+  run_decoder (&main_stream, FALSE, 31, NULL, &end_delay);
+  fail_unless (end_delay > 1);
+  run_decoder (&main_stream, TRUE, 31, NULL, &end_delay);
+  fail_unless_equals_int (end_delay, 0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h264_decoder_bumping_latency)
+{
+  guint n_pictures = 1 + 3 * 20;
+
+  /* without VUI, the reorder depth is inferred as the DPB size, which is 16
+   * frames for 320x240 at level 3 */
+  fail_unless_equals_int (run_decoder (&main_stream, FALSE, n_pictures, NULL,
+          NULL), 16);
+
+  /* num_reorder_frames 1 */
+  fail_unless_equals_int (run_decoder (&main_vui_stream, FALSE, n_pictures,
+          NULL, NULL), 1);
+
+  /* P pictures only, low-latency: the POC step is only known once two
+   * pictures got output, which first happens when the DPB is full */
+  fail_unless_equals_int (run_decoder (&baseline_stream, TRUE, n_pictures,
+          NULL, NULL), 16);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264decoder_suite (void)
+{
+  Suite *s = suite_create ("H264 decoder base class");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h264_decoder_output_order);
+  tcase_add_test (tc_chain, test_h264_decoder_low_latency);
+  tcase_add_test (tc_chain, test_h264_decoder_bumping_latency);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h264decoder);
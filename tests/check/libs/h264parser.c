@@ -313,6 +313,167 @@ GST_START_TEST (test_h264_parse_invalid_sei)
 
 GST_END_TEST;
 
+/* PPS and IDR slice matching nalu_sps_with_vui, as produced by x264. The
+ * slice data contains emulation prevention bytes */
+static guint8 nalu_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x68, 0xee, 0x3c, 0x80
+};
+
+static guint8 nalu_idr_slice[] = {
+  0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x82, 0x01,
+  0xff, 0x10, 0xff, 0xfe, 0xf6, 0xf0, 0x00, 0x00,
+  0x03, 0x01, 0x36, 0x56, 0x04, 0x00, 0x00, 0x03,
+  0x00, 0x7b, 0x3f, 0x53, 0xe1, 0x80
+};
+
+GST_START_TEST (test_h264_parse_repeated_parameter_sets)
+{
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  GstH264NalParser *const parser = gst_h264_nal_parser_new ();
+  guint8 *sps_data = g_memdup (nalu_sps_with_vui, sizeof (nalu_sps_with_vui));
+  GstH264SPS *sps, sps_copy;
+  GstH264PPS *pps;
+  guint n_sps_parsed = 0, n_pps_parsed = 0;
+  gboolean changed;
+  guint i;
+
+  /* the same parameter sets, as re-sent with every IDR, are only parsed
+   * once and handed out from the parser without copying them */
+  for (i = 0; i < 3; i++) {
+    res = gst_h264_parser_identify_nalu (parser, sps_data, 0,
+        sizeof (nalu_sps_with_vui), &nalu);
+    assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+    res = gst_h264_parser_update_sps (parser, &nalu, &sps, &changed);
+    assert_equals_int (res, GST_H264_PARSER_OK);
+    fail_unless (sps == &parser->sps[0]);
+    assert_equals_int (sps->level_idc, 40);
+    assert_equals_int (sps->width, 1920);
+    assert_equals_int (sps->height, 1088);
+    n_sps_parsed += changed;
+
+    res = gst_h264_parser_identify_nalu (parser, nalu_pps, 0,
+        sizeof (nalu_pps), &nalu);
+    assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+    res = gst_h264_parser_update_pps (parser, &nalu, &pps, &changed);
+    assert_equals_int (res, GST_H264_PARSER_OK);
+    fail_unless (pps == &parser->pps[0]);
+    fail_unless (pps->sequence == &parser->sps[0]);
+    n_pps_parsed += changed;
+  }
+  assert_equals_int (n_sps_parsed, 1);
+  assert_equals_int (n_pps_parsed, 1);
+
+  /* the copying API still fills a copy of the stored SPS */
+  res = gst_h264_parser_identify_nalu (parser, sps_data, 0,
+      sizeof (nalu_sps_with_vui), &nalu);
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  res = gst_h264_parser_parse_sps (parser, &nalu, &sps_copy);
+  assert_equals_int (res, GST_H264_PARSER_OK);
+  assert_equals_int (sps_copy.level_idc, 40);
+  gst_h264_sps_clear (&sps_copy);
+
+  /* a different SPS with the same id replaces the stored one */
+  sps_data[7] = 31;
+  res = gst_h264_parser_identify_nalu (parser, sps_data, 0,
+      sizeof (nalu_sps_with_vui), &nalu);
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  res = gst_h264_parser_update_sps (parser, &nalu, &sps, &changed);
+  assert_equals_int (res, GST_H264_PARSER_OK);
+  fail_unless (changed);
+  assert_equals_int (sps->level_idc, 31);
+
+  /* and the unchanged PPS referring to it is parsed again, once */
+  res = gst_h264_parser_identify_nalu (parser, nalu_pps, 0,
+      sizeof (nalu_pps), &nalu);
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  res = gst_h264_parser_update_pps (parser, &nalu, &pps, &changed);
+  assert_equals_int (res, GST_H264_PARSER_OK);
+  fail_unless (changed);
+  res = gst_h264_parser_update_pps (parser, &nalu, &pps, &changed);
+  assert_equals_int (res, GST_H264_PARSER_OK);
+  fail_if (changed);
+
+  /* switching back is noticed too */
+  res = gst_h264_parser_identify_nalu (parser, nalu_sps_with_vui, 0,
+      sizeof (nalu_sps_with_vui), &nalu);
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  res = gst_h264_parser_update_sps (parser, &nalu, &sps, &changed);
+  assert_equals_int (res, GST_H264_PARSER_OK);
+  fail_unless (changed);
+  assert_equals_int (sps->level_idc, 40);
+
+  g_free (sps_data);
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
+#define N_HEADER_PARSE_RUNS 100000
+
+GST_START_TEST (test_h264_parse_headers_perf)
+{
+  GstH264ParserResult res;
+  GstH264NalUnit sps_nalu, pps_nalu, slice_nalu;
+  GstH264NalParser *const parser = gst_h264_nal_parser_new ();
+  GstH264SliceHdr slice;
+  gint64 start, sps_time, pps_time, slice_time;
+  guint i;
+
+  res = gst_h264_parser_identify_nalu (parser, nalu_sps_with_vui, 0,
+      sizeof (nalu_sps_with_vui), &sps_nalu);
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  res = gst_h264_parser_identify_nalu (parser, nalu_pps, 0,
+      sizeof (nalu_pps), &pps_nalu);
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  res = gst_h264_parser_identify_nalu (parser, nalu_idr_slice, 0,
+      sizeof (nalu_idr_slice), &slice_nalu);
+  assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+  assert_equals_int (slice_nalu.type, GST_H264_NAL_SLICE_IDR);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_HEADER_PARSE_RUNS; i++) {
+    res = gst_h264_parser_parse_nal (parser, &sps_nalu);
+    fail_unless (res == GST_H264_PARSER_OK);
+  }
+  sps_time = g_get_monotonic_time () - start;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_HEADER_PARSE_RUNS; i++) {
+    res = gst_h264_parser_parse_nal (parser, &pps_nalu);
+    fail_unless (res == GST_H264_PARSER_OK);
+  }
+  pps_time = g_get_monotonic_time () - start;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_HEADER_PARSE_RUNS; i++) {
+    res = gst_h264_parser_parse_slice_hdr (parser, &slice_nalu, &slice,
+        TRUE, TRUE);
+    fail_unless (res == GST_H264_PARSER_OK);
+  }
+  slice_time = g_get_monotonic_time () - start;
+
+  assert_equals_int (slice.type, GST_H264_I_SLICE + 5);
+  assert_equals_int (slice.frame_num, 0);
+  assert_equals_int (slice.field_pic_flag, 0);
+  assert_equals_int (slice.idr_pic_id, 0);
+  assert_equals_int (slice.slice_qp_delta, 0);
+  assert_equals_int (slice.disable_deblocking_filter_idc, 0);
+  assert_equals_int (slice.header_size, 27);
+  assert_equals_int (slice.n_emulation_prevention_bytes, 0);
+  assert_equals_int (slice.pps->sequence->width, 1920);
+  assert_equals_int (slice.pps->sequence->height, 1088);
+
+  GST_INFO ("SPS: %.1f ns, PPS: %.1f ns, slice header: %.1f ns",
+      sps_time * 1000.0 / N_HEADER_PARSE_RUNS,
+      pps_time * 1000.0 / N_HEADER_PARSE_RUNS,
+      slice_time * 1000.0 / N_HEADER_PARSE_RUNS);
+
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 h264parser_suite (void)
 {
@@ -325,6 +486,8 @@ h264parser_suite (void)
   tcase_add_test (tc_chain, test_h264_parse_slice_eoseq_slice);
   tcase_add_test (tc_chain, test_h264_parse_slice_5bytes);
   tcase_add_test (tc_chain, test_h264_parse_invalid_sei);
+  tcase_add_test (tc_chain, test_h264_parse_repeated_parameter_sets);
+  tcase_add_test (tc_chain, test_h264_parse_headers_perf);
 
   return s;
 }
@@ -0,0 +1,598 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/base/gstbitwriter.h>
+#include <gst/codecs/gsth265decoder.h>
+
+#define FRAME_DURATION (40 * GST_MSECOND)
+#define WIDTH 320
+#define HEIGHT 240
+
+/* Mock accelerator: pictures are not decoded, the decoder only records in
+ * which order they come out of the DPB */
+typedef struct _GstTestH265Dec
+{
+  GstH265Decoder parent;
+
+  GstH265Picture *current_picture;
+  GstVideoCodecState *output_state;
+} GstTestH265Dec;
+
+typedef struct _GstTestH265DecClass
+{
+  GstH265DecoderClass parent_class;
+} GstTestH265DecClass;
+
+static GType gst_test_h265_dec_get_type (void);
+#define GST_TEST_H265_DEC(obj) ((GstTestH265Dec *) (obj))
+
+G_DEFINE_TYPE (GstTestH265Dec, gst_test_h265_dec, GST_TYPE_H265_DECODER);
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-h265"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-raw"));
+
+static gboolean
+gst_test_h265_dec_stop (GstVideoDecoder * decoder)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+
+  gst_h265_picture_clear (&self->current_picture);
+  g_clear_pointer (&self->output_state, gst_video_codec_state_unref);
+
+  return GST_VIDEO_DECODER_CLASS (gst_test_h265_dec_parent_class)->stop
+      (decoder);
+}
+
+static GstFlowReturn
+gst_test_h265_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+
+  fail_unless (self->current_picture != NULL);
+
+  gst_video_codec_frame_set_user_data (frame, self->current_picture,
+      (GDestroyNotify) gst_h265_picture_unref);
+  self->current_picture = NULL;
+  gst_video_codec_frame_unref (frame);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_test_h265_dec_new_sequence (GstH265Decoder * decoder,
+    const GstH265SPS * sps)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+
+  if (self->output_state)
+    gst_video_codec_state_unref (self->output_state);
+
+  self->output_state =
+      gst_video_decoder_set_output_state (GST_VIDEO_DECODER (self),
+      GST_VIDEO_FORMAT_GRAY8, sps->width, sps->height, decoder->input_state);
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_h265_dec_new_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+
+  gst_h265_picture_replace (&self->current_picture, picture);
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_h265_dec_decode_slice (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_test_h265_dec_output_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  GstVideoDecoder *vdec = GST_VIDEO_DECODER (decoder);
+  GstVideoCodecFrame *frame = NULL;
+  GList *frames, *iter;
+  GstFlowReturn ret;
+
+  frames = gst_video_decoder_get_frames (vdec);
+  for (iter = frames; iter; iter = g_list_next (iter)) {
+    GstVideoCodecFrame *tmp = (GstVideoCodecFrame *) iter->data;
+
+    if (gst_video_codec_frame_get_user_data (tmp) == picture) {
+      frame = gst_video_codec_frame_ref (tmp);
+      break;
+    }
+  }
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
+
+  fail_unless (frame != NULL);
+
+  ret = gst_video_decoder_allocate_output_frame (vdec, frame);
+  if (ret != GST_FLOW_OK) {
+    gst_video_decoder_drop_frame (vdec, frame);
+    return ret;
+  }
+
+  return gst_video_decoder_finish_frame (vdec, frame);
+}
+
+static void
+gst_test_h265_dec_class_init (GstTestH265DecClass * klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstH265DecoderClass *h265decoder_class = GST_H265_DECODER_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "Test H.265 decoder", "Codec/Decoder/Video",
+      "Mock GstH265Decoder subclass", "GStreamer developers");
+
+  decoder_class->stop = GST_DEBUG_FUNCPTR (gst_test_h265_dec_stop);
+  decoder_class->handle_frame =
+      GST_DEBUG_FUNCPTR (gst_test_h265_dec_handle_frame);
+
+  h265decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_test_h265_dec_new_sequence);
+  h265decoder_class->new_picture =
+      GST_DEBUG_FUNCPTR (gst_test_h265_dec_new_picture);
+  h265decoder_class->decode_slice =
+      GST_DEBUG_FUNCPTR (gst_test_h265_dec_decode_slice);
+  h265decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_test_h265_dec_output_picture);
+}
+
+static void
+gst_test_h265_dec_init (GstTestH265Dec * self)
+{
+}
+
+/* Bitstream generation: just enough of VPS, SPS, PPS and slice segment
+ * headers for the decoder to do its reference and output bookkeeping */
+typedef struct
+{
+  gboolean b_frames;
+  guint max_num_reorder_pics;
+} TestStream;
+
+/* short term reference picture sets of the SPS */
+enum
+{
+  RPS_P_AFTER_B,                /* P of a P B B mini-GOP */
+  RPS_FIRST_B,                  /* first B of a mini-GOP */
+  RPS_SECOND_B,                 /* second B of a mini-GOP */
+  RPS_P,                        /* P following a P */
+  NUM_RPS
+};
+
+static const struct
+{
+  gint n_negative;
+  gint negative[2];
+  gint n_positive;
+  gint positive[2];
+} rps[NUM_RPS] = {
+  {1, {-3}, 0, {0}},
+  {1, {-1}, 1, {2}},
+  {1, {-2}, 1, {1}},
+  {1, {-1}, 0, {0}},
+};
+
+typedef struct
+{
+  GstH265SliceType type;
+  GstH265NalUnitType nal_type;
+  guint rps_idx;
+  gint poc;
+} TestPicture;
+
+static const TestStream b_stream = { TRUE, 1 };
+
+/* signals more reordering than the stream uses */
+static const TestStream p_stream = { FALSE, 2 };
+
+static void
+put_ue (GstBitWriter * bw, guint32 val)
+{
+  guint len = g_bit_storage (val + 1);
+
+  if (len > 1)
+    gst_bit_writer_put_bits_uint32 (bw, 0, len - 1);
+  gst_bit_writer_put_bits_uint32 (bw, val + 1, len);
+}
+
+static void
+put_se (GstBitWriter * bw, gint32 val)
+{
+  put_ue (bw, val > 0 ? 2 * val - 1 : -2 * val);
+}
+
+/* terminates the RBSP in @bw and appends it as a byte-stream NAL */
+static void
+append_nal (GByteArray * au, GstH265NalUnitType type, GstBitWriter * bw)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+  /* nuh_layer_id 0, nuh_temporal_id_plus1 1 */
+  guint8 header[2] = { type << 1, 0x01 };
+  const guint8 *data;
+  guint i, size, zeros = 0;
+
+  gst_bit_writer_put_bits_uint32 (bw, 1, 1);
+  gst_bit_writer_align_bytes (bw, 0);
+  data = gst_bit_writer_get_data (bw);
+  size = gst_bit_writer_get_size (bw) / 8;
+
+  g_byte_array_append (au, start_code, sizeof (start_code));
+  g_byte_array_append (au, header, sizeof (header));
+  for (i = 0; i < size; i++) {
+    if (zeros >= 2 && data[i] <= 0x03) {
+      static const guint8 epb = 0x03;
+
+      g_byte_array_append (au, &epb, 1);
+      zeros = 0;
+    }
+    g_byte_array_append (au, &data[i], 1);
+    zeros = data[i] == 0x00 ? zeros + 1 : 0;
+  }
+
+  gst_bit_writer_reset (bw);
+}
+
+/* Main profile, level 2, progressive frames */
+static void
+put_profile_tier_level (GstBitWriter * bw)
+{
+  gst_bit_writer_put_bits_uint32 (bw, 0, 2);    /* profile_space */
+  gst_bit_writer_put_bits_uint32 (bw, 0, 1);    /* tier_flag */
+  gst_bit_writer_put_bits_uint32 (bw, 1, 5);    /* profile_idc */
+  gst_bit_writer_put_bits_uint32 (bw, 0x60000000, 32);  /* compatibility */
+  gst_bit_writer_put_bits_uint32 (bw, 1, 1);    /* progressive_source */
+  gst_bit_writer_put_bits_uint32 (bw, 0, 2);    /* interlaced, non_packed */
+  gst_bit_writer_put_bits_uint32 (bw, 1, 1);    /* frame_only_constraint */
+  gst_bit_writer_put_bits_uint32 (bw, 0, 32);   /* constraint and reserved */
+  gst_bit_writer_put_bits_uint32 (bw, 0, 12);
+  gst_bit_writer_put_bits_uint32 (bw, 60, 8);   /* level_idc */
+}
+
+static void
+put_sub_layer_ordering_info (GstBitWriter * bw, const TestStream * stream)
+{
+  gst_bit_writer_put_bits_uint32 (bw, 1, 1);    /* info present */
+  put_ue (bw, 4);               /* max_dec_pic_buffering_minus1 */
+  put_ue (bw, stream->max_num_reorder_pics);
+  put_ue (bw, 0);               /* max_latency_increase_plus1 */
+}
+
+static void
+append_vps (GByteArray * au, const TestStream * stream)
+{
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 4);   /* vps_id */
+  gst_bit_writer_put_bits_uint32 (&bw, 3, 2);   /* base layer flags */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 6);   /* max_layers_minus1 */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 3);   /* max_sub_layers_minus1 */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* temporal_id_nesting */
+  gst_bit_writer_put_bits_uint32 (&bw, 0xffff, 16);
+  put_profile_tier_level (&bw);
+  put_sub_layer_ordering_info (&bw, stream);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 6);   /* max_layer_id */
+  put_ue (&bw, 0);              /* num_layer_sets_minus1 */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* timing_info_present */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* vps_extension */
+  append_nal (au, GST_H265_NAL_VPS, &bw);
+}
+
+/* 4:2:0 8 bits, 16x16 CTBs, all reference picture sets in the SPS */
+static void
+append_sps (GByteArray * au, const TestStream * stream)
+{
+  GstBitWriter bw;
+  guint i;
+  gint j;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 4);   /* vps_id */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 3);   /* max_sub_layers_minus1 */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* temporal_id_nesting */
+  put_profile_tier_level (&bw);
+  put_ue (&bw, 0);              /* sps_id */
+  put_ue (&bw, 1);              /* chroma_format_idc */
+  put_ue (&bw, WIDTH);
+  put_ue (&bw, HEIGHT);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* conformance_window */
+  put_ue (&bw, 0);              /* bit_depth_luma_minus8 */
+  put_ue (&bw, 0);              /* bit_depth_chroma_minus8 */
+  put_ue (&bw, 4);              /* log2_max_pic_order_cnt_lsb_minus4 */
+  put_sub_layer_ordering_info (&bw, stream);
+  put_ue (&bw, 0);              /* log2_min_luma_coding_block_size_minus3 */
+  put_ue (&bw, 1);              /* log2_diff_max_min_luma_coding_block */
+  put_ue (&bw, 0);              /* log2_min_transform_block_size_minus2 */
+  put_ue (&bw, 2);              /* log2_diff_max_min_transform_block */
+  put_ue (&bw, 0);              /* max_transform_hierarchy_depth_inter */
+  put_ue (&bw, 0);              /* max_transform_hierarchy_depth_intra */
+  /* no scaling list, amp, sample adaptive offset nor pcm */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 4);
+  put_ue (&bw, NUM_RPS);
+  for (i = 0; i < NUM_RPS; i++) {
+    if (i > 0)
+      gst_bit_writer_put_bits_uint32 (&bw, 0, 1);       /* inter RPS pred */
+    put_ue (&bw, rps[i].n_negative);
+    put_ue (&bw, rps[i].n_positive);
+    for (j = 0; j < rps[i].n_negative; j++) {
+      put_ue (&bw, (j > 0 ? rps[i].negative[j - 1] : 0) -
+          rps[i].negative[j] - 1);
+      gst_bit_writer_put_bits_uint32 (&bw, 1, 1);       /* used_by_curr_pic */
+    }
+    for (j = 0; j < rps[i].n_positive; j++) {
+      put_ue (&bw, rps[i].positive[j] -
+          (j > 0 ? rps[i].positive[j - 1] : 0) - 1);
+      gst_bit_writer_put_bits_uint32 (&bw, 1, 1);       /* used_by_curr_pic */
+    }
+  }
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* long_term_ref_pics */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* temporal_mvp */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* strong_intra_smoothing */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* vui_parameters_present */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* sps_extension */
+  append_nal (au, GST_H265_NAL_SPS, &bw);
+}
+
+static void
+append_pps (GByteArray * au)
+{
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  put_ue (&bw, 0);              /* pps_id */
+  put_ue (&bw, 0);              /* sps_id */
+  /* no dependent slices, output flag, extra slice header bits, sign data
+   * hiding nor cabac_init */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 7);
+  put_ue (&bw, 0);              /* num_ref_idx_l0_default_active_minus1 */
+  put_ue (&bw, 0);              /* num_ref_idx_l1_default_active_minus1 */
+  put_se (&bw, 0);              /* init_qp_minus26 */
+  /* no constrained intra, transform skip nor cu_qp_delta */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 3);
+  put_se (&bw, 0);              /* cb_qp_offset */
+  put_se (&bw, 0);              /* cr_qp_offset */
+  /* no slice chroma qp offsets, weighted prediction, transquant bypass,
+   * tiles, entropy coding sync, loop filter across slices, deblocking
+   * control, scaling list nor lists modification */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 10);
+  put_ue (&bw, 0);              /* log2_parallel_merge_level_minus2 */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* header extension */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* pps_extension */
+  append_nal (au, GST_H265_NAL_PPS, &bw);
+}
+
+static void
+append_slice (GByteArray * au, const TestPicture * pic)
+{
+  GstBitWriter bw;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* first slice segment */
+  if (pic->nal_type == GST_H265_NAL_SLICE_IDR_W_RADL)
+    gst_bit_writer_put_bits_uint32 (&bw, 0, 1); /* no_output_of_prior_pics */
+  put_ue (&bw, 0);              /* pps_id */
+  put_ue (&bw, pic->type);
+  if (pic->nal_type != GST_H265_NAL_SLICE_IDR_W_RADL) {
+    gst_bit_writer_put_bits_uint32 (&bw, pic->poc % 256, 8);
+    gst_bit_writer_put_bits_uint32 (&bw, 1, 1); /* RPS from the SPS */
+    gst_bit_writer_put_bits_uint32 (&bw, pic->rps_idx, 2);
+  }
+  if (pic->type != GST_H265_I_SLICE) {
+    gst_bit_writer_put_bits_uint32 (&bw, 0, 1); /* num_ref_idx_override */
+    if (pic->type == GST_H265_B_SLICE)
+      gst_bit_writer_put_bits_uint32 (&bw, 0, 1);       /* mvd_l1_zero */
+    put_ue (&bw, 0);            /* five_minus_max_num_merge_cand */
+  }
+  put_se (&bw, 0);              /* slice_qp_delta */
+  /* byte_alignment () */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);
+  gst_bit_writer_align_bytes (&bw, 0);
+  /* stand-in for the slice data */
+  gst_bit_writer_put_bits_uint32 (&bw, 0xa5a5a5a5, 32);
+  append_nal (au, pic->nal_type, &bw);
+}
+
+/* IDR followed by P B B mini-GOPs or by P pictures only, in decoding order */
+static GArray *
+create_pictures (const TestStream * stream, guint n_pictures)
+{
+  GArray *pictures = g_array_new (FALSE, TRUE, sizeof (TestPicture));
+  TestPicture pic = { GST_H265_I_SLICE, GST_H265_NAL_SLICE_IDR_W_RADL, 0, 0 };
+  guint i;
+
+  g_array_append_val (pictures, pic);
+  for (i = 1; i < n_pictures; i++) {
+    guint display = ((i - 1) / 3) * 3;
+
+    if (!stream->b_frames) {
+      pic.type = GST_H265_P_SLICE;
+      pic.nal_type = GST_H265_NAL_SLICE_TRAIL_R;
+      pic.rps_idx = RPS_P;
+      pic.poc = i;
+    } else if ((i - 1) % 3 == 0) {
+      pic.type = GST_H265_P_SLICE;
+      pic.nal_type = GST_H265_NAL_SLICE_TRAIL_R;
+      pic.rps_idx = RPS_P_AFTER_B;
+      pic.poc = display + 3;
+    } else {
+      pic.type = GST_H265_B_SLICE;
+      pic.nal_type = GST_H265_NAL_SLICE_TRAIL_N;
+      pic.rps_idx = (i - 1) % 3 == 1 ? RPS_FIRST_B : RPS_SECOND_B;
+      pic.poc = display + (i - 1) % 3;
+    }
+    g_array_append_val (pictures, pic);
+  }
+
+  return pictures;
+}
+
+static GstBuffer *
+create_au (const TestStream * stream, const TestPicture * pic)
+{
+  GByteArray *au = g_byte_array_new ();
+  GstBuffer *buf;
+
+  if (pic->type == GST_H265_I_SLICE) {
+    append_vps (au, stream);
+    append_sps (au, stream);
+    append_pps (au);
+  }
+  append_slice (au, pic);
+
+  buf = gst_buffer_new_wrapped (au->data, au->len);
+  g_byte_array_free (au, FALSE);
+
+  GST_BUFFER_PTS (buf) = pic->poc * FRAME_DURATION;
+
+  return buf;
+}
+
+static GstHarness *
+create_harness (gboolean low_latency)
+{
+  GstHarness *h;
+
+  gst_element_register (NULL, "testh265dec", GST_RANK_NONE,
+      gst_test_h265_dec_get_type ());
+
+  h = gst_harness_new ("testh265dec");
+  g_object_set (h->element, "low-latency", low_latency, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h265, stream-format=byte-stream, alignment=au, "
+      "framerate=25/1");
+
+  return h;
+}
+
+/* decodes @n_pictures and checks that all of them are output in display
+ * order, returns the largest number of pictures held back by the DPB and
+ * in @end_delay the number held back after the last one was decoded */
+static guint
+run_decoder (const TestStream * stream, gboolean low_latency,
+    guint n_pictures, GstClockTime * latency, guint * end_delay)
+{
+  GArray *pictures = create_pictures (stream, n_pictures);
+  GstHarness *h = create_harness (low_latency);
+  GstBuffer *out;
+  guint i, n_out = 0, max_delay = 0;
+
+  for (i = 0; i < pictures->len; i++) {
+    TestPicture *pic = &g_array_index (pictures, TestPicture, i);
+
+    fail_unless_equals_int (gst_harness_push (h, create_au (stream, pic)),
+        GST_FLOW_OK);
+
+    while ((out = gst_harness_try_pull (h))) {
+      fail_unless_equals_uint64 (GST_BUFFER_PTS (out),
+          n_out * FRAME_DURATION);
+      gst_buffer_unref (out);
+      n_out++;
+    }
+    max_delay = MAX (max_delay, i + 1 - n_out);
+  }
+
+  if (latency)
+    *latency = gst_harness_query_latency (h);
+  if (end_delay)
+    *end_delay = n_pictures - n_out;
+
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  while ((out = gst_harness_try_pull (h))) {
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (out), n_out * FRAME_DURATION);
+    gst_buffer_unref (out);
+    n_out++;
+  }
+  fail_unless_equals_int (n_out, n_pictures);
+
+  gst_harness_teardown (h);
+  g_array_unref (pictures);
+
+  return max_delay;
+}
+
+GST_START_TEST (test_h265_decoder_output_order)
+{
+  /* the B pictures need a single picture delay */
+  fail_unless_equals_int (run_decoder (&b_stream, FALSE, 31, NULL, NULL), 1);
+  /* P pictures are held back as long as the signalled reordering allows */
+  fail_unless_equals_int (run_decoder (&p_stream, FALSE, 31, NULL, NULL), 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h265_decoder_low_latency)
+{
+  GstClockTime latency;
+  guint end_delay;
+
+  /* the reported latency follows sps_max_num_reorder_pics in any mode */
+  run_decoder (&p_stream, FALSE, 31, &latency, &end_delay);
+  fail_unless_equals_uint64 (latency, 2 * FRAME_DURATION);
+  fail_unless_equals_int (end_delay, 2);
+
+  /* in low-latency mode, pictures are output as soon as they are decoded
+   * once the POC step is known */
+  run_decoder (&p_stream, TRUE, 31, &latency, &end_delay);
+  fail_unless_equals_uint64 (latency, 2 * FRAME_DURATION);
+  fail_unless_equals_int (end_delay, 0);
+
+  /* B pictures: the P picture is held back until the B pictures preceding
+   * it in display order are decoded */
+  run_decoder (&b_stream, FALSE, 31, NULL, &end_delay);
+  fail_unless_equals_int (end_delay, 1);
+  run_decoder (&b_stream, TRUE, 31, NULL, &end_delay);
+  fail_unless_equals_int (end_delay, 0);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265decoder_suite (void)
+{
+  Suite *s = suite_create ("H265 decoder base class");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h265_decoder_output_order);
+  tcase_add_test (tc_chain, test_h265_decoder_low_latency);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265decoder);
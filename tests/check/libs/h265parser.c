@@ -18,6 +18,7 @@
  */
 #include <gst/check/gstcheck.h>
 #include <gst/codecparsers/gsth265parser.h>
+#include <gst/base/gstbitwriter.h>
 
 unsigned char slice_eos_slice_eob[] = {
   0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0xaf, 0x06, 0xb8, 0x63, 0xef, 0x3a,
@@ -456,6 +457,360 @@ GST_START_TEST (test_h265_parse_pps)
 
 GST_END_TEST;
 
+#define N_TILED_SLICES 64
+
+/* 8K picture split in 8x4 tiles, parameter sets are set up by hand as only
+ * the fields used by slice segment headers matter */
+static void
+setup_tiled_parameter_sets (GstH265Parser * parser)
+{
+  GstH265SPS *sps = &parser->sps[0];
+  GstH265PPS *pps = &parser->pps[0];
+
+  sps->valid = TRUE;
+  sps->log2_max_pic_order_cnt_lsb_minus4 = 4;
+
+  pps->valid = TRUE;
+  pps->sps = sps;
+  pps->PicWidthInCtbsY = 120;
+  pps->PicHeightInCtbsY = 68;
+  pps->tiles_enabled_flag = 1;
+  pps->num_tile_columns_minus1 = 7;
+  pps->num_tile_rows_minus1 = 3;
+}
+
+static void
+put_ue (GstBitWriter * bw, guint32 val)
+{
+  guint len = g_bit_storage (val + 1);
+
+  if (len > 1)
+    gst_bit_writer_put_bits_uint32 (bw, 0, len - 1);
+  gst_bit_writer_put_bits_uint32 (bw, val + 1, len);
+}
+
+/* IDR_N_LP slice segment with 3 entry points, @pps_id 1 is never valid */
+static guint8 *
+create_tiled_slice (guint idx, guint pps_id, GstH265NalUnit * nalu)
+{
+  GstBitWriter bw;
+  guint8 *data;
+  guint i;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, 20 << 1, 8);     /* nal header */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 8);
+  gst_bit_writer_put_bits_uint32 (&bw, idx == 0, 1);    /* first segment */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* no_output_of_prior_pics */
+  put_ue (&bw, pps_id);
+  if (idx > 0)
+    gst_bit_writer_put_bits_uint32 (&bw, idx * 127, 13);
+  put_ue (&bw, GST_H265_I_SLICE);
+  put_ue (&bw, idx % 8);        /* slice_qp_delta, as se(v) */
+  put_ue (&bw, 3);              /* num_entry_point_offsets */
+  put_ue (&bw, 15);             /* offset_len_minus1 */
+  for (i = 0; i < 3; i++)
+    gst_bit_writer_put_bits_uint32 (&bw, 1000 + idx * 7 + i, 16);
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* alignment */
+  gst_bit_writer_align_bytes (&bw, 0);
+  /* stand-in for the slice data */
+  gst_bit_writer_put_bits_uint32 (&bw, 0xa5a5a5a5, 32);
+
+  nalu->type = GST_H265_NAL_SLICE_IDR_N_LP;
+  nalu->layer_id = 0;
+  nalu->temporal_id_plus1 = 1;
+  nalu->offset = nalu->sc_offset = 0;
+  nalu->size = gst_bit_writer_get_size (&bw) / 8;
+  nalu->header_bytes = 2;
+  nalu->valid = TRUE;
+
+  data = gst_bit_writer_reset_and_get_data (&bw);
+  nalu->data = data;
+
+  return data;
+}
+
+static void
+assert_slice_hdrs_equal (const GstH265SliceHdr * a, const GstH265SliceHdr * b)
+{
+  guint i;
+
+  assert_equals_int (a->first_slice_segment_in_pic_flag,
+      b->first_slice_segment_in_pic_flag);
+  assert_equals_int (a->segment_address, b->segment_address);
+  assert_equals_int (a->type, b->type);
+  assert_equals_int (a->qp_delta, b->qp_delta);
+  assert_equals_int (a->num_entry_point_offsets, b->num_entry_point_offsets);
+  for (i = 0; i < a->num_entry_point_offsets; i++) {
+    assert_equals_int (a->entry_point_offset_minus1[i],
+        b->entry_point_offset_minus1[i]);
+  }
+  assert_equals_int (a->header_size, b->header_size);
+  fail_unless (a->pps == b->pps);
+}
+
+GST_START_TEST (test_h265_parse_slice_hdrs)
+{
+  GstH265Parser *const parser = gst_h265_parser_new ();
+  GstH265NalUnit nalus[N_TILED_SLICES];
+  GstH265SliceHdr slices[N_TILED_SLICES];
+  GstH265SliceHdr expected[N_TILED_SLICES];
+  GstH265ParserResult results[N_TILED_SLICES];
+  guint8 *data[N_TILED_SLICES];
+  GstH265ParserResult res;
+  guint i, n;
+
+  setup_tiled_parameter_sets (parser);
+
+  for (i = 0; i < N_TILED_SLICES; i++) {
+    data[i] = create_tiled_slice (i, i == 37 ? 1 : 0, &nalus[i]);
+    results[i] = gst_h265_parser_parse_slice_hdr (parser, &nalus[i],
+        &expected[i]);
+    if (i != 37)
+      assert_equals_int (results[i], GST_H265_PARSER_OK);
+  }
+  assert_equals_int (expected[10].segment_address, 10 * 127);
+  assert_equals_int (expected[10].entry_point_offset_minus1[2], 1072);
+
+  /* every batch size, parallel or not, must give the same headers */
+  for (n = 0; n <= N_TILED_SLICES; n++) {
+    res = gst_h265_parser_parse_slice_hdrs (parser, nalus, n, slices,
+        results);
+    assert_equals_int (res, n > 37 ? GST_H265_PARSER_BROKEN_LINK :
+        GST_H265_PARSER_OK);
+
+    for (i = 0; i < n; i++) {
+      if (i == 37) {
+        assert_equals_int (results[i], GST_H265_PARSER_BROKEN_LINK);
+        continue;
+      }
+      assert_equals_int (results[i], GST_H265_PARSER_OK);
+      assert_slice_hdrs_equal (&slices[i], &expected[i]);
+      gst_h265_slice_hdr_free (&slices[i]);
+    }
+  }
+
+  /* results are optional */
+  res = gst_h265_parser_parse_slice_hdrs (parser, nalus, 32, slices, NULL);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  for (i = 0; i < 32; i++) {
+    assert_slice_hdrs_equal (&slices[i], &expected[i]);
+    gst_h265_slice_hdr_free (&slices[i]);
+  }
+
+  for (i = 0; i < N_TILED_SLICES; i++) {
+    if (i != 37)
+      gst_h265_slice_hdr_free (&expected[i]);
+    g_free (data[i]);
+  }
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static const guint8 h265_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60, 0x00,
+  0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x3f, 0x95,
+  0x98, 0x09
+};
+
+static const guint8 h265_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00,
+  0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x3f, 0xa0, 0x88, 0x45, 0x96,
+  0x56, 0x6a, 0xbc, 0xaf, 0xff, 0x00, 0x01, 0x00, 0x01, 0x6a, 0x0c, 0x02, 0x0c,
+  0x08, 0x00, 0x00, 0x03, 0x00, 0x08, 0x00, 0x00, 0x03, 0x00, 0xf0, 0x40
+};
+
+static const guint8 h265_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc1, 0x73, 0xd0, 0x89
+};
+
+static void
+identify_nalu (GstH265Parser * parser, const guint8 * data, gsize size,
+    GstH265NalUnit * nalu)
+{
+  GstH265ParserResult res;
+
+  res = gst_h265_parser_identify_nalu_unchecked (parser, data, 0, size, nalu);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+}
+
+static void
+put_ptl_profile (GstBitWriter * bw)
+{
+  gst_bit_writer_put_bits_uint32 (bw, 1, 8);    /* space, tier, Main */
+  gst_bit_writer_put_bits_uint32 (bw, 0x60000000, 32);
+  gst_bit_writer_put_bits_uint32 (bw, 0x9, 4);  /* progressive, frame only */
+  gst_bit_writer_put_bits_uint32 (bw, 0, 32);
+  gst_bit_writer_put_bits_uint32 (bw, 0, 12);
+}
+
+/* 64x64 SPS with @max_sub_layers_minus1 sub-layers, every other one
+ * signalling its own profile, so that profile_tier_level() has a variable
+ * length. Emulation prevention bytes are inserted as needed */
+static guint8 *
+create_sps (guint id, guint max_sub_layers_minus1, guint8 level,
+    gsize * size)
+{
+  GstBitWriter bw;
+  GByteArray *nal;
+  guint8 *rbsp;
+  guint i, rbsp_size, zeros = 0;
+
+  gst_bit_writer_init (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 4);   /* vps id */
+  gst_bit_writer_put_bits_uint32 (&bw, max_sub_layers_minus1, 3);
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* temporal_id_nesting */
+  put_ptl_profile (&bw);
+  gst_bit_writer_put_bits_uint32 (&bw, level, 8);
+  for (i = 0; i < max_sub_layers_minus1; i++) {
+    gst_bit_writer_put_bits_uint32 (&bw, i % 2 == 0, 1);
+    gst_bit_writer_put_bits_uint32 (&bw, 1, 1);
+  }
+  if (max_sub_layers_minus1 > 0)
+    gst_bit_writer_put_bits_uint32 (&bw, 0, 2 * (8 - max_sub_layers_minus1));
+  for (i = 0; i < max_sub_layers_minus1; i++) {
+    if (i % 2 == 0)
+      put_ptl_profile (&bw);
+    gst_bit_writer_put_bits_uint32 (&bw, level, 8);
+  }
+  put_ue (&bw, id);
+  put_ue (&bw, 1);              /* chroma_format_idc */
+  put_ue (&bw, 64);
+  put_ue (&bw, 64);
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 1);   /* conformance_window */
+  put_ue (&bw, 0);              /* bit_depth_luma_minus8 */
+  put_ue (&bw, 0);              /* bit_depth_chroma_minus8 */
+  put_ue (&bw, 4);              /* log2_max_pic_order_cnt_lsb_minus4 */
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* ordering info present */
+  for (i = 0; i <= max_sub_layers_minus1; i++) {
+    put_ue (&bw, 1);            /* max_dec_pic_buffering_minus1 */
+    put_ue (&bw, 0);            /* max_num_reorder_pics */
+    put_ue (&bw, 0);            /* max_latency_increase_plus1 */
+  }
+  put_ue (&bw, 0);              /* log2_min_luma_coding_block_size_minus3 */
+  put_ue (&bw, 1);              /* log2_diff_max_min_luma_coding_block_size */
+  put_ue (&bw, 0);              /* log2_min_transform_block_size_minus2 */
+  put_ue (&bw, 1);              /* log2_diff_max_min_transform_block_size */
+  put_ue (&bw, 0);              /* max_transform_hierarchy_depth_inter */
+  put_ue (&bw, 0);              /* max_transform_hierarchy_depth_intra */
+  /* scaling lists, amp, sao, pcm */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 4);
+  put_ue (&bw, 0);              /* num_short_term_ref_pic_sets */
+  /* long term refs, tmvp, strong intra smoothing, vui, extension */
+  gst_bit_writer_put_bits_uint32 (&bw, 0, 5);
+  gst_bit_writer_put_bits_uint32 (&bw, 1, 1);   /* rbsp stop bit */
+  gst_bit_writer_align_bytes (&bw, 0);
+
+  rbsp_size = gst_bit_writer_get_size (&bw) / 8;
+  rbsp = gst_bit_writer_reset_and_get_data (&bw);
+
+  nal = g_byte_array_new ();
+  g_byte_array_append (nal, (const guint8 *) "\x00\x00\x00\x01\x42\x01", 6);
+  for (i = 0; i < rbsp_size; i++) {
+    if (zeros == 2 && rbsp[i] <= 3) {
+      g_byte_array_append (nal, (const guint8 *) "\x03", 1);
+      zeros = 0;
+    }
+    g_byte_array_append (nal, &rbsp[i], 1);
+    zeros = rbsp[i] == 0 ? zeros + 1 : 0;
+  }
+  g_free (rbsp);
+
+  *size = nal->len;
+  return g_byte_array_free (nal, FALSE);
+}
+
+GST_START_TEST (test_h265_parse_repeated_parameter_sets)
+{
+  GstH265Parser *const parser = gst_h265_parser_new ();
+  guint8 *vps_data = g_memdup (h265_vps, sizeof (h265_vps));
+  GstH265NalUnit vps_nalu, sps_nalu, pps_nalu, nalu;
+  GstH265ParserResult res;
+  GstH265VPS *vps;
+  GstH265SPS *sps;
+  GstH265PPS *pps;
+  guint n_vps_parsed = 0, n_sps_parsed = 0, n_pps_parsed = 0;
+  gboolean changed;
+  guint8 *data;
+  gsize size;
+  guint i;
+
+  identify_nalu (parser, vps_data, sizeof (h265_vps), &vps_nalu);
+  identify_nalu (parser, h265_sps, sizeof (h265_sps), &sps_nalu);
+  identify_nalu (parser, h265_pps, sizeof (h265_pps), &pps_nalu);
+
+  /* the same parameter sets, as re-sent with every IRAP picture, are only
+   * parsed once and handed out from the parser without copying them */
+  for (i = 0; i < 3; i++) {
+    res = gst_h265_parser_update_vps (parser, &vps_nalu, &vps, &changed);
+    assert_equals_int (res, GST_H265_PARSER_OK);
+    fail_unless (vps == &parser->vps[0]);
+    n_vps_parsed += changed;
+
+    res = gst_h265_parser_update_sps (parser, &sps_nalu, &sps, TRUE,
+        &changed);
+    assert_equals_int (res, GST_H265_PARSER_OK);
+    fail_unless (sps == &parser->sps[0]);
+    fail_unless (sps->vps == &parser->vps[0]);
+    assert_equals_int (sps->profile_tier_level.level_idc, 0x3f);
+    n_sps_parsed += changed;
+
+    res = gst_h265_parser_update_pps (parser, &pps_nalu, &pps, &changed);
+    assert_equals_int (res, GST_H265_PARSER_OK);
+    fail_unless (pps == &parser->pps[0]);
+    fail_unless (pps->sps == &parser->sps[0]);
+    n_pps_parsed += changed;
+  }
+  assert_equals_int (n_vps_parsed, 1);
+  assert_equals_int (n_sps_parsed, 1);
+  assert_equals_int (n_pps_parsed, 1);
+
+  /* a SPS parsed with its VUI also serves requests without it */
+  res = gst_h265_parser_update_sps (parser, &sps_nalu, &sps, FALSE, &changed);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  fail_if (changed);
+
+  /* a changed VPS makes the unchanged SPS and PPS be parsed again, once */
+  vps_data[24] = 0x5a;
+  res = gst_h265_parser_update_vps (parser, &vps_nalu, &vps, &changed);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  fail_unless (changed);
+  assert_equals_int (vps->profile_tier_level.level_idc, 0x5a);
+
+  for (i = 0; i < 2; i++) {
+    res = gst_h265_parser_update_sps (parser, &sps_nalu, &sps, TRUE,
+        &changed);
+    assert_equals_int (res, GST_H265_PARSER_OK);
+    assert_equals_int (changed, i == 0);
+
+    res = gst_h265_parser_update_pps (parser, &pps_nalu, &pps, &changed);
+    assert_equals_int (res, GST_H265_PARSER_OK);
+    assert_equals_int (changed, i == 0);
+  }
+
+  /* the id of a SPS with sub-layers is found behind its variable length
+   * profile_tier_level() */
+  for (i = 0; i < 3; i++) {
+    data = create_sps (3, 2, i < 2 ? 0x5a : 0x5d, &size);
+    identify_nalu (parser, data, size, &nalu);
+    res = gst_h265_parser_update_sps (parser, &nalu, &sps, TRUE, &changed);
+    assert_equals_int (res, GST_H265_PARSER_OK);
+    fail_unless (sps == &parser->sps[3]);
+    assert_equals_int (sps->max_sub_layers_minus1, 2);
+    assert_equals_int (sps->profile_tier_level.sub_layer_level_idc[1],
+        i < 2 ? 0x5a : 0x5d);
+    assert_equals_int (changed, i != 1);
+    g_free (data);
+  }
+  fail_unless (parser->sps[0].valid);
+
+  g_free (vps_data);
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 h265parser_suite (void)
 {
@@ -472,6 +827,8 @@ h265parser_suite (void)
   tcase_add_test (tc_chain, test_h265_format_range_profiles_partial_match);
   tcase_add_test (tc_chain, test_h265_parse_vps);
   tcase_add_test (tc_chain, test_h265_parse_pps);
+  tcase_add_test (tc_chain, test_h265_parse_slice_hdrs);
+  tcase_add_test (tc_chain, test_h265_parse_repeated_parameter_sets);
 
   return s;
 }
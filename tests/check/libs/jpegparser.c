@@ -0,0 +1,90 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstjpegparser.h>
+
+/* Entropy-coded data of three restart intervals, with stuffed 0xff bytes
+ * and a fill byte before the EOI marker */
+static const guint8 entropy_coded_data[] = {
+  0x12, 0xff, 0x00, 0x34,
+  0xff, 0xd0,
+  0x56, 0x78, 0xff, 0x00,
+  0xff, 0xd1,
+  0x9a,
+  0xff, 0xff, 0xd9
+};
+
+GST_START_TEST (test_jpeg_scan_for_marker_code)
+{
+  static const guint8 no_marker[] = { 0x00, 0xff, 0x00, 0xff };
+
+  assert_equals_int (gst_jpeg_scan_for_marker_code (entropy_coded_data,
+          sizeof (entropy_coded_data), 0), 4);
+  assert_equals_int (gst_jpeg_scan_for_marker_code (entropy_coded_data,
+          sizeof (entropy_coded_data), 6), 10);
+  /* fill bytes are skipped */
+  assert_equals_int (gst_jpeg_scan_for_marker_code (entropy_coded_data,
+          sizeof (entropy_coded_data), 12), 14);
+
+  assert_equals_int (gst_jpeg_scan_for_marker_code (no_marker,
+          sizeof (no_marker), 0), -1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_jpeg_scan_restart_intervals)
+{
+  GArray *intervals = g_array_new (FALSE, FALSE, sizeof (guint));
+  guint end_offset = 0;
+
+  fail_unless (gst_jpeg_scan_restart_intervals (entropy_coded_data,
+          sizeof (entropy_coded_data), 0, intervals, &end_offset));
+  assert_equals_int (intervals->len, 3);
+  assert_equals_int (g_array_index (intervals, guint, 0), 0);
+  assert_equals_int (g_array_index (intervals, guint, 1), 6);
+  assert_equals_int (g_array_index (intervals, guint, 2), 12);
+  assert_equals_int (end_offset, 14);
+
+  /* the end of the scan is missing */
+  g_array_set_size (intervals, 0);
+  fail_if (gst_jpeg_scan_restart_intervals (entropy_coded_data, 13, 0,
+          intervals, NULL));
+  assert_equals_int (intervals->len, 3);
+
+  g_array_unref (intervals);
+}
+
+GST_END_TEST;
+
+static Suite *
+jpegparsers_suite (void)
+{
+  Suite *s = suite_create ("JPEG Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_jpeg_scan_for_marker_code);
+  tcase_add_test (tc_chain, test_jpeg_scan_restart_intervals);
+
+  return s;
+}
+
+GST_CHECK_MAIN (jpegparsers);
@@ -667,6 +667,50 @@ GST_START_TEST (test_mpegts_dvb_descriptors)
 
 GST_END_TEST;
 
+GST_START_TEST (test_mpegts_section_crc)
+{
+  GstMpegtsSection *section;
+  GPtrArray *pat;
+  guint8 *data;
+  gsize data_size;
+  guint32 crc;
+  guint i, j, n;
+
+  /* Check the CRC of sections of all sizes against a bitwise implementation */
+  for (n = 0; n < 250; n += 7) {
+    pat = gst_mpegts_pat_new ();
+    for (i = 0; i < n; i++) {
+      GstMpegtsPatProgram *program = gst_mpegts_pat_program_new ();
+
+      program->program_number = i + 1;
+      program->network_or_program_map_PID = 0x100 + i;
+      g_ptr_array_add (pat, program);
+    }
+
+    section = gst_mpegts_section_from_pat (pat, 0);
+    data = gst_mpegts_section_packetize (section, &data_size);
+    fail_if (data == NULL);
+
+    crc = 0xffffffff;
+    for (i = 0; i < data_size - 4; i++) {
+      crc ^= (guint32) data[i] << 24;
+      for (j = 0; j < 8; j++)
+        crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+    }
+    assert_equals_int (GST_READ_UINT32_BE (data + data_size - 4), crc);
+
+    /* And that it is verified on parsing */
+    pat = gst_mpegts_section_get_pat (section);
+    fail_unless (pat != NULL);
+    assert_equals_int (pat->len, n);
+    g_ptr_array_unref (pat);
+
+    gst_mpegts_section_unref (section);
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegts_suite (void)
 {
@@ -685,6 +729,7 @@ mpegts_suite (void)
   tcase_add_test (tc_chain, test_mpegts_atsc_stt);
   tcase_add_test (tc_chain, test_mpegts_descriptors);
   tcase_add_test (tc_chain, test_mpegts_dvb_descriptors);
+  tcase_add_test (tc_chain, test_mpegts_section_crc);
 
   return s;
 }
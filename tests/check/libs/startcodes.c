@@ -0,0 +1,361 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* for direct access to the generic and vectorised scanners */
+#include "../../gst-libs/gst/codecparsers/parserutils.c"
+
+#include <gst/check/gstcheck.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gstmpegvideoparser.h>
+
+#define DATA_SIZE (4 * 1024 * 1024)
+#define N_RUNS 4
+
+/* Random payload with start codes injected at known offsets, sparse enough
+ * that most of the time is spent scanning, like in real slice data */
+static guint8 *
+create_stream (GArray * offsets)
+{
+  GRand *rand = g_rand_new_with_seed (0x5c5c5c5c);
+  guint8 *data = g_malloc (DATA_SIZE);
+  guint i;
+
+  for (i = 0; i < DATA_SIZE; i++) {
+    /* bias towards zero bytes so the scanners see plenty of candidates */
+    if (g_rand_int_range (rand, 0, 8) == 0)
+      data[i] = 0;
+    else
+      data[i] = g_rand_int_range (rand, 0, 256);
+  }
+
+  /* scrub accidental start codes */
+  for (i = 2; i < DATA_SIZE; i++) {
+    if (data[i - 2] == 0 && data[i - 1] == 0 && data[i] == 1)
+      data[i] = 2;
+  }
+
+  i = g_rand_int_range (rand, 0, 64);
+  while (i + 4 <= DATA_SIZE) {
+    data[i] = 0;
+    data[i + 1] = 0;
+    data[i + 2] = 1;
+    data[i + 3] = 0x41;
+    g_array_append_val (offsets, i);
+    i += 4 + g_rand_int_range (rand, 0, 4096);
+  }
+
+  g_rand_free (rand);
+
+  return data;
+}
+
+static guint
+scan_reference (const guint8 * data, GArray * found)
+{
+  GstByteReader br;
+  guint offset = 0;
+  gint off;
+
+  gst_byte_reader_init (&br, data, DATA_SIZE);
+
+  while (offset + 4 <= DATA_SIZE) {
+    off = gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
+        offset, DATA_SIZE - offset);
+    if (off < 0)
+      break;
+    if (found)
+      g_array_append_val (found, off);
+    offset = off + 3;
+  }
+
+  return offset;
+}
+
+static guint
+scan_mpeg_video (const guint8 * data, GArray * found)
+{
+  GstMpegVideoPacket packet = { 0, };
+  guint offset = 0;
+  guint start;
+
+  while (gst_mpeg_video_parse (&packet, data, DATA_SIZE, offset)) {
+    start = packet.offset - 4;
+    if (found)
+      g_array_append_val (found, start);
+    offset = packet.offset;
+  }
+
+  return offset;
+}
+
+static guint
+scan_h264 (GstH264NalParser * parser, const guint8 * data, GArray * found)
+{
+  GstH264NalUnit nalu;
+  guint offset = 0;
+  guint start;
+
+  while (gst_h264_parser_identify_nalu_unchecked (parser, data, offset,
+          DATA_SIZE, &nalu) == GST_H264_PARSER_OK) {
+    start = nalu.offset - 3;
+    if (found)
+      g_array_append_val (found, start);
+    offset = nalu.offset;
+  }
+
+  return offset;
+}
+
+static void
+assert_offsets_equal (GArray * expected, GArray * found, const gchar * name)
+{
+  guint i;
+
+  GST_DEBUG ("%s: %u start codes", name, found->len);
+  assert_equals_int (found->len, expected->len);
+  for (i = 0; i < expected->len; i++) {
+    fail_unless_equals_int (g_array_index (found, guint, i),
+        g_array_index (expected, guint, i));
+  }
+}
+
+static gdouble
+get_rate (gint64 elapsed)
+{
+  return (gdouble) DATA_SIZE * N_RUNS / MAX (elapsed, 1);
+}
+
+GST_START_TEST (test_start_code_scan)
+{
+  GArray *expected = g_array_new (FALSE, FALSE, sizeof (guint));
+  GArray *found = g_array_new (FALSE, FALSE, sizeof (guint));
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  guint8 *data = create_stream (expected);
+
+  scan_reference (data, found);
+  assert_offsets_equal (expected, found, "reference");
+
+  g_array_set_size (found, 0);
+  scan_mpeg_video (data, found);
+  assert_offsets_equal (expected, found, "mpegvideo");
+
+  g_array_set_size (found, 0);
+  scan_h264 (parser, data, found);
+  assert_offsets_equal (expected, found, "h264");
+
+  gst_h264_nal_parser_free (parser);
+  g_array_unref (found);
+  g_array_unref (expected);
+  g_free (data);
+}
+
+GST_END_TEST;
+
+static const guint8 edge_data[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0xb3, 0x00, 0x00, 0x01
+};
+
+GST_START_TEST (test_start_code_scan_edges)
+{
+  GstMpegVideoPacket packet = { 0, };
+  guint size;
+
+  /* start code straddling the end of a vector block */
+  fail_unless (gst_mpeg_video_parse (&packet, edge_data,
+          sizeof (edge_data), 0));
+  assert_equals_int (packet.offset, 33);
+  assert_equals_int (packet.type, 0xb3);
+  /* a trailing start code without payload does not terminate the packet */
+  assert_equals_int (packet.size, -1);
+
+  /* the same search at every possible buffer size */
+  for (size = 0; size < 33; size++)
+    fail_if (gst_mpeg_video_parse (&packet, edge_data, size, 0));
+  for (; size <= sizeof (edge_data); size++) {
+    fail_unless (gst_mpeg_video_parse (&packet, edge_data, size, 0));
+    assert_equals_int (packet.offset, 33);
+  }
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  const gchar *name;
+  ScanStartCodeFunc func;
+} ScanImpl;
+
+/* the scanners usable on this CPU, the generic one first */
+static guint
+get_scan_impls (ScanImpl * impls)
+{
+  guint n = 0;
+
+  impls[n].name = "c";
+  impls[n++].func = scan_start_code_c;
+#ifdef HAVE_START_CODE_SSE2
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse2")) {
+    impls[n].name = "sse2";
+    impls[n++].func = scan_start_code_sse2;
+  }
+#endif
+#ifdef HAVE_START_CODE_AVX2
+  if (__builtin_cpu_supports ("avx2")) {
+    impls[n].name = "avx2";
+    impls[n++].func = scan_start_code_avx2;
+  }
+#endif
+#ifdef HAVE_START_CODE_NEON
+  impls[n].name = "neon";
+  impls[n++].func = scan_start_code_neon;
+#endif
+
+  return n;
+}
+
+/* byte by byte version of the scanner contract */
+static gint
+scan_naive (const guint8 * data, guint size)
+{
+  guint i;
+
+  for (i = 0; i + 4 <= size; i++) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+      return i;
+  }
+
+  return -1;
+}
+
+#define IMPL_DATA_SIZE 160
+#define IMPL_MAX_OFFSET 32
+
+/* Mostly zero and one bytes, so that start codes and partial prefixes show
+ * up at every position. With @single, the only zero bytes are those of a
+ * start code followed by @pos bytes, so the vector loops skip whole blocks
+ * before finding it */
+static void
+fill_impl_data (guint8 * data, GRand * rand, gboolean single, guint pos)
+{
+  guint i;
+
+  for (i = 0; i < IMPL_DATA_SIZE; i++) {
+    if (single)
+      data[i] = g_rand_int_range (rand, 1, 256);
+    else if (g_rand_int_range (rand, 0, 3))
+      data[i] = g_rand_int_range (rand, 0, 2);
+    else
+      data[i] = g_rand_int_range (rand, 0, 256);
+  }
+
+  if (single) {
+    i = IMPL_DATA_SIZE - 3 - pos;
+    data[i] = 0;
+    data[i + 1] = 0;
+    data[i + 2] = 1;
+  }
+}
+
+GST_START_TEST (test_start_code_scan_impls)
+{
+  ScanImpl impls[4];
+  GRand *rand = g_rand_new_with_seed (0x5c5c5c5c);
+  guint8 data[IMPL_DATA_SIZE];
+  guint n_impls, run, offset, size, i;
+
+  n_impls = get_scan_impls (impls);
+
+  for (run = 0; run < 64; run++) {
+    fill_impl_data (data, rand, run % 2, 1 + run / 2 % 8);
+
+    /* every alignment of the start of the buffer, and every buffer size so
+     * that each scanner falls back to its tail loop at every position */
+    for (offset = 0; offset < IMPL_MAX_OFFSET; offset++) {
+      for (size = 0; offset + size <= IMPL_DATA_SIZE; size++) {
+        gint expected = scan_naive (data + offset, size);
+
+        for (i = 0; i < n_impls; i++) {
+          fail_unless (impls[i].func (data + offset, size) == expected,
+              "%s scanner, run %u offset %u size %u", impls[i].name, run,
+              offset, size);
+        }
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_start_code_scan_perf)
+{
+  GArray *expected = g_array_new (FALSE, FALSE, sizeof (guint));
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  guint8 *data = create_stream (expected);
+  gint64 start;
+  gint i;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_RUNS; i++)
+    scan_reference (data, NULL);
+  GST_INFO ("byte reader masked scan: %.1f MB/s",
+      get_rate (g_get_monotonic_time () - start));
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_RUNS; i++)
+    scan_mpeg_video (data, NULL);
+  GST_INFO ("gst_mpeg_video_parse: %.1f MB/s",
+      get_rate (g_get_monotonic_time () - start));
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_RUNS; i++)
+    scan_h264 (parser, data, NULL);
+  GST_INFO ("gst_h264_parser_identify_nalu_unchecked: %.1f MB/s",
+      get_rate (g_get_monotonic_time () - start));
+
+  gst_h264_nal_parser_free (parser);
+  g_array_unref (expected);
+  g_free (data);
+}
+
+GST_END_TEST;
+
+static Suite *
+startcodes_suite (void)
+{
+  Suite *s = suite_create ("Codec parsers start code scanning");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_start_code_scan);
+  tcase_add_test (tc_chain, test_start_code_scan_edges);
+  tcase_add_test (tc_chain, test_start_code_scan_impls);
+  tcase_add_test (tc_chain, test_start_code_scan_perf);
+
+  return s;
+}
+
+GST_CHECK_MAIN (startcodes);
@@ -0,0 +1,146 @@
+/* GStreamer
+ * Copyright (C) 2020 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstvp9parser.h>
+
+/* Two frames of 10 and 300 bytes followed by a superframe index using two
+ * bytes per frame size. The frame payloads are not valid VP9, only the
+ * superframe layout matters here */
+static guint8 *
+create_superframe (gsize * size)
+{
+  const guint8 marker = 0xc0 | (1 << 3) | 1;
+  guint8 *data;
+  guint8 *index;
+
+  *size = 10 + 300 + 6;
+  data = g_malloc (*size);
+  memset (data, 0x11, 10);
+  memset (data + 10, 0x22, 300);
+
+  index = data + 310;
+  index[0] = marker;
+  index[1] = 10;
+  index[2] = 0;
+  index[3] = 300 & 0xff;
+  index[4] = 300 >> 8;
+  index[5] = marker;
+
+  return data;
+}
+
+GST_START_TEST (test_vp9_parse_superframe_info)
+{
+  GstVp9Parser *parser = gst_vp9_parser_new ();
+  GstVp9SuperframeInfo info;
+  GstVp9ParserResult res;
+  guint8 frame[20];
+  guint8 *data;
+  gsize size;
+
+  data = create_superframe (&size);
+
+  res = gst_vp9_parser_parse_superframe_info (parser, &info, data, size);
+  assert_equals_int (res, GST_VP9_PARSER_OK);
+  assert_equals_int (info.frames_in_superframe, 2);
+  assert_equals_int (info.bytes_per_framesize, 2);
+  assert_equals_int (info.frame_sizes[0], 10);
+  assert_equals_int (info.frame_sizes[1], 300);
+  assert_equals_int (info.superframe_index_size, 6);
+
+  /* a frame whose last byte only looks like a marker */
+  memset (frame, 0x33, sizeof (frame));
+  frame[sizeof (frame) - 1] = data[size - 1];
+  res = gst_vp9_parser_parse_superframe_info (parser, &info, frame,
+      sizeof (frame));
+  assert_equals_int (res, GST_VP9_PARSER_OK);
+  assert_equals_int (info.frames_in_superframe, 1);
+  assert_equals_int (info.frame_sizes[0], sizeof (frame));
+  assert_equals_int (info.superframe_index_size, 0);
+
+  /* a regular frame */
+  res = gst_vp9_parser_parse_superframe_info (parser, &info, data, 10);
+  assert_equals_int (res, GST_VP9_PARSER_OK);
+  assert_equals_int (info.frames_in_superframe, 1);
+  assert_equals_int (info.frame_sizes[0], 10);
+
+  /* an index describing more data than there is */
+  data[313] = 0xff;
+  res = gst_vp9_parser_parse_superframe_info (parser, &info, data, size);
+  assert_equals_int (res, GST_VP9_PARSER_BROKEN_DATA);
+
+  g_free (data);
+  gst_vp9_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_vp9_superframe_info_get_frame)
+{
+  GstVp9Parser *parser = gst_vp9_parser_new ();
+  GstVp9SuperframeInfo info;
+  GstBuffer *buffer, *frame;
+  GstMapInfo map, frame_map;
+  guint8 *data;
+  gsize size;
+
+  data = create_superframe (&size);
+  buffer = gst_buffer_new_wrapped (data, size);
+  GST_BUFFER_PTS (buffer) = 42 * GST_SECOND;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  fail_unless_equals_int (gst_vp9_parser_parse_superframe_info (parser, &info,
+          map.data, map.size), GST_VP9_PARSER_OK);
+
+  frame = gst_vp9_superframe_info_get_frame (&info, buffer, 1);
+  fail_unless (frame != NULL);
+  assert_equals_int (gst_buffer_get_size (frame), 300);
+  assert_equals_uint64 (GST_BUFFER_PTS (frame), 42 * GST_SECOND);
+
+  /* the frame is a view on the superframe memory */
+  gst_buffer_map (frame, &frame_map, GST_MAP_READ);
+  fail_unless (frame_map.data == map.data + 10);
+  gst_buffer_unmap (frame, &frame_map);
+  gst_buffer_unref (frame);
+
+  fail_unless (gst_vp9_superframe_info_get_frame (&info, buffer, 2) == NULL);
+
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+  gst_vp9_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static Suite *
+vp9parsers_suite (void)
+{
+  Suite *s = suite_create ("VP9 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_vp9_parse_superframe_info);
+  tcase_add_test (tc_chain, test_vp9_superframe_info_get_frame);
+
+  return s;
+}
+
+GST_CHECK_MAIN (vp9parsers);
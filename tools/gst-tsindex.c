@@ -0,0 +1,125 @@
+/* GStreamer
+ *
+ * gst-tsindex: generates seek indexes of MPEG-TS files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+
+#include "mpegtsindex.h"
+
+#define CHUNK_SIZE (1024 * 1024)
+
+static gboolean
+build_index (const gchar * input, const gchar * output)
+{
+  MpegTSIndex *index;
+  GError *err = NULL;
+  guint8 *chunk;
+  gsize read;
+  FILE *f;
+  gboolean ret;
+
+  f = g_fopen (input, "rb");
+  if (f == NULL) {
+    g_printerr ("Could not open %s\n", input);
+    return FALSE;
+  }
+
+  index = mpegts_index_new ();
+  chunk = g_malloc (CHUNK_SIZE);
+  while ((read = fread (chunk, 1, CHUNK_SIZE, f)) > 0)
+    mpegts_index_scan (index, chunk, read);
+  ret = !ferror (f);
+  fclose (f);
+  g_free (chunk);
+
+  if (!ret) {
+    g_printerr ("Error reading %s\n", input);
+    goto done;
+  }
+
+  mpegts_index_finish (index);
+  if (mpegts_index_get_n_entries (index) == 0) {
+    g_printerr ("No PCR found in %s\n", input);
+    ret = FALSE;
+    goto done;
+  }
+
+  ret = mpegts_index_save (index, output, &err);
+  if (ret) {
+    g_print ("Wrote %u entries to %s\n", mpegts_index_get_n_entries (index),
+        output);
+  } else {
+    g_printerr ("Could not write %s: %s\n", output, err->message);
+    g_clear_error (&err);
+  }
+
+done:
+  mpegts_index_free (index);
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  gchar *output = NULL;
+  gchar **files = NULL;
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gboolean ret;
+  GOptionEntry options[] = {
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+        "Index file to write (default: <file>.tsidx)", "FILE"},
+    {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &files, NULL,
+        NULL},
+    {NULL}
+  };
+
+  ctx = g_option_context_new ("FILE - generate the seek index of a MPEG-TS "
+      "file, to be used with the index-location property of tsdemux");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (files == NULL || files[0] == NULL || files[1] != NULL) {
+    g_printerr ("Usage: %s [-o FILE] FILE\n", argv[0]);
+    return 1;
+  }
+
+  if (output == NULL)
+    output = g_strconcat (files[0], ".tsidx", NULL);
+
+  ret = build_index (files[0], output);
+
+  g_free (output);
+  g_strfreev (files);
+
+  return ret ? 0 : 1;
+}